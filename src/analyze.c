@@ -1038,6 +1038,7 @@ static int analysisLoader(void *pData, int argc, char **argv, char **NotUsed){
     if( i==0 ) pTable->nRowEst = v;
     if( pIndex==0 ) break;
     pIndex->aiRowEst[i] = v;
+    pIndex->hasStat1 = 1;
     if( *z==' ' ) z++;
     if( memcmp(z, "unordered", 10)==0 ){
       pIndex->bUnordered = 1;
@@ -1258,6 +1259,7 @@ int sqlite3AnalysisLoad(sqlite3 *db, int iDb){
 	/*sqliteHashFirst、sqliteHashNext为哈希表的宏定义，pSchema表示指向数据库模式的指针(可能是共享的)*/
     Index *pIdx = sqliteHashData(i);  /*sqliteHashData为哈希表的宏定义*/
     sqlite3DefaultRowEst(pIdx);  /*用默认的信息填充Index.aiRowEst[]数组，当我们不运行ANALYZE指令时，就使用这些信息。*/
+    pIdx->hasStat1 = 0;
 #ifdef SQLITE_ENABLE_STAT3
     sqlite3DeleteIndexSamples(db, pIdx);
     pIdx->aSample = 0;
@@ -285,6 +285,7 @@ static void detachFunc(
     goto detach_error;
   }
 
+  sqlite3WalCheckpointerClose(db, i);
   sqlite3BtreeClose(pDb->pBt);
   pDb->pBt = 0;
   pDb->pSchema = 0;
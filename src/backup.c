@@ -373,7 +373,7 @@ int sqlite3_backup_step(sqlite3_backup *p, int nPage){
     pgszSrc = sqlite3BtreeGetPageSize(p->pSrc);
     pgszDest = sqlite3BtreeGetPageSize(p->pDest);
     destMode = sqlite3PagerGetJournalMode(sqlite3BtreePager(p->pDest));
-    if( SQLITE_OK==rc && destMode==PAGER_JOURNALMODE_WAL && pgszSrc!=pgszDest ){
+    if( SQLITE_OK==rc && isWalMode(destMode) && pgszSrc!=pgszDest ){
       rc = SQLITE_READONLY;
     }
   
@@ -415,8 +415,9 @@ int sqlite3_backup_step(sqlite3_backup *p, int nPage){
         if( p->pDestDb ){
           sqlite3ResetAllSchemasOfConnection(p->pDestDb);
         }
-        if( destMode==PAGER_JOURNALMODE_WAL ){
-          rc = sqlite3BtreeSetVersion(p->pDest, 2);
+        if( isWalMode(destMode) ){
+          rc = sqlite3BtreeSetVersion(p->pDest,
+                            destMode==PAGER_JOURNALMODE_WAL2 ? 3 : 2);
         }
       }
       if( rc==SQLITE_OK ){
@@ -70,6 +70,14 @@ int sqlite3BtreeTrace=1;  /* True to enable tracing *//* 逻辑值为真表示
 
 #define get2byteNotZero(X)  (((((int)get2byte(X))-1)&0xffff)+1)
 
+/*
+** The number of sibling leaf pages to hint to the pager ahead of a cursor
+** that has the BTREE_SEQUENTIAL hint set. Set to 0 to disable read-ahead.
+*/
+#ifndef SQLITE_BTREE_READAHEAD
+# define SQLITE_BTREE_READAHEAD 16
+#endif
+
 #ifndef SQLITE_OMIT_SHARED_CACHE
 /*
 ** A list of BtShared objects that are eligible for participation
@@ -2048,13 +2056,14 @@ static int btreeGetPage(
   BtShared *pBt,       /* The btree */                          //B树
   Pgno pgno,           /* Number of the page to fetch */        //获取的页面数  /*【潘光珍】本页的页号*/
   MemPage **ppPage,    /* Return the page in this parameter */  //用这个参数返回页  /*【潘光珍】返回此参数中的页*/
-  int noContent        /* Do not load page content if true */   //如果为真,则不会加载页   /*【潘光珍】如果真的,不要加载页面内容*/
+  int flags            /* PAGER_ACQUIRE_NOCONTENT or PAGER_ACQUIRE_READONLY */
 ){
   int rc;
   DbPage *pDbPage;
 
+  assert( flags==0 || flags==PAGER_ACQUIRE_NOCONTENT || flags==PAGER_ACQUIRE_READONLY );
   assert( sqlite3_mutex_held(pBt->mutex) );
-  rc = sqlite3PagerAcquire(pBt->pPager, pgno, (DbPage**)&pDbPage, noContent);
+  rc = sqlite3PagerAcquire(pBt->pPager, pgno, (DbPage**)&pDbPage, flags);
   if( rc ) return rc; 
   *ppPage = btreePageFromDbPage(pDbPage, pgno, pBt);/*从pager中获取page,放在ppPage中*/
   return SQLITE_OK;
@@ -2105,15 +2114,17 @@ u32 sqlite3BtreeLastPage(Btree *p){
 static int getAndInitPage(    //从页对象中获得一个页面并初始化
   BtShared *pBt,          /* The database file */         //数据库文件
   Pgno pgno,           /* Number of the page to get */    //获得的页面的数量 /*【潘光珍】获得本页的页号*/
-  MemPage **ppPage     /* Write the page pointer here */  //在该变量上写指针
+  MemPage **ppPage,    /* Write the page pointer here */  //在该变量上写指针
+  int bReadonly        /* PAGER_ACQUIRE_READONLY or 0 */
 ){
   int rc;
   assert( sqlite3_mutex_held(pBt->mutex) );
+  assert( bReadonly==PAGER_ACQUIRE_READONLY || bReadonly==0 );
 
   if( pgno>btreePagecount(pBt) ){
     rc = SQLITE_CORRUPT_BKPT;
   }else{
-    rc = btreeGetPage(pBt, pgno, ppPage, 0); /*Get a page from the pager*/
+    rc = btreeGetPage(pBt, pgno, ppPage, bReadonly); /*Get a page from the pager*/
     if( rc==SQLITE_OK ){
       rc = btreeInitPage(*ppPage);/*初始化page*/
       if( rc!=SQLITE_OK ){/*ppPage的值未被定义.它的值可能未变化或者为无效值.*/
@@ -2439,6 +2450,18 @@ int sqlite3BtreeOpen(     //打开数据库文件并返回B树对象
     rc = sqlite3PagerSetPagesize(pBt->pPager, &pBt->pageSize, nReserve);
     if( rc ) goto btree_open_out;
     pBt->usableSize = pBt->pageSize - nReserve;
+
+    /* If the "warm_start" URI parameter is true, load the list of pages
+    ** that were cached when the database was last closed. They are read
+    ** ahead by lockBtree() once the list is known to be current. */
+    if( !isTempDb && !isMemdb
+     && sqlite3_uri_boolean(zFilename, "warm_start", SQLITE_DEFAULT_WARM_START)
+    ){
+      pBt->btsFlags |= BTS_WARM_START;
+      rc = sqlite3PagerWarmLoad(pBt->pPager, &pBt->aWarm, &pBt->nWarm,
+                                pBt->aWarmHdr);
+      if( rc ) goto btree_open_out;
+    }
     assert( (pBt->pageSize & 7)==0 );  /* 8-byte alignment of pageSize *//*8字节平衡的页大小*/
    
 #if !defined(SQLITE_OMIT_SHARED_CACHE) && !defined(SQLITE_OMIT_DISKIO)
@@ -2505,6 +2528,7 @@ btree_open_out:
     if( pBt && pBt->pPager ){
       sqlite3PagerClose(pBt->pPager);
     }
+    if( pBt ) sqlite3_free(pBt->aWarm);
     sqlite3_free(pBt);
     sqlite3_free(p);
     *ppBtree = 0;
@@ -2634,6 +2658,10 @@ int sqlite3BtreeClose(Btree *p){   //关闭已打开的数据库并且使游标
     ** Clean out and delete the BtShared object.
     ** 清理并删除BtShared对象 */
     assert( !pBt->pCursor );
+    if( (pBt->btsFlags & BTS_WARM_START) && pBt->bWarmHdr ){
+      sqlite3PagerWarmSave(pBt->pPager, pBt->aWarmHdr);
+    }
+    sqlite3_free(pBt->aWarm);
     sqlite3PagerClose(pBt->pPager);/*在共享列表中不再有此对象,删除BtShared共享对象*/
     if( pBt->xFreeSchema && pBt->pSchema ){
       pBt->xFreeSchema(pBt->pSchema);
@@ -2916,6 +2944,22 @@ int sqlite3BtreeGetAutoVacuum(Btree *p){//获取数据库是否自动清理页
 #endif
 }
 
+/*
+** Called by lockBtree() the first time page 1 is loaded after a list
+** of pages was read from the warm-start sidecar file. If bytes 24..31
+** of page 1 (the change counter and database size) still match the
+** values recorded in the sidecar, ask the pager to read the listed
+** pages ahead. The list is discarded either way.
+*/
+static void btreeWarmStart(BtShared *pBt, const u8 *page1){
+  if( memcmp(pBt->aWarmHdr, &page1[24], 8)==0 ){
+    sqlite3PagerPrefetch(pBt->pPager, pBt->aWarm, pBt->nWarm);
+  }
+  sqlite3_free(pBt->aWarm);
+  pBt->aWarm = 0;
+  pBt->nWarm = 0;
+}
+
 /*
 ** Get a reference to pPage1 of the database file.  This will
 ** also acquire a readlock on that file.
@@ -2971,10 +3015,10 @@ static int lockBtree(BtShared *pBt){
       goto page1_init_failed;
     }
 #else
-    if( page1[18]>2 ){
+    if( page1[18]>3 ){
       pBt->btsFlags |= BTS_READ_ONLY;
     }
-    if( page1[19]>2 ){
+    if( page1[19]>3 ){
       goto page1_init_failed;
     }
     /* If the write version is set to 2, this database should be accessed
@@ -2992,9 +3036,9 @@ static int lockBtree(BtShared *pBt){
 	然后返回SQLITE_OK还没有填充BtShared.pPage1来检测，再调用这个函数。
 	这是需要1页的版本目前在第一页缓冲区可能不是最新的版本可能会有一个新的日志文件中。
 	*/
-    if( page1[19]==2 && (pBt->btsFlags & BTS_NO_WAL)==0 ){
+    if( (page1[19]==2 || page1[19]==3) && (pBt->btsFlags & BTS_NO_WAL)==0 ){
       int isOpen = 0;
-      rc = sqlite3PagerOpenWal(pBt->pPager, &isOpen);/*打开日志*/
+      rc = sqlite3PagerOpenWal(pBt->pPager, page1[19]==3, &isOpen);/*打开日志*/
       if( rc!=SQLITE_OK ){
         goto page1_init_failed;
       }else if( isOpen==0 ){
@@ -3102,6 +3146,9 @@ static int lockBtree(BtShared *pBt){
     pBt->max1bytePayload = (u8)pBt->maxLocal;
   }
   assert( pBt->maxLeaf + 23 <= MX_CELL_SIZE(pBt) );
+  if( pBt->aWarm ){
+    btreeWarmStart(pBt, pPage1->aData);
+  }
   pBt->pPage1 = pPage1;
   pBt->nPage = nPage;
   return SQLITE_OK;
@@ -3132,6 +3179,11 @@ static void unlockBtreeIfUnused(BtShared *pBt){
     assert( pBt->pPage1->aData );
     assert( sqlite3PagerRefcount(pBt->pPager)==1 );
     assert( pBt->pPage1->aData );
+    if( pBt->btsFlags & BTS_WARM_START ){
+      /* Remember the change counter and size for sqlite3PagerWarmSave() */
+      memcpy(pBt->aWarmHdr, &pBt->pPage1->aData[24], 8);
+      pBt->bWarmHdr = 1;
+    }
     releasePage(pBt->pPage1);/*释放内存*/
     pBt->pPage1 = 0;
   }
@@ -3332,6 +3384,12 @@ int sqlite3BtreeBeginTrans(Btree *p, int wrflag){   //wrflag非零开始写事
 	  */
     while( pBt->pPage1==0 && SQLITE_OK==(rc = lockBtree(pBt)) );
 
+    /* Start or stop tracking the pages read by this transaction, depending
+    ** on whether or not it was opened by BEGIN CONCURRENT. */
+    if( rc==SQLITE_OK && p->inTrans==TRANS_NONE ){
+      rc = sqlite3PagerBeginConcurrent(pBt->pPager, p->db->bConcurrent);
+    }
+
     if( rc==SQLITE_OK && wrflag ){
       if( (pBt->btsFlags & BTS_READ_ONLY)!=0 ){
         rc = SQLITE_READONLY;
@@ -5253,6 +5311,60 @@ const void *sqlite3BtreeDataFetch(BtCursor *pCur, int *pAmt){  //用于快速访
   return p;
 }
 
+#ifndef SQLITE_OMIT_BATCH_AGGREGATE
+/*
+** Cursor pCur points to an entry of a table (intkey) b-tree.  Starting with
+** that entry, set aRec[i] and anRec[i] to the address and size of the data
+** of each of up to nMax consecutive entries on the same leaf page, and set
+** *pnRec to the number of entries found.  The scan stops early at the first
+** entry whose data spills onto overflow pages.
+**
+** The cursor is left pointing at the last entry returned, so that the next
+** call to sqlite3BtreeNext() moves to the first entry not yet seen.  If
+** *pnRec is set to zero, either because the cursor does not point to a
+** leaf entry or because that entry has overflow pages, the cursor is not
+** moved.
+**
+** As with sqlite3BtreeDataFetch(), the pointers returned are ephemeral and
+** are only valid until the next call to any other Btree routine.
+*/
+int sqlite3BtreeLeafBatch(
+  BtCursor *pCur,         /* Cursor pointing to the first entry wanted */
+  int nMax,               /* Maximum number of entries to return */
+  const u8 **aRec,        /* OUT: Data of each entry */
+  u32 *anRec,             /* OUT: Size of the data of each entry */
+  int *pnRec              /* OUT: Number of entries returned */
+){
+  MemPage *pPage;
+  int idx;
+  int n = 0;
+  int rc;
+
+  assert( cursorHoldsMutex(pCur) );
+  *pnRec = 0;
+  rc = restoreCursorPosition(pCur);
+  if( rc!=SQLITE_OK ) return rc;
+  if( pCur->eState!=CURSOR_VALID || pCur->skipNext ) return SQLITE_OK;
+  pPage = pCur->apPage[pCur->iPage];
+  if( !pPage->leaf || !pPage->intKey || !pPage->hasData ) return SQLITE_OK;
+  for(idx=pCur->aiIdx[pCur->iPage]; n<nMax && idx<pPage->nCell; idx++){
+    CellInfo info;
+    btreeParseCellPtr(pPage, findCell(pPage, idx), &info);
+    if( info.iOverflow ) break;
+    aRec[n] = info.pCell + info.nHeader;
+    anRec[n] = info.nData;
+    n++;
+  }
+  if( n>0 ){
+    pCur->aiIdx[pCur->iPage] = (u16)(idx-1);
+    pCur->info.nSize = 0;
+    pCur->validNKey = 0;
+  }
+  *pnRec = n;
+  return SQLITE_OK;
+}
+#endif /* SQLITE_OMIT_BATCH_AGGREGATE */
+
 /*
 ** Move the cursor down to a new child page.  The newPgno argument is the
 ** page number of the child page to move to.
@@ -5269,6 +5381,69 @@ const void *sqlite3BtreeDataFetch(BtCursor *pCur, int *pAmt){  //用于快速访
 	如果page-header标志与其父节点的标志不匹配,此函数返回SQLITE_CORRUPT.
 	*/
 
+#ifdef SQLITE_TEST
+/*
+** The following global variable is incremented each time a cursor passes
+** a read-ahead hint to the pager. The test scripts use it to check that
+** hints are issued by scans and not by seeks.
+*/
+int sqlite3_readahead_count = 0;
+#endif
+
+#if SQLITE_BTREE_READAHEAD>0
+/*
+** Cursor pCur, which has the BTREE_SEQUENTIAL hint set, has just been
+** moved by sqlite3BtreeNext() or Previous() onto a leaf that is a child
+** of an interior page. Pass the page numbers of the next
+** SQLITE_BTREE_READAHEAD children of the parent page in the direction of
+** the scan (towards the end if bForward is true, towards the start if
+** not) to the pager as a read-ahead hint.
+**
+** Hints are only issued each time the cursor crosses a multiple of
+** SQLITE_BTREE_READAHEAD children, so that a scan hints each sibling
+** exactly once while it is still ahead of the cursor. Seeks, and the
+** moves made by sqlite3BtreeFirst() and Last(), do not call this routine,
+** as they may read a single leaf.
+*/
+static void btreeReadahead(BtCursor *pCur, int bForward){
+  Pgno aPgno[SQLITE_BTREE_READAHEAD];   /* Child pages to hint */
+  int nPgno = 0;                        /* Number of entries in aPgno[] */
+  MemPage *pParent;                     /* Parent of the current leaf */
+  int iIdx;                             /* Index of the leaf in pParent */
+  int i;
+
+  assert( cursorHoldsMutex(pCur) );
+  if( (pCur->hints & BTREE_SEQUENTIAL)==0 || pCur->iPage<1 ) return;
+  assert( pCur->apPage[pCur->iPage]->leaf );
+  pParent = pCur->apPage[pCur->iPage-1];
+  iIdx = pCur->aiIdx[pCur->iPage-1];
+  assert( !pParent->leaf );
+  if( bForward ){
+    if( iIdx % SQLITE_BTREE_READAHEAD ) return;
+    for(i=iIdx+1; i<=pParent->nCell && nPgno<SQLITE_BTREE_READAHEAD; i++){
+      if( i<pParent->nCell ){
+        aPgno[nPgno++] = get4byte(findCell(pParent, i));
+      }else{
+        aPgno[nPgno++] = get4byte(&pParent->aData[pParent->hdrOffset+8]);
+      }
+    }
+  }else{
+    if( (pParent->nCell - iIdx) % SQLITE_BTREE_READAHEAD ) return;
+    for(i=iIdx-1; i>=0 && nPgno<SQLITE_BTREE_READAHEAD; i--){
+      aPgno[nPgno++] = get4byte(findCell(pParent, i));
+    }
+  }
+  if( nPgno>0 ){
+#ifdef SQLITE_TEST
+    sqlite3_readahead_count++;
+#endif
+    sqlite3PagerPrefetch(pCur->pBt->pPager, aPgno, nPgno);
+  }
+}
+#else
+# define btreeReadahead(X,Y)
+#endif
+
 static int moveToChild(BtCursor *pCur, u32 newPgno){      //移动游标到下一个新的孩子页面
   int rc;
   int i = pCur->iPage;
@@ -5281,8 +5456,10 @@ static int moveToChild(BtCursor *pCur, u32 newPgno){      //移动游标到下
   if( pCur->iPage>=(BTCURSOR_MAX_DEPTH-1) ){
     return SQLITE_CORRUPT_BKPT;
   }
-  rc = getAndInitPage(pBt, newPgno, &pNewPage);
+  rc = getAndInitPage(pBt, newPgno, &pNewPage,
+      (pCur->wrFlag==0 ? PAGER_ACQUIRE_READONLY : 0));
   if( rc ) return rc;
+  pCur->nFetch++;
   pCur->apPage[i+1] = pNewPage;
   pCur->aiIdx[i+1] = 0;
   pCur->iPage++;
@@ -5427,11 +5604,13 @@ static int moveToRoot(BtCursor *pCur){      //移动游标指向B树结构的根
     pCur->eState = CURSOR_INVALID;
     return SQLITE_OK;
   }else{
-    rc = getAndInitPage(pBt, pCur->pgnoRoot, &pCur->apPage[0]);
+    rc = getAndInitPage(pBt, pCur->pgnoRoot, &pCur->apPage[0],
+        (pCur->wrFlag==0 ? PAGER_ACQUIRE_READONLY : 0));
     if( rc!=SQLITE_OK ){
       pCur->eState = CURSOR_INVALID;
       return rc;
     }
+    pCur->nFetch++;
     pCur->iPage = 0;
 
     /* If pCur->pKeyInfo is not NULL, then the caller that opened this cursor
@@ -5957,6 +6136,7 @@ int sqlite3BtreeNext(BtCursor *pCur, int *pRes){   //移动游标到数据库中
       rc = moveToChild(pCur, get4byte(&pPage->aData[pPage->hdrOffset+8]));
       if( rc ) return rc;
       rc = moveToLeftmost(pCur);
+      if( rc==SQLITE_OK ) btreeReadahead(pCur, 1);
       *pRes = 0;
       return rc;
     }
@@ -5982,6 +6162,7 @@ int sqlite3BtreeNext(BtCursor *pCur, int *pRes){   //移动游标到数据库中
     return SQLITE_OK;
   }
   rc = moveToLeftmost(pCur);
+  if( rc==SQLITE_OK ) btreeReadahead(pCur, 1);
   return rc;
 }
 
@@ -6029,6 +6210,7 @@ int sqlite3BtreePrevious(BtCursor *pCur, int *pRes){   //逐步使游标回到
       return rc;
     }
     rc = moveToRightmost(pCur);
+    if( rc==SQLITE_OK ) btreeReadahead(pCur, 0);
   }else{
     while( pCur->aiIdx[pCur->iPage]==0 ){
       if( pCur->iPage==0 ){
@@ -6311,7 +6493,7 @@ static int allocateBtreePage(           //从数据库文件分配一个新页
             memcpy(&aData[8+closest*4], &aData[4+k*4], 4);
           }
           put4byte(&aData[4], k-1);
-          noContent = !btreeGetHasContent(pBt, *pPgno);
+          noContent = !btreeGetHasContent(pBt, *pPgno) ? PAGER_ACQUIRE_NOCONTENT : 0;
           rc = btreeGetPage(pBt, *pPgno, ppPage, noContent);
           if( rc==SQLITE_OK ){
             rc = sqlite3PagerWrite((*ppPage)->pDbPage);
@@ -6350,7 +6532,7 @@ static int allocateBtreePage(           //从数据库文件分配一个新页
       MemPage *pPg = 0;
       TRACE(("ALLOCATE: %d from end of file (pointer-map page)\n", pBt->nPage));
       assert( pBt->nPage!=PENDING_BYTE_PAGE(pBt) );
-      rc = btreeGetPage(pBt, pBt->nPage, &pPg, 1);
+      rc = btreeGetPage(pBt, pBt->nPage, &pPg, PAGER_ACQUIRE_NOCONTENT);
       if( rc==SQLITE_OK ){
         rc = sqlite3PagerWrite(pPg->pDbPage);
         releasePage(pPg);
@@ -6364,7 +6546,7 @@ static int allocateBtreePage(           //从数据库文件分配一个新页
     *pPgno = pBt->nPage;
 
     assert( *pPgno!=PENDING_BYTE_PAGE(pBt) );
-    rc = btreeGetPage(pBt, *pPgno, ppPage, 1);
+    rc = btreeGetPage(pBt, *pPgno, ppPage, PAGER_ACQUIRE_NOCONTENT);
     if( rc ) return rc;
     rc = sqlite3PagerWrite((*ppPage)->pDbPage);
     if( rc!=SQLITE_OK ){
@@ -7617,7 +7799,7 @@ static int balance_nonroot(                                //调整B树的各节
   }
   pgno = get4byte(pRight);
   while( 1 ){
-    rc = getAndInitPage(pBt, pgno, &apOld[i]);
+    rc = getAndInitPage(pBt, pgno, &apOld[i], 0);
     if( rc ){
       memset(apOld, 0, (i+1)*sizeof(MemPage*));
       goto balance_cleanup;
@@ -9082,7 +9264,7 @@ static int clearDatabasePage(    //擦除给定的数据库页和其所有孩子
     return SQLITE_CORRUPT_BKPT;
   }
 
-  rc = getAndInitPage(pBt, pgno, &pPage);  //从页对象中获得一个页面并初始化
+  rc = getAndInitPage(pBt, pgno, &pPage, 0);  //从页对象中获得一个页面并初始化
   if( rc ) return rc;
   for(i=0; i<pPage->nCell; i++){
     pCell = findCell(pPage, i);
@@ -10314,7 +10496,7 @@ int sqlite3BtreeSetVersion(Btree *pBtree, int iVersion){  //在数据库头部
   BtShared *pBt = pBtree->pBt;
   int rc;                         /* Return code */
  
-  assert( iVersion==1 || iVersion==2 );
+  assert( iVersion==1 || iVersion==2 || iVersion==3 );
 
   /* If setting the version fields to 1, do not automatically open the
   ** WAL connection, even if the version fields are currently set to 2.
@@ -10343,10 +10525,27 @@ int sqlite3BtreeSetVersion(Btree *pBtree, int iVersion){  //在数据库头部
 
 /*
 ** set the mask of hint flags for cursor pCsr. Currently the only valid
-** values are 0 and BTREE_BULKLOAD.
+** values are 0, BTREE_BULKLOAD and BTREE_SEQUENTIAL.
 ** 设置游标pCsr掩码.当前唯一有效值是0,且BTREE_BULKLOAD.
 */
 void sqlite3BtreeCursorHints(BtCursor *pCsr, unsigned int mask){
-  assert( mask==BTREE_BULKLOAD || mask==0 );/*设置掩码mask=BTREE_BULKLOAD 或0*/
+  assert( (mask & ~(BTREE_BULKLOAD|BTREE_SEQUENTIAL))==0 );/*设置掩码mask=BTREE_BULKLOAD 或0*/
   pCsr->hints = mask;
 }
+
+/*
+** Add the hint flags in mask to those already set for cursor pCsr.
+*/
+void sqlite3BtreeCursorAddHints(BtCursor *pCsr, unsigned int mask){
+  assert( (mask & ~(BTREE_BULKLOAD|BTREE_SEQUENTIAL))==0 );
+  pCsr->hints |= mask;
+}
+
+/*
+** Return the number of b-tree pages cursor pCsr has loaded while moving
+** down the tree since it was opened. A page that the cursor visits more
+** than once is counted each time.
+*/
+u32 sqlite3BtreeCursorFetchCount(BtCursor *pCsr){
+  return pCsr->nFetch;
+}
@@ -140,7 +140,8 @@ int sqlite3BtreeUpdateMeta(Btree*, int idx, u32 value);
 ** Values that may be OR'd together to form the second argument of an
 ** sqlite3BtreeCursorHints() call.
 */
-#define BTREE_BULKLOAD 0x00000001
+#define BTREE_BULKLOAD   0x00000001
+#define BTREE_SEQUENTIAL 0x00000002
 
 int sqlite3BtreeCursor(     //创建一个指向特定B树的游标。可以是读或写游标，但读游标和写游标不能同时在同一B树中存在
   Btree*,                              /* BTree containing table to open */      //打开B树包含的表
@@ -174,6 +175,9 @@ int sqlite3BtreeKeySize(BtCursor*, i64 *pSize);                   //返回当前
 int sqlite3BtreeKey(BtCursor*, u32 offset, u32 amt, void*);       //返回当前游标锁时记录的关键字
 const void *sqlite3BtreeKeyFetch(BtCursor*, int *pAmt);           //用于快速访问key
 const void *sqlite3BtreeDataFetch(BtCursor*, int *pAmt);          //用于快速访问data
+#ifndef SQLITE_OMIT_BATCH_AGGREGATE
+int sqlite3BtreeLeafBatch(BtCursor*, int, const u8**, u32*, int*);
+#endif
 int sqlite3BtreeDataSize(BtCursor*, u32 *pSize);                  //返回当前游标锁时记录的数据字长度
 int sqlite3BtreeData(BtCursor*, u32 offset, u32 amt, void*);      //返回当前游标锁时记录的数据
 void sqlite3BtreeSetCachedRowid(BtCursor*, sqlite3_int64);        //设置相同的数据库文件中中每个游标的cache行号
@@ -187,6 +191,8 @@ void sqlite3BtreeCacheOverflow(BtCursor *);                       //此函数在
 void sqlite3BtreeClearCursor(BtCursor *);                         //清除当前游标位置
 int sqlite3BtreeSetVersion(Btree *pBt, int iVersion);
 void sqlite3BtreeCursorHints(BtCursor *, unsigned int mask);
+void sqlite3BtreeCursorAddHints(BtCursor *, unsigned int mask);
+u32 sqlite3BtreeCursorFetchCount(BtCursor *);
 
 #ifndef NDEBUG
 int sqlite3BtreeCursorIsValid(BtCursor*);
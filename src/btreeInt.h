@@ -467,7 +467,12 @@ struct BtShared {
   BtLock *pLock;        /* List of locks held on this shared-btree struct */       //在shared-btree结构上持有的锁列表
   Btree *pWriter;       /* Btree with currently open write transaction */          //B树带有当前开放性写事务
 #endif
-  u8 *pTmpSpace;        /* BtShared.pageSize bytes of space for tmp use */         //BtShared.pageSize临时使用的空字节数
+  u8 *pTmpSpace;        /* BtShared.pageSize bytes of space for tmp use */
+  Pgno *aWarm;          /* Pages to read ahead from the warm-start sidecar */
+  int nWarm;            /* Number of entries in aWarm[] */
+  u8 aWarmHdr[8];       /* Bytes 24..31 of page 1 when aWarm[] was saved, then
+                        ** as last seen by unlockBtreeIfUnused() */
+  u8 bWarmHdr;          /* True once aWarmHdr[] holds the last seen bytes */
 };
 
 /*
@@ -479,7 +484,8 @@ struct BtShared {
 #define BTS_INITIALLY_EMPTY  0x0008   /* Database was empty at trans start */      //在事务的开始数据库是空
 #define BTS_NO_WAL           0x0010   /* Do not open write-ahead-log files */      //不打开write-ahead-log文件
 #define BTS_EXCLUSIVE        0x0020   /* pWriter has an exclusive lock */          //pWrite独占锁
-#define BTS_PENDING          0x0040   /* Waiting for read-locks to clear */        //等待读锁清除
+#define BTS_PENDING          0x0040   /* Waiting for read-locks to clear */
+#define BTS_WARM_START       0x0080   /* Save cached page list on close */        //等待读锁清除
 
 /*
 ** An instance of the following structure is used to hold information
@@ -550,6 +556,7 @@ struct BtCursor {           //B树上的游标，游标是指向一个特定条
   u8 isIncrblobHandle;      /* True if this cursor is an incr. io handle */       //如果游标是一个incr.io句柄则为真
 #endif
   u8 hints;                             /* As configured by CursorSetHints() */   //通过CursorSetHints()设置
+  u32 nFetch;                           /* Pages loaded by moveToRoot/Child() */
   i16 iPage;                            /* Index of current page in apPage */     //当前页在apPage中的索引
   u16 aiIdx[BTCURSOR_MAX_DEPTH];        /* Current index in apPage[i] */          //apPage[i]中的当前索引。空注：单元指针数组中的当前下标。
 
@@ -3715,13 +3715,13 @@ void sqlite3BeginTransaction(Parse *pParse, int type){
   }
   v = sqlite3GetVdbe(pParse);
   if( !v ) return;   //获得VDBE引擎的支持
-  if( type!=TK_DEFERRED ){
+  if( type!=TK_DEFERRED && type!=TK_CONCURRENT ){
     for(i=0; i<db->nDb; i++){
       sqlite3VdbeAddOp2(v, OP_Transaction, i, (type==TK_EXCLUSIVE)+1);   //给VDBE引擎增加处理事务的操作OP_Transaction
       sqlite3VdbeUsesBtree(v, i);  //VDBE操作时需要使用BTree
     }
   }
-  sqlite3VdbeAddOp2(v, OP_AutoCommit, 0, 0);  //给VDBE增加自动提交事务的操作
+  sqlite3VdbeAddOp3(v, OP_AutoCommit, 0, 0, type==TK_CONCURRENT);  //给VDBE增加自动提交事务的操作
 }
 
 /*
@@ -3784,7 +3784,7 @@ void sqlite3Savepoint(Parse *pParse, int op, Token *pName){
 */
 int sqlite3OpenTempDatabase(Parse *pParse){
   sqlite3 *db = pParse->db;
-  if( db->aDb[1].pBt==0 && !pParse->explain ){
+  if( db->aDb[1].pBt==0 && (pParse->explain==0 || pParse->explain==3) ){
     int rc;
     Btree *pBt;
     static const int flags = 
@@ -4101,6 +4101,10 @@ KeyInfo *sqlite3IndexKeyinfo(Parse *pParse, Index *pIdx){
       pKey->aSortOrder[i] = pIdx->aSortOrder[i];
     }
     pKey->nField = (u16)nCol;
+    if( nCol>0 && pIdx->aiColumn[0]>=0 ){
+      Column *pCol = &pIdx->pTable->aCol[pIdx->aiColumn[0]];
+      sqlite3VdbeRecordCompareInit(pKey, pCol->affinity);
+    }
   }
 
   if( pParse->nErr ){
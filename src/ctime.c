@@ -186,6 +186,9 @@ static const char * const azCompileOpt[] = {
 #ifdef SQLITE_OMIT_AUTOVACUUM
   "OMIT_AUTOVACUUM",
 #endif
+#ifdef SQLITE_OMIT_BATCH_AGGREGATE
+  "OMIT_BATCH_AGGREGATE",
+#endif
 #ifdef SQLITE_OMIT_BETWEEN_OPTIMIZATION
   "OMIT_BETWEEN_OPTIMIZATION",
 #endif
@@ -215,6 +218,9 @@ static const char * const azCompileOpt[] = {
 #ifdef SQLITE_OMIT_COMPOUND_SELECT
   "OMIT_COMPOUND_SELECT",
 #endif
+#ifdef SQLITE_OMIT_COMPUTED_GOTO
+  "OMIT_COMPUTED_GOTO",
+#endif
 #ifdef SQLITE_OMIT_DATETIME_FUNCS
   "OMIT_DATETIME_FUNCS",
 #endif
@@ -296,6 +302,9 @@ static const char * const azCompileOpt[] = {
 #ifdef SQLITE_OMIT_SUBQUERY
   "OMIT_SUBQUERY",
 #endif
+#ifdef SQLITE_OMIT_SUPERINSTRUCTIONS
+  "OMIT_SUPERINSTRUCTIONS",
+#endif
 #ifdef SQLITE_OMIT_TCL_VARIABLE
   "OMIT_TCL_VARIABLE",
 #endif
@@ -1649,7 +1649,7 @@ int sqlite3CodeSubselect(
   }
 
 #ifndef SQLITE_OMIT_EXPLAIN
-  if( pParse->explain==2 ){
+  if( pParse->explain>=2 ){
     char *zMsg = sqlite3MPrintf(
         pParse->db, "EXECUTE %s%s SUBQUERY %d", testAddr>=0?"":"CORRELATED ",
         pExpr->op==TK_IN?"LIST":"SCALAR", pParse->iNextSelectId
@@ -1719,6 +1719,41 @@ int sqlite3IsLikeFunction(sqlite3 *db, Expr *pExpr, int *pIsNocase, char *aWc){
   return 1;
 }
 
+#ifndef SQLITE_OMIT_BATCH_AGGREGATE
+/*
+** If pDef is the built-in count(), sum(), total(), avg(), min() or max()
+** aggregate, return the BATCHAGG_* code that OP_BatchAgg uses for it.
+** Otherwise, including for application-defined functions that override
+** the built-ins, return 0.
+*/
+int sqlite3BatchAggKind(FuncDef *pDef){
+  if( pDef->xStep==countStep ) return BATCHAGG_COUNT;
+  if( pDef->xStep==sumStep ){
+    if( pDef->xFinalize==sumFinalize ) return BATCHAGG_SUM;
+    if( pDef->xFinalize==totalFinalize ) return BATCHAGG_TOTAL;
+    if( pDef->xFinalize==avgFinalize ) return BATCHAGG_AVG;
+  }
+  if( pDef->xStep==minmaxStep ){
+    /* See the comment in minmaxStep() */
+    return pDef->pUserData ? BATCHAGG_MAX : BATCHAGG_MIN;
+  }
+  return 0;
+}
+#endif /* SQLITE_OMIT_BATCH_AGGREGATE */
+
+#ifndef SQLITE_OMIT_HASH_AGGREGATE
+/*
+** Return true if pDef is the built-in count(), sum(), total() or avg()
+** aggregate. The state of these aggregates does not grow as rows are
+** added, so a GROUP BY that uses only them may be computed in a hash
+** table of bounded size. The state of min(), max() and group_concat()
+** may hold strings or blobs of any length.
+*/
+int sqlite3FixedSizeAgg(FuncDef *pDef){
+  return pDef->xStep==countStep || pDef->xStep==sumStep;
+}
+#endif /* SQLITE_OMIT_HASH_AGGREGATE */
+
 /*
 ** All all of the FuncDef structures in the aBuiltinFunc[] array above
 ** to the global function hash table.  This occurs at start-time (as
@@ -164,6 +164,10 @@ const unsigned char sqlite3CtypeMap[256] = {
 # define  SQLITE_USE_URI 0
 #endif
 
+#ifndef SQLITE_DEFAULT_PCACHE_POLICY
+# define SQLITE_DEFAULT_PCACHE_POLICY SQLITE_PCACHE_POLICY_LRU
+#endif
+
 /*
 ** The following singleton contains the global configuration for
 ** the SQLite library.
@@ -193,6 +197,7 @@ SQLITE_WSD struct Sqlite3Config sqlite3Config = { //用来存储各种字符
    0,                         /* szPage */
    0,                         /* nPage */
    0,                         /* mxParserStack */
+   SQLITE_DEFAULT_PCACHE_POLICY, /* ePcachePolicy */
    0,                         /* sharedCacheEnabled */
    /* All the rest should always be initialized to zero */ /*所有空闲都被初始化为0*/
    0,                         /* isInit */
@@ -11,7 +11,7 @@
 ******************************************************************************
 **
 ** This file contains inline asm code for retrieving "high-performance"
-** counters for x86 class CPUs.
+** counters for x86, PowerPC and ARMv8 class CPUs.
 */
 #ifndef _HWTIME_H_
 #define _HWTIME_H_
@@ -47,9 +47,9 @@
 #elif (defined(__GNUC__) && defined(__x86_64__))
 
   __inline__ sqlite_uint64 sqlite3Hwtime(void){
-      unsigned long val;
-      __asm__ __volatile__ ("rdtsc" : "=A" (val));
-      return val;
+      unsigned int lo, hi;
+      __asm__ __volatile__ ("rdtsc" : "=a" (lo), "=d" (hi));
+      return (sqlite_uint64)hi << 32 | lo;
   }
  
 #elif (defined(__GNUC__) && defined(__ppc__))
@@ -67,7 +67,15 @@
       return retval;
   }
 
-#else
+#elif (defined(__GNUC__) && defined(__aarch64__))
+
+  __inline__ sqlite_uint64 sqlite3Hwtime(void){
+      sqlite_uint64 val;
+      __asm__ __volatile__ ("mrs %0, cntvct_el0" : "=r" (val));
+      return val;
+  }
+
+#elif defined(VDBE_PROFILE) || defined(SQLITE_PERFORMANCE_TRACE)
 
   #error Need implementation of sqlite3Hwtime() for your platform.
 
@@ -80,6 +88,14 @@
   */
   sqlite_uint64 sqlite3Hwtime(void){ return ((sqlite_uint64)0); }
 
+#else
+
+  /*
+  ** The statement profiler (see vdbeprofile.c) is available on all
+  ** platforms. Where there is no cycle counter, it reports zero cycles.
+  */
+  static sqlite_uint64 sqlite3Hwtime(void){ return ((sqlite_uint64)0); }
+
 #endif
 
 #endif /* !defined(_HWTIME_H_) */
@@ -547,6 +547,19 @@ int sqlite3_config(int op, ...){
       break;
     }
 
+    case SQLITE_CONFIG_PCACHE_POLICY: {
+      /* Select the replacement policy of the built-in page cache */
+      int ePolicy = va_arg(ap, int);
+      if( ePolicy!=SQLITE_PCACHE_POLICY_LRU
+       && ePolicy!=SQLITE_PCACHE_POLICY_2Q
+      ){
+        rc = SQLITE_ERROR;
+      }else{
+        sqlite3GlobalConfig.ePcachePolicy = ePolicy;
+      }
+      break;
+    }
+
     default: {
       rc = SQLITE_ERROR;
       break;
@@ -748,6 +761,16 @@ static int binCollFunc(
   return rc;
 }
 
+/*
+** Return true if p is the BINARY collating sequence, or is NULL (which
+** the comparison routines treat the same as BINARY).  RTRIM shares its
+** comparison function with BINARY but has a non-NULL pUser, so it does
+** not qualify.
+*/
+int sqlite3IsBinary(const CollSeq *p){
+  return p==0 || (p->xCmp==binCollFunc && p->pUser==0);
+}
+
 /*
 ** Another built-in collating sequence: NOCASE. 
 **
@@ -976,6 +999,9 @@ void sqlite3LeaveMutexAndCloseZombie(sqlite3 *db){
   /* Free any outstanding Savepoint structures. */
   sqlite3CloseSavepoints(db);
 
+  /* Stop any background checkpointers before closing the databases */
+  sqlite3WalCheckpointerCloseAll(db);
+
   /* Close all database connections */
   //关闭所有的数据库连接
   for(j=0; j<db->nDb; j++){
@@ -1041,6 +1067,9 @@ void sqlite3LeaveMutexAndCloseZombie(sqlite3 *db){
   }
   sqlite3HashClear(&db->aModule);
 #endif
+#ifndef SQLITE_OMIT_STMT_PROFILE
+  sqlite3VdbeProfileClear(db);
+#endif
 
   sqlite3Error(db, SQLITE_OK, 0); /* Deallocates any cached error strings. 释放任何错误的字符串缓存*/
   if( db->pErr ){
@@ -1103,6 +1132,7 @@ void sqlite3RollbackAll(sqlite3 *db, int tripCode){
   /* Any deferred constraint violations have now been resolved. */
   //何延迟约束违反已被解决
   db->nDeferredCons = 0;
+  db->bConcurrent = 0;
 
   /* If one has been configured, invoke the rollback-hook callback */
   //如果已经被定义，调用回滚的回调函数
@@ -1607,7 +1637,9 @@ int sqlite3WalDefaultHook(
   const char *zDb,       /* Database */                                        /*数据库*/
   int nFrame             /* Size of WAL */                                     /*WAL的大小*/
 ){
-  if( nFrame>=SQLITE_PTR_TO_INT(pClientData) ){
+  if( nFrame>=SQLITE_PTR_TO_INT(pClientData)
+   && !sqlite3WalCheckpointerWake(db, zDb, nFrame)
+  ){
     sqlite3BeginBenignMalloc();                                                /*开始分配内存*/
     sqlite3_wal_checkpoint(db, zDb);                                           /*检查指针*/
     sqlite3EndBenignMalloc();                                                  /*分配内存结束*/
@@ -1986,6 +2018,7 @@ static const int aHardLimit[] = {
   SQLITE_MAX_LIKE_PATTERN_LENGTH,
   SQLITE_MAX_VARIABLE_NUMBER,
   SQLITE_MAX_TRIGGER_DEPTH,
+  SQLITE_MAX_WORKER_THREADS,
 };
 
 /*
@@ -2021,6 +2054,9 @@ static const int aHardLimit[] = {
 #if SQLITE_MAX_TRIGGER_DEPTH<1
 # error SQLITE_MAX_TRIGGER_DEPTH must be at least 1
 #endif
+#if SQLITE_MAX_WORKER_THREADS<0 || SQLITE_MAX_WORKER_THREADS>50
+# error SQLITE_MAX_WORKER_THREADS must be between 0 and 50
+#endif
 
 
 /*
@@ -2054,7 +2090,8 @@ int sqlite3_limit(sqlite3 *db, int limitId, int newLimit){                     /
                                                SQLITE_MAX_LIKE_PATTERN_LENGTH );
   assert( aHardLimit[SQLITE_LIMIT_VARIABLE_NUMBER]==SQLITE_MAX_VARIABLE_NUMBER);
   assert( aHardLimit[SQLITE_LIMIT_TRIGGER_DEPTH]==SQLITE_MAX_TRIGGER_DEPTH );
-  assert( SQLITE_LIMIT_TRIGGER_DEPTH==(SQLITE_N_LIMIT-1) );
+  assert( aHardLimit[SQLITE_LIMIT_WORKER_THREADS]==SQLITE_MAX_WORKER_THREADS );
+  assert( SQLITE_LIMIT_WORKER_THREADS==(SQLITE_N_LIMIT-1) );
 
 
   if( limitId<0 || limitId>=SQLITE_N_LIMIT ){
@@ -2401,6 +2438,7 @@ static int openDatabase(
 
   assert( sizeof(db->aLimit)==sizeof(aHardLimit) );
   memcpy(db->aLimit, aHardLimit, sizeof(db->aLimit));
+  db->aLimit[SQLITE_LIMIT_WORKER_THREADS] = SQLITE_DEFAULT_WORKER_THREADS;
   db->autoCommit = 1;
   db->nextAutovac = -1;
   db->nextPagesize = 0;
@@ -2422,6 +2460,9 @@ static int openDatabase(
 #ifndef SQLITE_OMIT_VIRTUALTABLE
   sqlite3HashInit(&db->aModule);
 #endif
+#ifndef SQLITE_OMIT_STMT_PROFILE
+  sqlite3HashInit(&db->aStmtProfile);
+#endif
 
   /* Add the default collation sequence BINARY. BINARY works for both UTF-8
   ** and UTF-16, so add a version for each to avoid any unnecessary
@@ -2528,6 +2569,12 @@ static int openDatabase(
   }
 #endif
 
+#ifndef SQLITE_OMIT_STMT_PROFILE
+  if( !db->mallocFailed && rc==SQLITE_OK ){
+    rc = sqlite3VdbeProfileInit(db);
+  }
+#endif
+
   sqlite3Error(db, rc, 0);
 
   /* -DSQLITE_DEFAULT_LOCKING_MODE=1 makes EXCLUSIVE the default locking
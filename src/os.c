@@ -163,6 +163,27 @@ int sqlite3OsShmMap(
   return id->pMethods->xShmMap(id, iPage, pgsz, bExtend, pp);
 }
 
+/*
+** Attempt to obtain a pointer directly into the file content for iAmt
+** bytes at offset iOff.  If the VFS does not support xFetch(), or if it
+** declines the request, *pp is set to NULL and SQLITE_OK returned.  The
+** caller must then read the data using sqlite3OsRead() instead.
+*/
+int sqlite3OsFetch(sqlite3_file *id, i64 iOff, int iAmt, void **pp){
+  DO_OS_MALLOC_TEST(id);
+  if( id->pMethods->iVersion<3 || id->pMethods->xFetch==0 ){
+    *pp = 0;
+    return SQLITE_OK;
+  }
+  return id->pMethods->xFetch(id, iOff, iAmt, pp);
+}
+int sqlite3OsUnfetch(sqlite3_file *id, i64 iOff, void *p){
+  if( id->pMethods->iVersion<3 || id->pMethods->xUnfetch==0 ){
+    return SQLITE_OK;
+  }
+  return id->pMethods->xUnfetch(id, iOff, p);
+}
+
 /*
 ** The next group of routines are convenience wrappers around the
 ** VFS methods.
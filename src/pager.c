@@ -36,12 +36,16 @@ int sqlite3PagerSetJournalMode(Pager *, int);
 int sqlite3PagerGetJournalMode(Pager*);
 int sqlite3PagerOkToChangeJournalMode(Pager*);
 i64 sqlite3PagerJournalSizeLimit(Pager *, i64);
+void sqlite3PagerMmapLimit(Pager *, sqlite3_int64);
 sqlite3_backup **sqlite3PagerBackupPtr(Pager*);
 
 /* Functions used to obtain and release page references. */ 
-int sqlite3PagerAcquire(Pager *pPager, Pgno pgno, DbPage **ppPage, int clrFlag);
+int sqlite3PagerAcquire(Pager *pPager, Pgno pgno, DbPage **ppPage, int flags);
 #define sqlite3PagerGet(A,B,C) sqlite3PagerAcquire(A,B,C,0)
 DbPage *sqlite3PagerLookup(Pager *pPager, Pgno pgno);
+void sqlite3PagerPrefetch(Pager *pPager, const Pgno *aPgno, int nPgno);
+void sqlite3PagerWarmSave(Pager *pPager, const u8 *aHdr);
+int sqlite3PagerWarmLoad(Pager *pPager, Pgno **paPgno, int *pnPgno, u8 *aHdr);
 void sqlite3PagerRef(DbPage*);
 void sqlite3PagerUnref(DbPage*);
 
@@ -68,7 +72,7 @@ int sqlite3PagerSharedLock(Pager *pPager);
 int sqlite3PagerCheckpoint(Pager *pPager, int, int*, int*);
 int sqlite3PagerWalSupported(Pager *pPager);
 int sqlite3PagerWalCallback(Pager *pPager);
-int sqlite3PagerOpenWal(Pager *pPager, int *pisOpen);
+int sqlite3PagerOpenWal(Pager *pPager, int bWal2, int *pisOpen);
 int sqlite3PagerCloseWal(Pager *pPager);
 #ifdef SQLITE_ENABLE_ZIPVFS
   int sqlite3PagerWalFramesize(Pager *pPager);
@@ -112,6 +116,110 @@ void *sqlite3PagerCodec(DbPage *);
 
 #endif /* _PAGER_H_ */
 
+/*
+** The USEFETCH(pPager) macro is true if pages of the database file may
+** be read directly out of a memory mapping of the file (see xFetch in
+** sqlite3_io_methods), rather than copied into the page cache.
+*/
+#if SQLITE_MAX_MMAP_SIZE>0
+# define USEFETCH(x) ((x)->bUseFetch)
+#else
+# define USEFETCH(x) 0
+#endif
+
+/*
+** Invoke SQLITE_FCNTL_MMAP_SIZE based on the current value of szMmap.
+** The VFS may clamp the limit, so Pager.bUseFetch is only set if the
+** file supports xFetch (iVersion 3 or greater) and the limit is non-zero.
+*/
+static void pagerFixMaplimit(Pager *pPager){
+#if SQLITE_MAX_MMAP_SIZE>0
+  sqlite3_file *fd = pPager->fd;
+  if( isOpen(fd) && fd->pMethods->iVersion>=3 ){
+    sqlite3_int64 sz;
+    sz = pPager->szMmap;
+    pPager->bUseFetch = (sz>0);
+    sqlite3OsFileControlHint(pPager->fd, SQLITE_FCNTL_MMAP_SIZE, &sz);
+  }
+#else
+  UNUSED_PARAMETER(pPager);
+#endif
+}
+
+/*
+** Obtain a page handle for page pgno whose content is the memory mapped
+** buffer pData. Page handles are recycled through Pager.pMmapFreelist,
+** linked by their pDirty field, so that a scan of a mapped file does not
+** allocate a new PgHdr for every page.
+**
+** If an error occurs, SQLITE_NOMEM is returned and the xFetch reference
+** to pData is released before returning.
+*/
+static int pagerAcquireMapPage(
+  Pager *pPager,                  /* Pager object */
+  Pgno pgno,                      /* Page number */
+  void *pData,                    /* xFetch()'d data for this page */
+  PgHdr **ppPage                  /* OUT: Acquired page object */
+){
+  PgHdr *p;                       /* Memory mapped page to return */
+
+  if( pPager->pMmapFreelist ){
+    *ppPage = p = pPager->pMmapFreelist;
+    pPager->pMmapFreelist = p->pDirty;
+    p->pDirty = 0;
+    memset(p->pExtra, 0, pPager->nExtra);
+  }else{
+    *ppPage = p = (PgHdr *)sqlite3MallocZero(sizeof(PgHdr) + pPager->nExtra);
+    if( p==0 ){
+      sqlite3OsUnfetch(pPager->fd, (i64)(pgno-1) * pPager->pageSize, pData);
+      return SQLITE_NOMEM;
+    }
+    p->pExtra = (void *)&p[1];
+    p->flags = PGHDR_MMAP;
+    p->nRef = 1;
+    p->pPager = pPager;
+  }
+
+  assert( p->pExtra==(void *)&p[1] );
+  assert( p->pPage==0 );
+  assert( p->flags==PGHDR_MMAP );
+  assert( p->pPager==pPager );
+  assert( p->nRef==1 );
+
+  p->pgno = pgno;
+  p->pData = pData;
+  pPager->nMmapOut++;
+
+  return SQLITE_OK;
+}
+
+/*
+** Release a reference to page pPg. pPg must have been returned by an 
+** earlier call to pagerAcquireMapPage().
+*/
+static void pagerReleaseMapPage(PgHdr *pPg){
+  Pager *pPager = pPg->pPager;
+  pPager->nMmapOut--;
+  pPg->pDirty = pPager->pMmapFreelist;
+  pPager->pMmapFreelist = pPg;
+
+  assert( pPager->fd->pMethods->iVersion>=3 );
+  sqlite3OsUnfetch(pPager->fd, (i64)(pPg->pgno-1)*pPager->pageSize, pPg->pData);
+}
+
+/*
+** Free all PgHdr objects stored in the Pager.pMmapFreelist list.
+*/
+static void pagerFreeMapHdrs(Pager *pPager){
+  PgHdr *p;
+  PgHdr *pNext;
+  for(p=pPager->pMmapFreelist; p; p=pNext){
+    pNext = p->pDirty;
+    sqlite3_free(p);
+  }
+  pPager->pMmapFreelist = 0;
+}
+
 /*
 ** Allocate and initialize a new Pager object and put a pointer to it
 ** in *ppPager. The pager should eventually be freed by passing it
@@ -473,7 +581,10 @@ else{
   /* pPager->pLast = 0; */
   pPager->nExtra = (u16)nExtra;
   pPager->journalSizeLimit = SQLITE_DEFAULT_JOURNAL_SIZE_LIMIT;
+  pPager->iGroupCommit = -1;
   assert( isOpen(pPager->fd) || tempFile );
+  pPager->szMmap = SQLITE_DEFAULT_MMAP_SIZE;
+  pagerFixMaplimit(pPager);
   setSectorSize(pPager);
   if( !useJournal ){
     pPager->journalMode = PAGER_JOURNALMODE_OFF;
@@ -490,6 +601,18 @@ else{
 }
 
 
+/*
+** Stop tracking the pages read by a BEGIN CONCURRENT transaction, if one
+** was open.
+*/
+static void pagerEndConcurrent(Pager *pPager){
+  if( pPager->pAllRead ){
+    sqlite3BitvecDestroy(pPager->pAllRead);
+    pPager->pAllRead = 0;
+    pPager->doNotSpill = pPager->doNotSpillSaved;
+  }
+}
+
 /*
 ** Shutdown the page cache.  Free all memory and close all files.
 **
@@ -524,6 +647,7 @@ int sqlite3PagerClose(Pager *pPager){
   pPager->pWal = 0;
 #endif
   pager_reset(pPager);
+  pagerEndConcurrent(pPager);
   if( MEMDB ){
     pager_unlock(pPager);
   }else{
@@ -555,6 +679,8 @@ int sqlite3PagerClose(Pager *pPager){
   enable_simulated_io_errors();
   PAGERTRACE(("CLOSE %d\n", PAGERID(pPager)));
   IOTRACE(("CLOSE %p\n", pPager))
+  assert( pPager->nMmapOut==0 );
+  pagerFreeMapHdrs(pPager);
   sqlite3OsClose(pPager->jfd);
   sqlite3OsClose(pPager->fd);
   sqlite3PageFree(pTmp);
@@ -858,6 +984,7 @@ int sqlite3PagerLockingMode(Pager *pPager, int eMode){
 **    PAGER_JOURNALMODE_OFF
 **    PAGER_JOURNALMODE_MEMORY
 **    PAGER_JOURNALMODE_WAL
+**    PAGER_JOURNALMODE_WAL2
 **
 ** The journalmode is set to the value specified if the change is allowed.
 ** The change may be disallowed for the following reasons:
@@ -901,6 +1028,7 @@ int sqlite3PagerSetJournalMode(Pager *pPager, int eMode){
             || eMode==PAGER_JOURNALMODE_PERSIST
             || eMode==PAGER_JOURNALMODE_OFF 
             || eMode==PAGER_JOURNALMODE_WAL 
+            || eMode==PAGER_JOURNALMODE_WAL2 
             || eMode==PAGER_JOURNALMODE_MEMORY );
 
   /* This routine is only called from the OP_JournalMode opcode, and
@@ -908,7 +1036,7 @@ int sqlite3PagerSetJournalMode(Pager *pPager, int eMode){
   ** to WAL mode.
   */
 //��������ֻ��OP_JournalMode�������е��ã����Ҷ���Ԥд��־�����С���Զ������һ����ʱ�ļ��ı䡱���߼���
-  assert( pPager->tempFile==0 || eMode!=PAGER_JOURNALMODE_WAL );
+  assert( pPager->tempFile==0 || !isWalMode(eMode) );
 
   /* Do allow the journalmode of an in-memory database to be set to
   ** anything other than MEMORY or OFF
@@ -929,8 +1057,9 @@ int sqlite3PagerSetJournalMode(Pager *pPager, int eMode){
     pPager->journalMode = (u8)eMode;
 
     /* When transistioning from TRUNCATE or PERSIST to any other journal
-    ** mode except WAL, unless the pager is in locking_mode=exclusive mode,
-    ** delete the journal file.
+    ** mode except WAL or WAL2, unless the pager is in locking_mode=exclusive
+    ** mode, delete the journal file. WAL2 does not fit the bit pattern
+    ** tested below, so it is excluded explicitly.
     */
 //����truncate����persistת�����κγ�wal֮����������־ģʽ������ҳ��������ģʽ=����ģʽ�У�ɾ����־�ļ���
     assert( (PAGER_JOURNALMODE_TRUNCATE & 5)==1 );
@@ -941,7 +1070,9 @@ int sqlite3PagerSetJournalMode(Pager *pPager, int eMode){
     assert( (PAGER_JOURNALMODE_WAL & 5)==5 );
 
     assert( isOpen(pPager->fd) || pPager->exclusiveMode );
-    if( !pPager->exclusiveMode && (eOld & 5)==1 && (eMode & 1)==0 ){
+    if( !pPager->exclusiveMode && (eOld & 5)==1 && (eMode & 1)==0
+     && eMode!=PAGER_JOURNALMODE_WAL2
+    ){
 
       /* In this case we would like to delete the journal file. If it is
       ** not possible, then that is not a problem. Deleting the journal file
@@ -1028,6 +1159,15 @@ i64 sqlite3PagerJournalSizeLimit(Pager *pPager, i64 iLimit){
   return pPager->journalSizeLimit;
 }
 
+/*
+** Set the maximum number of bytes of the database file that may be
+** accessed through a memory mapping. See also "PRAGMA mmap_size".
+*/
+void sqlite3PagerMmapLimit(Pager *pPager, sqlite3_int64 szMmap){
+  pPager->szMmap = szMmap;
+  pagerFixMaplimit(pPager);
+}
+
 /*
 ** Return a pointer to the pPager->pBackup variable. The backup module
 ** in backup.c maintains the content of this variable. This module
@@ -1111,17 +1251,35 @@ int sqlite3PagerAcquire(
   Pager *pPager,      /* The pager open on the database file ��ҳ���������ݿ��ļ�����*/
   Pgno pgno,          /* Page number to fetch   ��ȡҳ��*/
   DbPage **ppPage,    /* Write a pointer to the page here дһ��ָ��ָ��������ҳ��*/
-  int noContent       /* Do not bother reading content from disk if true  ����Ϊ�治Ҫ�жϴӴ��̶�ȡ����*/
+  int flags           /* PAGER_ACQUIRE_XXX flags */
 ){
-  int rc;
-  PgHdr *pPg;
+  int rc = SQLITE_OK;
+  PgHdr *pPg = 0;
+  u32 iFrame = 0;                 /* Frame to read from WAL file */
+  const int noContent = (flags & PAGER_ACQUIRE_NOCONTENT);
+
+  /* It is acceptable to use a read-only (mmap) page for any page except
+  ** page 1 if there is no write-transaction open or the ACQUIRE_READONLY
+  ** flag was specified by the caller. And so long as the db is not a 
+  ** temporary or in-memory database.  */
+  const int bMmapOk = (pgno!=1 && USEFETCH(pPager)
+   && (pPager->eState==PAGER_READER || (flags & PAGER_ACQUIRE_READONLY))
+#ifdef SQLITE_HAS_CODEC
+   && pPager->xCodec==0
+#endif
+  );
 
   assert( pPager->eState>=PAGER_READER );
   assert( assert_pager_state(pPager) );
+  assert( noContent==0 || bMmapOk==0 );
 
   if( pgno==0 ){
     return SQLITE_CORRUPT_BKPT;
   }
+  if( pPager->pAllRead ){
+    rc = sqlite3BitvecSet(pPager->pAllRead, pgno);
+    if( rc!=SQLITE_OK ) return rc;
+  }
 
   /* If the pager is in the error state, return an error immediately. 
   ** Otherwise, request the page from the PCache layer. 
@@ -1129,6 +1287,41 @@ int sqlite3PagerAcquire(
   if( pPager->errCode!=SQLITE_OK ){
     rc = pPager->errCode;
   }else{
+
+    if( bMmapOk && pagerUseWal(pPager) ){
+      rc = sqlite3WalFindFrame(pPager->pWal, pgno, &iFrame);
+      if( rc!=SQLITE_OK ) goto pager_acquire_err;
+    }
+
+    if( iFrame==0 && bMmapOk && pgno<=pPager->dbSize ){
+      void *pData = 0;
+
+      rc = sqlite3OsFetch(pPager->fd, 
+          (i64)(pgno-1) * pPager->pageSize, pPager->pageSize, &pData
+      );
+
+      if( rc==SQLITE_OK && pData ){
+        if( pPager->eState>PAGER_READER
+         && sqlite3PcachePeek(pPager->pPCache, pgno)
+        ){
+          (void)sqlite3PcacheFetch(pPager->pPCache, pgno, 0, &pPg);
+        }
+        if( pPg==0 ){
+          rc = pagerAcquireMapPage(pPager, pgno, pData, &pPg);
+        }else{
+          sqlite3OsUnfetch(pPager->fd, (i64)(pgno-1)*pPager->pageSize, pData);
+        }
+        if( pPg ){
+          assert( rc==SQLITE_OK );
+          *ppPage = pPg;
+          return SQLITE_OK;
+        }
+      }
+      if( rc!=SQLITE_OK ){
+        goto pager_acquire_err;
+      }
+    }
+
     rc = sqlite3PcacheFetch(pPager->pPCache, pgno, 1, ppPage);
   }
 
@@ -1238,10 +1431,254 @@ DbPage *sqlite3PagerLookup(Pager *pPager, Pgno pgno){
   assert( pgno!=0 );
   assert( pPager->pPCache!=0 );
   assert( pPager->eState>=PAGER_READER && pPager->eState!=PAGER_ERROR );
-  sqlite3PcacheFetch(pPager->pPCache, pgno, 0, &pPg);
+  if( sqlite3PcachePeek(pPager->pPCache, pgno) ){
+    sqlite3PcacheFetch(pPager->pPCache, pgno, 0, &pPg);
+  }
   return pPg;
 }
 
+/*
+** Hint to the pager that the pages in array aPgno[] are likely to be
+** requested soon. Pages that are already in the cache, that lie beyond
+** the end of the database image or that will be read from the WAL are
+** ignored. For the remainder, runs of consecutive page numbers are
+** coalesced and passed to the VFS as SQLITE_FCNTL_READAHEAD hints so
+** that the operating system can begin reading them asynchronously.
+**
+** This routine never reads any data itself and never fails. It is a
+** no-op for in-memory and temporary databases.
+*/
+void sqlite3PagerPrefetch(Pager *pPager, const Pgno *aPgno, int nPgno){
+  i64 aRange[2];                  /* Offset and size of pending hint */
+  Pgno iPrev = 0;                 /* Last page added to aRange[] */
+  int i;
+
+  assert( pPager->eState>=PAGER_READER && pPager->eState!=PAGER_ERROR );
+  if( MEMDB || pPager->tempFile || !isOpen(pPager->fd) ) return;
+
+  aRange[0] = aRange[1] = 0;
+  for(i=0; i<nPgno; i++){
+    Pgno pgno = aPgno[i];
+
+    if( pgno==0 || pgno>pPager->dbSize ) continue;
+    if( sqlite3PcachePeek(pPager->pPCache, pgno) ) continue;
+    if( pagerUseWal(pPager) ){
+      u32 iFrame = 0;
+      if( sqlite3WalFindFrame(pPager->pWal, pgno, &iFrame) || iFrame ){
+        continue;
+      }
+    }
+
+    if( iPrev && pgno==iPrev+1 ){
+      aRange[1] += pPager->pageSize;
+    }else{
+      if( aRange[1] ){
+        sqlite3OsFileControlHint(pPager->fd, SQLITE_FCNTL_READAHEAD, aRange);
+      }
+      aRange[0] = (i64)(pgno-1) * pPager->pageSize;
+      aRange[1] = pPager->pageSize;
+    }
+    iPrev = pgno;
+  }
+  if( aRange[1] ){
+    sqlite3OsFileControlHint(pPager->fd, SQLITE_FCNTL_READAHEAD, aRange);
+  }
+}
+
+/*
+** The warm-start sidecar file written by sqlite3PagerWarmSave() and read
+** by sqlite3PagerWarmLoad() has the name of the database file with the
+** suffix "-warm" appended. Its format is as follows (all integers are
+** 4-byte big-endian):
+**
+**     0: Magic number (PAGER_WARM_MAGIC)
+**     4: Page size of the database
+**     8: Bytes 24 through 31 of page 1 (change counter and database size)
+**    16: Number of page numbers that follow (N)
+**    20: N page numbers in ascending order
+*/
+#define PAGER_WARM_MAGIC  0x5157a3d1
+#define PAGER_WARM_HDRSZ  20
+
+/*
+** Sort the n page numbers in a[] into ascending order. aTmp[] must have
+** room for n page numbers; it is used as scratch space.
+*/
+static void pagerSortPgno(Pgno *a, Pgno *aTmp, int n){
+  int w;                          /* Width of the runs being merged */
+  for(w=1; w<n; w*=2){
+    int i;
+    for(i=0; i<n; i+=2*w){
+      int iLeft = i;
+      int iMid = MIN(i+w, n);
+      int iRight = iMid;
+      int iEnd = MIN(i+2*w, n);
+      int k;
+      for(k=i; k<iEnd; k++){
+        if( iRight>=iEnd || (iLeft<iMid && a[iLeft]<=a[iRight]) ){
+          aTmp[k] = a[iLeft++];
+        }else{
+          aTmp[k] = a[iRight++];
+        }
+      }
+    }
+    memcpy(a, aTmp, n*sizeof(Pgno));
+  }
+}
+
+/*
+** Write the page numbers of all pages currently held in the page cache
+** to the warm-start sidecar file of the database, so that the next
+** process to open the database can ask the OS to read them ahead (see
+** sqlite3PagerWarmLoad()). aHdr[] holds bytes 24 through 31 of page 1
+** (the change counter and size) as the caller last saw them. They are
+** recorded in the header of the sidecar.
+**
+** The page numbers are obtained by listing the pages resident in the
+** cache, so the cost depends on the size of the cache and not on the
+** size of the database. If the page cache in use cannot list its pages
+** (an application-defined cache), no sidecar is written.
+**
+** This is called by the b-tree layer just before sqlite3PagerClose(),
+** when no locks are held, so nothing is read from the database file.
+** Errors are not reported; the sidecar is only a hint.
+*/
+void sqlite3PagerWarmSave(Pager *pPager, const u8 *aHdr){
+  u8 *aBuf;                       /* Content of the sidecar file */
+  Pgno *aPgno;                    /* Resident pages, then scratch space */
+  char *zWarm;                    /* Name of the sidecar file */
+  sqlite3_file *pFile = 0;        /* The open sidecar file */
+  int nMax;                       /* Number of pages in the cache */
+  int nRes;                       /* Number of entries of aPgno[] used */
+  int nPgno = 0;                  /* Number of page numbers in aBuf[] */
+  int i;
+  int rc;
+
+  if( MEMDB || pPager->tempFile || pPager->dbSize==0 ) return;
+  nMax = sqlite3PcachePagecount(pPager->pPCache);
+  if( nMax==0 ) return;
+
+  sqlite3BeginBenignMalloc();
+  aBuf = (u8 *)sqlite3Malloc(PAGER_WARM_HDRSZ + 4*nMax);
+  aPgno = (Pgno *)sqlite3Malloc(2*sizeof(Pgno)*nMax);
+  zWarm = sqlite3_mprintf("%s-warm", pPager->zFilename);
+  if( aBuf && aPgno && zWarm
+   && (nRes = sqlite3PcacheResident(pPager->pPCache, aPgno, nMax))>0
+  ){
+    pagerSortPgno(aPgno, &aPgno[nMax], nRes);
+    sqlite3Put4byte(&aBuf[0], PAGER_WARM_MAGIC);
+    sqlite3Put4byte(&aBuf[4], pPager->pageSize);
+    memcpy(&aBuf[8], aHdr, 8);
+    for(i=0; i<nRes && aPgno[i]<=pPager->dbSize; i++){
+      if( aPgno[i]==0 ) continue;
+      sqlite3Put4byte(&aBuf[PAGER_WARM_HDRSZ + 4*nPgno], aPgno[i]);
+      nPgno++;
+    }
+    sqlite3Put4byte(&aBuf[16], nPgno);
+
+    /* The sidecar is opened as a temporary database, not as a journal, so
+    ** that VFSes do not apply journal handling (such as deleting it or
+    ** treating it as a hot journal) to it. */
+    rc = sqlite3OsOpenMalloc(pPager->pVfs, zWarm, &pFile,
+        SQLITE_OPEN_READWRITE|SQLITE_OPEN_CREATE|SQLITE_OPEN_TEMP_DB, 0
+    );
+    if( rc==SQLITE_OK ){
+      i64 nByte = PAGER_WARM_HDRSZ + 4*(i64)nPgno;
+      rc = sqlite3OsWrite(pFile, aBuf, (int)nByte, 0);
+      if( rc==SQLITE_OK ) sqlite3OsTruncate(pFile, nByte);
+      sqlite3OsCloseFree(pFile);
+    }
+  }
+  sqlite3_free(zWarm);
+  sqlite3_free(aPgno);
+  sqlite3_free(aBuf);
+  sqlite3EndBenignMalloc();
+}
+
+/*
+** Read the warm-start sidecar file of the database, if there is one.
+** If it is well-formed and was written for a database with the current
+** page size, set *paPgno to point to an array of the *pnPgno page numbers
+** it contains (in ascending order, so in file-offset order) and copy the
+** 8 bytes of page 1 recorded with it into aHdr[]. The caller must free
+** *paPgno using sqlite3_free().
+**
+** The caller is expected to compare aHdr[] with bytes 24 through 31 of
+** page 1 once a read transaction is open, and to pass the array to
+** sqlite3PagerPrefetch() only if they match. Otherwise the list belongs
+** to an older version of the database and should be discarded.
+**
+** Missing, unreadable or malformed sidecar files are silently ignored:
+** *paPgno is set to NULL and SQLITE_OK returned. SQLITE_NOMEM is
+** returned if a malloc fails.
+*/
+int sqlite3PagerWarmLoad(Pager *pPager, Pgno **paPgno, int *pnPgno, u8 *aHdr){
+  int rc = SQLITE_OK;
+  char *zWarm;                    /* Name of the sidecar file */
+  sqlite3_file *pFile = 0;        /* The open sidecar file */
+  int bExists = 0;                /* True if the sidecar file exists */
+  u8 aFileHdr[PAGER_WARM_HDRSZ];  /* Header read from the sidecar file */
+  u8 *aBuf = 0;                   /* Page number array read from the file */
+  Pgno *aPgno = 0;                /* Decoded page numbers */
+  i64 nByte = 0;                  /* Size of the sidecar file */
+  int nPgno;
+  int i;
+
+  *paPgno = 0;
+  *pnPgno = 0;
+  if( MEMDB || pPager->tempFile ) return SQLITE_OK;
+
+  zWarm = sqlite3_mprintf("%s-warm", pPager->zFilename);
+  if( zWarm==0 ) return SQLITE_NOMEM;
+  if( sqlite3OsAccess(pPager->pVfs, zWarm, SQLITE_ACCESS_EXISTS, &bExists)
+   || bExists==0
+   || sqlite3OsOpenMalloc(pPager->pVfs, zWarm, &pFile,
+          SQLITE_OPEN_READONLY|SQLITE_OPEN_TEMP_DB, 0)
+  ){
+    sqlite3_free(zWarm);
+    return SQLITE_OK;
+  }
+  sqlite3_free(zWarm);
+
+  if( sqlite3OsFileSize(pFile, &nByte)
+   || nByte<PAGER_WARM_HDRSZ
+   || sqlite3OsRead(pFile, aFileHdr, PAGER_WARM_HDRSZ, 0)
+   || sqlite3Get4byte(&aFileHdr[0])!=PAGER_WARM_MAGIC
+   || sqlite3Get4byte(&aFileHdr[4])!=(u32)pPager->pageSize
+  ){
+    goto warm_load_out;
+  }
+  nPgno = (int)sqlite3Get4byte(&aFileHdr[16]);
+  if( nPgno<=0 || nByte!=PAGER_WARM_HDRSZ + 4*(i64)nPgno ){
+    goto warm_load_out;
+  }
+
+  aBuf = (u8 *)sqlite3Malloc(4*nPgno);
+  aPgno = (Pgno *)sqlite3Malloc(sizeof(Pgno)*nPgno);
+  if( aBuf==0 || aPgno==0 ){
+    rc = SQLITE_NOMEM;
+    goto warm_load_out;
+  }
+  if( sqlite3OsRead(pFile, aBuf, 4*nPgno, PAGER_WARM_HDRSZ) ){
+    goto warm_load_out;
+  }
+  for(i=0; i<nPgno; i++){
+    aPgno[i] = sqlite3Get4byte(&aBuf[4*i]);
+    if( aPgno[i]==0 || (i>0 && aPgno[i]<=aPgno[i-1]) ) goto warm_load_out;
+  }
+
+  memcpy(aHdr, &aFileHdr[8], 8);
+  *paPgno = aPgno;
+  *pnPgno = nPgno;
+  aPgno = 0;
+
+warm_load_out:
+  sqlite3_free(aPgno);
+  sqlite3_free(aBuf);
+  sqlite3OsCloseFree(pFile);
+  return rc;
+}
+
 /*
 ** Increment the reference count for page pPg.
 */
@@ -1266,7 +1703,11 @@ void sqlite3PagerRef(DbPage *pPg){
 void sqlite3PagerUnref(DbPage *pPg){
   if( pPg ){
     Pager *pPager = pPg->pPager;
-    sqlite3PcacheRelease(pPg);
+    if( pPg->flags & PGHDR_MMAP ){
+      pagerReleaseMapPage(pPg);
+    }else{
+      sqlite3PcacheRelease(pPg);
+    }
     pagerUnlockIfUnused(pPager);
   }
 }
@@ -1299,6 +1740,8 @@ int sqlite3PagerWrite(DbPage *pDbPage){
   Pager *pPager = pPg->pPager;
   Pgno nPagePerSector = (pPager->sectorSize/pPager->pageSize);
 
+  assert( (pPg->flags & PGHDR_MMAP)==0 );
+
   assert( pPager->eState>=PAGER_WRITER_LOCKED );
   assert( pPager->eState!=PAGER_ERROR );
   assert( assert_pager_state(pPager) );
@@ -1685,7 +2128,14 @@ int sqlite3PagerBegin(Pager *pPager, int exFlag, int subjInMemory){
           ����־�ļ���ȡд���������ɹ������µ�PAGER_RESERVED״̬�����򣬸������߷���һ����������
           ������һ�������Ѿ�����д������ôæ���󲢲��ᱻ���ѡ��������ܣ���һ����������*/
           
-      rc = sqlite3WalBeginWriteTransaction(pPager->pWal);
+      if( pPager->pAllRead ){
+        /* In a BEGIN CONCURRENT transaction the write lock is not taken
+        ** until commit. Until then, dirty pages must not be spilled into
+        ** the WAL. */
+        pPager->doNotSpill = 1;
+      }else{
+        rc = sqlite3WalBeginWriteTransaction(pPager->pWal);
+      }
     }else{
       /* Obtain a RESERVED lock on the database file. If the exFlag parameter
       ** is true, then immediately upgrade this to an EXCLUSIVE lock. The
@@ -1729,6 +2179,79 @@ int sqlite3PagerBegin(Pager *pPager, int exFlag, int subjInMemory){
   return rc;
 }
 
+/*
+** Begin or end tracking the pages read by a BEGIN CONCURRENT transaction.
+** This is called as each transaction on the pager is opened, with 
+** isConcurrent set to true if it is a BEGIN CONCURRENT transaction. If
+** the pager is not in WAL mode the transaction runs as an ordinary
+** deferred transaction instead.
+*/
+int sqlite3PagerBeginConcurrent(Pager *pPager, int isConcurrent){
+  pagerEndConcurrent(pPager);
+  if( isConcurrent && pagerUseWal(pPager) ){
+    pPager->pAllRead = sqlite3BitvecCreate(pPager->mxPgno);
+    if( pPager->pAllRead==0 ) return SQLITE_NOMEM;
+    pPager->doNotSpillSaved = pPager->doNotSpill;
+  }
+  return SQLITE_OK;
+}
+
+/*
+** Invoked by sqlite3WalLockForCommit() for each page written by a commit
+** that the snapshot of a BEGIN CONCURRENT transaction has just moved past.
+** A clean cached copy of such a page is out of date: drop it if nothing
+** else refers to it, otherwise reread it from the new snapshot. Dirty
+** pages hold this transaction's own changes and are left alone.
+*/
+static int pagerConcurrentReload(void *pCtx, Pgno iPg){
+  Pager *pPager = (Pager *)pCtx;
+  PgHdr *pPg;
+  int rc = SQLITE_OK;
+
+  pPg = pager_lookup(pPager, iPg);
+  if( pPg ){
+    if( (pPg->flags & PGHDR_DIRTY)==0 && sqlite3PcachePageRefcount(pPg)==1 ){
+      sqlite3PcacheDrop(pPg);
+      return SQLITE_OK;
+    }
+    if( (pPg->flags & PGHDR_DIRTY)==0 ){
+      rc = readDbPage(pPg);
+      if( rc==SQLITE_OK ){
+        pPager->xReiniter(pPg);
+      }
+    }
+    sqlite3PagerUnref(pPg);
+  }
+  return rc;
+}
+
+/*
+** Take the WAL write lock to commit a BEGIN CONCURRENT transaction, and
+** check that no page it read has been modified since its snapshot was
+** opened. See sqlite3WalLockForCommit() for details.
+*/
+static int pagerLockForConcurrentCommit(Pager *pPager){
+  PgHdr *pPg1 = pager_lookup(pPager, 1);
+  const u8 *aPage1 = 0;
+  u32 nPage = 0;
+  int rc;
+
+  if( pPg1 && (pPg1->flags & PGHDR_DIRTY)==0 ){
+    aPage1 = (const u8 *)pPg1->pData;
+  }
+  rc = sqlite3WalLockForCommit(pPager->pWal, pPager->pAllRead, aPage1, &nPage,
+                               pagerConcurrentReload, (void *)pPager);
+  if( pPg1 ) sqlite3PagerUnref(pPg1);
+
+  /* If the snapshot moved forward and this transaction did not modify 
+  ** page 1, it did not change the size of the database either. So the
+  ** commit record must carry the size written by the latest commit. */
+  if( rc==SQLITE_OK && nPage && aPage1 ){
+    pPager->dbSize = nPage;
+  }
+  return rc;
+}
+
 /*
 ** Sync the database file for the pager pPager. zMaster points to the name
 ** of a master journal file that should be written into the individual
@@ -1802,6 +2325,13 @@ int sqlite3PagerCommitPhaseOne(
     if( pagerUseWal(pPager) ){
       PgHdr *pList = sqlite3PcacheDirtyList(pPager->pPCache);
       PgHdr *pPageOne = 0;
+      if( pPager->pAllRead ){
+        /* A BEGIN CONCURRENT transaction has written nothing to the WAL,
+        ** so if it has no dirty pages there is nothing to commit. */
+        if( pList==0 ) return SQLITE_OK;
+        rc = pagerLockForConcurrentCommit(pPager);
+        if( rc!=SQLITE_OK ) return rc;
+      }
       if( pList==0 ){
         /* Must have at least one page for the WAL commit flag.
         ** Ticket [2d1a5c67dfc2363e44f29d9bbd57f] 2011-05-18 
@@ -1855,6 +2385,7 @@ int sqlite3PagerCommitPhaseOne(
       assert( isOpen(pPager->jfd) 
            || pPager->journalMode==PAGER_JOURNALMODE_OFF 
            || pPager->journalMode==PAGER_JOURNALMODE_WAL 
+           || pPager->journalMode==PAGER_JOURNALMODE_WAL2 
       );
       if( !zMaster && isOpen(pPager->jfd) 
        && pPager->journalOff==jrnlBufferSize(pPager) 
@@ -2090,6 +2621,15 @@ int sqlite3PagerCommitPhaseTwo(Pager *pPager){
 
   PAGERTRACE(("COMMIT %d\n", PAGERID(pPager)));
   rc = pager_end_transaction(pPager, pPager->setMaster);
+  pagerEndConcurrent(pPager);
+
+  /* If this commit was added to a group commit, wait for the group sync.
+  ** The commit was not published unless the sync succeeded, so a failed
+  ** sync fails the commit. */
+  if( pagerUseWal(pPager) ){
+    int rc2 = sqlite3WalCommitSync(pPager->pWal);
+    if( rc==SQLITE_OK ) rc = rc2;
+  }
   return pager_error(pPager, rc);
 }
  
@@ -2152,6 +2692,7 @@ int sqlite3PagerRollback(Pager *pPager){
     rc = sqlite3PagerSavepoint(pPager, SAVEPOINT_ROLLBACK, -1);
     rc2 = pager_end_transaction(pPager, pPager->setMaster);
     if( rc==SQLITE_OK ) rc = rc2;
+    pagerEndConcurrent(pPager);
   }else if( !isOpen(pPager->jfd) || pPager->eState==PAGER_WRITER_LOCKED ){
     int eState = pPager->eState;
     rc = pager_end_transaction(pPager, 0);
@@ -2634,6 +3175,16 @@ int sqlite3PagerSharedLock(Pager *pPager){
  
       if( memcmp(pPager->dbFileVers, dbFileVers, sizeof(dbFileVers))!=0 ){
         pager_reset(pPager);
+
+        /* Unmap the database file. It is possible that external processes
+        ** may have truncated the database file and then extended it back
+        ** to its original size while this process was not holding a lock.
+        ** In this case there may exist a Pager.pMap mapping that appears
+        ** to be the right size but is not actually valid. Avoid this
+        ** possibility by unmapping the db here. */
+        if( USEFETCH(pPager) ){
+          sqlite3OsUnfetch(pPager->fd, 0, 0);
+        }
       }
     }
  
@@ -2879,6 +3430,16 @@ int sqlite3PagerSharedLock(Pager *pPager){
  
       if( memcmp(pPager->dbFileVers, dbFileVers, sizeof(dbFileVers))!=0 ){
         pager_reset(pPager);
+
+        /* Unmap the database file. It is possible that external processes
+        ** may have truncated the database file and then extended it back
+        ** to its original size while this process was not holding a lock.
+        ** In this case there may exist a Pager.pMap mapping that appears
+        ** to be the right size but is not actually valid. Avoid this
+        ** possibility by unmapping the db here. */
+        if( USEFETCH(pPager) ){
+          sqlite3OsUnfetch(pPager->fd, 0, 0);
+        }
       }
     }
  
@@ -2928,6 +3489,53 @@ int sqlite3PagerWalCallback(Pager *pPager){
   return sqlite3WalCallback(pPager->pWal);
 }
 
+/*
+** Limit the number of frames copied into the database file by each
+** PASSIVE checkpoint run through this pager. Zero means no limit.
+*/
+void sqlite3PagerCheckpointStep(Pager *pPager, int nFrame){
+  sqlite3WalCheckpointStep(pPager->pWal, nFrame);
+}
+
+/*
+** Get/set the group commit window used in WAL mode, in microseconds.
+**
+** A negative value (the default) disables group commit. Zero enables it
+** without a window, so that a commit only shares a sync with commits
+** that join before the first one has finished. An attempt to set a
+** value smaller than -1 is a no-op.
+*/
+int sqlite3PagerWalGroupCommit(Pager *pPager, int nWindow){
+  if( nWindow>=-1 ){
+    pPager->iGroupCommit = nWindow;
+    sqlite3WalGroupCommit(pPager->pWal, nWindow);
+  }
+  return pPager->iGroupCommit;
+}
+
+/*
+** Get/set whether or not read transactions in WAL mode share a read lock
+** with other connections in this process (see the SHARED READERS
+** section of wal.c). If eOnOff is negative, the setting is not changed.
+** Return the current setting.
+*/
+int sqlite3PagerWalSharedReaders(Pager *pPager, int eOnOff){
+  if( eOnOff>=0 ){
+    pPager->bSharedReaders = (u8)(eOnOff!=0);
+    sqlite3WalSharedReaders(pPager->pWal, pPager->bSharedReaders);
+  }
+  return pPager->bSharedReaders;
+}
+
+/*
+** Set whether or not the next read transaction is opened for a statement
+** that will write in autocommit mode. In WAL mode with group commit, such
+** a statement may add its commit to a pending group commit.
+*/
+void sqlite3PagerWalWriteIntent(Pager *pPager, int bIntent){
+  sqlite3WalWriteIntent(pPager->pWal, bIntent);
+}
+
 /*
 ** Call sqlite3WalOpen() to open the WAL handle. If the pager is in 
 ** exclusive-locking mode when this function is called, take an EXCLUSIVE
@@ -2939,7 +3547,7 @@ int sqlite3PagerWalCallback(Pager *pPager){
 �����ݿ��ļ��ϲ�ȡ�������������ö��ڴ����洢wal-index��
 ����,ʹ�������Ĺ����ڴ棨shared-memory����
 */
-static int pagerOpenWal(Pager *pPager){
+static int pagerOpenWal(Pager *pPager, int bWal2){
   int rc = SQLITE_OK;
 
   assert( pPager->pWal==0 && pPager->tempFile==0 );
@@ -2960,10 +3568,16 @@ static int pagerOpenWal(Pager *pPager){
   */
   if( rc==SQLITE_OK ){
     rc = sqlite3WalOpen(pPager->pVfs, 
-        pPager->fd, pPager->zWal, pPager->exclusiveMode,
+        pPager->fd, pPager->zWal, pPager->exclusiveMode, bWal2,
         pPager->journalSizeLimit, &pPager->pWal
     );
   }
+  if( rc==SQLITE_OK && pPager->iGroupCommit>=0 ){
+    sqlite3WalGroupCommit(pPager->pWal, pPager->iGroupCommit);
+  }
+  if( rc==SQLITE_OK && pPager->bSharedReaders ){
+    sqlite3WalSharedReaders(pPager->pWal, 1);
+  }
 
   return rc;
 }
@@ -2984,8 +3598,9 @@ static int pagerOpenWal(Pager *pPager){
 
 int sqlite3PagerCloseWal(Pager *pPager){
   int rc = SQLITE_OK;
+  int bWal2 = (pPager->journalMode==PAGER_JOURNALMODE_WAL2);
  
-  assert( pPager->journalMode==PAGER_JOURNALMODE_WAL );
+  assert( isWalMode(pPager->journalMode) );
  
   /* If the log file is not already open, but does exist in the file-system,
   ** it may need to be checkpointed before the connection can switch to
@@ -3000,8 +3615,19 @@ int sqlite3PagerCloseWal(Pager *pPager){
           pPager->pVfs, pPager->zWal, SQLITE_ACCESS_EXISTS, &logexists
       );
     }
+    if( rc==SQLITE_OK && !logexists && bWal2 ){
+      /* In wal2 mode, the content may be in the second WAL file only */
+      char *zWal2 = sqlite3MPrintf(0, "%s2", pPager->zWal);
+      if( zWal2==0 ){
+        rc = SQLITE_NOMEM;
+      }else{
+        rc = sqlite3OsAccess(pPager->pVfs, zWal2, SQLITE_ACCESS_EXISTS,
+                             &logexists);
+        sqlite3_free(zWal2);
+      }
+    }
     if( rc==SQLITE_OK && logexists ){
-      rc = pagerOpenWal(pPager);
+      rc = pagerOpenWal(pPager, bWal2);
     }
   }
  
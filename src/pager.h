@@ -69,6 +69,12 @@ typedef struct PgHdr DbPage;
 #define PAGER_MEMORY        0x0002    /* In-memory database */
 PAGER_OMIT_JOURNAL 0 x0001 / *ʹûع־* / 
 PAGER_MEMORY 0 x0002 /*ڴݿ* /
+/*
+** Flags that may be passed as the fourth argument to sqlite3PagerAcquire().
+*/
+#define PAGER_ACQUIRE_NOCONTENT     0x01  /* Do not load data from disk */
+#define PAGER_ACQUIRE_READONLY      0x02  /* Read-only page is acceptable */
+
 /*
 ** Valid values for the second argument to sqlite3PagerLockingMode().
 */
@@ -90,6 +96,11 @@ sqlite3PagerLockingMode()
 #define PAGER_JOURNALMODE_TRUNCATE    3   /* Commit by truncating journal */
 #define PAGER_JOURNALMODE_MEMORY      4   /* In-memory journal file */
 #define PAGER_JOURNALMODE_WAL         5   /* Use write-ahead logging */
+#define PAGER_JOURNALMODE_WAL2        6   /* Use two write-ahead log files */
+
+/* True if journal mode eMode is one of the write-ahead log modes */
+#define isWalMode(eMode) \
+    ((eMode)==PAGER_JOURNALMODE_WAL || (eMode)==PAGER_JOURNALMODE_WAL2)
  /*#PAGER_JOURNALMODE_QUERY(-1)    /*ѯjournalmodeֵ* /
 #PAGER_JOURNALMODE_DELETE 0  //ύͨɾ־ļ
 # define PAGER_JOURNALMODE_PERSIST 1 //ύͨ־⡡
@@ -141,14 +152,20 @@ int sqlite3PagerOkToChangeJournalMode(Pager*);
 
 i64 sqlite3PagerJournalSizeLimit(Pager *, i64);
 
+void sqlite3PagerMmapLimit(Pager *, sqlite3_int64);
+
 sqlite3_backup **sqlite3PagerBackupPtr(Pager*);
 
 /* Functions used to obtain and release page references. */ 
-int sqlite3PagerAcquire(Pager *pPager, Pgno pgno, DbPage **ppPage, int clrFlag);
+int sqlite3PagerAcquire(Pager *pPager, Pgno pgno, DbPage **ppPage, int flags);
 #define sqlite3PagerGet(A,B,C) sqlite3PagerAcquire(A,B,C,0)
 
 DbPage *sqlite3PagerLookup(Pager *pPager, Pgno pgno);
 
+void sqlite3PagerPrefetch(Pager *pPager, const Pgno *aPgno, int nPgno);
+void sqlite3PagerWarmSave(Pager *pPager, const u8 *aHdr);
+int sqlite3PagerWarmLoad(Pager *pPager, Pgno **paPgno, int *pnPgno, u8 *aHdr);
+
 void sqlite3PagerRef(DbPage*);
 
 void sqlite3PagerUnref(DbPage*);
@@ -186,7 +203,12 @@ int sqlite3PagerSharedLock(Pager *pPager);
 int sqlite3PagerCheckpoint(Pager *pPager, int, int*, int*);
 int sqlite3PagerWalSupported(Pager *pPager);
 int sqlite3PagerWalCallback(Pager *pPager);
-int sqlite3PagerOpenWal(Pager *pPager, int *pisOpen);
+void sqlite3PagerCheckpointStep(Pager *pPager, int nFrame);
+int sqlite3PagerWalGroupCommit(Pager *pPager, int nWindow);
+int sqlite3PagerWalSharedReaders(Pager *pPager, int eOnOff);
+void sqlite3PagerWalWriteIntent(Pager *pPager, int bIntent);
+int sqlite3PagerBeginConcurrent(Pager *pPager, int isConcurrent);
+int sqlite3PagerOpenWal(Pager *pPager, int bWal2, int *pisOpen);
 int sqlite3PagerCloseWal(Pager *pPager);
 #ifdef SQLITE_ENABLE_ZIPVFS
   int sqlite3PagerWalFramesize(Pager *pPager);
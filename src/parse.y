@@ -114,6 +114,27 @@ explain ::= .           { sqlite3BeginParse(pParse, 0); }
 %ifndef SQLITE_OMIT_EXPLAIN
 explain ::= EXPLAIN.              { sqlite3BeginParse(pParse, 1); }
 explain ::= EXPLAIN QUERY PLAN.   { sqlite3BeginParse(pParse, 2); }
+explain ::= EXPLAIN ANALYZE.      { sqlite3BeginParse(pParse, 3); }
+
+// EXPLAIN ANALYZE followed by a statement runs the statement and lists its
+// query plan together with run-time counters. The precedence declarations
+// resolve the conflict with an EXPLAIN of the ANALYZE command in favor of
+// EXPLAIN ANALYZE, so the two forms of that command are spelled out here.
+//
+%nonassoc EXPLAIN.
+%nonassoc ANALYZE.
+%ifndef SQLITE_OMIT_ANALYZE
+ecmd ::= EXPLAIN ANALYZE SEMI. {
+  sqlite3BeginParse(pParse, 1);
+  sqlite3Analyze(pParse, 0, 0);
+  sqlite3FinishCoding(pParse);
+}
+ecmd ::= EXPLAIN ANALYZE nm(X) dbnm(Y) SEMI. {
+  sqlite3BeginParse(pParse, 1);
+  sqlite3Analyze(pParse, &X, &Y);
+  sqlite3FinishCoding(pParse);
+}
+%endif  SQLITE_OMIT_ANALYZE
 %endif  SQLITE_OMIT_EXPLAIN
 cmdx ::= cmd.           { sqlite3FinishCoding(pParse); }
 
@@ -129,6 +150,7 @@ transtype(A) ::= .             {A = TK_DEFERRED;}
 transtype(A) ::= DEFERRED(X).  {A = @X;}
 transtype(A) ::= IMMEDIATE(X). {A = @X;}
 transtype(A) ::= EXCLUSIVE(X). {A = @X;}
+transtype(A) ::= CONCURRENT(X). {A = @X;}
 cmd ::= COMMIT trans_opt.      {sqlite3CommitTransaction(pParse);}
 cmd ::= END trans_opt.         {sqlite3CommitTransaction(pParse);}
 cmd ::= ROLLBACK trans_opt.    {sqlite3RollbackTransaction(pParse);}
@@ -205,7 +227,7 @@ id(A) ::= INDEXED(X).    {A = X;}
   CONFLICT DATABASE DEFERRED DESC DETACH EACH END EXCLUSIVE EXPLAIN FAIL FOR
   IGNORE IMMEDIATE INITIALLY INSTEAD LIKE_KW MATCH NO PLAN
   QUERY KEY OF OFFSET PRAGMA RAISE RELEASE REPLACE RESTRICT ROW ROLLBACK
-  SAVEPOINT TEMP TRIGGER VACUUM VIEW VIRTUAL
+  SAVEPOINT TEMP TRIGGER VACUUM VIEW VIRTUAL CONCURRENT
 %ifdef SQLITE_OMIT_COMPOUND_SELECT
   EXCEPT INTERSECT UNION
 %endif SQLITE_OMIT_COMPOUND_SELECT
@@ -648,6 +648,37 @@ int sqlite3PcachePagecount(PCache *pCache){
   return nPage;
 }
 
+/*
+** Return true if page pgno is held in the cache. With the built-in page
+** cache the page is not pinned, so the probe is not counted as a hit or
+** a miss and does not change the page's place in the replacement order.
+** An application-defined cache offers no such lookup, so for it the page
+** is fetched and released again.
+*/
+int sqlite3PcachePeek(PCache *pCache, Pgno pgno){
+  PgHdr *pPg = 0;
+  if( pCache->pCache==0 ) return 0;
+  if( sqlite3Pcache1IsDefault() ){
+    return sqlite3Pcache1Peek(pCache->pCache, pgno);
+  }
+  sqlite3PcacheFetch(pCache, pgno, 0, &pPg);
+  if( pPg==0 ) return 0;
+  sqlite3PcacheRelease(pPg);
+  return 1;
+}
+
+/*
+** Write the numbers of up to nMax pages held in the cache to aPgno[], in
+** no particular order, and return the number written. Like
+** sqlite3PcachePeek(), this has no effect on the replacement policy.
+** Return -1 if the page cache in use cannot list its pages.
+*/
+int sqlite3PcacheResident(PCache *pCache, Pgno *aPgno, int nMax){
+  if( pCache->pCache==0 ) return 0;
+  if( !sqlite3Pcache1IsDefault() ) return -1;
+  return sqlite3Pcache1Keys(pCache->pCache, (unsigned int *)aPgno, nMax);
+}
+
 #ifdef SQLITE_TEST
 /*
 ** Get the suggested cache-size value.
@@ -57,6 +57,7 @@ struct PgHdr {
 #define PGHDR_NEED_READ         0x008  /* 内容不可读*/
 #define PGHDR_REUSE_UNLIKELY    0x010  /* 暗示不可重用*/
 #define PGHDR_DONT_WRITE        0x020  /* 不能向磁盘写内容*/
+#define PGHDR_MMAP              0x040  /* This is an mmap page object */
 
 /* Initialize and shutdown the page cache subsystem 
 ** 初始化和关闭页面缓存子系统
@@ -185,9 +186,19 @@ int sqlite3PcacheReleaseMemory(int);
 #endif
 
 #ifdef SQLITE_TEST
-void sqlite3PcacheStats(int*,int*,int*,int*);
+void sqlite3PcacheStats(int*,int*,int*,int*,i64*,i64*);
 #endif
 
+/* Check for or list resident pages without affecting the replacement
+** policy. The sqlite3Pcache1*() functions are used by these when the
+** built-in page cache is in use.
+*/
+int sqlite3PcachePeek(PCache*, Pgno);
+int sqlite3PcacheResident(PCache*, Pgno*, int);
+int sqlite3Pcache1IsDefault(void);
+int sqlite3Pcache1Peek(sqlite3_pcache*, unsigned int);
+int sqlite3Pcache1Keys(sqlite3_pcache*, unsigned int*, int);
+
 void sqlite3PCacheSetDefault(void);
 
 #endif /* _PCACHE_H_ */
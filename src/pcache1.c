@@ -20,10 +20,31 @@
 #include "sqliteInt.h"
 
 typedef struct PCache1 PCache1;
+typedef struct PCache1Shard PCache1Shard;
 typedef struct PgHdr1 PgHdr1;
 typedef struct PgFreeslot PgFreeslot;
 typedef struct PGroup PGroup;
 
+/*
+** The number of shards the global PGroup of mode (2) below is split into.
+** Must be a power of two. Setting it to 1 restores a single global LRU
+** list protected by a single mutex.
+*/
+#ifndef SQLITE_PCACHE_NSHARD
+# define SQLITE_PCACHE_NSHARD 8
+#endif
+#if SQLITE_PCACHE_NSHARD<1 || (SQLITE_PCACHE_NSHARD&(SQLITE_PCACHE_NSHARD-1))!=0
+# error "SQLITE_PCACHE_NSHARD must be a power of two"
+#endif
+
+/*
+** Number of entries in the ghost table (PGroup.aGhost[]) used by the 2Q
+** replacement policy to remember recently evicted pages.
+*/
+#ifndef PCACHE1_NGHOST
+# define PCACHE1_NGHOST 256
+#endif
+
 /* Each page cache (or PCache) belongs to a PGroup.  A PGroup is a set 
 ** of one or more PCaches that are able to recycle each others unpinned
 ** pages when they are under memory pressure.  A PGroup is an instance of
@@ -42,17 +63,39 @@ typedef struct PGroup PGroup;
 ** and is therefore often faster.  Mode 2 requires a mutex in order to be
 ** threadsafe, but recycles pages more efficiently.
 **
-** For mode (1), PGroup.mutex is NULL.  For mode (2) there is only a single
-** PGroup which is the pcache1.grp global variable and its mutex is
-** SQLITE_MUTEX_STATIC_LRU.
+** For mode (1), PGroup.mutex is NULL.  For mode (2) the global PGroup is
+** split into SQLITE_PCACHE_NSHARD shards, the pcache1.aGrp[] array.  Page
+** iKey of every cache belongs to shard (iKey % SQLITE_PCACHE_NSHARD), so
+** threads working on different pages usually take different mutexes.  The
+** mutex of shard 0 is SQLITE_MUTEX_STATIC_LRU; the others are allocated
+** by xInit.  Each shard is given a share of the nMax and nMin values of
+** every purgeable cache, and of the 10 pages by which mxPinned exceeds
+** nMaxPage-nMinPage, so the sum over all shards still enforces the
+** global page budget, one shard at a time.
+**
+** Unpinned pages are kept on one of two lists. With the default
+** SQLITE_PCACHE_POLICY_LRU replacement policy only the pLruHead/pLruTail
+** list is used and the least recently used page is always recycled first.
+** With SQLITE_PCACHE_POLICY_2Q that list holds the "cold" pages that have
+** only been referenced once since they were loaded, and pHotHead/pHotTail
+** holds pages that have been referenced again (or that were loaded again
+** soon after being evicted, as remembered by aGhost[]). Cold pages are
+** recycled first as long as there are more than nMaxPage/4 of them, so a
+** single large table scan cannot flush the hot pages out of the cache.
 */
 struct PGroup {
   sqlite3_mutex *mutex;          /* MUTEX_STATIC_LRU or NULL */
   unsigned int nMaxPage;         /* Sum of nMax for purgeable caches */
   unsigned int nMinPage;         /* Sum of nMin for purgeable caches */
-  unsigned int mxPinned;         /* nMaxpage + 10 - nMinPage */
+  unsigned int mxPinned;         /* nMaxpage + nSlack - nMinPage */
+  unsigned int nSlack;           /* This group's part of the 10 spare pages */
   unsigned int nCurrentPage;     /* Number of purgeable pages allocated */
-  PgHdr1 *pLruHead, *pLruTail;   /* LRU list of unpinned pages */
+  PgHdr1 *pLruHead, *pLruTail;   /* LRU list of unpinned (cold) pages */
+  PgHdr1 *pHotHead, *pHotTail;   /* LRU list of unpinned hot pages (2Q) */
+  unsigned int nCold;            /* Number of pages on the pLruHead list */
+  u32 aGhost[PCACHE1_NGHOST];    /* Tags of recently evicted cold pages */
+  i64 nHit;                      /* Number of xFetch() calls that hit */
+  i64 nMiss;                     /* Number of xFetch() calls that missed */
 };
 
 /* Each page cache is an instance of the following object.  Every
@@ -63,13 +106,24 @@ struct PGroup {
 ** Pointers to structures of this type are cast and returned as 
 ** opaque sqlite3_pcache* handles.
 */
+struct PCache1Shard {
+  /* Hash table of the pages of a cache that belong to a single shard. The
+  ** following variables may only be accessed when the accessor is holding
+  ** the mutex of pGroup.
+  */
+  PGroup *pGroup;                     /* PGroup (shard) these pages belong to */
+  unsigned int nRecyclable;           /* Number of pages in the LRU list */
+  unsigned int nPage;                 /* Total number of pages in apHash */
+  unsigned int nHash;                 /* Number of slots in apHash[] */
+  PgHdr1 **apHash;                    /* Hash table for fast lookup by key */
+};
+
 struct PCache1 {
   /* Cache configuration parameters. Page size (szPage) and the purgeable
   ** flag (bPurgeable) are set when the cache is created. nMax may be 
   ** modified at any time by a call to the pcache1Cachesize() method.
-  ** The PGroup mutex must be held when accessing nMax.
+  ** These fields are only used by the thread that owns the cache.
   */
-  PGroup *pGroup;                     /* PGroup this cache belongs to */
   int szPage;                         /* Size of allocated pages in bytes */
   int szExtra;                        /* Size of extra space in bytes */
   int bPurgeable;                     /* True if cache is purgeable */
@@ -78,13 +132,11 @@ struct PCache1 {
   unsigned int n90pct;                /* nMax*9/10 */
   unsigned int iMaxKey;               /* Largest key seen since xTruncate() */
 
-  /* Hash table of all pages. The following variables may only be accessed
-  ** when the accessor is holding the PGroup mutex.
+  /* Per-shard hash tables. Page iKey is stored in aShard[iKey & (nShard-1)].
+  ** nShard is 1 for mode (1) and SQLITE_PCACHE_NSHARD for mode (2).
   */
-  unsigned int nRecyclable;           /* Number of pages in the LRU list */
-  unsigned int nPage;                 /* Total number of pages in apHash */
-  unsigned int nHash;                 /* Number of slots in apHash[] */
-  PgHdr1 **apHash;                    /* Hash table for fast lookup by key */
+  int nShard;                         /* Number of entries of aShard[] used */
+  PCache1Shard aShard[SQLITE_PCACHE_NSHARD];
 };
 
 /*
@@ -100,6 +152,7 @@ struct PgHdr1 {
   PCache1 *pCache;               /* Cache that currently owns this page */
   PgHdr1 *pLruNext;              /* Next in LRU list of unpinned pages */
   PgHdr1 *pLruPrev;              /* Previous in LRU list of unpinned pages */
+  u8 bHot;                       /* True if page belongs on the hot list */
 };
 
 /*
@@ -114,7 +167,7 @@ struct PgFreeslot {
 ** Global data used by this cache.
 */
 static SQLITE_WSD struct PCacheGlobal {
-  PGroup grp;                    /* The global PGroup for mode (2) */
+  PGroup aGrp[SQLITE_PCACHE_NSHARD];  /* The global PGroup shards, mode (2) */
 
   /* Variables related to SQLITE_CONFIG_PAGECACHE settings.  The
   ** szSlot, nSlot, pStart, pEnd, nReserve, and isInit values are all
@@ -122,6 +175,7 @@ static SQLITE_WSD struct PCacheGlobal {
   ** The nFreeSlot and pFree values do require mutex protection.
   */
   int isInit;                    /* True if initialized */
+  int ePolicy;                   /* SQLITE_PCACHE_POLICY_LRU or _2Q */
   int szSlot;                    /* Size of each free slot */
   int nSlot;                     /* The number of pcache slots */
   int nReserve;                  /* Try to keep nFreeSlot above this */
@@ -130,6 +184,8 @@ static SQLITE_WSD struct PCacheGlobal {
   sqlite3_mutex *mutex;          /* Mutex for accessing the following: */
   PgFreeslot *pFree;             /* Free page blocks */
   int nFreeSlot;                 /* Number of unused pcache slots */
+  i64 nHit;                      /* Hits of destroyed mode (1) caches */
+  i64 nMiss;                     /* Misses of destroyed mode (1) caches */
   /* The following value requires a mutex to change.  We skip the mutex on
   ** reading because (1) most platforms read a 32-bit integer atomically and
   ** (2) even if an incorrect value is read, no great harm is done since this
@@ -150,6 +206,33 @@ static SQLITE_WSD struct PCacheGlobal {
 #define pcache1EnterMutex(X) sqlite3_mutex_enter((X)->mutex)
 #define pcache1LeaveMutex(X) sqlite3_mutex_leave((X)->mutex)
 
+/*
+** Return the PCache1Shard of cache pCache that holds page iKey.
+*/
+#define pcache1Shard(pCache, iKey) \
+  (&(pCache)->aShard[(iKey) & (unsigned int)((pCache)->nShard-1)])
+
+/*
+** The initial number of hash slots allocated for each shard of a cache.
+** A cache starts with 256 slots in total, however many shards it has.
+*/
+#define PCACHE1_NHASH_INIT \
+  (256/SQLITE_PCACHE_NSHARD>16 ? 256/SQLITE_PCACHE_NSHARD : 16)
+
+#ifndef NDEBUG
+/*
+** Return true if the current thread holds none of the global PGroup
+** mutexes. Used in assert() statements only.
+*/
+static int pcache1NoGroupMutexHeld(void){
+  int i;
+  for(i=0; i<SQLITE_PCACHE_NSHARD; i++){
+    if( !sqlite3_mutex_notheld(pcache1.aGrp[i].mutex) ) return 0;
+  }
+  return 1;
+}
+#endif
+
 /******************************************************************************/
 /******** Page Allocation/SQLITE_CONFIG_PCACHE Related Functions **************/
 
@@ -193,7 +276,7 @@ void sqlite3PCacheBufferSetup(void *pBuf, int sz, int n){
 */
 static void *pcache1Alloc(int nByte){
   void *p = 0;
-  assert( sqlite3_mutex_notheld(pcache1.grp.mutex) );
+  assert( pcache1NoGroupMutexHeld() );
   sqlite3StatusSet(SQLITE_STATUS_PAGECACHE_SIZE, nByte);
   if( nByte<=pcache1.szSlot ){
     sqlite3_mutex_enter(pcache1.mutex);
@@ -276,16 +359,17 @@ static int pcache1MemSize(void *p){
 
 /*
 ** Allocate a new page object initially associated with cache pCache.
+** pGroup is the shard the page will be added to. Its mutex must be held.
 */
-static PgHdr1 *pcache1AllocPage(PCache1 *pCache){
+static PgHdr1 *pcache1AllocPage(PCache1 *pCache, PGroup *pGroup){
   PgHdr1 *p = 0;
   void *pPg;
 
   /* The group mutex must be released before pcache1Alloc() is called. This
   ** is because it may call sqlite3_release_memory(), which assumes that 
   ** this mutex is not held. */
-  assert( sqlite3_mutex_held(pCache->pGroup->mutex) );
-  pcache1LeaveMutex(pCache->pGroup);
+  assert( sqlite3_mutex_held(pGroup->mutex) );
+  pcache1LeaveMutex(pGroup);
 #ifdef SQLITE_PCACHE_SEPARATE_HEADER
   pPg = pcache1Alloc(pCache->szPage);
   p = sqlite3Malloc(sizeof(PgHdr1) + pCache->szExtra);
@@ -298,13 +382,13 @@ static PgHdr1 *pcache1AllocPage(PCache1 *pCache){
   pPg = pcache1Alloc(sizeof(PgHdr1) + pCache->szPage + pCache->szExtra);
   p = (PgHdr1 *)&((u8 *)pPg)[pCache->szPage];
 #endif
-  pcache1EnterMutex(pCache->pGroup);
+  pcache1EnterMutex(pGroup);
 
   if( pPg ){
     p->page.pBuf = pPg;
     p->page.pExtra = &p[1];
     if( pCache->bPurgeable ){
-      pCache->pGroup->nCurrentPage++;
+      pGroup->nCurrentPage++;
     }
     return p;
   }
@@ -321,13 +405,14 @@ static PgHdr1 *pcache1AllocPage(PCache1 *pCache){
 static void pcache1FreePage(PgHdr1 *p){
   if( ALWAYS(p) ){
     PCache1 *pCache = p->pCache;
-    assert( sqlite3_mutex_held(p->pCache->pGroup->mutex) );
+    PGroup *pGroup = pcache1Shard(pCache, p->iKey)->pGroup;
+    assert( sqlite3_mutex_held(pGroup->mutex) );
     pcache1Free(p->page.pBuf);
 #ifdef SQLITE_PCACHE_SEPARATE_HEADER
     sqlite3_free(p);
 #endif
     if( pCache->bPurgeable ){
-      pCache->pGroup->nCurrentPage--;
+      pGroup->nCurrentPage--;
     }
   }
 }
@@ -378,12 +463,13 @@ static int pcache1UnderMemoryPressure(PCache1 *pCache){
 /******** General Implementation Functions ************************************/
 
 /*
-** This function is used to resize the hash table used by the cache passed
+** This function is used to resize the hash table of the cache shard passed
 ** as the first argument.
 **
-** The PCache mutex must be held when this function is called.
+** The mutex of the shard's PGroup must be held when this function is
+** called.
 */
-static int pcache1ResizeHash(PCache1 *p){
+static int pcache1ResizeHash(PCache1Shard *p){
   PgHdr1 **apNew;
   unsigned int nNew;
   unsigned int i;
@@ -391,8 +477,8 @@ static int pcache1ResizeHash(PCache1 *p){
   assert( sqlite3_mutex_held(p->pGroup->mutex) );
 
   nNew = p->nHash*2;
-  if( nNew<256 ){
-    nNew = 256;
+  if( nNew<PCACHE1_NHASH_INIT ){
+    nNew = PCACHE1_NHASH_INIT;
   }
 
   pcache1LeaveMutex(p->pGroup);
@@ -429,50 +515,99 @@ static int pcache1ResizeHash(PCache1 *p){
 ** If pPage is NULL then this routine is a no-op.
 */
 static void pcache1PinPage(PgHdr1 *pPage){
-  PCache1 *pCache;
+  PCache1Shard *pShard;
   PGroup *pGroup;
+  PgHdr1 **ppHead;
+  PgHdr1 **ppTail;
 
   if( pPage==0 ) return;
-  pCache = pPage->pCache;
-  pGroup = pCache->pGroup;
+  pShard = pcache1Shard(pPage->pCache, pPage->iKey);
+  pGroup = pShard->pGroup;
   assert( sqlite3_mutex_held(pGroup->mutex) );
-  if( pPage->pLruNext || pPage==pGroup->pLruTail ){
+  if( pPage->bHot ){
+    ppHead = &pGroup->pHotHead;
+    ppTail = &pGroup->pHotTail;
+  }else{
+    ppHead = &pGroup->pLruHead;
+    ppTail = &pGroup->pLruTail;
+  }
+  if( pPage->pLruNext || pPage==*ppTail ){
     if( pPage->pLruPrev ){
       pPage->pLruPrev->pLruNext = pPage->pLruNext;
     }
     if( pPage->pLruNext ){
       pPage->pLruNext->pLruPrev = pPage->pLruPrev;
     }
-    if( pGroup->pLruHead==pPage ){
-      pGroup->pLruHead = pPage->pLruNext;
+    if( *ppHead==pPage ){
+      *ppHead = pPage->pLruNext;
     }
-    if( pGroup->pLruTail==pPage ){
-      pGroup->pLruTail = pPage->pLruPrev;
+    if( *ppTail==pPage ){
+      *ppTail = pPage->pLruPrev;
     }
     pPage->pLruNext = 0;
     pPage->pLruPrev = 0;
-    pPage->pCache->nRecyclable--;
+    pShard->nRecyclable--;
+    if( !pPage->bHot ) pGroup->nCold--;
   }
 }
 
+/*
+** Return a tag identifying page iKey of cache pCache in the PGroup.aGhost[]
+** table. Tags are never zero, so a zero entry in aGhost[] is always empty.
+*/
+static u32 pcache1GhostTag(PCache1 *pCache, unsigned int iKey){
+  u32 h = (iKey * 0x9E3779B1) ^ (u32)SQLITE_PTR_TO_INT(pCache);
+  return h ? h : 1;
+}
 
 /*
-** Remove the page supplied as an argument from the hash table 
-** (PCache1.apHash structure) that it is currently stored in.
+** Return the unpinned page that should be recycled next from PGroup
+** pGroup, or NULL if there are no unpinned pages. The caller is expected
+** to remove the page from the cache.
+**
+** For the 2Q policy, cold pages are chosen while there are more than
+** nMaxPage/4 of them or there are no hot pages. The tag of a cold page
+** is remembered in aGhost[] so that it is loaded as a hot page if it is
+** requested again before its entry is overwritten.
 **
 ** The PGroup mutex must be held when this function is called.
 */
+static PgHdr1 *pcache1LruVictim(PGroup *pGroup){
+  PgHdr1 *p;
+  assert( sqlite3_mutex_held(pGroup->mutex) );
+  if( pGroup->pHotTail==0
+   || (pGroup->pLruTail && pGroup->nCold>pGroup->nMaxPage/4)
+  ){
+    p = pGroup->pLruTail;
+    if( p && pcache1.ePolicy==SQLITE_PCACHE_POLICY_2Q ){
+      u32 tag = pcache1GhostTag(p->pCache, p->iKey);
+      pGroup->aGhost[tag % PCACHE1_NGHOST] = tag;
+    }
+  }else{
+    p = pGroup->pHotTail;
+  }
+  return p;
+}
+
+
+/*
+** Remove the page supplied as an argument from the hash table 
+** (PCache1Shard.apHash structure) that it is currently stored in.
+**
+** The PGroup mutex of the page's shard must be held when this function
+** is called.
+*/
 static void pcache1RemoveFromHash(PgHdr1 *pPage){
   unsigned int h;
-  PCache1 *pCache = pPage->pCache;
+  PCache1Shard *pShard = pcache1Shard(pPage->pCache, pPage->iKey);
   PgHdr1 **pp;
 
-  assert( sqlite3_mutex_held(pCache->pGroup->mutex) );
-  h = pPage->iKey % pCache->nHash;
-  for(pp=&pCache->apHash[h]; (*pp)!=pPage; pp=&(*pp)->pNext);
+  assert( sqlite3_mutex_held(pShard->pGroup->mutex) );
+  h = pPage->iKey % pShard->nHash;
+  for(pp=&pShard->apHash[h]; (*pp)!=pPage; pp=&(*pp)->pNext);
   *pp = (*pp)->pNext;
 
-  pCache->nPage--;
+  pShard->nPage--;
 }
 
 /*
@@ -480,10 +615,12 @@ static void pcache1RemoveFromHash(PgHdr1 *pPage){
 ** to recycle pages to reduce the number allocated to nMaxPage.
 */
 static void pcache1EnforceMaxPage(PGroup *pGroup){
+  PgHdr1 *p;
   assert( sqlite3_mutex_held(pGroup->mutex) );
-  while( pGroup->nCurrentPage>pGroup->nMaxPage && pGroup->pLruTail ){
-    PgHdr1 *p = pGroup->pLruTail;
-    assert( p->pCache->pGroup==pGroup );
+  while( pGroup->nCurrentPage>pGroup->nMaxPage
+      && (p = pcache1LruVictim(pGroup))!=0
+  ){
+    assert( pcache1Shard(p->pCache, p->iKey)->pGroup==pGroup );
     pcache1PinPage(p);
     pcache1RemoveFromHash(p);
     pcache1FreePage(p);
@@ -491,25 +628,26 @@ static void pcache1EnforceMaxPage(PGroup *pGroup){
 }
 
 /*
-** Discard all pages from cache pCache with a page number (key value) 
-** greater than or equal to iLimit. Any pinned pages that meet this 
+** Discard all pages from shard pShard of a cache with a page number (key
+** value) greater than or equal to iLimit. Any pinned pages that meet this 
 ** criteria are unpinned before they are discarded.
 **
-** The PCache mutex must be held when this function is called.
+** The mutex of the shard's PGroup must be held when this function is
+** called.
 */
 static void pcache1TruncateUnsafe(
-  PCache1 *pCache,             /* The cache to truncate */
+  PCache1Shard *pShard,        /* The cache shard to truncate */
   unsigned int iLimit          /* Drop pages with this pgno or larger */
 ){
-  TESTONLY( unsigned int nPage = 0; )  /* To assert pCache->nPage is correct */
+  TESTONLY( unsigned int nPage = 0; )  /* To assert pShard->nPage is correct */
   unsigned int h;
-  assert( sqlite3_mutex_held(pCache->pGroup->mutex) );
-  for(h=0; h<pCache->nHash; h++){
-    PgHdr1 **pp = &pCache->apHash[h]; 
+  assert( sqlite3_mutex_held(pShard->pGroup->mutex) );
+  for(h=0; h<pShard->nHash; h++){
+    PgHdr1 **pp = &pShard->apHash[h]; 
     PgHdr1 *pPage;
     while( (pPage = *pp)!=0 ){
       if( pPage->iKey>=iLimit ){
-        pCache->nPage--;
+        pShard->nPage--;
         *pp = pPage->pNext;
         pcache1PinPage(pPage);
         pcache1FreePage(pPage);
@@ -519,7 +657,45 @@ static void pcache1TruncateUnsafe(
       }
     }
   }
-  assert( pCache->nPage==nPage );
+  assert( pShard->nPage==nPage );
+}
+
+/*
+** Return the part of a per-cache quantity n (nMax or nMin) that is
+** charged to shard iShard of a cache with nShard shards.  The shares of
+** all shards add up to exactly n.
+*/
+static unsigned int pcache1Share(unsigned int n, int iShard, int nShard){
+  return n/nShard + ((unsigned int)iShard < n%nShard ? 1 : 0);
+}
+
+/*
+** Return the number of pages currently held by cache pCache, and the
+** number of those that are pinned.  The caller holds the mutex of one
+** shard only.  The counters of the other shards are read without their
+** mutexes, since taking them here, in shard order or otherwise, would
+** serialize every xFetch() on the cache again and could deadlock with a
+** thread doing the same from another shard.
+**
+** This is a deliberate data race.  Each counter is an aligned unsigned
+** int read through a volatile pointer, so the value read is one that the
+** counter really held, but it may be stale if another thread is pinning
+** or unpinning pages of another shard, or recycling pages of this cache
+** from another shard.  The result is only used to decide whether to
+** recycle a page or refuse a createFlag==1 fetch early; the page budget
+** of each shard is still enforced exactly under its own mutex.
+*/
+static unsigned int pcache1LazyCount(PCache1 *pCache, unsigned int *pnPinned){
+  unsigned int nPage = 0;
+  unsigned int nRecyclable = 0;
+  int i;
+  for(i=0; i<pCache->nShard; i++){
+    volatile PCache1Shard *pShard = &pCache->aShard[i];
+    nPage += pShard->nPage;
+    nRecyclable += pShard->nRecyclable;
+  }
+  if( pnPinned ) *pnPinned = (nPage>nRecyclable ? nPage-nRecyclable : 0);
+  return nPage;
 }
 
 /******************************************************************************/
@@ -529,26 +705,43 @@ static void pcache1TruncateUnsafe(
 ** Implementation of the sqlite3_pcache.xInit method.
 */
 static int pcache1Init(void *NotUsed){
+  int i;
   UNUSED_PARAMETER(NotUsed);
   assert( pcache1.isInit==0 );
   memset(&pcache1, 0, sizeof(pcache1));
   if( sqlite3GlobalConfig.bCoreMutex ){
-    pcache1.grp.mutex = sqlite3_mutex_alloc(SQLITE_MUTEX_STATIC_LRU);
+    pcache1.aGrp[0].mutex = sqlite3_mutex_alloc(SQLITE_MUTEX_STATIC_LRU);
     pcache1.mutex = sqlite3_mutex_alloc(SQLITE_MUTEX_STATIC_PMEM);
+    for(i=1; i<SQLITE_PCACHE_NSHARD; i++){
+      pcache1.aGrp[i].mutex = sqlite3_mutex_alloc(SQLITE_MUTEX_FAST);
+      if( pcache1.aGrp[i].mutex==0 ){
+        while( --i>0 ) sqlite3_mutex_free(pcache1.aGrp[i].mutex);
+        memset(&pcache1, 0, sizeof(pcache1));
+        return SQLITE_NOMEM;
+      }
+    }
   }
-  pcache1.grp.mxPinned = 10;
+  for(i=0; i<SQLITE_PCACHE_NSHARD; i++){
+    pcache1.aGrp[i].nSlack = pcache1Share(10, i, SQLITE_PCACHE_NSHARD);
+    pcache1.aGrp[i].mxPinned = pcache1.aGrp[i].nSlack;
+  }
+  pcache1.ePolicy = sqlite3GlobalConfig.ePcachePolicy;
   pcache1.isInit = 1;
   return SQLITE_OK;
 }
 
 /*
 ** Implementation of the sqlite3_pcache.xShutdown method.
-** Note that the static mutex allocated in xInit does 
-** not need to be freed.
+** Note that the static mutexes allocated in xInit do not need 
+** to be freed, but the per-shard mutexes of shards 1 and greater do.
 */
 static void pcache1Shutdown(void *NotUsed){
+  int i;
   UNUSED_PARAMETER(NotUsed);
   assert( pcache1.isInit!=0 );
+  for(i=1; i<SQLITE_PCACHE_NSHARD; i++){
+    if( pcache1.aGrp[i].mutex ) sqlite3_mutex_free(pcache1.aGrp[i].mutex);
+  }
   memset(&pcache1, 0, sizeof(pcache1));
 }
 
@@ -561,6 +754,7 @@ static sqlite3_pcache *pcache1Create(int szPage, int szExtra, int bPurgeable){
   PCache1 *pCache;      /* The newly created page cache */
   PGroup *pGroup;       /* The group the new page cache will belong to */
   int sz;               /* Bytes of memory required to allocate the new cache */
+  int i;
 
   /*
   ** The seperateCache variable is true if each PCache has its own private
@@ -588,20 +782,46 @@ static sqlite3_pcache *pcache1Create(int szPage, int szExtra, int bPurgeable){
   if( pCache ){
     if( separateCache ){
       pGroup = (PGroup*)&pCache[1];
+      pGroup->nSlack = 10;
       pGroup->mxPinned = 10;
+      pCache->nShard = 1;
+      pCache->aShard[0].pGroup = pGroup;
     }else{
-      pGroup = &pcache1.grp;
+      pCache->nShard = SQLITE_PCACHE_NSHARD;
+      for(i=0; i<SQLITE_PCACHE_NSHARD; i++){
+        pCache->aShard[i].pGroup = &pcache1.aGrp[i];
+      }
     }
-    pCache->pGroup = pGroup;
+
+    /* Allocate the hash table of each shard up front. This way
+    ** pcache1Rekey(), which cannot fail, can always move a page into the
+    ** hash table of another shard.  */
+    for(i=0; i<pCache->nShard; i++){
+      PCache1Shard *pShard = &pCache->aShard[i];
+      pShard->apHash = (PgHdr1 **)sqlite3MallocZero(
+          sizeof(PgHdr1 *)*PCACHE1_NHASH_INIT
+      );
+      if( pShard->apHash==0 ){
+        while( i-- ) sqlite3_free(pCache->aShard[i].apHash);
+        sqlite3_free(pCache);
+        return 0;
+      }
+      pShard->nHash = PCACHE1_NHASH_INIT;
+    }
+
     pCache->szPage = szPage;
     pCache->szExtra = szExtra;
     pCache->bPurgeable = (bPurgeable ? 1 : 0);
     if( bPurgeable ){
       pCache->nMin = 10;
-      pcache1EnterMutex(pGroup);
-      pGroup->nMinPage += pCache->nMin;
-      pGroup->mxPinned = pGroup->nMaxPage + 10 - pGroup->nMinPage;
-      pcache1LeaveMutex(pGroup);
+      for(i=0; i<pCache->nShard; i++){
+        pGroup = pCache->aShard[i].pGroup;
+        pcache1EnterMutex(pGroup);
+        pGroup->nMinPage += pcache1Share(pCache->nMin, i, pCache->nShard);
+        pGroup->mxPinned = pGroup->nMaxPage + pGroup->nSlack
+                         - pGroup->nMinPage;
+        pcache1LeaveMutex(pGroup);
+      }
     }
   }
   return (sqlite3_pcache *)pCache;
@@ -615,14 +835,19 @@ static sqlite3_pcache *pcache1Create(int szPage, int szExtra, int bPurgeable){
 static void pcache1Cachesize(sqlite3_pcache *p, int nMax){
   PCache1 *pCache = (PCache1 *)p;
   if( pCache->bPurgeable ){
-    PGroup *pGroup = pCache->pGroup;
-    pcache1EnterMutex(pGroup);
-    pGroup->nMaxPage += (nMax - pCache->nMax);
-    pGroup->mxPinned = pGroup->nMaxPage + 10 - pGroup->nMinPage;
+    int i;
+    for(i=0; i<pCache->nShard; i++){
+      PGroup *pGroup = pCache->aShard[i].pGroup;
+      pcache1EnterMutex(pGroup);
+      pGroup->nMaxPage += pcache1Share(nMax, i, pCache->nShard);
+      pGroup->nMaxPage -= pcache1Share(pCache->nMax, i, pCache->nShard);
+      pGroup->mxPinned = pGroup->nMaxPage + pGroup->nSlack
+                       - pGroup->nMinPage;
+      pcache1EnforceMaxPage(pGroup);
+      pcache1LeaveMutex(pGroup);
+    }
     pCache->nMax = nMax;
     pCache->n90pct = pCache->nMax*9/10;
-    pcache1EnforceMaxPage(pGroup);
-    pcache1LeaveMutex(pGroup);
   }
 }
 
@@ -634,14 +859,17 @@ static void pcache1Cachesize(sqlite3_pcache *p, int nMax){
 static void pcache1Shrink(sqlite3_pcache *p){
   PCache1 *pCache = (PCache1*)p;
   if( pCache->bPurgeable ){
-    PGroup *pGroup = pCache->pGroup;
-    int savedMaxPage;
-    pcache1EnterMutex(pGroup);
-    savedMaxPage = pGroup->nMaxPage;
-    pGroup->nMaxPage = 0;
-    pcache1EnforceMaxPage(pGroup);
-    pGroup->nMaxPage = savedMaxPage;
-    pcache1LeaveMutex(pGroup);
+    int i;
+    for(i=0; i<pCache->nShard; i++){
+      PGroup *pGroup = pCache->aShard[i].pGroup;
+      int savedMaxPage;
+      pcache1EnterMutex(pGroup);
+      savedMaxPage = pGroup->nMaxPage;
+      pGroup->nMaxPage = 0;
+      pcache1EnforceMaxPage(pGroup);
+      pGroup->nMaxPage = savedMaxPage;
+      pcache1LeaveMutex(pGroup);
+    }
   }
 }
 
@@ -649,11 +877,15 @@ static void pcache1Shrink(sqlite3_pcache *p){
 ** Implementation of the sqlite3_pcache.xPagecount method. 
 */
 static int pcache1Pagecount(sqlite3_pcache *p){
-  int n;
+  int n = 0;
+  int i;
   PCache1 *pCache = (PCache1*)p;
-  pcache1EnterMutex(pCache->pGroup);
-  n = pCache->nPage;
-  pcache1LeaveMutex(pCache->pGroup);
+  for(i=0; i<pCache->nShard; i++){
+    PCache1Shard *pShard = &pCache->aShard[i];
+    pcache1EnterMutex(pShard->pGroup);
+    n += pShard->nPage;
+    pcache1LeaveMutex(pShard->pGroup);
+  }
   return n;
 }
 
@@ -688,9 +920,10 @@ static int pcache1Pagecount(sqlite3_pcache *p){
 **       (a) the number of pages pinned by the cache is greater than
 **           PCache1.nMax, or
 **
-**       (b) the number of pages pinned by the cache is greater than
-**           the sum of nMax for all purgeable caches, less the sum of 
-**           nMin for all other purgeable caches, or
+**       (b) the number of pages of the shard pinned by the cache is
+**           greater than the shard's share of nMax for all purgeable
+**           caches, less its share of nMin for all other purgeable
+**           caches, or
 **
 **   4. If none of the first three conditions apply and the cache is marked
 **      as purgeable, and if one of the following is true:
@@ -698,16 +931,20 @@ static int pcache1Pagecount(sqlite3_pcache *p){
 **       (a) The number of pages allocated for the cache is already 
 **           PCache1.nMax, or
 **
-**       (b) The number of pages allocated for all purgeable caches is
-**           already equal to or greater than the sum of nMax for all
-**           purgeable caches,
+**       (b) The number of pages of the shard allocated for all purgeable
+**           caches is already equal to or greater than the shard's share
+**           of nMax for all purgeable caches,
 **
 **       (c) The system is under memory pressure and wants to avoid
 **           unnecessary pages cache entry allocations
 **
-**      then attempt to recycle a page from the LRU list. If it is the right
-**      size, return the recycled buffer. Otherwise, free the buffer and
-**      proceed to step 5. 
+**      then attempt to recycle a page from the LRU list of the shard. If it
+**      is the right size, return the recycled buffer. Otherwise, free the
+**      buffer and proceed to step 5. 
+**
+** Only the mutex of the shard that page iKey belongs to is taken. The
+** page counts of the other shards of the cache are read without a mutex
+** (see pcache1LazyCount()).
 **
 **   5. Otherwise, allocate and return a new page buffer.
 */
@@ -717,7 +954,9 @@ static sqlite3_pcache_page *pcache1Fetch(
   int createFlag
 ){
   unsigned int nPinned;
+  unsigned int nCachePinned;
   PCache1 *pCache = (PCache1 *)p;
+  PCache1Shard *pShard = pcache1Shard(pCache, iKey);
   PGroup *pGroup;
   PgHdr1 *pPage = 0;
 
@@ -725,17 +964,23 @@ static sqlite3_pcache_page *pcache1Fetch(
   assert( pCache->bPurgeable || pCache->nMin==0 );
   assert( pCache->bPurgeable==0 || pCache->nMin==10 );
   assert( pCache->nMin==0 || pCache->bPurgeable );
-  pcache1EnterMutex(pGroup = pCache->pGroup);
+  pcache1EnterMutex(pGroup = pShard->pGroup);
 
   /* Step 1: Search the hash table for an existing entry. */
-  if( pCache->nHash>0 ){
-    unsigned int h = iKey % pCache->nHash;
-    for(pPage=pCache->apHash[h]; pPage&&pPage->iKey!=iKey; pPage=pPage->pNext);
+  if( pShard->nHash>0 ){
+    unsigned int h = iKey % pShard->nHash;
+    for(pPage=pShard->apHash[h]; pPage&&pPage->iKey!=iKey; pPage=pPage->pNext);
   }
 
   /* Step 2: Abort if no existing page is found and createFlag is 0 */
+  if( pPage ){
+    pShard->pGroup->nHit++;
+  }else{
+    pShard->pGroup->nMiss++;
+  }
   if( pPage || createFlag==0 ){
     pcache1PinPage(pPage);
+    if( pPage && pcache1.ePolicy==SQLITE_PCACHE_POLICY_2Q ) pPage->bHot = 1;
     goto fetch_out;
   }
 
@@ -747,38 +992,43 @@ static sqlite3_pcache_page *pcache1Fetch(
   ** this point.
   */
 #ifdef SQLITE_MUTEX_OMIT
-  pGroup = pCache->pGroup;
+  pGroup = pShard->pGroup;
 #endif
 
   /* Step 3: Abort if createFlag is 1 but the cache is nearly full */
-  assert( pCache->nPage >= pCache->nRecyclable );
-  nPinned = pCache->nPage - pCache->nRecyclable;
-  assert( pGroup->mxPinned == pGroup->nMaxPage + 10 - pGroup->nMinPage );
+  assert( pShard->nPage >= pShard->nRecyclable );
+  nPinned = pShard->nPage - pShard->nRecyclable;
+  pcache1LazyCount(pCache, &nCachePinned);
+  assert( pGroup->mxPinned==pGroup->nMaxPage+pGroup->nSlack-pGroup->nMinPage );
   assert( pCache->n90pct == pCache->nMax*9/10 );
   if( createFlag==1 && (
         nPinned>=pGroup->mxPinned
-     || nPinned>=pCache->n90pct
+     || nCachePinned>=pCache->n90pct
      || pcache1UnderMemoryPressure(pCache)
   )){
     goto fetch_out;
   }
 
-  if( pCache->nPage>=pCache->nHash && pcache1ResizeHash(pCache) ){
+  if( pShard->nPage>=pShard->nHash && pcache1ResizeHash(pShard) ){
     goto fetch_out;
   }
 
   /* Step 4. Try to recycle a page. */
-  if( pCache->bPurgeable && pGroup->pLruTail && (
-         (pCache->nPage+1>=pCache->nMax)
+  if( pCache->bPurgeable && (pGroup->pLruTail || pGroup->pHotTail) && (
+         (pcache1LazyCount(pCache, 0)+1>=pCache->nMax)
       || pGroup->nCurrentPage>=pGroup->nMaxPage
       || pcache1UnderMemoryPressure(pCache)
   )){
     PCache1 *pOther;
-    pPage = pGroup->pLruTail;
+    pPage = pcache1LruVictim(pGroup);
     pcache1RemoveFromHash(pPage);
     pcache1PinPage(pPage);
     pOther = pPage->pCache;
 
+    /* Every page on the LRU list of a shard belongs to that shard in its
+    ** own cache, so its buffer may be reused for page iKey of pCache.  */
+    assert( pcache1Shard(pOther, pPage->iKey)->pGroup==pGroup );
+
     /* We want to verify that szPage and szExtra are the same for pOther
     ** and pCache.  Assert that we can verify this by comparing sums. */
     assert( (pCache->szPage & (pCache->szPage-1))==0 && pCache->szPage>=512 );
@@ -799,20 +1049,28 @@ static sqlite3_pcache_page *pcache1Fetch(
   */
   if( !pPage ){
     if( createFlag==1 ) sqlite3BeginBenignMalloc();
-    pPage = pcache1AllocPage(pCache);
+    pPage = pcache1AllocPage(pCache, pGroup);
     if( createFlag==1 ) sqlite3EndBenignMalloc();
   }
 
   if( pPage ){
-    unsigned int h = iKey % pCache->nHash;
-    pCache->nPage++;
+    unsigned int h = iKey % pShard->nHash;
+    pShard->nPage++;
     pPage->iKey = iKey;
-    pPage->pNext = pCache->apHash[h];
+    pPage->pNext = pShard->apHash[h];
     pPage->pCache = pCache;
     pPage->pLruPrev = 0;
     pPage->pLruNext = 0;
+    pPage->bHot = 0;
     *(void **)pPage->page.pExtra = 0;
-    pCache->apHash[h] = pPage;
+    pShard->apHash[h] = pPage;
+    if( pcache1.ePolicy==SQLITE_PCACHE_POLICY_2Q ){
+      u32 tag = pcache1GhostTag(pCache, iKey);
+      if( pGroup->aGhost[tag % PCACHE1_NGHOST]==tag ){
+        pGroup->aGhost[tag % PCACHE1_NGHOST] = 0;
+        pPage->bHot = 1;
+      }
+    }
   }
 
 fetch_out:
@@ -836,7 +1094,8 @@ static void pcache1Unpin(
 ){
   PCache1 *pCache = (PCache1 *)p;
   PgHdr1 *pPage = (PgHdr1 *)pPg;
-  PGroup *pGroup = pCache->pGroup;
+  PCache1Shard *pShard = pcache1Shard(pCache, pPage->iKey);
+  PGroup *pGroup = pShard->pGroup;
  
   assert( pPage->pCache==pCache );
   pcache1EnterMutex(pGroup);
@@ -846,24 +1105,35 @@ static void pcache1Unpin(
   */
   assert( pPage->pLruPrev==0 && pPage->pLruNext==0 );
   assert( pGroup->pLruHead!=pPage && pGroup->pLruTail!=pPage );
+  assert( pGroup->pHotHead!=pPage && pGroup->pHotTail!=pPage );
 
   if( reuseUnlikely || pGroup->nCurrentPage>pGroup->nMaxPage ){
     pcache1RemoveFromHash(pPage);
     pcache1FreePage(pPage);
   }else{
-    /* Add the page to the PGroup LRU list. */
-    if( pGroup->pLruHead ){
-      pGroup->pLruHead->pLruPrev = pPage;
-      pPage->pLruNext = pGroup->pLruHead;
-      pGroup->pLruHead = pPage;
+    /* Add the page to the head of the PGroup LRU list it belongs on. */
+    PgHdr1 **ppHead;
+    PgHdr1 **ppTail;
+    if( pPage->bHot ){
+      ppHead = &pGroup->pHotHead;
+      ppTail = &pGroup->pHotTail;
+    }else{
+      ppHead = &pGroup->pLruHead;
+      ppTail = &pGroup->pLruTail;
+      pGroup->nCold++;
+    }
+    if( *ppHead ){
+      (*ppHead)->pLruPrev = pPage;
+      pPage->pLruNext = *ppHead;
+      *ppHead = pPage;
     }else{
-      pGroup->pLruTail = pPage;
-      pGroup->pLruHead = pPage;
+      *ppTail = pPage;
+      *ppHead = pPage;
     }
-    pCache->nRecyclable++;
+    pShard->nRecyclable++;
   }
 
-  pcache1LeaveMutex(pCache->pGroup);
+  pcache1LeaveMutex(pGroup);
 }
 
 /*
@@ -877,29 +1147,42 @@ static void pcache1Rekey(
 ){
   PCache1 *pCache = (PCache1 *)p;
   PgHdr1 *pPage = (PgHdr1 *)pPg;
+  PCache1Shard *pOld = pcache1Shard(pCache, iOld);
+  PCache1Shard *pNew = pcache1Shard(pCache, iNew);
   PgHdr1 **pp;
   unsigned int h; 
   assert( pPage->iKey==iOld );
   assert( pPage->pCache==pCache );
 
-  pcache1EnterMutex(pCache->pGroup);
-
-  h = iOld%pCache->nHash;
-  pp = &pCache->apHash[h];
+  /* The page is pinned, so it is not on any LRU list and no other cache
+  ** can find it while it is briefly absent from both hash tables. The
+  ** two shard mutexes are therefore never held at the same time. If
+  ** the page moves between shards, so does its share of nCurrentPage. */
+  pcache1EnterMutex(pOld->pGroup);
+  h = iOld%pOld->nHash;
+  pp = &pOld->apHash[h];
   while( (*pp)!=pPage ){
     pp = &(*pp)->pNext;
   }
   *pp = pPage->pNext;
+  if( pOld!=pNew ){
+    pOld->nPage--;
+    if( pCache->bPurgeable ) pOld->pGroup->nCurrentPage--;
+    pcache1LeaveMutex(pOld->pGroup);
+    pcache1EnterMutex(pNew->pGroup);
+    pNew->nPage++;
+    if( pCache->bPurgeable ) pNew->pGroup->nCurrentPage++;
+  }
 
-  h = iNew%pCache->nHash;
+  h = iNew%pNew->nHash;
   pPage->iKey = iNew;
-  pPage->pNext = pCache->apHash[h];
-  pCache->apHash[h] = pPage;
+  pPage->pNext = pNew->apHash[h];
+  pNew->apHash[h] = pPage;
   if( iNew>pCache->iMaxKey ){
     pCache->iMaxKey = iNew;
   }
 
-  pcache1LeaveMutex(pCache->pGroup);
+  pcache1LeaveMutex(pNew->pGroup);
 }
 
 /*
@@ -911,12 +1194,16 @@ static void pcache1Rekey(
 */
 static void pcache1Truncate(sqlite3_pcache *p, unsigned int iLimit){
   PCache1 *pCache = (PCache1 *)p;
-  pcache1EnterMutex(pCache->pGroup);
   if( iLimit<=pCache->iMaxKey ){
-    pcache1TruncateUnsafe(pCache, iLimit);
+    int i;
+    for(i=0; i<pCache->nShard; i++){
+      PCache1Shard *pShard = &pCache->aShard[i];
+      pcache1EnterMutex(pShard->pGroup);
+      pcache1TruncateUnsafe(pShard, iLimit);
+      pcache1LeaveMutex(pShard->pGroup);
+    }
     pCache->iMaxKey = iLimit-1;
   }
-  pcache1LeaveMutex(pCache->pGroup);
 }
 
 /*
@@ -926,18 +1213,34 @@ static void pcache1Truncate(sqlite3_pcache *p, unsigned int iLimit){
 */
 static void pcache1Destroy(sqlite3_pcache *p){
   PCache1 *pCache = (PCache1 *)p;
-  PGroup *pGroup = pCache->pGroup;
+  int i;
   assert( pCache->bPurgeable || (pCache->nMax==0 && pCache->nMin==0) );
-  pcache1EnterMutex(pGroup);
-  pcache1TruncateUnsafe(pCache, 0);
-  assert( pGroup->nMaxPage >= pCache->nMax );
-  pGroup->nMaxPage -= pCache->nMax;
-  assert( pGroup->nMinPage >= pCache->nMin );
-  pGroup->nMinPage -= pCache->nMin;
-  pGroup->mxPinned = pGroup->nMaxPage + 10 - pGroup->nMinPage;
-  pcache1EnforceMaxPage(pGroup);
-  pcache1LeaveMutex(pGroup);
-  sqlite3_free(pCache->apHash);
+  for(i=0; i<pCache->nShard; i++){
+    PCache1Shard *pShard = &pCache->aShard[i];
+    PGroup *pGroup = pShard->pGroup;
+    unsigned int nMax = pcache1Share(pCache->nMax, i, pCache->nShard);
+    unsigned int nMin = pcache1Share(pCache->nMin, i, pCache->nShard);
+    pcache1EnterMutex(pGroup);
+    pcache1TruncateUnsafe(pShard, 0);
+    assert( pGroup->nMaxPage >= nMax );
+    pGroup->nMaxPage -= nMax;
+    assert( pGroup->nMinPage >= nMin );
+    pGroup->nMinPage -= nMin;
+    pGroup->mxPinned = pGroup->nMaxPage + pGroup->nSlack
+                     - pGroup->nMinPage;
+    pcache1EnforceMaxPage(pGroup);
+    pcache1LeaveMutex(pGroup);
+    sqlite3_free(pShard->apHash);
+  }
+  if( pCache->nShard==1 ){
+    /* A mode (1) cache. Fold the hit and miss counts of its private
+    ** PGroup into the global totals reported by sqlite3PcacheStats(). */
+    PGroup *pGroup = pCache->aShard[0].pGroup;
+    sqlite3_mutex_enter(pcache1.mutex);
+    pcache1.nHit += pGroup->nHit;
+    pcache1.nMiss += pGroup->nMiss;
+    sqlite3_mutex_leave(pcache1.mutex);
+  }
   sqlite3_free(pCache);
 }
 
@@ -965,6 +1268,60 @@ void sqlite3PCacheSetDefault(void){
   sqlite3_config(SQLITE_CONFIG_PCACHE2, &defaultMethods);
 }
 
+/*
+** Return true if the page cache implementation in use is this one, so
+** that sqlite3Pcache1Peek() and sqlite3Pcache1Keys() may be called on the
+** caches it creates.
+*/
+int sqlite3Pcache1IsDefault(void){
+  return sqlite3GlobalConfig.pcache2.xFetch==pcache1Fetch;
+}
+
+/*
+** Return true if page iKey of cache p is resident. Unlike xFetch(), this
+** does not pin the page, is not counted as a hit or a miss and does not
+** move the page to the hot list, so probes made only to decide whether
+** to read a page ahead do not influence the replacement policy.
+*/
+int sqlite3Pcache1Peek(sqlite3_pcache *p, unsigned int iKey){
+  PCache1 *pCache = (PCache1 *)p;
+  PCache1Shard *pShard = pcache1Shard(pCache, iKey);
+  PgHdr1 *pPage = 0;
+
+  pcache1EnterMutex(pShard->pGroup);
+  if( pShard->nHash>0 ){
+    unsigned int h = iKey % pShard->nHash;
+    for(pPage=pShard->apHash[h]; pPage&&pPage->iKey!=iKey; pPage=pPage->pNext);
+  }
+  pcache1LeaveMutex(pShard->pGroup);
+  return pPage!=0;
+}
+
+/*
+** Write the keys of up to nMax pages resident in cache p to aKey[], in no
+** particular order, and return the number written. Like
+** sqlite3Pcache1Peek(), this has no effect on the replacement policy.
+*/
+int sqlite3Pcache1Keys(sqlite3_pcache *p, unsigned int *aKey, int nMax){
+  PCache1 *pCache = (PCache1 *)p;
+  int n = 0;
+  int i;
+
+  for(i=0; i<pCache->nShard; i++){
+    PCache1Shard *pShard = &pCache->aShard[i];
+    unsigned int h;
+    pcache1EnterMutex(pShard->pGroup);
+    for(h=0; h<pShard->nHash && n<nMax; h++){
+      PgHdr1 *pPage;
+      for(pPage=pShard->apHash[h]; pPage && n<nMax; pPage=pPage->pNext){
+        aKey[n++] = pPage->iKey;
+      }
+    }
+    pcache1LeaveMutex(pShard->pGroup);
+  }
+  return n;
+}
+
 #ifdef SQLITE_ENABLE_MEMORY_MANAGEMENT
 /*
 ** This function is called to free superfluous dynamically allocated memory
@@ -977,21 +1334,25 @@ void sqlite3PCacheSetDefault(void){
 */
 int sqlite3PcacheReleaseMemory(int nReq){
   int nFree = 0;
-  assert( sqlite3_mutex_notheld(pcache1.grp.mutex) );
+  assert( pcache1NoGroupMutexHeld() );
   assert( sqlite3_mutex_notheld(pcache1.mutex) );
   if( pcache1.pStart==0 ){
-    PgHdr1 *p;
-    pcache1EnterMutex(&pcache1.grp);
-    while( (nReq<0 || nFree<nReq) && ((p=pcache1.grp.pLruTail)!=0) ){
-      nFree += pcache1MemSize(p->page.pBuf);
+    int i;
+    for(i=0; i<SQLITE_PCACHE_NSHARD && (nReq<0 || nFree<nReq); i++){
+      PGroup *pGroup = &pcache1.aGrp[i];
+      PgHdr1 *p;
+      pcache1EnterMutex(pGroup);
+      while( (nReq<0 || nFree<nReq) && ((p=pcache1LruVictim(pGroup))!=0) ){
+        nFree += pcache1MemSize(p->page.pBuf);
 #ifdef SQLITE_PCACHE_SEPARATE_HEADER
-      nFree += sqlite3MemSize(p);
+        nFree += sqlite3MemSize(p);
 #endif
-      pcache1PinPage(p);
-      pcache1RemoveFromHash(p);
-      pcache1FreePage(p);
+        pcache1PinPage(p);
+        pcache1RemoveFromHash(p);
+        pcache1FreePage(p);
+      }
+      pcache1LeaveMutex(pGroup);
     }
-    pcache1LeaveMutex(&pcache1.grp);
   }
   return nFree;
 }
@@ -1001,21 +1362,47 @@ int sqlite3PcacheReleaseMemory(int nReq){
 /*
 ** This function is used by test procedures to inspect the internal state
 ** of the global cache.
+**
+** The hit and miss counts cover every xFetch() call made on a cache of
+** the global PGroup, plus those of mode (1) caches that have already been
+** destroyed. Comparing *pnHit/(*pnHit+*pnMiss) for the two replacement
+** policies on the same workload shows which one suits it better.
 */
 void sqlite3PcacheStats(
   int *pnCurrent,      /* OUT: Total number of pages cached */
   int *pnMax,          /* OUT: Global maximum cache size */
   int *pnMin,          /* OUT: Sum of PCache1.nMin for purgeable caches */
-  int *pnRecyclable    /* OUT: Total number of pages available for recycling */
+  int *pnRecyclable,   /* OUT: Total number of pages available for recycling */
+  i64 *pnHit,          /* OUT: Number of xFetch() calls that found the page */
+  i64 *pnMiss          /* OUT: Number of xFetch() calls that did not */
 ){
   PgHdr1 *p;
   int nRecyclable = 0;
-  for(p=pcache1.grp.pLruHead; p; p=p->pLruNext){
-    nRecyclable++;
+  int nCurrent = 0;
+  int nMax = 0;
+  int nMin = 0;
+  i64 nHit = pcache1.nHit;
+  i64 nMiss = pcache1.nMiss;
+  int i;
+  for(i=0; i<SQLITE_PCACHE_NSHARD; i++){
+    PGroup *pGroup = &pcache1.aGrp[i];
+    for(p=pGroup->pLruHead; p; p=p->pLruNext){
+      nRecyclable++;
+    }
+    for(p=pGroup->pHotHead; p; p=p->pLruNext){
+      nRecyclable++;
+    }
+    nCurrent += pGroup->nCurrentPage;
+    nMax += (int)pGroup->nMaxPage;
+    nMin += (int)pGroup->nMinPage;
+    nHit += pGroup->nHit;
+    nMiss += pGroup->nMiss;
   }
-  *pnCurrent = pcache1.grp.nCurrentPage;
-  *pnMax = (int)pcache1.grp.nMaxPage;
-  *pnMin = (int)pcache1.grp.nMinPage;
+  *pnCurrent = nCurrent;
+  *pnMax = nMax;
+  *pnMin = nMin;
   *pnRecyclable = nRecyclable;
+  *pnHit = nHit;
+  *pnMiss = nMiss;
 }
 #endif
@@ -270,7 +270,7 @@ const char *sqlite3JournalModename(int eMode){
   static char * const azModeName[] = {
     "delete", "persist", "off", "truncate", "memory"
 #ifndef SQLITE_OMIT_WAL
-     , "wal"
+     , "wal", "wal2"
 #endif
   };
   assert( PAGER_JOURNALMODE_DELETE==0 );
@@ -279,6 +279,7 @@ const char *sqlite3JournalModename(int eMode){
   assert( PAGER_JOURNALMODE_TRUNCATE==3 );
   assert( PAGER_JOURNALMODE_MEMORY==4 );
   assert( PAGER_JOURNALMODE_WAL==5 );
+  assert( PAGER_JOURNALMODE_WAL2==6 );
   assert( eMode>=0 && eMode<=ArraySize(azModeName) );
 
   if( eMode==ArraySize(azModeName) ) return 0;
@@ -565,7 +566,7 @@ void sqlite3Pragma(
   /*
   **  PRAGMA [database.]journal_mode
   **  PRAGMA [database.]journal_mode =
-  **                      (delete|persist|off|truncate|memory|wal|off)
+  **                      (delete|persist|off|truncate|memory|wal|wal2|off)
   */
   if( sqlite3StrICmp(zLeft,"journal_mode")==0 ){
     int eMode;        /* One of the PAGER_JOURNALMODE_XXX symbols */
@@ -629,6 +630,41 @@ void sqlite3Pragma(
     returnSingleInt(pParse, "journal_size_limit", iLimit);
   }else
 
+  /*
+  **  PRAGMA [database.]mmap_size
+  **  PRAGMA [database.]mmap_size=N
+  **
+  ** Get or set the maximum number of bytes of the database file that
+  ** will be accessed using memory-mapped I/O. A negative value restores
+  ** the compile-time default (SQLITE_DEFAULT_MMAP_SIZE). Setting the
+  ** value to zero disables memory-mapped I/O. If the database is
+  ** not named, the limit applies to all attached databases.
+  */
+  if( sqlite3StrICmp(zLeft,"mmap_size")==0 ){
+    sqlite3_int64 sz;
+    if( zRight ){
+      int ii;
+      sqlite3Atoi64(zRight, &sz, 1000, SQLITE_UTF8);
+      if( sz<0 ) sz = SQLITE_DEFAULT_MMAP_SIZE;
+      for(ii=db->nDb-1; ii>=0; ii--){
+        if( db->aDb[ii].pBt && (ii==iDb || pId2->n==0) ){
+          sqlite3PagerMmapLimit(sqlite3BtreePager(db->aDb[ii].pBt), sz);
+        }
+      }
+    }
+    sz = -1;
+    rc = sqlite3_file_control(db, zDb, SQLITE_FCNTL_MMAP_SIZE, &sz);
+#if SQLITE_MAX_MMAP_SIZE==0
+    sz = 0;
+#endif
+    if( rc==SQLITE_OK ){
+      returnSingleInt(pParse, "mmap_size", sz);
+    }else if( rc!=SQLITE_NOTFOUND ){
+      pParse->nErr++;
+      pParse->rc = rc;
+    }
+  }else
+
 #endif /* SQLITE_OMIT_PAGER_PRAGMAS */
 
   /*
@@ -1524,6 +1560,65 @@ void sqlite3Pragma(
        db->xWalCallback==sqlite3WalDefaultHook ? 
            SQLITE_PTR_TO_INT(db->pWalArg) : 0);
   }else
+
+  /*
+  **   PRAGMA [database.]wal_group_commit
+  **   PRAGMA [database.]wal_group_commit = N
+  **
+  ** Get or set the group commit window for a WAL database, in
+  ** microseconds. A negative value disables group commit. Zero lets
+  ** commits share a sync only if they join before the first commit in
+  ** the group has finished. A value greater than zero makes the
+  ** connection that owns each group wait that long before syncing, so
+  ** that more commits may join it.
+  */
+  if( sqlite3StrICmp(zLeft, "wal_group_commit")==0 ){
+    Pager *pPager = sqlite3BtreePager(pDb->pBt);
+    int N = -2;
+    if( zRight ){
+      N = sqlite3Atoi(zRight);
+      if( N<-1 ) N = -1;
+    }
+    returnSingleInt(pParse, "wal_group_commit",
+                    sqlite3PagerWalGroupCommit(pPager, N));
+  }else
+
+  /*
+  **   PRAGMA [database.]wal_shared_readers
+  **   PRAGMA [database.]wal_shared_readers = boolean
+  **
+  ** Query or set whether read transactions on a WAL database share a
+  ** read lock with other connections in the same process that use the
+  ** same database, so that most of them do not need file locks.
+  */
+  if( sqlite3StrICmp(zLeft, "wal_shared_readers")==0 ){
+    Pager *pPager = sqlite3BtreePager(pDb->pBt);
+    int b = -1;
+    if( zRight ){
+      b = sqlite3GetBoolean(zRight, 0);
+    }
+    returnSingleInt(pParse, "wal_shared_readers",
+                    sqlite3PagerWalSharedReaders(pPager, b));
+  }else
+
+  /*
+  **   PRAGMA [database.]checkpoint_thread
+  **   PRAGMA [database.]checkpoint_thread = N
+  **
+  ** If N is greater than zero, hand the automatic checkpoints of the
+  ** database over to a background thread, which escalates to RESTART
+  ** checkpoints once the WAL holds N frames. If N is zero, run automatic
+  ** checkpoints inline again. Return the current value of N.
+  */
+  if( sqlite3StrICmp(zLeft, "checkpoint_thread")==0 ){
+    int N = -1;
+    if( zRight ){
+      N = sqlite3Atoi(zRight);
+      if( N<0 ) N = 0;
+    }
+    returnSingleInt(pParse, "checkpoint_thread",
+                    sqlite3WalCheckpointerConfig(db, iDb, N));
+  }else
 #endif
 
   /*
@@ -1536,6 +1631,41 @@ void sqlite3Pragma(
     sqlite3_db_release_memory(db);
   }else
 
+  /*
+  **   PRAGMA threads
+  **   PRAGMA threads = N
+  **
+  ** Configure the maximum number of worker threads that a prepared
+  ** statement may use for sorting.  Return the new limit.  The value
+  ** is silently capped at SQLITE_MAX_WORKER_THREADS.
+  */
+  if( sqlite3StrICmp(zLeft, "threads")==0 ){
+    sqlite3_int64 N;
+    if( zRight && sqlite3Atoi64(zRight, &N, 1000, SQLITE_UTF8)==0 && N>=0 ){
+      sqlite3_limit(db, SQLITE_LIMIT_WORKER_THREADS, (int)(N&0x7fffffff));
+    }
+    returnSingleInt(pParse, "threads",
+                    sqlite3_limit(db, SQLITE_LIMIT_WORKER_THREADS, -1));
+  }else
+
+#ifndef SQLITE_OMIT_STMT_PROFILE
+  /*
+  **   PRAGMA stmt_profile
+  **   PRAGMA stmt_profile = boolean
+  **
+  ** Query or set whether the run-time profile of each statement is
+  ** collected, for reading through the stmt_profile virtual table.
+  ** Turning profiling off discards all profiles collected so far.
+  */
+  if( sqlite3StrICmp(zLeft, "stmt_profile")==0 ){
+    if( zRight ){
+      db->bStmtProfile = sqlite3GetBoolean(zRight, 0);
+      if( db->bStmtProfile==0 ) sqlite3VdbeProfileClear(db);
+    }
+    returnSingleInt(pParse, "stmt_profile", db->bStmtProfile);
+  }else
+#endif
+
 #if defined(SQLITE_DEBUG) || defined(SQLITE_TEST)
   /*
   ** Report the current state of file logs for all databases
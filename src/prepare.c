@@ -629,10 +629,15 @@ static int sqlite3Prepare(
   if( rc==SQLITE_OK && pParse->pVdbe && pParse->explain ){
     static const char * const azColName[] = {
        "addr", "opcode", "p1", "p2", "p3", "p4", "p5", "comment",
-       "selectid", "order", "from", "detail"
+       "selectid", "order", "from", "detail",
+       "loops", "visited", "output", "cycles", "pages"
     };
     int iFirst, mx;
-    if( pParse->explain==2 ){
+    if( pParse->explain==3 ){
+      sqlite3VdbeSetNumCols(pParse->pVdbe, 9);
+      iFirst = 8;
+      mx = 17;
+    }else if( pParse->explain==2 ){
       sqlite3VdbeSetNumCols(pParse->pVdbe, 4);
       iFirst = 8;
       mx = 12;
@@ -643,6 +643,11 @@ static int sqliteProcessJoin(Parse *pParse, Select *p){/*定义静态整型进
 ** Insert code into "v" that will push the record on the top of the
 ** stack into the sorter.
 ** 把代码插入到"v"，分选机将会推进记录到栈的顶部。
+**
+** If the SELECT has a LIMIT, at most LIMIT+OFFSET rows are retained.
+** A sorter is passed the register holding that count and keeps only the
+** smallest keys in a bounded heap. An ephemeral index is trimmed by
+** deleting its largest entry whenever it grows beyond the count.
 */
 static void pushOntoSorter(/*定义静态函数更新数据*/ /*推进记录到栈的顶部*/
 	Parse *pParse,        /*定义数组指针 */  /* Parser context  语义分析*/
@@ -655,6 +660,10 @@ static void pushOntoSorter(/*定义静态函数更新数据*/ /*推进记录到
 	int regBase = sqlite3GetTempRange(pParse, nExpr + 2);  /*定义获取元素函数*/ /*分配或释放一块连续的寄存器，返回一个整数值，把该值赋给regBase。*/
 	int regRecord = sqlite3GetTempReg(pParse);  /*定义获取函数元素并取值*/ /*分配一个新的寄存器用于控制中间结果。*/
 	int op; /*定义整型数据*/
+	int iLimit = 0;  /* Register holding LIMIT+OFFSET, or 0 */
+	if (pSelect->iLimit){
+		iLimit = pSelect->iOffset ? pSelect->iOffset + 1 : pSelect->iLimit;
+	}
 	sqlite3ExprCacheClear(pParse); /*释放指定的缓存内容*/  /*清除所有列的缓存条目*/
 	sqlite3ExprCodeExprList(pParse, pOrderBy, regBase, 0);  /*调用函数进行传值*/ /*将表达式列表中每个元素的每个值都放到一个队列中，返回一个元素的估计个数。*/
 	sqlite3VdbeAddOp2(v, OP_Sequence, pOrderBy->iECursor, regBase + nExpr); /*调用函数进行函数传值*/ /*将表达式放到VDBE中，再返回一个新的指令地址*/
@@ -666,18 +675,12 @@ static void pushOntoSorter(/*定义静态函数更新数据*/ /*推进记录到
 	else{
 		op = OP_IdxInsert; /*定义插入值*/ /*否则使用索引方式插入*/
 	}
-	sqlite3VdbeAddOp2(v, op, pOrderBy->iECursor, regRecord); /*插入函数值*/ /*将Orderby表达式放到当前使用的VDBE中，然后返回一个新的指令地址*/
+	sqlite3VdbeAddOp3(v, op, pOrderBy->iECursor, regRecord,
+		op == OP_SorterInsert ? iLimit : 0); /*插入函数值*/ /*将Orderby表达式放到当前使用的VDBE中，然后返回一个新的指令地址*/
 	sqlite3ReleaseTempReg(pParse, regRecord);  /*释放寄存器中的值*/ /*释放regRecord寄存器*/
 	sqlite3ReleaseTempRange(pParse, regBase, nExpr + 2); /*继续释放寄存器中的值*/ /*释放regBase这个连续寄存器，长度是表达式的长度加2*/
-	if (pSelect->iLimit){ /*用判断语句进行判断表中值*/ /*如果使用Limit子句*/
+	if (iLimit && op == OP_IdxInsert){ /*用判断语句进行判断表中值*/ /*如果使用Limit子句*/
 		int addr1, addr2; /*定义两个增加变量名*/
-		int iLimit;/*定义限制变量名*/
-		if (pSelect->iOffset){  /*判断是否使用了Offset偏移量*/ /*如果使用了Offset偏移量*/
-			iLimit = pSelect->iOffset + 1; /*那么Limit的值为偏移量加1*/ /*那么Limit的值为偏移量加1*/
-		}
-		else{
-			iLimit = pSelect->iLimit; /*用表中的数据进行赋值*/  /*否则等于默认的，从第一个开始计算*/
-		}
 		addr1 = sqlite3VdbeAddOp1(v, OP_IfZero, iLimit); /*用地址名传值*/  /*这个地址是结果限制了返回的条数，给的新的指令地址*/
 		sqlite3VdbeAddOp2(v, OP_AddImm, iLimit, -1); /*调用添加函数进行传值*/ /*将指令放到当前使用的VDBE，然后返回一个地址*/
 		addr2 = sqlite3VdbeAddOp0(v, OP_Goto);/*把添加函数传的值赋给地址addr2*/ /*这个是使用Goto语句之后返回的地址*/
@@ -1064,6 +1067,9 @@ static KeyInfo *keyInfoFromExprList(Parse *pParse, ExprList *pList){/*定义静
 			pInfo->aSortOrder[i] = pItem->sortOrder;/*关键信息结构体中排序的顺序为语法分析树中语法项表达式的排序方法*/
 			/*备注：做标记，我没有看懂这种排序的方法，个人理解为把指定使用某种排序的方式记下来，如果没有使用系统默认的。再把语法树中表达式记下来，两者应该是一个东西，只是表达的方式不一样*/
 		}
+		if (nExpr>0){/*Pick the record comparison from the leading key term*/
+			sqlite3VdbeRecordCompareInit(pInfo, sqlite3ExprAffinity(pList->a[0].pExpr));
+		}
 	}
 	return pInfo;/*返回这个关键信息结构体*/
 }
@@ -1095,17 +1101,23 @@ static const char *selectOpName(int id){/*定义静态且是只读的字符型
 **
 ** where xxx is one of "DISTINCT", "ORDER BY" or "GROUP BY". Exactly which
 ** is determined by the zUsage argument.
+**
+** For EXPLAIN ANALYZE, iCsr is the cursor used to access the temp b-tree
+** or sorter, whose counters are reported alongside the row.
 ** 除非一个"EXPLAIN QUERY PLAN"命令正在处理，否则这个功能就是一个空操作。
 ** 否则，它增加一个单独的输出行到EQP结果，标题的形式为:
 ** "USE TEMP B-TREE FOR xxx"
 ** 其中xxx是"distinct","order by",或者"group by"中的一个。究竟是哪个由
 ** zUsage参数决定。
 */
-static void explainTempTable(Parse *pParse, const char *zUsage){
-	if (pParse->explain == 2){/*如果语法分析树中的explain是第二个*/
+static void explainTempTable(Parse *pParse, const char *zUsage, int iCsr){
+	if (pParse->explain >= 2){/*如果语法分析树中的explain是第二个*/
 		Vdbe *v = pParse->pVdbe;/*声明一个虚拟机*/
 		char *zMsg = sqlite3MPrintf(pParse->db, "USE TEMP B-TREE FOR %s", zUsage);/*把输出的格式的内容传递给zMsg，其中%S 是传入的参数在Usage*/
-		sqlite3VdbeAddOp4(v, OP_Explain, pParse->iSelectId, 0, 0, zMsg, P4_DYNAMIC); /*添加一个操作码，其中包括作为指针的p4值。*/
+		int addr = sqlite3VdbeAddOp4(v, OP_Explain, pParse->iSelectId, 0, 0, zMsg, P4_DYNAMIC); /*添加一个操作码，其中包括作为指针的p4值。*/
+		if (pParse->explain == 3){
+			sqlite3VdbeScanStat(v, addr, -1, -1, iCsr, -1);
+		}
 	}
   }
 }
@@ -1124,7 +1136,7 @@ static void explainTempTable(Parse *pParse, const char *zUsage){
 
 #else
 /* No-op versions of the explainXXX() functions and macros. explainXXX() 函数和宏无操作符的版本。*/
-# define explainTempTable(y,z)
+# define explainTempTable(x,y,z)
 # define explainSetInteger(y,z)
 #endif
 
@@ -1159,7 +1171,7 @@ static void explainComposite(
 	int bUseTmp                     /* True if a temp table was used 如果使用的是临时表，就是true*/
 	){
 	assert(op == TK_UNION || op == TK_EXCEPT || op == TK_INTERSECT || op == TK_ALL);/*判断op是否是TK_UNION、TK_EXCEPT、K_INTERSECT或TK_ALL中的一种或几种*/
-	if (pParse->explain == 2){/*如果pParse->explain与字符z相同*/
+	if (pParse->explain >= 2){/*如果pParse->explain与字符z相同*/
 		Vdbe *v = pParse->pVdbe;/*声明一个虚拟机*/
 		char *zMsg = sqlite3MPrintf(/*设置标记信息*/
 			pParse->db, "COMPOUND SUBQUERIES %d AND %d %s(%s)", iSub1, iSub2,
@@ -1285,6 +1297,13 @@ static void generateSortTail(
 	sqlite3ReleaseTempReg(pParse, regRow);/*释放寄存器*/
 	sqlite3ReleaseTempReg(pParse, regRowid);/*释放寄存器*/
 
+	/* A sorter may return more than LIMIT+OFFSET rows if it had to give
+	** up its bounded heap, so stop once LIMIT rows have been output.
+	*/
+	if (p->iLimit && (p->selFlags & SF_UseSorter)){
+		sqlite3VdbeAddOp3(v, OP_IfZero, p->iLimit, addrBreak, -1);
+	}
+
 	/* The bottom of the loop
 	** 循环的底部
 	*/
@@ -4682,7 +4701,7 @@ static void explainSimpleCount(
 	Table *pTab,                    /* 正在查询的表*/
 	Index *pIdx                     /* 用于优化扫描的索引 */
 	){
-	if (pParse->explain == 2){/*如果语法解析树中explain表达式为2*/
+	if (pParse->explain >= 2){/*如果语法解析树中explain表达式为2*/
 		char *zEqp = sqlite3MPrintf(pParse->db, "SCAN TABLE %s %s%s(~%d rows)",
 			pTab->zName,
 			pIdx ? "USING COVERING INDEX " : "",
@@ -4698,6 +4717,342 @@ static void explainSimpleCount(
 # define explainSimpleCount(a,b,c)
 #endif
 
+#ifndef SQLITE_OMIT_HASH_AGGREGATE
+#ifdef SQLITE_TEST
+/*
+** If this variable is set, GROUP BY queries are never computed using a
+** hash table.  Test builds only.
+*/
+int sqlite3_select_nohash = 0;
+#else
+# define sqlite3_select_nohash 0
+#endif
+
+/*
+** Return true if the GROUP BY clause pGroupBy of aggregate query p should
+** be computed using an in-memory hash table (see vdbehash.c) instead of by
+** sorting every input row.  nAggReg is the number of registers of
+** accumulator state that each group requires.
+**
+** The hash strategy is only chosen when ANALYZE statistics show that the
+** query produces few groups relative to the number of input rows, and that
+** those groups will fit in the same memory budget the sorter uses for a
+** single in-memory run.  Without statistics the sorter is always used.  In
+** any case, groups that do not fit in memory at run-time are passed on to
+** the sorter and aggregated in the usual way.
+**
+** Queries with DISTINCT aggregates, aggregates whose state may grow without
+** bound (min(), max(), group_concat() and application-defined functions),
+** non-BINARY GROUP BY collations, or an ORDER BY clause that is satisfied
+** by the sorted GROUP BY output are not candidates.
+*/
+static int groupByUseHash(
+	Parse *pParse,                  /* Parsing context */
+	Select *p,                      /* The aggregate query */
+	ExprList *pGroupBy,             /* The GROUP BY clause */
+	ExprList *pOrderBy,             /* ORDER BY clause, or NULL if it was dropped */
+	AggInfo *pAggInfo,              /* Aggregate information for p */
+	int nAggReg                     /* Registers of state per group */
+	){
+	sqlite3 *db = pParse->db;
+	SrcList *pTabList = p->pSrc;
+	Table *pTab;
+	Index *pIdx;
+	tRowcnt nRow = 0;               /* Estimated number of input rows */
+	tRowcnt nGroup = 0;             /* Estimated number of groups */
+	int i;
+
+	if (sqlite3_select_nohash) return 0;
+	if (p->pOrderBy && pOrderBy == 0) return 0;
+	if (pTabList->nSrc != 1) return 0;
+	pTab = pTabList->a[0].pTab;
+	if (pTab == 0 || pTab->pSelect || IsVirtual(pTab)) return 0;
+	for (i = 0; i < pAggInfo->nFunc; i++){
+		if (pAggInfo->aFunc[i].iDistinct >= 0) return 0;
+		if (!sqlite3FixedSizeAgg(pAggInfo->aFunc[i].pFunc)) return 0;
+	}
+	for (i = 0; i < pGroupBy->nExpr; i++){
+		Expr *pExpr = pGroupBy->a[i].pExpr;
+		CollSeq *pColl = sqlite3ExprCollSeq(pParse, pExpr);
+		if (pColl && sqlite3StrICmp(pColl->zName, "BINARY")) return 0;
+		if ((pExpr->op != TK_COLUMN && pExpr->op != TK_AGG_COLUMN)
+			|| pExpr->iTable != pTabList->a[0].iCursor || pExpr->iColumn < 0){
+			return 0;
+		}
+	}
+
+	/* Look for an analyzed index whose left-most pGroupBy->nExpr columns are
+	** exactly the GROUP BY columns. aiRowEst[0]/aiRowEst[n] is then the
+	** estimated number of distinct GROUP BY keys.  */
+	for (pIdx = pTab->pIndex; pIdx; pIdx = pIdx->pNext){
+		int n = pGroupBy->nExpr;
+		if (!pIdx->hasStat1 || pIdx->nColumn < n || pIdx->aiRowEst[n] == 0) continue;
+		for (i = 0; i < n; i++){
+			int j;
+			int iCol = pGroupBy->a[i].pExpr->iColumn;
+			for (j = 0; j < n && pIdx->aiColumn[j] != iCol; j++);
+			if (j == n) break;
+		}
+		if (i < n) continue;
+		nRow = pIdx->aiRowEst[0];
+		nGroup = nRow / pIdx->aiRowEst[n];
+#ifdef SQLITE_ENABLE_STAT3
+		if (n == 1 && pIdx->nSample > 0){
+			/* sqlite_stat3 records the number of distinct values less than the
+			** largest sample, which is a better lower bound for skewed data. */
+			tRowcnt nDistinct = pIdx->aSample[pIdx->nSample - 1].nDLt + 1;
+			if (nDistinct > nGroup) nGroup = nDistinct;
+		}
+#endif
+		break;
+	}
+	if (pIdx == 0) return 0;
+
+	return nGroup <= sqlite3VdbeHashAggBudget(db, pGroupBy->nExpr, nAggReg)
+		&& nGroup * 2 <= nRow;
+}
+#endif /* SQLITE_OMIT_HASH_AGGREGATE */
+
+#ifndef SQLITE_OMIT_BATCH_AGGREGATE
+/*
+** The maximum number of WHERE clause terms, and of aggregate functions, in
+** a query computed by OP_BatchAgg.
+*/
+#define BATCHAGG_MAX_TERM 8
+
+#ifdef SQLITE_TEST
+/*
+** If this variable is set, aggregate queries are always computed a row at
+** a time, even when OP_BatchAgg could be used.  It is set by the
+** sqlite3_batch_agg_check command in test1.c.
+*/
+int sqlite3_select_nobatch = 0;
+#else
+# define sqlite3_select_nobatch 0
+#endif
+
+/*
+** If pExpr is a column of table pTab (open as cursor iCur) that OP_BatchAgg
+** is able to decode, return its column number.  Otherwise return -1.  The
+** INTEGER PRIMARY KEY column is not stored in the record, and columns with
+** TEXT affinity seldom hold numbers, so neither is used.
+*/
+static int batchAggColumn(Table *pTab, int iCur, Expr *pExpr){
+	int iCol;
+	if (pExpr == 0) return -1;
+	if (pExpr->op != TK_COLUMN && pExpr->op != TK_AGG_COLUMN) return -1;
+	iCol = pExpr->iColumn;
+	if (pExpr->iTable != iCur || iCol < 0 || iCol == pTab->iPKey) return -1;
+	if (pTab->aCol[iCol].affinity == SQLITE_AFF_TEXT) return -1;
+	return iCol;
+}
+
+/*
+** Return true if pExpr is a value that OP_BatchAgg may compare a column
+** against: a NULL, a bound parameter or a (possibly negated) number.
+*/
+static int batchAggValue(Expr *pExpr){
+	if (pExpr->op == TK_UMINUS){
+		pExpr = pExpr->pLeft;
+		return pExpr->op == TK_INTEGER || pExpr->op == TK_FLOAT;
+	}
+	return pExpr->op == TK_INTEGER || pExpr->op == TK_FLOAT
+		|| pExpr->op == TK_NULL || pExpr->op == TK_VARIABLE;
+}
+
+/*
+** Add the AND-connected terms of expression pExpr to apTerm[].  Return 0
+** if there are more than BATCHAGG_MAX_TERM of them.
+*/
+static int batchAggSplit(Expr *pExpr, Expr **apTerm, int *pnTerm){
+	if (pExpr == 0) return 1;
+	if (pExpr->op == TK_AND){
+		return batchAggSplit(pExpr->pLeft, apTerm, pnTerm)
+			&& batchAggSplit(pExpr->pRight, apTerm, pnTerm);
+	}
+	if (*pnTerm >= BATCHAGG_MAX_TERM) return 0;
+	apTerm[(*pnTerm)++] = pExpr;
+	return 1;
+}
+
+/*
+** Return the index of table column iCol in aiCol[], first appending it if
+** it is not already there.
+*/
+static int batchAggSlot(int *aiCol, int *pnSlot, int iCol){
+	int i;
+	for (i = 0; i < *pnSlot && aiCol[i] != iCol; i++);
+	if (i == *pnSlot) aiCol[(*pnSlot)++] = iCol;
+	return i;
+}
+
+/*
+** Try to compute aggregate query p, which has no GROUP BY clause, using
+** OP_BatchAgg (see vdbebatch.c).  This is possible if p reads a single
+** database table, not a subquery or view, if its WHERE clause pWhere is
+** made of terms "column op value" and "column IS [NOT] NULL" joined by
+** AND, and if it uses only the built-in count(), sum(), total(), avg(),
+** min() and max() aggregates of columns, without DISTINCT and with no bare
+** columns anywhere else in the query.
+**
+** If so, generate code to run OP_BatchAgg over the table and return a
+** label that the caller must resolve after the row at a time loop that
+** it codes next.  OP_BatchAgg jumps to that loop if it meets a row it
+** cannot handle.  Otherwise generate no code and return 0.
+*/
+static int batchAggregate(
+	Parse *pParse,                  /* Parsing context */
+	Select *p,                      /* The aggregate query */
+	Expr *pWhere,                   /* The WHERE clause of p */
+	AggInfo *pAggInfo               /* Aggregate information for p */
+	){
+	sqlite3 *db = pParse->db;
+	Vdbe *v = pParse->pVdbe;
+	SrcList *pTabList = p->pSrc;
+	Table *pTab;
+	int iCur;                           /* Cursor of the table in the row loop */
+	Expr *apTerm[BATCHAGG_MAX_TERM];    /* AND-connected terms of pWhere */
+	Expr *apValue[BATCHAGG_MAX_TERM];   /* Value compared by each term */
+	int aiCol[BATCHAGG_MAX_TERM * 2];   /* Table column of each slot */
+	int nTerm = 0;                      /* Number of entries in apTerm[] */
+	int nSlot = 0;                      /* Number of entries in aiCol[] */
+	int *aSpec;                         /* P4 of the OP_BatchAgg */
+	int *aFilterSpec;                   /* Filters within aSpec[] */
+	int *aAggSpec;                      /* Aggregates within aSpec[] */
+	int iDb;                            /* Database holding pTab */
+	int iCsr;                           /* Cursor for OP_BatchAgg */
+	int regValue;                       /* First register of term values */
+	int addrFallback;                   /* Label of the row at a time loop */
+	int addrEnd;                        /* Label of the code after that loop */
+	int i;
+
+	if (sqlite3_select_nobatch) return 0;
+	if (pTabList->nSrc != 1 || pTabList->a[0].pSelect) return 0;
+	pTab = pTabList->a[0].pTab;
+	if (pTab == 0 || pTab->pSelect || IsVirtual(pTab)) return 0;
+	if ((pTab->tabFlags & TF_Ephemeral) != 0 || pTab->tnum == 0) return 0;
+	iCur = pTabList->a[0].iCursor;
+	if (pAggInfo->nAccumulator > 0) return 0;
+	if (pAggInfo->nFunc == 0 || pAggInfo->nFunc > BATCHAGG_MAX_TERM) return 0;
+	if (!batchAggSplit(pWhere, apTerm, &nTerm)) return 0;
+
+	aSpec = (int *)sqlite3DbMallocRaw(db, sizeof(int)*
+		(3 + BATCHAGG_MAX_TERM * 2 * 2 + (nTerm + pAggInfo->nFunc) * 3));
+	if (aSpec == 0) return 0;
+	aFilterSpec = &aSpec[3 + BATCHAGG_MAX_TERM * 2 * 2];
+	aAggSpec = &aFilterSpec[nTerm * 3];
+
+	/* Each WHERE term becomes a filter of (slot, operator, register) */
+	for (i = 0; i < nTerm; i++){
+		Expr *pTerm = apTerm[i];
+		int op = pTerm->op;
+		int iCol = -1;
+		apValue[i] = 0;
+		switch (op){
+		case TK_ISNULL:
+		case TK_NOTNULL:
+			iCol = batchAggColumn(pTab, iCur, pTerm->pLeft);
+			break;
+		case TK_EQ:
+		case TK_NE:
+		case TK_LT:
+		case TK_LE:
+		case TK_GT:
+		case TK_GE:
+			iCol = batchAggColumn(pTab, iCur, pTerm->pLeft);
+			apValue[i] = pTerm->pRight;
+			if (iCol < 0){
+				/* "value op column" is the same as "column op' value" */
+				iCol = batchAggColumn(pTab, iCur, pTerm->pRight);
+				apValue[i] = pTerm->pLeft;
+				switch (op){
+				case TK_LT: op = TK_GT; break;
+				case TK_LE: op = TK_GE; break;
+				case TK_GT: op = TK_LT; break;
+				case TK_GE: op = TK_LE; break;
+				}
+			}
+			if (!batchAggValue(apValue[i])) iCol = -1;
+			break;
+		}
+		if (iCol < 0) goto batch_not_used;
+		aFilterSpec[i * 3] = batchAggSlot(aiCol, &nSlot, iCol);
+		aFilterSpec[i * 3 + 1] = op;
+	}
+
+	/* Each aggregate becomes (BATCHAGG_xx code, slot or -1, register) */
+	for (i = 0; i < pAggInfo->nFunc; i++){
+		struct AggInfo_func *pF = &pAggInfo->aFunc[i];
+		ExprList *pList = pF->pExpr->x.pList;
+		int eKind = sqlite3BatchAggKind(pF->pFunc);
+		int iSlot = -1;
+		if (eKind == 0 || pF->iDistinct >= 0) goto batch_not_used;
+		if (pList && pList->nExpr > 0){
+			int iCol = pList->nExpr == 1 ?
+				batchAggColumn(pTab, iCur, pList->a[0].pExpr) : -1;
+			if (iCol < 0) goto batch_not_used;
+			iSlot = batchAggSlot(aiCol, &nSlot, iCol);
+		}
+		else if (eKind != BATCHAGG_COUNT){
+			goto batch_not_used;
+		}
+		aAggSpec[i * 3] = eKind;
+		aAggSpec[i * 3 + 1] = iSlot;
+		aAggSpec[i * 3 + 2] = pF->iMem;
+	}
+
+	/* Move the filters and aggregates down to follow the nSlot slots */
+	aSpec[0] = nSlot;
+	aSpec[1] = nTerm;
+	aSpec[2] = pAggInfo->nFunc;
+	for (i = 0; i < nSlot; i++){
+		aSpec[3 + i * 2] = aiCol[i];
+		aSpec[3 + i * 2 + 1] = pTab->aCol[aiCol[i]].affinity;
+	}
+	memmove(&aSpec[3 + nSlot * 2], aFilterSpec,
+		sizeof(int)*(nTerm + pAggInfo->nFunc) * 3);
+	aFilterSpec = &aSpec[3 + nSlot * 2];
+
+	/* Evaluate the values the columns are compared against */
+	regValue = pParse->nMem + 1;
+	pParse->nMem += nTerm;
+	for (i = 0; i < nTerm; i++){
+		aFilterSpec[i * 3 + 2] = regValue + i;
+		if (apValue[i]){
+			sqlite3ExprCode(pParse, apValue[i], regValue + i);
+		}
+	}
+
+	iDb = sqlite3SchemaToIndex(db, pTab->pSchema);
+	iCsr = pParse->nTab++;
+	sqlite3CodeVerifySchema(pParse, iDb);
+	sqlite3TableLock(pParse, iDb, pTab->tnum, 0, pTab->zName);
+	sqlite3VdbeAddOp3(v, OP_OpenRead, iCsr, pTab->tnum, iDb);
+	sqlite3VdbeChangeP4(v, -1, SQLITE_INT_TO_PTR(pTab->nCol), P4_INT32);
+	VdbeComment((v, "%s", pTab->zName));
+	addrFallback = sqlite3VdbeMakeLabel(v);
+	addrEnd = sqlite3VdbeMakeLabel(v);
+	sqlite3VdbeAddOp4(v, OP_BatchAgg, iCsr, addrFallback, 0,
+		(char *)aSpec, P4_INTARRAY);
+	sqlite3VdbeAddOp1(v, OP_Close, iCsr);
+	sqlite3VdbeAddOp2(v, OP_Goto, 0, addrEnd);
+	sqlite3VdbeResolveLabel(v, addrFallback);
+	sqlite3VdbeAddOp1(v, OP_Close, iCsr);
+#ifndef SQLITE_OMIT_EXPLAIN
+	if (pParse->explain >= 2){
+		sqlite3VdbeAddOp4(v, OP_Explain, pParse->iSelectId, 0, 0,
+			sqlite3MPrintf(db, "USE BATCH AGGREGATE ON TABLE %s", pTab->zName),
+			P4_DYNAMIC);
+	}
+#endif
+	return addrEnd;
+
+batch_not_used:
+	sqlite3DbFree(db, aSpec);
+	return 0;
+}
+#endif /* SQLITE_OMIT_BATCH_AGGREGATE */
+
 /*
 ** Generate code for the SELECT statement given in the p argument.
 **
@@ -5113,7 +5468,11 @@ int sqlite3Select(
 	iEnd = sqlite3VdbeMakeLabel(v);/*生成一个新标签，返回值赋值给iEnd*/
 	p->nSelectRow = (double)LARGEST_INT64;/*将SELECT行最大设为64位*/
 	computeLimitRegisters(pParse, p, iEnd);/*计算iLimit和iOffset字段*/
+#ifdef SQLITE_OMIT_MERGE_SORT
 	if (p->iLimit == 0 && addrSortIndex >= 0){/*如果limit为0并且排序索引大于等于0*/
+#else
+	if (addrSortIndex >= 0){
+#endif
 		sqlite3VdbeGetOp(v, addrSortIndex)->opcode = OP_SorterOpen;/*将操作OP_SorterOpen（打开分拣器），将排序索引交给VDBE*/
 		p->selFlags |= SF_UseSorter;/*将selFlags位与SF_UseSorter，再赋值给selFlags*/
 	}
@@ -5315,6 +5674,9 @@ int sqlite3Select(
 			int addrSortingIdx; /* The OP_OpenEphemeral for the sorting index *//* 排序索引的OP_OpenEphemeral */
 			int addrReset;      /* Subroutine for resetting the accumulator   重置累加器的子程序*/
 			int regReset;       /* Return address register for reset subroutine  为重置子程序返回地址寄存器*/
+			int useHash = 0;    /* True to aggregate using a hash table */
+			int iHashTab = 0;   /* Cursor for the OP_HashAggOpen hash table */
+			int addrHashOpen = -1; /* The OP_HashAggOpen instruction */
 
 			/* If there is a GROUP BY clause we might need a sorting index to
 			** implement it.  Allocate that sorting index now.  If it turns out
@@ -5352,6 +5714,32 @@ int sqlite3Select(
 			VdbeComment((v, "indicate accumulator empty"));/*将“indicate accumulator empty"放入到VDBE中*/
 			sqlite3VdbeAddOp3(v, OP_Null, 0, iAMem, iAMem + pGroupBy->nExpr - 1);/*将OP_Null操作交给vdbe，然后返回这个操作的地址*/
 
+#ifndef SQLITE_OMIT_HASH_AGGREGATE
+			/* If the statistics suggest a hash table will hold all the groups,
+			** open one now. The accumulator registers allocated by the
+			** aggregate analysis above form the per-group state. If it turns
+			** out that the rows are delivered in GROUP BY order after all, the
+			** OP_HashAggOpen will be converted into a Noop.
+			*/
+			if (sAggInfo.nColumn + sAggInfo.nFunc > 0){
+				int iAggFirst = 0;  /* First accumulator register */
+				int iAggLast = 0;   /* Last accumulator register */
+				for (i = 0; i < sAggInfo.nColumn + sAggInfo.nFunc; i++){
+					int iMem = i < sAggInfo.nColumn ? sAggInfo.aCol[i].iMem
+						: sAggInfo.aFunc[i - sAggInfo.nColumn].iMem;
+					if (iAggFirst == 0 || iMem < iAggFirst) iAggFirst = iMem;
+					if (iMem > iAggLast) iAggLast = iMem;
+				}
+				if (groupByUseHash(pParse, p, pGroupBy, pOrderBy, &sAggInfo,
+					iAggLast - iAggFirst + 1)){
+					useHash = 1;
+					iHashTab = pParse->nTab++;
+					addrHashOpen = sqlite3VdbeAddOp4Int(v, OP_HashAggOpen, iHashTab,
+						iAggFirst, iAggLast - iAggFirst + 1, pGroupBy->nExpr);
+				}
+			}
+#endif
+
 
 			/* Begin a loop that will extract all source rows in GROUP BY order.
 			** This might involve two separate loops with an OP_Sort in between, or
@@ -5382,6 +5770,10 @@ int sqlite3Select(
 				*/
 				pGroupBy = p->pGroupBy;/*将SELECT中pGroupBy赋值给pGroupBy*/
 				groupBySort = 0;/*将GROUP BY中排序设为0*/
+				if (useHash){
+					sqlite3VdbeChangeToNoop(v, addrHashOpen);
+					useHash = 0;
+				}
 			}
 			else{
 				/* Rows are coming out in undetermined order.  We have to push
@@ -5400,9 +5792,21 @@ int sqlite3Select(
 				int regRecord;/*寄存器中记录*/
 				int nCol;/*列数*/
 				int nGroupBy;/*GROUP BY的个数*/
+				int addrHashSkip = 0; /* Jump over the sorter for rows in the hash table */
 
-				explainTempTable(pParse,
-					isDistinct && !(p->selFlags&SF_Distinct) ? "DISTINCT" : "GROUP BY");/*执行出错才会使用该函数，输出错误信息到语法解析树中*/
+				if (useHash){
+#ifndef SQLITE_OMIT_EXPLAIN
+					if (pParse->explain >= 2){
+						sqlite3VdbeAddOp4(v, OP_Explain, pParse->iSelectId, 0, 0,
+							sqlite3MPrintf(db, "USE HASH AGGREGATE"), P4_DYNAMIC);
+					}
+#endif
+				}
+				else{
+					explainTempTable(pParse,
+						isDistinct && !(p->selFlags&SF_Distinct) ? "DISTINCT" : "GROUP BY",
+						sAggInfo.sortingIdx);/*执行出错才会使用该函数，输出错误信息到语法解析树中*/
+				}
 
 
 				groupBySort = 1;/*将GROUP BY排序置为1*/
@@ -5418,6 +5822,19 @@ int sqlite3Select(
 				regBase = sqlite3GetTempRange(pParse, nCol);/*为处理列分配寄存器，把寄存器起始值返回给regBase*/
 				sqlite3ExprCacheClear(pParse);/*清除缓存中的语法解析树*/
 				sqlite3ExprCodeExprList(pParse, pGroupBy, regBase, 0);/*把表达式列表pEList中的值起始值regBase放到已分配一系列的寄存器中*/
+				if (useHash){
+					/* Update the accumulators of the row's group in the hash table
+					** directly. If the group is not in the table and the table is
+					** full, OP_HashAggFind jumps to the code that spills the row to
+					** the sorter, to be aggregated by the sort-based loop below.
+					*/
+					int addrHashFind;
+					addrHashFind = sqlite3VdbeAddOp3(v, OP_HashAggFind, iHashTab, 0, regBase);
+					updateAccumulator(pParse, &sAggInfo);
+					sqlite3VdbeAddOp1(v, OP_HashAggSave, iHashTab);
+					addrHashSkip = sqlite3VdbeAddOp0(v, OP_Goto);
+					sqlite3VdbeJumpHere(v, addrHashFind);
+				}
 				sqlite3VdbeAddOp2(v, OP_Sequence, sAggInfo.sortingIdx, regBase + nGroupBy);/*将OP_Gosub操作交给vdbe，然后返回这个操作的地址*/
 				j = nGroupBy + 1;/*将nGroupBy+1赋值给j*/
 				for (i = 0; i < sAggInfo.nColumn; i++){/*遍历聚集函数信息中的列*/
@@ -5439,7 +5856,26 @@ int sqlite3Select(
 				sqlite3VdbeAddOp2(v, OP_SorterInsert, sAggInfo.sortingIdx, regRecord);
 				sqlite3ReleaseTempReg(pParse, regRecord);/*释放语法解析树中临时寄存器regRecord的值*/
 				sqlite3ReleaseTempRange(pParse, regBase, nCol);/*释放起始地址为regBase连续寄存器，长度是nCol*/
+				if (addrHashSkip) sqlite3VdbeJumpHere(v, addrHashSkip);
 				sqlite3WhereEnd(pWInfo);/*判断WHERE返回信息，再结束WHERE子句*/
+				if (useHash){
+					/* Output one row for each group in the hash table. Then reset
+					** the accumulators and fall through to aggregate any rows that
+					** were spilled to the sorter.
+					*/
+					int addrHashTop;
+					int addrHashDone = sqlite3VdbeMakeLabel(v);
+					sqlite3VdbeAddOp2(v, OP_HashAggRewind, iHashTab, addrHashDone);
+					addrHashTop = sqlite3VdbeAddOp2(v, OP_Integer, 1, iUseFlag);
+					sqlite3VdbeAddOp2(v, OP_Gosub, regOutputRow, addrOutputRow);
+					VdbeComment((v, "output one hash group"));
+					sqlite3VdbeAddOp2(v, OP_IfPos, iAbortFlag, addrEnd);
+					sqlite3VdbeAddOp2(v, OP_HashAggNext, iHashTab, addrHashTop);
+					sqlite3VdbeResolveLabel(v, addrHashDone);
+					sqlite3VdbeAddOp2(v, OP_Integer, 0, iUseFlag);
+					sqlite3VdbeAddOp2(v, OP_Gosub, regReset, addrReset);
+					VdbeComment((v, "reset accumulator"));
+				}
 				sAggInfo.sortingIdxPTab = sortPTab = pParse->nTab++;/*将语法解析树中表个数赋值给聚集函数信息结构体中排序索引表*/
 				sortOut = sqlite3GetTempReg(pParse);/*得到语法解析树中临时寄存器中的值给sortOut*/
 				sqlite3VdbeAddOp3(v, OP_OpenPseudo, sortPTab, sortOut, nCol);/*将OP_OpenPseudo操作交给vdbe，然后返回这个操作的地址*/
@@ -5722,6 +6158,7 @@ int sqlite3Select(
 			**   和注释来获取细节。
 			*/
 				ExprList *pMinMax = 0;/*声明一个表达式列表，存放最小或最大值的表达式*/
+				int addrBatchEnd = 0; /* Resolve here if OP_BatchAgg succeeds */
 				u8 flag = minMaxQuery(p);/*对SELECT结构体p进行最大值或最小值查询，并赋值给flag*/
 				if (flag){/*如果flag存在*/
 					assert(!ExprHasProperty(p->pEList->a[0].pExpr, EP_xIsSelect));/*插入断点，如果p->pEList->a[0].pExpr中包含EP_xIsSelect属性不为空，抛出错误信息*/
@@ -5745,6 +6182,15 @@ int sqlite3Select(
 				** 如果聚集函数没有 GROUP BY语句，则执行此情况。这个处理程序简单的
 				** 多因为它只有一个单行的输出。
 				*/
+#ifndef SQLITE_OMIT_BATCH_AGGREGATE
+				/* Simple scans of a single table can be computed a batch of
+				** rows at a time by OP_BatchAgg. The row at a time loop below
+				** is then only run if OP_BatchAgg meets a row it cannot handle.
+				*/
+				if (flag == 0){
+					addrBatchEnd = batchAggregate(pParse, p, pWhere, &sAggInfo);
+				}
+#endif
 				resetAccumulator(pParse, &sAggInfo);/*重置聚合累加器*/
 				pWInfo = sqlite3WhereBegin(pParse, pTabList, pWhere, &pMinMax, 0, flag, 0);/*生成处理where子句的循环的开始*/
 				if (pWInfo == 0){/*若为空，则删除并结束select*/
@@ -5759,6 +6205,11 @@ int sqlite3Select(
 				}
 				sqlite3WhereEnd(pWInfo);/*结束where 循环*/
 				finalizeAggFunctions(pParse, &sAggInfo);/*结束聚合函数*/
+#ifndef SQLITE_OMIT_BATCH_AGGREGATE
+				if (addrBatchEnd){
+					sqlite3VdbeResolveLabel(v, addrBatchEnd);
+				}
+#endif
 			}
 
 			pOrderBy = 0;
@@ -5772,7 +6223,7 @@ int sqlite3Select(
 	} /* endif aggregate query *//*如果是聚集查询*/
 
 	if (distinct >= 0){
-		explainTempTable(pParse, "DISTINCT");/*取消重复表达式的值大于等于0，执行出错才会使用该函数，输出错误信息"DISTINCT"到语法解析树*/
+		explainTempTable(pParse, "DISTINCT", distinct);/*取消重复表达式的值大于等于0，执行出错才会使用该函数，输出错误信息"DISTINCT"到语法解析树*/
 	}
 
 	/* If there is an ORDER BY clause, then we need to sort the results
@@ -5786,7 +6237,7 @@ int sqlite3Select(
 	** 回调函数。
 	*/
 	if (pOrderBy){
-		explainTempTable(pParse, "ORDER BY");/*输出信息"ORDER BY"到语法解析树*/
+		explainTempTable(pParse, "ORDER BY", pOrderBy->iECursor);/*输出信息"ORDER BY"到语法解析树*/
 		generateSortTail(pParse, p, v, pEList->nExpr, pDest);/*调用自身函数，输出ORDER BY结果*/
 	}
 
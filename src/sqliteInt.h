@@ -662,6 +662,7 @@ typedef struct Parse Parse;
 typedef struct RowSet RowSet;
 typedef struct Savepoint Savepoint;
 typedef struct Select Select;
+typedef struct SQLiteThread SQLiteThread;
 typedef struct SrcList SrcList;
 typedef struct StrAccum StrAccum;
 typedef struct Table Table;
@@ -673,6 +674,7 @@ typedef struct TriggerStep TriggerStep;
 typedef struct UnpackedRecord UnpackedRecord;
 typedef struct VTable VTable;
 typedef struct VtabCtx VtabCtx;
+typedef struct WalCheckpointer WalCheckpointer;
 typedef struct Walker Walker;
 typedef struct WherePlan WherePlan;
 typedef struct WhereInfo WhereInfo;
@@ -773,7 +775,7 @@ struct Schema {
 ** The number of different kinds of things that can be limited
 ** using the sqlite3_limit() interface.//ͬණǿsqlite3_limit()ӿƵġ
 */
-#define SQLITE_N_LIMIT (SQLITE_LIMIT_TRIGGER_DEPTH+1)
+#define SQLITE_N_LIMIT (SQLITE_LIMIT_WORKER_THREADS+1)
 
 /*
 ** Lookaside malloc is a set of fixed-size buffers that can be used    //mallocȫmemory allocation,̬ڴ䣬޷֪ڴλõʱҪڴռ䣬Ҫõ̬ķڴ档
@@ -835,6 +837,8 @@ struct sqlite3 {
   unsigned int openFlags;       /* Flags passed to sqlite3_vfs.xOpen() ݸsqlite3_vfs.xOpen()ı־*/
   int errCode;                  /* Most recent error code (SQLITE_*) Ĵ*/
   int errMask;                  /* & result codes with this before returning ִʾ*/
+  u8 bConcurrent;               /* True inside a BEGIN CONCURRENT transaction */
+  u8 bStmtProfile;              /* True if PRAGMA stmt_profile is on */
   u8 autoCommit;                /* The auto-commit flag. Զύ־*/
   u8 temp_store;                /* 1: file 2: memory 0: default 1:ļ  2:ڴ  0:Ĭ*/
   u8 mallocFailed;              /* True if we have seen a malloc failure ̬ڴʧܼΪ*/
@@ -872,6 +876,7 @@ struct sqlite3 {
 #ifndef SQLITE_OMIT_WAL
   int (*xWalCallback)(void *, sqlite3 *, const char *, int);
   void *pWalArg;
+  WalCheckpointer *pCkpt;       /* Background checkpointers */
 #endif
   void(*xCollNeeded)(void*,sqlite3*,int eTextRep,const char*);
   void(*xCollNeeded16)(void*,sqlite3*,int eTextRep,const void*);
@@ -903,6 +908,9 @@ struct sqlite3 {
 #endif
   FuncDefHash aFunc;            /* Hash table of connection functions ӹܹϣ*/
   Hash aCollSeq;                /* All collating sequences */
+#ifndef SQLITE_OMIT_STMT_PROFILE
+  Hash aStmtProfile;            /* Statement profiles, keyed by SQL text */
+#endif
   BusyHandler busyHandler;      /* Busy callback عæ*/
   Db aDbStatic[2];              /* Static space for the 2 default backends 2ĬϺ˵ľ̬ռ*/
   Savepoint *pSavepoint;        /* List of active savepoints б*/
@@ -1525,10 +1533,21 @@ struct KeyInfo {
   sqlite3 *db;        /* The database connection  ݿ*/
   u8 enc;             /* Text encoding - one of the SQLITE_UTF* values ı-SQLITE_UTF*һֵ*/
   u16 nField;         /* Number of entries in aColl[] aColl[]еĿ*/
+  u8 eRecCmp;         /* KEYINFO_CMP_* shape used by sqlite3VdbeRecordCompare */
   u8 *aSortOrder;     /* Sort order for each column.  May be NULL ÿе˳򣬿Ϊ*/
   CollSeq *aColl[1];  /* Collating sequence for each term of the key ÿһ*/
 };
 
+/*
+** Allowed values for KeyInfo.eRecCmp.  These select a specialized
+** comparison routine for records that use the KeyInfo, based on the
+** expected type of the leading field of each key.  A KeyInfo that is
+** zeroed on allocation uses the generic comparison.
+*/
+#define KEYINFO_CMP_GENERIC 0   /* No assumption about the key shape */
+#define KEYINFO_CMP_INT     1   /* Leading field is usually an integer */
+#define KEYINFO_CMP_TEXT    2   /* Leading field is text, BINARY collation */
+
 /*
 ** An instance of the following structure holds information about a
 ** single index record that has already been parsed out into individual
@@ -1615,6 +1634,7 @@ struct Index {
   u8 onError;      /* OE_Abort, OE_Ignore, OE_Replace, or OE_None */
   u8 autoIndex;    /* True if is automatically created (ex: by UNIQUE) ϵͳԶΪ*/
   u8 bUnordered;   /* Use this index for == or IN queries only ==ʹøǽIN ѯʹ*/
+  u8 hasStat1;     /* aiRowEst[] values were loaded from sqlite_stat1 */
 #ifdef SQLITE_ENABLE_STAT3
   int nSample;             /* Number of elements in aSample[] aSampleеԪĿ*/
   tRowcnt avgEq;           /* Average nEq value for key values not in aSample aSampleеļֵƽnEqֵ*/
@@ -2069,6 +2089,8 @@ struct WhereLevel {
   int addrNxt;          /* Jump here to start the next IN combination 		ת￪ʼһIN*/
   int addrCont;         /* Jump here to continue with the next loop cycle 	תһѭ*/
   int addrFirst;        /* First instruction of interior of the loop 		ѭڲĵһָ*/
+  int addrExplain;      /* OP_Explain for this loop, or 0 */
+  int addrVisit;        /* Executed once for each row visited by the loop */
   u8 iFrom;             /* Which entry in the FROM clause 			FORMӾеĿ*/
   u8 op, p5;            /* Opcode and P5 of the opcode that ends the loop 	ѭĲP5*/
   int p1, p2;           /* Operands of the opcode used to ends the loop 	ڽѭĲĲ*/
@@ -2611,6 +2633,7 @@ struct Sqlite3Config {
   int szPage;                       /* Size of each page in pPage[] 		pPage[]ÿҳĴС*/
   int nPage;                        /* Number of pages in pPage[] 		pPage[]ҳ*/
   int mxParserStack;                /* maximum depth of the parser stack 	ջ*/
+  int ePcachePolicy;                /* SQLITE_PCACHE_POLICY_LRU or _2Q */
   int sharedCacheEnabled;           /* true if shared-cache mode enabled 	ģʽΪ*/
   /* The above might be initialized to non-zero.  The following need to always	ܻʼΪ㡣ʼճʼΪ
   ** initially be zero, however. */
@@ -2793,6 +2816,9 @@ const sqlite3_mem_methods *sqlite3MemGetMemsys5(void);
   int sqlite3MutexEnd(void);
 #endif
 
+int sqlite3ThreadCreate(SQLiteThread**,void*(*)(void*),void*);
+int sqlite3ThreadJoin(SQLiteThread*, void**);
+
 int sqlite3StatusValue(int);
 void sqlite3StatusAdd(int, int);
 void sqlite3StatusSet(int, int);
@@ -3151,6 +3177,7 @@ CollSeq *sqlite3LocateCollSeq(Parse *pParse, const char*zName);
 CollSeq *sqlite3ExprCollSeq(Parse *pParse, Expr *pExpr);
 Expr *sqlite3ExprSetColl(Expr*, CollSeq*);
 Expr *sqlite3ExprSetCollByToken(Parse *pParse, Expr*, Token*);
+int sqlite3IsBinary(const CollSeq*);
 int sqlite3CheckCollSeq(Parse *, CollSeq *);
 int sqlite3CheckObjectName(Parse *, const char *);
 void sqlite3VdbeSetChanges(sqlite3 *, int);
@@ -3214,6 +3241,12 @@ void sqlite3DeleteIndexSamples(sqlite3*,Index*);
 void sqlite3DefaultRowEst(Index*);
 void sqlite3RegisterLikeFunctions(sqlite3*, int);
 int sqlite3IsLikeFunction(sqlite3*,Expr*,int*,char*);
+#ifndef SQLITE_OMIT_BATCH_AGGREGATE
+int sqlite3BatchAggKind(FuncDef*);
+#endif
+#ifndef SQLITE_OMIT_HASH_AGGREGATE
+int sqlite3FixedSizeAgg(FuncDef*);
+#endif
 void sqlite3MinimumFileFormat(Parse*, int, int);
 void sqlite3SchemaClear(void *);
 Schema *sqlite3SchemaGet(sqlite3 *, Btree *);
@@ -3310,6 +3343,16 @@ int sqlite3TempInMemory(const sqlite3*);
 const char *sqlite3JournalModename(int);
 int sqlite3Checkpoint(sqlite3*, int, int, int*, int*);
 int sqlite3WalDefaultHook(void*,sqlite3*,const char*,int);
+#ifndef SQLITE_OMIT_WAL
+int sqlite3WalCheckpointerConfig(sqlite3*, int, int);
+int sqlite3WalCheckpointerWake(sqlite3*, const char*, int);
+void sqlite3WalCheckpointerClose(sqlite3*, int);
+void sqlite3WalCheckpointerCloseAll(sqlite3*);
+void sqlite3WalCheckpointerStatus(sqlite3*, int, int*, int*, int);
+#else
+# define sqlite3WalCheckpointerClose(x,y)
+# define sqlite3WalCheckpointerCloseAll(x)
+#endif
 
 /* Declarations for functions in fkey.c. All of these are replaced by
 ** no-op macros if OMIT_FOREIGN_KEY is defined. In this case no foreign
@@ -207,3 +207,52 @@
 #ifndef SQLITE_MAX_TRIGGER_DEPTH
 # define SQLITE_MAX_TRIGGER_DEPTH 1000
 #endif
+
+/*
+** Maximum number of bytes of a database file that may be memory-mapped
+** by the VFS, and the default value of the mmap_size pragma.
+**
+** Memory-mapped I/O is opt-in: SQLITE_DEFAULT_MMAP_SIZE is zero unless
+** overridden at compile-time.  The default upper limit is 2GiB on 32-bit
+** builds, where address space is scarce, and 64GiB on 64-bit builds.
+*/
+#ifndef SQLITE_MAX_MMAP_SIZE
+# if defined(__LP64__) || defined(_WIN64)
+#   define SQLITE_MAX_MMAP_SIZE 0x1000000000
+# else
+#   define SQLITE_MAX_MMAP_SIZE 0x7fff0000
+# endif
+#endif
+#ifndef SQLITE_DEFAULT_MMAP_SIZE
+# define SQLITE_DEFAULT_MMAP_SIZE 0
+#endif
+#if SQLITE_DEFAULT_MMAP_SIZE>SQLITE_MAX_MMAP_SIZE
+# undef SQLITE_DEFAULT_MMAP_SIZE
+# define SQLITE_DEFAULT_MMAP_SIZE SQLITE_MAX_MMAP_SIZE
+#endif
+
+/*
+** The default value of the "warm_start" URI parameter. If true, the list
+** of cached pages is saved to a "-warm" sidecar file when a database is
+** closed and read ahead the next time it is opened.
+*/
+#ifndef SQLITE_DEFAULT_WARM_START
+# define SQLITE_DEFAULT_WARM_START 0
+#endif
+
+/*
+** Maximum number of auxiliary worker threads that a single prepared
+** statement may use, and the default value of the "threads" pragma
+** (the SQLITE_LIMIT_WORKER_THREADS limit).  Worker threads are never
+** used unless the library is built threadsafe.
+*/
+#ifndef SQLITE_MAX_WORKER_THREADS
+# define SQLITE_MAX_WORKER_THREADS 8
+#endif
+#ifndef SQLITE_DEFAULT_WORKER_THREADS
+# define SQLITE_DEFAULT_WORKER_THREADS 0
+#endif
+#if SQLITE_DEFAULT_WORKER_THREADS>SQLITE_MAX_WORKER_THREADS
+# undef SQLITE_DEFAULT_WORKER_THREADS
+# define SQLITE_DEFAULT_WORKER_THREADS SQLITE_MAX_WORKER_THREADS
+#endif
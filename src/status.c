@@ -242,6 +242,22 @@ int sqlite3_db_status(
       break;
     }
 
+    /*
+    ** Set *pCurrent to the number of WAL frames copied into the database
+    ** by background checkpointers, or to the number of frames they have
+    ** yet to copy. See walthread.c.
+    */
+    case SQLITE_DBSTATUS_CHECKPOINT_DONE:
+    case SQLITE_DBSTATUS_CHECKPOINT_LAG: {
+#ifndef SQLITE_OMIT_WAL
+      sqlite3WalCheckpointerStatus(db, op, pCurrent, pHighwater, resetFlag);
+#else
+      *pCurrent = 0;
+      *pHighwater = 0;
+#endif
+      break;
+    }
+
     default: {
       rc = SQLITE_ERROR;
     }
@@ -5375,10 +5375,11 @@ static int test_limit(
     { "SQLITE_LIMIT_LIKE_PATTERN_LENGTH", SQLITE_LIMIT_LIKE_PATTERN_LENGTH  },
     { "SQLITE_LIMIT_VARIABLE_NUMBER",     SQLITE_LIMIT_VARIABLE_NUMBER      },
     { "SQLITE_LIMIT_TRIGGER_DEPTH",       SQLITE_LIMIT_TRIGGER_DEPTH        },
+    { "SQLITE_LIMIT_WORKER_THREADS",      SQLITE_LIMIT_WORKER_THREADS       },
     
     /* Out of range test cases */
     { "SQLITE_LIMIT_TOOSMALL",            -1,                               },
-    { "SQLITE_LIMIT_TOOBIG",              SQLITE_LIMIT_TRIGGER_DEPTH+1      },
+    { "SQLITE_LIMIT_TOOBIG",              SQLITE_LIMIT_WORKER_THREADS+1     },
   };
   int i, id;
   int val;
@@ -5465,9 +5466,11 @@ static int test_pcache_stats(
   int nMax;
   int nCurrent;
   int nRecyclable;
+  i64 nHit;
+  i64 nMiss;
   Tcl_Obj *pRet;
 
-  sqlite3PcacheStats(&nCurrent, &nMax, &nMin, &nRecyclable);
+  sqlite3PcacheStats(&nCurrent, &nMax, &nMin, &nRecyclable, &nHit, &nMiss);
 
   pRet = Tcl_NewObj();
   Tcl_ListObjAppendElement(interp, pRet, Tcl_NewStringObj("current", -1));
@@ -5478,6 +5481,10 @@ static int test_pcache_stats(
   Tcl_ListObjAppendElement(interp, pRet, Tcl_NewIntObj(nMin));
   Tcl_ListObjAppendElement(interp, pRet, Tcl_NewStringObj("recyclable", -1));
   Tcl_ListObjAppendElement(interp, pRet, Tcl_NewIntObj(nRecyclable));
+  Tcl_ListObjAppendElement(interp, pRet, Tcl_NewStringObj("hit", -1));
+  Tcl_ListObjAppendElement(interp, pRet, Tcl_NewWideIntObj(nHit));
+  Tcl_ListObjAppendElement(interp, pRet, Tcl_NewStringObj("miss", -1));
+  Tcl_ListObjAppendElement(interp, pRet, Tcl_NewWideIntObj(nMiss));
 
   Tcl_SetObjResult(interp, pRet);
 
@@ -5970,6 +5977,376 @@ static int optimization_control(
   return TCL_OK;
 }
 
+/*
+** Usage: sqlite3_vdbe_dispatch_bench DB NROW NITER
+**
+** Fill the temporary table "vdbe_dispatch_bench" of database DB with NROW
+** rows, then run each of a small set of scan-and-filter queries NITER times
+** with the virtual machine forced to use switch dispatch and NITER times
+** with the default dispatch, which is computed-goto dispatch in builds
+** that support it.  Return a list of three elements for each query: the
+** SQL text and the elapsed time in microseconds for each of the two runs.
+*/
+static int test_vdbe_dispatch_bench(
+  void * clientData,
+  Tcl_Interp *interp,
+  int objc,
+  Tcl_Obj *CONST objv[]
+){
+  extern int sqlite3_vdbe_switch_dispatch;
+  static const char *azSql[] = {
+    "SELECT count(*) FROM vdbe_dispatch_bench WHERE a%7=3",
+    "SELECT sum(a+b), max(b) FROM vdbe_dispatch_bench"
+        " WHERE b BETWEEN 100 AND 900",
+    "SELECT count(*) FROM vdbe_dispatch_bench WHERE c>='x5' AND a&1",
+  };
+  sqlite3 *db;
+  sqlite3_stmt *pStmt;
+  int nRow, nIter;
+  int i, j, k;
+  int rc;
+  Tcl_Obj *pRet;
+
+  if( objc!=4 ){
+    Tcl_WrongNumArgs(interp, 1, objv, "DB NROW NITER");
+    return TCL_ERROR;
+  }
+  if( getDbPointer(interp, Tcl_GetString(objv[1]), &db) ) return TCL_ERROR;
+  if( Tcl_GetIntFromObj(interp, objv[2], &nRow) ) return TCL_ERROR;
+  if( Tcl_GetIntFromObj(interp, objv[3], &nIter) ) return TCL_ERROR;
+
+  rc = sqlite3_exec(db,
+      "DROP TABLE IF EXISTS temp.vdbe_dispatch_bench;"
+      "CREATE TEMP TABLE vdbe_dispatch_bench(a INTEGER, b INTEGER, c TEXT);"
+      "BEGIN;", 0, 0, 0);
+  if( rc==SQLITE_OK ){
+    rc = sqlite3_prepare_v2(db,
+        "INSERT INTO vdbe_dispatch_bench VALUES(?1, ?2, 'x' || ?2)",
+        -1, &pStmt, 0);
+  }
+  for(i=0; rc==SQLITE_OK && i<nRow; i++){
+    unsigned int r;
+    sqlite3_randomness(sizeof(r), &r);
+    sqlite3_bind_int(pStmt, 1, i);
+    sqlite3_bind_int(pStmt, 2, (int)(r%1000));
+    sqlite3_step(pStmt);
+    rc = sqlite3_reset(pStmt);
+  }
+  sqlite3_finalize(pStmt);
+  if( rc==SQLITE_OK ) rc = sqlite3_exec(db, "COMMIT", 0, 0, 0);
+  if( rc!=SQLITE_OK ){
+    Tcl_AppendResult(interp, sqlite3_errmsg(db), (char*)0);
+    sqlite3_exec(db, "ROLLBACK", 0, 0, 0);
+    return TCL_ERROR;
+  }
+
+  pRet = Tcl_NewObj();
+  Tcl_IncrRefCount(pRet);
+  for(j=0; j<sizeof(azSql)/sizeof(azSql[0]); j++){
+    Tcl_ListObjAppendElement(interp, pRet, Tcl_NewStringObj(azSql[j], -1));
+    rc = sqlite3_prepare_v2(db, azSql[j], -1, &pStmt, 0);
+    if( rc!=SQLITE_OK ) break;
+    for(k=0; k<2; k++){
+      Tcl_Time t1, t2;
+      sqlite3_vdbe_switch_dispatch = (k==0);
+      Tcl_GetTime(&t1);
+      for(i=0; i<nIter; i++){
+        while( sqlite3_step(pStmt)==SQLITE_ROW );
+        sqlite3_reset(pStmt);
+      }
+      Tcl_GetTime(&t2);
+      Tcl_ListObjAppendElement(interp, pRet, Tcl_NewWideIntObj(
+          ((Tcl_WideInt)t2.sec - t1.sec)*1000000 + (t2.usec - t1.usec)
+      ));
+    }
+    sqlite3_vdbe_switch_dispatch = 0;
+    sqlite3_finalize(pStmt);
+  }
+  if( rc!=SQLITE_OK ){
+    Tcl_AppendResult(interp, sqlite3_errmsg(db), (char*)0);
+    Tcl_DecrRefCount(pRet);
+    return TCL_ERROR;
+  }
+  Tcl_SetObjResult(interp, pRet);
+  Tcl_DecrRefCount(pRet);
+  return TCL_OK;
+}
+
+/*
+** Usage: sqlite3_record_compare_bench DB NROW NITER
+**
+** Fill the temporary table "record_compare_bench" of database DB with NROW
+** rows and index it on an INTEGER column, a TEXT column and both of them
+** together.  Then run NITER point lookups through each index, once with
+** sqlite3VdbeRecordCompare() forced to use the generic comparison and once
+** with the comparison chosen for the index.  Return a list of four
+** elements for each index: the SQL text, the elapsed time in microseconds
+** for each of the two runs, and 1 if both runs found the same number of
+** rows or 0 if they did not.
+*/
+static int test_record_compare_bench(
+  void * clientData,
+  Tcl_Interp *interp,
+  int objc,
+  Tcl_Obj *CONST objv[]
+){
+  extern int sqlite3_vdbe_generic_compare;
+  static const char *azSql[] = {
+    "SELECT count(*) FROM record_compare_bench INDEXED BY rcb_a"
+        " WHERE a=?1",
+    "SELECT count(*) FROM record_compare_bench INDEXED BY rcb_b"
+        " WHERE b=?2",
+    "SELECT count(*) FROM record_compare_bench INDEXED BY rcb_ab"
+        " WHERE a=?1 AND b>=?2",
+  };
+  sqlite3 *db;
+  sqlite3_stmt *pStmt;
+  int nRow, nIter;
+  int i, j, k;
+  int rc;
+  Tcl_Obj *pRet;
+
+  if( objc!=4 ){
+    Tcl_WrongNumArgs(interp, 1, objv, "DB NROW NITER");
+    return TCL_ERROR;
+  }
+  if( getDbPointer(interp, Tcl_GetString(objv[1]), &db) ) return TCL_ERROR;
+  if( Tcl_GetIntFromObj(interp, objv[2], &nRow) ) return TCL_ERROR;
+  if( Tcl_GetIntFromObj(interp, objv[3], &nIter) ) return TCL_ERROR;
+  if( nRow<1 ) nRow = 1;
+
+  rc = sqlite3_exec(db,
+      "DROP TABLE IF EXISTS temp.record_compare_bench;"
+      "CREATE TEMP TABLE record_compare_bench(a INTEGER, b TEXT);"
+      "CREATE INDEX rcb_a ON record_compare_bench(a);"
+      "CREATE INDEX rcb_b ON record_compare_bench(b);"
+      "CREATE INDEX rcb_ab ON record_compare_bench(a, b);"
+      "BEGIN;", 0, 0, 0);
+  if( rc==SQLITE_OK ){
+    rc = sqlite3_prepare_v2(db,
+        "INSERT INTO record_compare_bench VALUES(?1, ?2)", -1, &pStmt, 0);
+  }
+  for(i=0; rc==SQLITE_OK && i<nRow; i++){
+    unsigned int r;
+    sqlite3_randomness(sizeof(r), &r);
+    r %= nRow;
+    sqlite3_bind_int(pStmt, 1, (int)r);
+    sqlite3_bind_text(pStmt, 2, sqlite3_mprintf("key%08d", r), -1,
+                      sqlite3_free);
+    sqlite3_step(pStmt);
+    rc = sqlite3_reset(pStmt);
+  }
+  sqlite3_finalize(pStmt);
+  if( rc==SQLITE_OK ) rc = sqlite3_exec(db, "COMMIT", 0, 0, 0);
+  if( rc!=SQLITE_OK ){
+    Tcl_AppendResult(interp, sqlite3_errmsg(db), (char*)0);
+    sqlite3_exec(db, "ROLLBACK", 0, 0, 0);
+    return TCL_ERROR;
+  }
+
+  pRet = Tcl_NewObj();
+  Tcl_IncrRefCount(pRet);
+  for(j=0; j<sizeof(azSql)/sizeof(azSql[0]); j++){
+    sqlite3_int64 aFound[2];
+    Tcl_ListObjAppendElement(interp, pRet, Tcl_NewStringObj(azSql[j], -1));
+    rc = sqlite3_prepare_v2(db, azSql[j], -1, &pStmt, 0);
+    if( rc!=SQLITE_OK ) break;
+    for(k=0; k<2; k++){
+      Tcl_Time t1, t2;
+      aFound[k] = 0;
+      sqlite3_vdbe_generic_compare = (k==0);
+      Tcl_GetTime(&t1);
+      for(i=0; i<nIter; i++){
+        int iKey = (int)(((sqlite3_int64)i*7919) % nRow);
+        sqlite3_bind_int(pStmt, 1, iKey);
+        sqlite3_bind_text(pStmt, 2, sqlite3_mprintf("key%08d", iKey), -1,
+                          sqlite3_free);
+        while( sqlite3_step(pStmt)==SQLITE_ROW ){
+          aFound[k] += sqlite3_column_int64(pStmt, 0);
+        }
+        sqlite3_reset(pStmt);
+      }
+      Tcl_GetTime(&t2);
+      Tcl_ListObjAppendElement(interp, pRet, Tcl_NewWideIntObj(
+          ((Tcl_WideInt)t2.sec - t1.sec)*1000000 + (t2.usec - t1.usec)
+      ));
+    }
+    sqlite3_vdbe_generic_compare = 0;
+    sqlite3_finalize(pStmt);
+    Tcl_ListObjAppendElement(interp, pRet,
+        Tcl_NewIntObj(aFound[0]==aFound[1]));
+  }
+  if( rc!=SQLITE_OK ){
+    Tcl_AppendResult(interp, sqlite3_errmsg(db), (char*)0);
+    Tcl_DecrRefCount(pRet);
+    return TCL_ERROR;
+  }
+  Tcl_SetObjResult(interp, pRet);
+  Tcl_DecrRefCount(pRet);
+  return TCL_OK;
+}
+
+#if !defined(SQLITE_OMIT_SUPERINSTRUCTIONS) \
+ || !defined(SQLITE_OMIT_BATCH_AGGREGATE)
+/*
+** Prepare and run SQL statement zSql on database db.  Append the type and
+** text of every value returned to list pList and write the number of
+** opcodes in the prepared program that appear in array aOp[] into *pnOp.
+*/
+static int toggleCheckRun(
+  Tcl_Interp *interp,
+  sqlite3 *db,
+  const char *zSql,
+  const u8 *aOp,
+  int nOp,
+  Tcl_Obj *pList,
+  int *pnOp
+){
+  sqlite3_stmt *pStmt;
+  Vdbe *v;
+  int i, j, rc;
+
+  rc = sqlite3_prepare_v2(db, zSql, -1, &pStmt, 0);
+  if( rc!=SQLITE_OK ) return rc;
+  *pnOp = 0;
+  v = (Vdbe*)pStmt;
+  for(i=0; v && i<v->nOp; i++){
+    for(j=0; j<nOp; j++){
+      if( v->aOp[i].opcode==aOp[j] ) (*pnOp)++;
+    }
+  }
+  while( sqlite3_step(pStmt)==SQLITE_ROW ){
+    for(i=0; i<sqlite3_column_count(pStmt); i++){
+      const char *z = (const char*)sqlite3_column_text(pStmt, i);
+      Tcl_ListObjAppendElement(interp, pList,
+          Tcl_NewIntObj(sqlite3_column_type(pStmt, i)));
+      Tcl_ListObjAppendElement(interp, pList, Tcl_NewStringObj(z?z:"", -1));
+    }
+  }
+  return sqlite3_finalize(pStmt);
+}
+
+/*
+** Common implementation of the "DB SQL" commands below that compare the
+** results of a statement run with and without an optimization.  Run SQL
+** once with *pDisable set to 1 and once with it set to 0.  Return a list
+** of two integers: the number of opcodes in the second program that appear
+** in array aOp[], and 1 if both runs returned the same values of the same
+** types in the same order, or 0 if they did not.
+*/
+static int toggleCheck(
+  Tcl_Interp *interp,
+  int objc,
+  Tcl_Obj *CONST objv[],
+  int *pDisable,
+  const u8 *aOp,
+  int nOp
+){
+  sqlite3 *db;
+  const char *zSql;
+  Tcl_Obj *apRes[2];
+  int nFound = 0;
+  int rc;
+  int k;
+  int isSame;
+
+  if( objc!=3 ){
+    Tcl_WrongNumArgs(interp, 1, objv, "DB SQL");
+    return TCL_ERROR;
+  }
+  if( getDbPointer(interp, Tcl_GetString(objv[1]), &db) ) return TCL_ERROR;
+  zSql = Tcl_GetString(objv[2]);
+
+  for(k=0; k<2; k++){
+    apRes[k] = Tcl_NewObj();
+    Tcl_IncrRefCount(apRes[k]);
+  }
+  *pDisable = 1;
+  rc = toggleCheckRun(interp, db, zSql, aOp, nOp, apRes[0], &nFound);
+  *pDisable = 0;
+  if( rc==SQLITE_OK ){
+    rc = toggleCheckRun(interp, db, zSql, aOp, nOp, apRes[1], &nFound);
+  }
+  isSame = strcmp(Tcl_GetString(apRes[0]), Tcl_GetString(apRes[1]))==0;
+  for(k=0; k<2; k++){
+    Tcl_DecrRefCount(apRes[k]);
+  }
+  if( rc!=SQLITE_OK ){
+    Tcl_AppendResult(interp, sqlite3_errmsg(db), (char*)0);
+    return TCL_ERROR;
+  }
+  apRes[0] = Tcl_NewIntObj(nFound);
+  apRes[1] = Tcl_NewIntObj(isSame);
+  Tcl_SetObjResult(interp, Tcl_NewListObj(2, apRes));
+  return TCL_OK;
+}
+#endif
+
+#ifndef SQLITE_OMIT_SUPERINSTRUCTIONS
+/*
+** Usage: sqlite3_vdbe_fuse_check DB SQL
+**
+** Run SQL once as an unfused program and once with the superinstructions
+** substituted by sqlite3VdbeMakeReady().  Return a list of two integers:
+** the number of fused opcodes in the second program and 1 if both runs
+** returned the same values in the same order, or 0 if they did not.
+*/
+static int test_vdbe_fuse_check(
+  void * clientData,
+  Tcl_Interp *interp,
+  int objc,
+  Tcl_Obj *CONST objv[]
+){
+  extern int sqlite3_vdbe_nofuse;
+  static const u8 aFused[] = {
+    OP_ColumnCol, OP_ColumnCmp, OP_ColumnRange, OP_NextCol
+  };
+  return toggleCheck(interp, objc, objv, &sqlite3_vdbe_nofuse,
+                     aFused, ArraySize(aFused));
+}
+
+/*
+** Usage: sqlite3_vdbe_column_range_check DB SQL
+**
+** Like sqlite3_vdbe_fuse_check, except that the first integer returned is
+** the number of OP_ColumnRange opcodes in the fused program.
+*/
+static int test_vdbe_column_range_check(
+  void * clientData,
+  Tcl_Interp *interp,
+  int objc,
+  Tcl_Obj *CONST objv[]
+){
+  extern int sqlite3_vdbe_nofuse;
+  static const u8 aRange[] = { OP_ColumnRange };
+  return toggleCheck(interp, objc, objv, &sqlite3_vdbe_nofuse,
+                     aRange, ArraySize(aRange));
+}
+#endif /* SQLITE_OMIT_SUPERINSTRUCTIONS */
+
+#ifndef SQLITE_OMIT_BATCH_AGGREGATE
+/*
+** Usage: sqlite3_batch_agg_check DB SQL
+**
+** Run SQL once using the row at a time aggregate loop only and once with
+** OP_BatchAgg, if sqlite3Select() chooses to use it.  Return a list of two
+** integers: the number of OP_BatchAgg opcodes in the second program and 1
+** if both runs returned the same values of the same types, or 0 if they
+** did not.
+*/
+static int test_batch_agg_check(
+  void * clientData,
+  Tcl_Interp *interp,
+  int objc,
+  Tcl_Obj *CONST objv[]
+){
+  extern int sqlite3_select_nobatch;
+  static const u8 aBatch[] = { OP_BatchAgg };
+  return toggleCheck(interp, objc, objv, &sqlite3_select_nobatch,
+                     aBatch, ArraySize(aBatch));
+}
+#endif /* SQLITE_OMIT_BATCH_AGGREGATE */
+
 /*
 ** Register commands with the TCL interpreter.
 */
@@ -5979,6 +6356,22 @@ int Sqlitetest1_Init(Tcl_Interp *interp){
   extern int sqlite3_interrupt_count;
   extern int sqlite3_open_file_count;
   extern int sqlite3_sort_count;
+  extern int sqlite3_readahead_count;
+  extern int sqlite3_vdbe_switch_dispatch;
+  extern int sqlite3_vdbe_generic_compare;
+#ifndef SQLITE_OMIT_SUPERINSTRUCTIONS
+  extern int sqlite3_vdbe_nofuse;
+#endif
+#ifndef SQLITE_OMIT_BATCH_AGGREGATE
+  extern int sqlite3_select_nobatch;
+#endif
+#ifndef SQLITE_OMIT_HASH_AGGREGATE
+  extern int sqlite3_select_nohash;
+  extern int sqlite3_hashagg_spill_count;
+#endif
+#if !defined(SQLITE_OMIT_AUTOMATIC_INDEX) && !defined(SQLITE_OMIT_HASH_JOIN)
+  extern int sqlite3_where_nohash;
+#endif
   extern int sqlite3_current_time;
 #if SQLITE_OS_UNIX && defined(__APPLE__) && SQLITE_ENABLE_LOCKING_STYLE
   extern int sqlite3_hostid_num;
@@ -6185,6 +6578,15 @@ int Sqlitetest1_Init(Tcl_Interp *interp){
      { "test_sqlite3_log",         test_sqlite3_log, 0  },
 #ifndef SQLITE_OMIT_EXPLAIN
      { "print_explain_query_plan", test_print_eqp, 0  },
+#endif
+     { "sqlite3_vdbe_dispatch_bench", test_vdbe_dispatch_bench, 0 },
+     { "sqlite3_record_compare_bench", test_record_compare_bench, 0 },
+#ifndef SQLITE_OMIT_SUPERINSTRUCTIONS
+     { "sqlite3_vdbe_fuse_check", test_vdbe_fuse_check, 0 },
+     { "sqlite3_vdbe_column_range_check", test_vdbe_column_range_check, 0 },
+#endif
+#ifndef SQLITE_OMIT_BATCH_AGGREGATE
+     { "sqlite3_batch_agg_check", test_batch_agg_check, 0 },
 #endif
      { "sqlite3_test_control", test_test_control },
   };
@@ -6227,6 +6629,30 @@ int Sqlitetest1_Init(Tcl_Interp *interp){
       (char*)&sqlite3_found_count, TCL_LINK_INT);
   Tcl_LinkVar(interp, "sqlite_sort_count", 
       (char*)&sqlite3_sort_count, TCL_LINK_INT);
+  Tcl_LinkVar(interp, "sqlite_readahead_count",
+      (char*)&sqlite3_readahead_count, TCL_LINK_INT);
+  Tcl_LinkVar(interp, "sqlite_vdbe_switch_dispatch",
+      (char*)&sqlite3_vdbe_switch_dispatch, TCL_LINK_INT);
+  Tcl_LinkVar(interp, "sqlite_vdbe_generic_compare",
+      (char*)&sqlite3_vdbe_generic_compare, TCL_LINK_INT);
+#ifndef SQLITE_OMIT_SUPERINSTRUCTIONS
+  Tcl_LinkVar(interp, "sqlite_vdbe_nofuse",
+      (char*)&sqlite3_vdbe_nofuse, TCL_LINK_INT);
+#endif
+#ifndef SQLITE_OMIT_BATCH_AGGREGATE
+  Tcl_LinkVar(interp, "sqlite_select_nobatch",
+      (char*)&sqlite3_select_nobatch, TCL_LINK_INT);
+#endif
+#ifndef SQLITE_OMIT_HASH_AGGREGATE
+  Tcl_LinkVar(interp, "sqlite_select_nohash",
+      (char*)&sqlite3_select_nohash, TCL_LINK_INT);
+  Tcl_LinkVar(interp, "sqlite_hashagg_spill_count",
+      (char*)&sqlite3_hashagg_spill_count, TCL_LINK_INT);
+#endif
+#if !defined(SQLITE_OMIT_AUTOMATIC_INDEX) && !defined(SQLITE_OMIT_HASH_JOIN)
+  Tcl_LinkVar(interp, "sqlite_where_nohash",
+      (char*)&sqlite3_where_nohash, TCL_LINK_INT);
+#endif
   Tcl_LinkVar(interp, "sqlite3_max_blobsize", 
       (char*)&sqlite3_max_blobsize, TCL_LINK_INT);
   Tcl_LinkVar(interp, "sqlite_like_count", 
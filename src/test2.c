@@ -632,6 +632,144 @@ static int testBitvecBuiltinTest(
   return TCL_OK;
 }  
 
+#ifndef SQLITE_OMIT_WAL
+/*
+** sqlite3_wal_cksum_bench NBYTE NITER
+**
+** Compute the WAL checksum of an NBYTE buffer of pseudo-random data NITER
+** times using the portable C code and then NITER times using the code
+** that the WAL module actually uses, which may be SSE2, AVX2 or NEON.
+** Return a list of four elements: the name of the implementation used
+** by the WAL module, the elapsed time in microseconds for each of the two
+** runs, and 1 if both gave the same checksums in both byte orders, or 0
+** if they did not.
+*/
+static int testWalCksumBench(
+  void *NotUsed,
+  Tcl_Interp *interp,    /* The TCL interpreter that invoked this command */
+  int argc,              /* Number of arguments */
+  const char **argv      /* Text of each argument */
+){
+  extern const char *sqlite3WalChecksumTest(int, int, u8*, int, u32*);
+  int nByte, nIter;
+  int i, k;
+  int isSame = 1;
+  u8 *aBuf;
+  u32 aRef[2], aCksum[2];
+  const char *zImpl = 0;
+  Tcl_WideInt aUs[2];
+  Tcl_Obj *pRet;
+
+  if( argc!=3 ){
+    Tcl_AppendResult(interp, "wrong # args: should be \"", argv[0],
+                     " NBYTE NITER\"", (void*)0);
+    return TCL_ERROR;
+  }
+  if( Tcl_GetInt(interp, argv[1], &nByte) ) return TCL_ERROR;
+  if( Tcl_GetInt(interp, argv[2], &nIter) ) return TCL_ERROR;
+  if( nByte<8 || (nByte&7)!=0 || nIter<1 ){
+    Tcl_AppendResult(interp, "NBYTE must be a positive multiple of 8 "
+                     "and NITER must be positive", (void*)0);
+    return TCL_ERROR;
+  }
+  aBuf = (u8*)sqlite3_malloc(nByte);
+  if( aBuf==0 ){
+    Tcl_AppendResult(interp, "out of memory", (void*)0);
+    return TCL_ERROR;
+  }
+  sqlite3_randomness(nByte, aBuf);
+
+  for(k=0; k<2; k++){
+    sqlite3WalChecksumTest(1, k, aBuf, nByte, aRef);
+    zImpl = sqlite3WalChecksumTest(0, k, aBuf, nByte, aCksum);
+    if( aRef[0]!=aCksum[0] || aRef[1]!=aCksum[1] ) isSame = 0;
+  }
+  for(k=0; k<2; k++){
+    Tcl_Time t1, t2;
+    Tcl_GetTime(&t1);
+    for(i=0; i<nIter; i++){
+      sqlite3WalChecksumTest(k==0, 1, aBuf, nByte, aCksum);
+      aBuf[i%nByte] ^= (u8)aCksum[0];
+    }
+    Tcl_GetTime(&t2);
+    aUs[k] = ((Tcl_WideInt)t2.sec - t1.sec)*1000000 + (t2.usec - t1.usec);
+  }
+  sqlite3_free(aBuf);
+
+  pRet = Tcl_NewObj();
+  Tcl_ListObjAppendElement(interp, pRet, Tcl_NewStringObj(zImpl, -1));
+  Tcl_ListObjAppendElement(interp, pRet, Tcl_NewWideIntObj(aUs[0]));
+  Tcl_ListObjAppendElement(interp, pRet, Tcl_NewWideIntObj(aUs[1]));
+  Tcl_ListObjAppendElement(interp, pRet, Tcl_NewIntObj(isSame));
+  Tcl_SetObjResult(interp, pRet);
+  return TCL_OK;
+}
+
+/*
+** sqlite3_wal_cksum_check NBYTE NTRIAL
+**
+** Fill an NBYTE buffer with pseudo-random data NTRIAL times. Each time,
+** compute its WAL checksum in both byte orders using the portable C code
+** and using the code that the WAL module actually uses. Do this for the
+** buffer at an address that is a multiple of 16 and at one that is not.
+** Return a list of two elements: the name of the implementation used by
+** the WAL module and the number of checksums that did not match.
+*/
+static int testWalCksumCheck(
+  void *NotUsed,
+  Tcl_Interp *interp,    /* The TCL interpreter that invoked this command */
+  int argc,              /* Number of arguments */
+  const char **argv      /* Text of each argument */
+){
+  extern const char *sqlite3WalChecksumTest(int, int, u8*, int, u32*);
+  int nByte, nTrial;
+  int i, k, iOff;
+  int nDiff = 0;
+  u8 *aAlloc;
+  u8 *aBuf;
+  u32 aRef[2], aCksum[2];
+  const char *zImpl = 0;
+  Tcl_Obj *pRet;
+
+  if( argc!=3 ){
+    Tcl_AppendResult(interp, "wrong # args: should be \"", argv[0],
+                     " NBYTE NTRIAL\"", (void*)0);
+    return TCL_ERROR;
+  }
+  if( Tcl_GetInt(interp, argv[1], &nByte) ) return TCL_ERROR;
+  if( Tcl_GetInt(interp, argv[2], &nTrial) ) return TCL_ERROR;
+  if( nByte<8 || (nByte&7)!=0 || nTrial<1 ){
+    Tcl_AppendResult(interp, "NBYTE must be a positive multiple of 8 "
+                     "and NTRIAL must be positive", (void*)0);
+    return TCL_ERROR;
+  }
+  aAlloc = (u8*)sqlite3_malloc(nByte + 24);
+  if( aAlloc==0 ){
+    Tcl_AppendResult(interp, "out of memory", (void*)0);
+    return TCL_ERROR;
+  }
+
+  for(i=0; i<nTrial; i++){
+    for(iOff=0; iOff<=8; iOff+=8){
+      aBuf = &aAlloc[((16 - SQLITE_PTR_TO_INT(aAlloc)) & 15) + iOff];
+      sqlite3_randomness(nByte, aBuf);
+      for(k=0; k<2; k++){
+        sqlite3WalChecksumTest(1, k, aBuf, nByte, aRef);
+        zImpl = sqlite3WalChecksumTest(0, k, aBuf, nByte, aCksum);
+        if( aRef[0]!=aCksum[0] || aRef[1]!=aCksum[1] ) nDiff++;
+      }
+    }
+  }
+  sqlite3_free(aAlloc);
+
+  pRet = Tcl_NewObj();
+  Tcl_ListObjAppendElement(interp, pRet, Tcl_NewStringObj(zImpl, -1));
+  Tcl_ListObjAppendElement(interp, pRet, Tcl_NewIntObj(nDiff));
+  Tcl_SetObjResult(interp, pRet);
+  return TCL_OK;
+}
+#endif /* SQLITE_OMIT_WAL */
+
 /*
 ** Register commands with the TCL interpreter.
 */
@@ -642,6 +780,10 @@ int Sqlitetest2_Init(Tcl_Interp *interp){
   extern int sqlite3_io_error_hardhit;
   extern int sqlite3_diskfull_pending;
   extern int sqlite3_diskfull;
+#ifndef SQLITE_OMIT_WAL
+  extern int sqlite3_wal_recovery_threads;
+  extern int sqlite3_wal_ckpt_batch;
+#endif
   static struct {
     char *zName;
     Tcl_CmdProc *xProc;
@@ -667,6 +809,10 @@ int Sqlitetest2_Init(Tcl_Interp *interp){
 #endif
     { "sqlite3BitvecBuiltinTest",(Tcl_CmdProc*)testBitvecBuiltinTest     },
     { "sqlite3_test_control_pending_byte", (Tcl_CmdProc*)testPendingByte },
+#ifndef SQLITE_OMIT_WAL
+    { "sqlite3_wal_cksum_bench", (Tcl_CmdProc*)testWalCksumBench },
+    { "sqlite3_wal_cksum_check", (Tcl_CmdProc*)testWalCksumCheck },
+#endif
   };
   int i;
   for(i=0; i<sizeof(aCmd)/sizeof(aCmd[0]); i++){
@@ -687,6 +833,12 @@ int Sqlitetest2_Init(Tcl_Interp *interp){
 #ifndef SQLITE_OMIT_WSD
   Tcl_LinkVar(interp, "sqlite_pending_byte",
      (char*)&sqlite3PendingByte, TCL_LINK_INT | TCL_LINK_READ_ONLY);
+#endif
+#ifndef SQLITE_OMIT_WAL
+  Tcl_LinkVar(interp, "sqlite_wal_recovery_threads",
+     (char*)&sqlite3_wal_recovery_threads, TCL_LINK_INT);
+  Tcl_LinkVar(interp, "sqlite_wal_ckpt_batch",
+     (char*)&sqlite3_wal_ckpt_batch, TCL_LINK_INT);
 #endif
   return TCL_OK;
 }
@@ -1199,6 +1199,38 @@ static int test_config_uri(
   return TCL_OK;
 }
 
+/*
+** Usage:    sqlite3_config_pcache_policy  POLICY
+**
+** Invoke sqlite3_config(SQLITE_CONFIG_PCACHE_POLICY, ...) where POLICY
+** is either "lru" or "2q".
+*/
+static int test_config_pcache_policy(
+  void * clientData, 
+  Tcl_Interp *interp,
+  int objc,
+  Tcl_Obj *CONST objv[]
+){
+  static const char *azPolicy[] = { "lru", "2q", 0 };
+  int rc;
+  int iPolicy;
+
+  if( objc!=2 ){
+    Tcl_WrongNumArgs(interp, 1, objv, "POLICY");
+    return TCL_ERROR;
+  }
+  if( Tcl_GetIndexFromObj(interp, objv[1], azPolicy, "policy", 0, &iPolicy) ){
+    return TCL_ERROR;
+  }
+
+  rc = sqlite3_config(SQLITE_CONFIG_PCACHE_POLICY, 
+      iPolicy==0 ? SQLITE_PCACHE_POLICY_LRU : SQLITE_PCACHE_POLICY_2Q
+  );
+  Tcl_SetResult(interp, (char *)sqlite3TestErrorName(rc), TCL_VOLATILE);
+
+  return TCL_OK;
+}
+
 /*
 ** Usage:    
 **
@@ -1324,7 +1356,9 @@ static int test_db_status(
     { "LOOKASIDE_MISS_FULL", SQLITE_DBSTATUS_LOOKASIDE_MISS_FULL },
     { "CACHE_HIT",           SQLITE_DBSTATUS_CACHE_HIT           },
     { "CACHE_MISS",          SQLITE_DBSTATUS_CACHE_MISS          },
-    { "CACHE_WRITE",         SQLITE_DBSTATUS_CACHE_WRITE         }
+    { "CACHE_WRITE",         SQLITE_DBSTATUS_CACHE_WRITE         },
+    { "CHECKPOINT_DONE",     SQLITE_DBSTATUS_CHECKPOINT_DONE     },
+    { "CHECKPOINT_LAG",      SQLITE_DBSTATUS_CHECKPOINT_LAG      }
   };
   Tcl_Obj *pResult;
   if( objc!=4 ){
@@ -1451,6 +1485,7 @@ int Sqlitetest_malloc_Init(Tcl_Interp *interp){
      { "sqlite3_config_lookaside",   test_config_lookaside         ,0 },
      { "sqlite3_config_error",       test_config_error             ,0 },
      { "sqlite3_config_uri",         test_config_uri               ,0 },
+     { "sqlite3_config_pcache_policy",test_config_pcache_policy    ,0 },
      { "sqlite3_db_config_lookaside",test_db_config_lookaside      ,0 },
      { "sqlite3_dump_memsys3",       test_dump_memsys3             ,3 },
      { "sqlite3_dump_memsys5",       test_dump_memsys3             ,5 },
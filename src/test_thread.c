@@ -53,6 +53,8 @@ struct EvalEvent {
 
 static Tcl_ObjCmdProc sqlthread_proc;
 static Tcl_ObjCmdProc clock_seconds_proc;
+static Tcl_ObjCmdProc pcache_bench_proc;
+static Tcl_ObjCmdProc group_commit_bench_proc;
 #if SQLITE_OS_UNIX && defined(SQLITE_ENABLE_UNLOCK_NOTIFY)
 static Tcl_ObjCmdProc blocking_step_proc;
 static Tcl_ObjCmdProc blocking_prepare_v2_proc;
@@ -394,6 +396,276 @@ static int clock_seconds_proc(
   return TCL_OK;
 }
 
+/*
+** One of these is allocated for each thread started by the
+** [sqlite3_pcache_bench] command.
+*/
+typedef struct PcacheBench PcacheBench;
+struct PcacheBench {
+  int iThread;             /* Index of this thread, used to seed the PRNG */
+  int nPage;               /* Number of distinct pages to fetch */
+  int nIter;               /* Number of xFetch()/xUnpin() pairs to do */
+  int nMiss;               /* OUT: Number of times xFetch() returned 0 */
+};
+
+/*
+** The body of each thread started by [sqlite3_pcache_bench]. Each thread
+** creates its own purgeable page cache and then repeatedly fetches and 
+** unpins pseudo-random pages from it. All of the caches draw on the same 
+** global page budget, so with a unified page cache (mode 2 in pcache1.c)
+** this measures contention on the shared LRU state.
+*/
+static Tcl_ThreadCreateType pcache_bench_thread(ClientData pSqlThread){
+  PcacheBench *p = (PcacheBench *)pSqlThread;
+  sqlite3_pcache_methods2 *pMethods = &sqlite3GlobalConfig.pcache2;
+  sqlite3_pcache *pCache;
+  unsigned int x = 1 + p->iThread*7919;
+  int i;
+
+  pCache = pMethods->xCreate(1024, 16, 1);
+  if( pCache ){
+    pMethods->xCachesize(pCache, p->nPage);
+    for(i=0; i<p->nIter; i++){
+      sqlite3_pcache_page *pPg;
+      x = x*1103515245 + 12345;
+      pPg = pMethods->xFetch(pCache, 1 + (x>>8)%p->nPage, 2);
+      if( pPg ){
+        pMethods->xUnpin(pCache, pPg, 0);
+      }else{
+        p->nMiss++;
+      }
+    }
+    pMethods->xDestroy(pCache);
+  }
+  TCL_THREAD_CREATE_RETURN;
+}
+
+/*
+** Usage: sqlite3_pcache_bench NTHREAD NPAGE NITER
+**
+** Start NTHREAD threads (between 1 and 64), each of which does NITER
+** fetch/unpin operations on its own cache of NPAGE pages. Wait for all
+** threads to finish and return a list of two elements: the elapsed time
+** in microseconds and the total number of failed fetches.
+*/
+static int pcache_bench_proc(
+  ClientData clientData,
+  Tcl_Interp *interp,
+  int objc,
+  Tcl_Obj *CONST objv[]
+){
+  PcacheBench aBench[64];
+  Tcl_ThreadId aId[64];
+  int nThread, nPage, nIter;
+  int nMiss = 0;
+  int i;
+  Tcl_Time t1, t2;
+  Tcl_WideInt nUs;
+  Tcl_Obj *pRet;
+
+  UNUSED_PARAMETER(clientData);
+  if( objc!=4 ){
+    Tcl_WrongNumArgs(interp, 1, objv, "NTHREAD NPAGE NITER");
+    return TCL_ERROR;
+  }
+  if( Tcl_GetIntFromObj(interp, objv[1], &nThread)
+   || Tcl_GetIntFromObj(interp, objv[2], &nPage)
+   || Tcl_GetIntFromObj(interp, objv[3], &nIter)
+  ){
+    return TCL_ERROR;
+  }
+  if( nThread<1 || nThread>ArraySize(aBench) || nPage<1 || nIter<0 ){
+    Tcl_AppendResult(interp, "NTHREAD must be between 1 and 64, "
+        "NPAGE must be positive", (char*)0);
+    return TCL_ERROR;
+  }
+  if( sqlite3_initialize() ){
+    Tcl_AppendResult(interp, "sqlite3_initialize() failed", (char*)0);
+    return TCL_ERROR;
+  }
+
+  Tcl_GetTime(&t1);
+  for(i=0; i<nThread; i++){
+    aBench[i].iThread = i;
+    aBench[i].nPage = nPage;
+    aBench[i].nIter = nIter;
+    aBench[i].nMiss = 0;
+    if( Tcl_CreateThread(&aId[i], pcache_bench_thread, (void *)&aBench[i],
+          TCL_THREAD_STACK_DEFAULT, TCL_THREAD_JOINABLE)!=TCL_OK ){
+      while( i-- ){
+        int rc;
+        Tcl_JoinThread(aId[i], &rc);
+      }
+      Tcl_AppendResult(interp, "Error in Tcl_CreateThread()", (char*)0);
+      return TCL_ERROR;
+    }
+  }
+  for(i=0; i<nThread; i++){
+    int rc;
+    Tcl_JoinThread(aId[i], &rc);
+    nMiss += aBench[i].nMiss;
+  }
+  Tcl_GetTime(&t2);
+
+  nUs = ((Tcl_WideInt)t2.sec - t1.sec)*1000000 + (t2.usec - t1.usec);
+  pRet = Tcl_NewObj();
+  Tcl_ListObjAppendElement(interp, pRet, Tcl_NewWideIntObj(nUs));
+  Tcl_ListObjAppendElement(interp, pRet, Tcl_NewIntObj(nMiss));
+  Tcl_SetObjResult(interp, pRet);
+  return TCL_OK;
+}
+
+/*
+** One of these is allocated for each thread started by the
+** [sqlite3_group_commit_bench] command.
+*/
+typedef struct CommitBench CommitBench;
+struct CommitBench {
+  const char *zFile;       /* Database file to write to */
+  int iThread;             /* Index of this thread */
+  int nCommit;             /* Number of transactions to commit */
+  int nWindow;             /* Value for PRAGMA wal_group_commit */
+  int nError;              /* OUT: Number of failed commits */
+};
+
+/*
+** The body of each thread started by [sqlite3_group_commit_bench]. Each
+** thread opens its own connection to the database and commits nCommit
+** single-row transactions with synchronous=FULL.
+*/
+static Tcl_ThreadCreateType group_commit_bench_thread(ClientData pSqlThread){
+  CommitBench *p = (CommitBench *)pSqlThread;
+  sqlite3 *db = 0;
+  sqlite3_stmt *pStmt = 0;
+  char *zSql;
+  int i;
+
+  if( sqlite3_open(p->zFile, &db)==SQLITE_OK ){
+    sqlite3_busy_timeout(db, 10000);
+    zSql = sqlite3_mprintf(
+        "PRAGMA synchronous = FULL; PRAGMA wal_group_commit = %d;", p->nWindow
+    );
+    sqlite3_exec(db, zSql, 0, 0, 0);
+    sqlite3_free(zSql);
+    sqlite3_prepare_v2(db, 
+        "INSERT INTO t1 VALUES(?, randomblob(100))", -1, &pStmt, 0
+    );
+  }
+  for(i=0; i<p->nCommit; i++){
+    if( pStmt==0 ){
+      p->nError++;
+      continue;
+    }
+    sqlite3_bind_int(pStmt, 1, p->iThread);
+    sqlite3_step(pStmt);
+    if( sqlite3_reset(pStmt)!=SQLITE_OK ) p->nError++;
+  }
+  sqlite3_finalize(pStmt);
+  sqlite3_close(db);
+  TCL_THREAD_CREATE_RETURN;
+}
+
+/*
+** Usage: sqlite3_group_commit_bench FILENAME NTHREAD NCOMMIT ?WINDOW?
+**
+** Put database FILENAME in WAL mode and start NTHREAD threads (between 1
+** and 64), each of which commits NCOMMIT single-row transactions through
+** its own connection. Each connection sets "PRAGMA wal_group_commit" to
+** WINDOW, which defaults to -1 (group commit disabled). Wait for all 
+** threads to finish and return a list of three elements: the elapsed
+** time in microseconds, the number of commits per second and the number
+** of commits that failed.
+*/
+static int group_commit_bench_proc(
+  ClientData clientData,
+  Tcl_Interp *interp,
+  int objc,
+  Tcl_Obj *CONST objv[]
+){
+  CommitBench aBench[64];
+  Tcl_ThreadId aId[64];
+  const char *zFile;
+  int nThread, nCommit;
+  int nWindow = -1;
+  int nError = 0;
+  int i;
+  int rc;
+  sqlite3 *db;
+  Tcl_Time t1, t2;
+  Tcl_WideInt nUs;
+  Tcl_Obj *pRet;
+
+  UNUSED_PARAMETER(clientData);
+  if( objc!=4 && objc!=5 ){
+    Tcl_WrongNumArgs(interp, 1, objv, "FILENAME NTHREAD NCOMMIT ?WINDOW?");
+    return TCL_ERROR;
+  }
+  zFile = Tcl_GetString(objv[1]);
+  if( Tcl_GetIntFromObj(interp, objv[2], &nThread)
+   || Tcl_GetIntFromObj(interp, objv[3], &nCommit)
+   || (objc==5 && Tcl_GetIntFromObj(interp, objv[4], &nWindow))
+  ){
+    return TCL_ERROR;
+  }
+  if( nThread<1 || nThread>ArraySize(aBench) || nCommit<0 ){
+    Tcl_AppendResult(interp, "NTHREAD must be between 1 and 64, "
+        "NCOMMIT must not be negative", (char*)0);
+    return TCL_ERROR;
+  }
+
+  rc = sqlite3_open(zFile, &db);
+  if( rc==SQLITE_OK ){
+    rc = sqlite3_exec(db, 
+        "PRAGMA journal_mode = WAL;"
+        "CREATE TABLE IF NOT EXISTS t1(a, b);", 0, 0, 0
+    );
+  }
+  if( rc!=SQLITE_OK ){
+    Tcl_AppendResult(interp, "failed to set up database: ", 
+        sqlite3_errmsg(db), (char*)0);
+    sqlite3_close(db);
+    return TCL_ERROR;
+  }
+
+  /* Keep db open while the threads run so that the WAL file and the
+  ** wal-index are not deleted and recreated between connections. */
+  Tcl_GetTime(&t1);
+  for(i=0; i<nThread; i++){
+    aBench[i].zFile = zFile;
+    aBench[i].iThread = i;
+    aBench[i].nCommit = nCommit;
+    aBench[i].nWindow = nWindow;
+    aBench[i].nError = 0;
+    if( Tcl_CreateThread(&aId[i], group_commit_bench_thread, 
+          (void *)&aBench[i], TCL_THREAD_STACK_DEFAULT, TCL_THREAD_JOINABLE)
+        !=TCL_OK 
+    ){
+      while( i-- ){
+        Tcl_JoinThread(aId[i], &rc);
+      }
+      sqlite3_close(db);
+      Tcl_AppendResult(interp, "Error in Tcl_CreateThread()", (char*)0);
+      return TCL_ERROR;
+    }
+  }
+  for(i=0; i<nThread; i++){
+    Tcl_JoinThread(aId[i], &rc);
+    nError += aBench[i].nError;
+  }
+  Tcl_GetTime(&t2);
+  sqlite3_close(db);
+
+  nUs = ((Tcl_WideInt)t2.sec - t1.sec)*1000000 + (t2.usec - t1.usec);
+  pRet = Tcl_NewObj();
+  Tcl_ListObjAppendElement(interp, pRet, Tcl_NewWideIntObj(nUs));
+  Tcl_ListObjAppendElement(interp, pRet, Tcl_NewDoubleObj(
+      nUs>0 ? (double)nThread*nCommit*1000000.0/(double)nUs : 0.0
+  ));
+  Tcl_ListObjAppendElement(interp, pRet, Tcl_NewIntObj(nError));
+  Tcl_SetObjResult(interp, pRet);
+  return TCL_OK;
+}
+
 /*************************************************************************
 ** This block contains the implementation of the [sqlite3_blocking_step]
 ** command available to threads created by [sqlthread spawn] commands. It
@@ -629,6 +901,9 @@ static int blocking_prepare_v2_proc(
 int SqlitetestThread_Init(Tcl_Interp *interp){
   Tcl_CreateObjCommand(interp, "sqlthread", sqlthread_proc, 0, 0);
   Tcl_CreateObjCommand(interp, "clock_seconds", clock_seconds_proc, 0, 0);
+  Tcl_CreateObjCommand(interp, "sqlite3_pcache_bench", pcache_bench_proc,0,0);
+  Tcl_CreateObjCommand(interp, 
+      "sqlite3_group_commit_bench", group_commit_bench_proc, 0, 0);
 #if SQLITE_OS_UNIX && defined(SQLITE_ENABLE_UNLOCK_NOTIFY)
   Tcl_CreateObjCommand(interp, "sqlite3_blocking_step", blocking_step_proc,0,0);
   Tcl_CreateObjCommand(interp, 
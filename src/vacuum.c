@@ -244,8 +244,7 @@ int sqlite3RunVacuum(char **pzErrMsg, sqlite3 *db){
   if( rc!=SQLITE_OK ) goto end_of_vacuum;
 
   /* 不要试图改变WAL数据库的页面大小*/
-  if( sqlite3PagerGetJournalMode(sqlite3BtreePager(pMain))
-                                               ==PAGER_JOURNALMODE_WAL ){
+  if( isWalMode(sqlite3PagerGetJournalMode(sqlite3BtreePager(pMain))) ){
     db->nextPagesize = 0;
   }
 
@@ -111,6 +111,16 @@ int sqlite3_interrupt_count = 0;/*当这个全局变量为正数时，指令在V
 									*/
 #endif
 
+/*
+** When this global variable is non-zero, sqlite3VdbeExec() always returns
+** to the top of its loop and the switch statement between opcodes, even in
+** builds that support computed-goto dispatch.  It lets the test harness
+** compare the two dispatch methods.  Test builds only.
+*/
+#ifdef SQLITE_TEST
+int sqlite3_vdbe_switch_dispatch = 0;
+#endif
+
 /*
 ** The next global variable is incremented each type the OP_Sort opcode
 ** is executed.  The test procedures use this information to make sure that
@@ -154,6 +164,18 @@ static void updateMaxBlobsize(Mem *p){
 int sqlite3_found_count = 0;
 #endif
 
+/*
+** The next global variable is incremented each time OP_HashAggFind meets
+** a row whose group is not in the hash table because the table has used
+** up its memory budget, so that the row is passed on to the sorter.  The
+** test procedures use it to make sure that the budget is enforced.  This
+** variable has no function other than to help verify the correct
+** operation of the library.
+*/
+#if defined(SQLITE_TEST) && !defined(SQLITE_OMIT_HASH_AGGREGATE)
+int sqlite3_hashagg_spill_count = 0;
+#endif
+
 /*
 ** Test a register to see if it exceeds the current maximum blob size.
 ** If it does, record the new maximum blob size.测试一个寄存器来看它是否超过
@@ -533,7 +555,7 @@ static void registerTrace(FILE *out, int iReg, Mem *p){
 #endif
 
 
-#ifdef VDBE_PROFILE
+#if defined(VDBE_PROFILE) || !defined(SQLITE_OMIT_STMT_PROFILE)
 
 /*
 ** hwtime.h contains inline assembler code for implementing
@@ -562,6 +584,93 @@ static void registerTrace(FILE *out, int iReg, Mem *p){
 #define CHECK_FOR_INTERRUPT \
    if( db->u1.isInterrupted ) goto abort_due_to_interrupt;
 
+/*
+** On compilers that support the "labels as values" extension, the
+** interpreter loop in sqlite3VdbeExec() can dispatch each opcode with an
+** indirect jump through the aOpTarget[] table instead of returning to the
+** top of the for() loop and the switch.  Each case of the big switch is
+** also given a label L_OP_xxx by OPCODE_LABEL(), and most case bodies end
+** with NEXT_OPCODE rather than "break".  NEXT_OPCODE jumps straight to the
+** next opcode whenever none of the per-instruction bookkeeping at the top
+** of the loop (progress callbacks, stmt_profile counters, the interrupt
+** simulation used by the test harness) is active.  Otherwise, or when a
+** case body sets rc, it falls back to "break" and the ordinary loop.
+**
+** Computed-goto dispatch is turned off for VDBE_PROFILE and SQLITE_DEBUG
+** builds, which need the per-instruction work at the loop top, and may be
+** turned off explicitly with SQLITE_OMIT_COMPUTED_GOTO.
+*/
+#if defined(__GNUC__) && !defined(SQLITE_OMIT_COMPUTED_GOTO) \
+ && !defined(VDBE_PROFILE) && !defined(SQLITE_DEBUG)
+# define VDBE_COMPUTED_GOTO 1
+#endif
+
+/*
+** VDBE_SLOW_DISPATCH is true if each opcode must be started from the top
+** of the interpreter loop in sqlite3VdbeExec(), because some per-opcode
+** bookkeeping is active.  Both the computed-goto dispatch and the fused
+** opcodes (superinstructions) built by sqlite3VdbeMakeReady() use it to
+** decide whether they may move on to the next opcode directly.
+*/
+#ifndef SQLITE_OMIT_STMT_PROFILE
+# define VDBE_SLOW_PROFILE  (aOpStat!=0)
+#else
+# define VDBE_SLOW_PROFILE  0
+#endif
+#ifndef SQLITE_OMIT_PROGRESS_CALLBACK
+# define VDBE_SLOW_PROGRESS checkProgress
+#else
+# define VDBE_SLOW_PROGRESS 0
+#endif
+#ifdef SQLITE_TEST
+# define VDBE_SLOW_TEST (sqlite3_interrupt_count>0||sqlite3_vdbe_switch_dispatch)
+#else
+# define VDBE_SLOW_TEST 0
+#endif
+#if defined(VDBE_PROFILE)
+# define VDBE_SLOW_DEBUG 1
+#elif defined(SQLITE_DEBUG)
+# define VDBE_SLOW_DEBUG (p->trace!=0)
+#else
+# define VDBE_SLOW_DEBUG 0
+#endif
+#define VDBE_SLOW_DISPATCH \
+   (VDBE_SLOW_PROFILE || VDBE_SLOW_PROGRESS || VDBE_SLOW_TEST || VDBE_SLOW_DEBUG)
+
+#ifdef VDBE_COMPUTED_GOTO
+# define OPCODE_LABEL(X) L_OP_##X:
+# define NEXT_OPCODE                                          \
+   if( rc==SQLITE_OK && !db->mallocFailed && !VDBE_SLOW_DISPATCH ){ \
+     pOp = &aOp[++pc];                                        \
+     if( pOp->opflags & OPFLG_OUT2_PRERELEASE ){              \
+       pOut = &aMem[pOp->p2];                                 \
+       memAboutToChange(p, pOut);                             \
+       VdbeMemRelease(pOut);                                  \
+       pOut->flags = MEM_Int;                                 \
+     }                                                        \
+     goto *aOpTarget[pOp->opcode];                            \
+   }                                                          \
+   break
+#else
+# define OPCODE_LABEL(X)
+# define NEXT_OPCODE break
+#endif
+
+/*
+** A fused opcode first does the work of the opcode it replaced.  Then,
+** if that work did not jump and the slow dispatch is not required, it
+** continues directly into the implementation of the following opcode
+** at label L, skipping a trip through the dispatch.  Otherwise it ends
+** like any other opcode and the following one is dispatched as usual.
+*/
+#ifndef SQLITE_OMIT_SUPERINSTRUCTIONS
+# define FUSED_NEXT(L) \
+   if( rc==SQLITE_OK && !db->mallocFailed && !VDBE_SLOW_DISPATCH ){ \
+     pOp = &aOp[++pc];                                        \
+     goto L;                                                  \
+   }
+#endif
+
 
 #ifndef NDEBUG
 /*
@@ -679,9 +788,17 @@ int sqlite3VdbeExec(
                              ** 操作码OP_Compare使用的数组。
                              */
   i64 lastRowid = db->lastRowid;  /* Saved value of the last insert ROWID */
-#ifdef VDBE_PROFILE
-  u64 start;                 /* CPU clock count at start of opcode */
-  int origPc;                /* Program counter at start of opcode */
+#if defined(VDBE_PROFILE) || !defined(SQLITE_OMIT_STMT_PROFILE)
+  u64 start = 0;             /* CPU clock count at start of opcode */
+  int origPc = 0;            /* Program counter at start of opcode */
+#endif
+#ifndef SQLITE_OMIT_STMT_PROFILE
+  VdbeOpStat *aOpStat = 0;   /* PRAGMA stmt_profile counters, or NULL */
+#endif
+#ifdef VDBE_COMPUTED_GOTO
+  static const void *const aOpTarget[256] = {
+#include "vdbegoto.h"
+  };                         /* Jump target for each opcode */
 #endif
   /*** INSERT STACK UNION HERE ***/
 
@@ -694,7 +811,7 @@ int sqlite3VdbeExec(
   }
   assert( p->rc==SQLITE_OK || p->rc==SQLITE_BUSY );
   p->rc = SQLITE_OK;
-  assert( p->explain==0 );
+  assert( p->explain==0 || p->explain==3 );
   p->pResultSet = 0;
   db->busyHandler.nBusy = 0;
   CHECK_FOR_INTERRUPT;
@@ -702,6 +819,14 @@ int sqlite3VdbeExec(
 #ifndef SQLITE_OMIT_PROGRESS_CALLBACK
   checkProgress = db->xProgress!=0;
 #endif
+#ifndef SQLITE_OMIT_STMT_PROFILE
+  if( (db->bStmtProfile || p->explain==3) && p->pFrame==0 ){
+    if( p->aOpStat==0 ){
+      p->aOpStat = (VdbeOpStat*)sqlite3MallocZero(p->nOp*sizeof(VdbeOpStat));
+    }
+    aOpStat = p->aOpStat;
+  }
+#endif
 #ifdef SQLITE_DEBUG
   sqlite3BeginBenignMalloc();
   if( p->pc==0  && (p->db->flags & SQLITE_VdbeListing)!=0 ){
@@ -720,6 +845,13 @@ int sqlite3VdbeExec(
 #ifdef VDBE_PROFILE
     origPc = pc;
     start = sqlite3Hwtime();
+#endif
+#ifndef SQLITE_OMIT_STMT_PROFILE
+    if( aOpStat ){
+      origPc = pc;
+      aOpStat[pc].nExec++;
+      start = sqlite3Hwtime();
+    }
 #endif
     pOp = &aOp[pc];
 
@@ -823,6 +955,9 @@ int sqlite3VdbeExec(
     }
 #endif
   
+#ifdef VDBE_COMPUTED_GOTO
+    if( !VDBE_SLOW_DISPATCH ) goto *aOpTarget[pOp->opcode];
+#endif
     switch( pOp->opcode ){
 
 /*****************************************************************************
@@ -863,6 +998,12 @@ int sqlite3VdbeExec(
 ** VDBE操作码文档是通过扫描这个文件中包含“Opcode:”的行来生成的。
 ** 这条线和所有后续注释行都用于生成opcode.html这个文档文件。
 **
+** Each "case OP_xxx:" is followed by OPCODE_LABEL(xxx), which names the
+** target of the computed-goto dispatch, and a case body that is not left
+** by a jump or a fall-through ends with NEXT_OPCODE instead of "break".
+** The aOpTarget[] initializer in vdbegoto.h must have one entry for each
+** case; see that file for how to regenerate it.
+**
 ** SUMMARY:
 **
 **     Formatting is important to scripts that scan this file.
@@ -878,10 +1019,10 @@ int sqlite3VdbeExec(
 ** the program.
 ** 一个无条件跳转到P2地址的操作码,下一条执行的指令会是从程序一开始就有的的索引P2里的
 */
-case OP_Goto: {             /* jump */
+case OP_Goto: OPCODE_LABEL(Goto) { /* jump */
   CHECK_FOR_INTERRUPT;
   pc = pOp->p2 - 1;
-  break;
+  NEXT_OPCODE;
 }
 
 /* Opcode:  Gosub P1 P2 * * *
@@ -890,7 +1031,7 @@ case OP_Goto: {             /* jump */
 ** and then jump to address P2.
 ** 把当前地址写入寄存器P1,然后跳到P2地址
 */
-case OP_Gosub: {            /* jump */
+case OP_Gosub: OPCODE_LABEL(Gosub) { /* jump */
   assert( pOp->p1>0 && pOp->p1<=p->nMem );
   pIn1 = &aMem[pOp->p1];
   assert( (pIn1->flags & MEM_Dyn)==0 );
@@ -899,7 +1040,7 @@ case OP_Gosub: {            /* jump */
   pIn1->u.i = pc;
   REGISTER_TRACE(pOp->p1, pIn1);
   pc = pOp->p2 - 1;
-  break;
+  NEXT_OPCODE;
 }
 
 /* Opcode:  Return P1 * * * *
@@ -907,11 +1048,11 @@ case OP_Gosub: {            /* jump */
 ** Jump to the next instruction after the address in register P1.
 ** 跳到寄存器P1后面地址的指令
 */
-case OP_Return: {           /* in1 */
+case OP_Return: OPCODE_LABEL(Return) { /* in1 */
   pIn1 = &aMem[pOp->p1];
   assert( pIn1->flags & MEM_Int );
   pc = (int)pIn1->u.i;
-  break;
+  NEXT_OPCODE;
 }
 
 /* Opcode:  Yield P1 * * * *
@@ -919,7 +1060,7 @@ case OP_Return: {           /* in1 */
 ** Swap the program counter with the value in register P1.
 ** 交换程序计数器和寄存器P1里的值
 */
-case OP_Yield: {            /* in1 */
+case OP_Yield: OPCODE_LABEL(Yield) { /* in1 */
   int pcDest;
   pIn1 = &aMem[pOp->p1];
   assert( (pIn1->flags & MEM_Dyn)==0 );
@@ -928,7 +1069,7 @@ case OP_Yield: {            /* in1 */
   pIn1->u.i = pc;
   REGISTER_TRACE(pOp->p1, pIn1);
   pc = pcDest;
-  break;
+  NEXT_OPCODE;
 }
 
 /* Opcode:  HaltIfNull  P1 P2 P3 P4 *
@@ -939,7 +1080,7 @@ case OP_Yield: {            /* in1 */
 ** 检查寄存器P3里的值,如果是空的,并且有Halt指令,那么Halt指令使用参数P1,P2
 ** 和P4,如果寄存器P3里的值不是NULL,这个程序就什么都不做.
 */
-case OP_HaltIfNull: {      /* in3 */
+case OP_HaltIfNull: OPCODE_LABEL(HaltIfNull) { /* in3 */
   pIn3 = &aMem[pOp->p3];
   if( (pIn3->flags & MEM_Null)==0 ) break;
   /* Fall through into OP_Halt */
@@ -971,7 +1112,7 @@ case OP_HaltIfNull: {      /* in3 */
 ** 有一个隐藏的"Halt 0 0 0"指令,他嵌在每一个程序最后.所以一个跳过上一条指令
 ** 的跳转也是执行Halt.
 */
-case OP_Halt: {
+case OP_Halt: OPCODE_LABEL(Halt) {
   if( pOp->p1==SQLITE_OK && p->pFrame ){
     /* Halt the sub-program. Return control to the parent frame. */
     VdbeFrame *pFrame = p->pFrame;
@@ -980,6 +1121,15 @@ case OP_Halt: {
     sqlite3VdbeSetChanges(db, p->nChange);
     pc = sqlite3VdbeFrameRestore(pFrame);
     lastRowid = db->lastRowid;
+#ifndef SQLITE_OMIT_STMT_PROFILE
+    /* Back in the main program, so resume profiling. The remainder of
+    ** this opcode is charged to the OP_Program that invoked the trigger. */
+    if( p->pFrame==0 && (db->bStmtProfile || p->explain==3) && p->aOpStat ){
+      aOpStat = p->aOpStat;
+      origPc = pc;
+      start = sqlite3Hwtime();
+    }
+#endif
     if( pOp->p2==OE_Ignore ){
       /* Instruction pc is the OP_Program that invoked the sub-program 
       ** currently being halted. If the p2 instruction of this OP_Halt
@@ -1026,9 +1176,9 @@ case OP_Halt: {
 ** The 32-bit integer value P1 is written into register P2.
 ** 存放32位整型值的寄存器P1写入到寄存器P2里
 */
-case OP_Integer: {         /* out2-prerelease */
+case OP_Integer: OPCODE_LABEL(Integer) { /* out2-prerelease */
   pOut->u.i = pOp->p1;
-  break;
+  NEXT_OPCODE;
 }
 
 /* Opcode: Int64 * P2 * P4 *
@@ -1037,10 +1187,10 @@ case OP_Integer: {         /* out2-prerelease */
 ** Write that value into register P2.
 ** P4是一个指向64位整型值的指针,把P4的值写入到P2里
 */
-case OP_Int64: {           /* out2-prerelease */
+case OP_Int64: OPCODE_LABEL(Int64) { /* out2-prerelease */
   assert( pOp->p4.pI64!=0 );
   pOut->u.i = *pOp->p4.pI64;
-  break;
+  NEXT_OPCODE;
 }
 
 #ifndef SQLITE_OMIT_FLOATING_POINT
@@ -1050,11 +1200,11 @@ case OP_Int64: {           /* out2-prerelease */
 ** Write that value into register P2.
 ** P4是一个指向64位浮点型值的指针,把这个值写入到P2
 */
-case OP_Real: {            /* same as TK_FLOAT, out2-prerelease */
+case OP_Real: OPCODE_LABEL(Real) { /* same as TK_FLOAT, out2-prerelease */
   pOut->flags = MEM_Real;
   assert( !sqlite3IsNaN(*pOp->p4.pReal) );
   pOut->r = *pOp->p4.pReal;
-  break;
+  NEXT_OPCODE;
 }
 #endif
 
@@ -1065,7 +1215,7 @@ case OP_Real: {            /* same as TK_FLOAT, out2-prerelease */
 ** P4是一个UTF-8制式的以nul结尾的字符串,这个操作码在第一次被执行前会转换为
 ** 一个OP_String.
 */
-case OP_String8: {         /* same as TK_STRING, out2-prerelease */
+case OP_String8: OPCODE_LABEL(String8) { /* same as TK_STRING, out2-prerelease */
   assert( pOp->p4.z!=0 );
   pOp->opcode = OP_String;
   pOp->p1 = sqlite3Strlen30(pOp->p4.z);
@@ -1099,14 +1249,14 @@ case OP_String8: {         /* same as TK_STRING, out2-prerelease */
 ** The string value P4 of length P1 (bytes) is stored in register P2.
 ** 
 */
-case OP_String: {          /* out2-prerelease */
+case OP_String: OPCODE_LABEL(String) { /* out2-prerelease */
   assert( pOp->p4.z!=0 );
   pOut->flags = MEM_Str|MEM_Static|MEM_Term;
   pOut->z = pOp->p4.z;
   pOut->n = pOp->p1;
   pOut->enc = encoding;
   UPDATE_MAX_BLOBSIZE(pOut);
-  break;
+  NEXT_OPCODE;
 }
 
 /* Opcode: Null * P2 P3 * *
@@ -1118,7 +1268,7 @@ case OP_String: {          /* out2-prerelease */
 ** 往P2里写入一个NULL,如果P3比P2大,那么也要往P3里写入NULL,甚至P2P3之间的
 ** 寄存器也要写入.如果P3小于P2(特别是P3是zero时),那就只把P2设置为NULL.
 */
-case OP_Null: {           /* out2-prerelease */
+case OP_Null: OPCODE_LABEL(Null) { /* out2-prerelease */
   int cnt;
   cnt = pOp->p3-pOp->p2;
   assert( pOp->p3<=p->nMem );
@@ -1130,7 +1280,7 @@ case OP_Null: {           /* out2-prerelease */
     pOut->flags = MEM_Null;
     cnt--;
   }
-  break;
+  NEXT_OPCODE;
 }
 
 
@@ -1140,12 +1290,12 @@ case OP_Null: {           /* out2-prerelease */
 ** blob in register P2.
 ** 
 */
-case OP_Blob: {                /* out2-prerelease */
+case OP_Blob: OPCODE_LABEL(Blob) { /* out2-prerelease */
   assert( pOp->p1 <= SQLITE_MAX_LENGTH );
   sqlite3VdbeMemSetStr(pOut, pOp->p4.z, pOp->p1, 0, 0);
   pOut->enc = encoding;
   UPDATE_MAX_BLOBSIZE(pOut);
-  break;
+  NEXT_OPCODE;
 } 
 
 /* Opcode: Variable P1 P2 * P4 *
@@ -1157,7 +1307,7 @@ case OP_Blob: {                /* out2-prerelease */
 ** 把P1参数的边界值传递给P2,如果参数命名过了,那么他的名字也要出现在
 ** P4中,P3为1.P4的值是被sqlite3_bind_parameter_name()使用的.
 */
-case OP_Variable: {            /* out2-prerelease */
+case OP_Variable: OPCODE_LABEL(Variable) { /* out2-prerelease */
   Mem *pVar;       /* Value being transferred */
 
   assert( pOp->p1>0 && pOp->p1<=p->nVar );
@@ -1168,7 +1318,7 @@ case OP_Variable: {            /* out2-prerelease */
   }
   sqlite3VdbeMemShallowCopy(pOut, pVar, MEM_Static);
   UPDATE_MAX_BLOBSIZE(pOut);
-  break;
+  NEXT_OPCODE;
 }
 
 /* Opcode: Move P1 P2 P3 * *
@@ -1180,7 +1330,7 @@ case OP_Variable: {            /* out2-prerelease */
 ** 把P1..P1+P3-1的值转移到P2..P2+P3-1中.P1..P1+P1-1丢弃并设为NULL,
 ** P1..P1+P3-1到P2..P2+P3-1的值重复是一个错误
 */
-case OP_Move: {
+case OP_Move: OPCODE_LABEL(Move) {
   char *zMalloc;   /* Holding variable for allocated memory */
   int n;           /* Number of registers left to copy */
   int p1;          /* Register to copy from */
@@ -1212,7 +1362,7 @@ case OP_Move: {
     pIn1++;
     pOut++;
   }
-  break;
+  NEXT_OPCODE;
 }
 
 /* Opcode: Copy P1 P2 * * *
@@ -1222,14 +1372,14 @@ case OP_Move: {
 ** This instruction makes a deep copy of the value.  A duplicate
 ** is made of any string or blob constant.  See also OP_SCopy.
 */
-case OP_Copy: {             /* in1, out2 */
+case OP_Copy: OPCODE_LABEL(Copy) { /* in1, out2 */
   pIn1 = &aMem[pOp->p1];
   pOut = &aMem[pOp->p2];
   assert( pOut!=pIn1 );
   sqlite3VdbeMemShallowCopy(pOut, pIn1, MEM_Ephem);
   Deephemeralize(pOut);
   REGISTER_TRACE(pOp->p2, pOut);
-  break;
+  NEXT_OPCODE;
 }
 
 /* Opcode: SCopy P1 P2 * * *
@@ -1248,7 +1398,7 @@ case OP_Copy: {             /* in1, out2 */
 ** 这个拷贝就变无效了,因此程序必须保证在有拷贝期间源不会改变.使用OP_Copy
 ** 生成一个完整的拷贝.
 */
-case OP_SCopy: {            /* in1, out2 */
+case OP_SCopy: OPCODE_LABEL(SCopy) { /* in1, out2 */
   pIn1 = &aMem[pOp->p1];
   pOut = &aMem[pOp->p2];
   assert( pOut!=pIn1 );
@@ -1257,7 +1407,7 @@ case OP_SCopy: {            /* in1, out2 */
   if( pOut->pScopyFrom==0 ) pOut->pScopyFrom = pIn1;
 #endif
   REGISTER_TRACE(pOp->p2, pOut);
-  break;
+  NEXT_OPCODE;
 }
 
 /* Opcode: ResultRow P1 P2 * * *
@@ -1271,7 +1421,7 @@ case OP_SCopy: {            /* in1, out2 */
 ** 至结束,返回一个SQLITE_ROW,它还设置sqlite3_stmt结构体能够提供与结果
 ** 行里的最上面的P1值的交互.
 */
-case OP_ResultRow: {
+case OP_ResultRow: OPCODE_LABEL(ResultRow) {
   Mem *pMem;
   int i;
   assert( p->nResColumn==pOp->p2 );
@@ -1352,7 +1502,7 @@ case OP_ResultRow: {
 ** to avoid a memcpy().
 ** 添加P1中的文本到P2中文本的末尾,把结果放在P3中,如果P1或P2的文本是空的,那就在P3中存放NULL
 */
-case OP_Concat: {           /* same as TK_CONCAT, in1, in2, out3 */
+case OP_Concat: OPCODE_LABEL(Concat) { /* same as TK_CONCAT, in1, in2, out3 */
   i64 nByte;
 
   pIn1 = &aMem[pOp->p1];
@@ -1384,7 +1534,7 @@ case OP_Concat: {           /* same as TK_CONCAT, in1, in2, out3 */
   pOut->n = (int)nByte;
   pOut->enc = encoding;
   UPDATE_MAX_BLOBSIZE(pOut);
-  break;
+  NEXT_OPCODE;
 }
 
 /* Opcode: Add P1 P2 P3 * *
@@ -1426,11 +1576,11 @@ case OP_Concat: {           /* same as TK_CONCAT, in1, in2, out3 */
 ** 计算P1/P2的余数放在P3中,如果P2的值是0,那结果为NULL,如果任意一个操作数为NULL,那结果也是NULL
 ** 
 */
-case OP_Add:                   /* same as TK_PLUS, in1, in2, out3 */
-case OP_Subtract:              /* same as TK_MINUS, in1, in2, out3 */
-case OP_Multiply:              /* same as TK_STAR, in1, in2, out3 */
-case OP_Divide:                /* same as TK_SLASH, in1, in2, out3 */
-case OP_Remainder: {           /* same as TK_REM, in1, in2, out3 */
+case OP_Add: OPCODE_LABEL(Add) /* same as TK_PLUS, in1, in2, out3 */
+case OP_Subtract: OPCODE_LABEL(Subtract) /* same as TK_MINUS, in1, in2, out3 */
+case OP_Multiply: OPCODE_LABEL(Multiply) /* same as TK_STAR, in1, in2, out3 */
+case OP_Divide: OPCODE_LABEL(Divide) /* same as TK_SLASH, in1, in2, out3 */
+case OP_Remainder: OPCODE_LABEL(Remainder) { /* same as TK_REM, in1, in2, out3 */
   int flags;      /* Combined MEM_* flags from both inputs */
   i64 iA;         /* Integer value of left operand */
   i64 iB;         /* Integer value of right operand */
@@ -1507,7 +1657,7 @@ fp_math:
 
 arithmetic_result_is_null:
   sqlite3VdbeMemSetNull(pOut);
-  break;
+  NEXT_OPCODE;
 }
 
 /* Opcode: CollSeq P1 * * P4
@@ -1529,12 +1679,12 @@ arithmetic_result_is_null:
 ** nullif函数使用的.
 ** 
 */
-case OP_CollSeq: {
+case OP_CollSeq: OPCODE_LABEL(CollSeq) {
   assert( pOp->p4type==P4_COLLSEQ );
   if( pOp->p1 ){
     sqlite3VdbeMemSetInt64(&aMem[pOp->p1], 0);
   }
-  break;
+  NEXT_OPCODE;
 }
 
 /* Opcode: Function P1 P2 P3 P4 P5
@@ -1560,7 +1710,7 @@ case OP_CollSeq: {
 ** 操作码下一次被调用.
 ** 还可以看下: AggStep和AggFinal
 */
-case OP_Function: {
+case OP_Function: OPCODE_LABEL(Function) {
   int i;
   Mem *pArg;
   sqlite3_context ctx;
@@ -1666,7 +1816,7 @@ case OP_Function: {
 
   REGISTER_TRACE(pOp->p3, pOut);
   UPDATE_MAX_BLOBSIZE(pOut);
-  break;
+  NEXT_OPCODE;
 }
 
 /* Opcode: BitAnd P1 P2 P3 * *
@@ -1702,10 +1852,10 @@ case OP_Function: {
 ** 通过P1中的整形确定P2中的整形值右移几位.P3存放移动后的结果
 ** 如果输入都是空的,那结果也是空的
 */
-case OP_BitAnd:                 /* same as TK_BITAND, in1, in2, out3 */
-case OP_BitOr:                  /* same as TK_BITOR, in1, in2, out3 */
-case OP_ShiftLeft:              /* same as TK_LSHIFT, in1, in2, out3 */
-case OP_ShiftRight: {           /* same as TK_RSHIFT, in1, in2, out3 */
+case OP_BitAnd: OPCODE_LABEL(BitAnd) /* same as TK_BITAND, in1, in2, out3 */
+case OP_BitOr: OPCODE_LABEL(BitOr) /* same as TK_BITOR, in1, in2, out3 */
+case OP_ShiftLeft: OPCODE_LABEL(ShiftLeft) /* same as TK_LSHIFT, in1, in2, out3 */
+case OP_ShiftRight: OPCODE_LABEL(ShiftRight) { /* same as TK_RSHIFT, in1, in2, out3 */
   i64 iA;
   u64 uA;
   i64 iB;
@@ -1751,7 +1901,7 @@ case OP_ShiftRight: {           /* same as TK_RSHIFT, in1, in2, out3 */
   }
   pOut->u.i = iA;
   MemSetTypeFlag(pOut, MEM_Int);
-  break;
+  NEXT_OPCODE;
 }
 
 /* Opcode: AddImm  P1 P2 * * *
@@ -1763,12 +1913,12 @@ case OP_ShiftRight: {           /* same as TK_RSHIFT, in1, in2, out3 */
 ** 添加一个常量P2给P1里的值,结果是一个整数.
 ** 把每个寄存器的值改为整形的话就添加0.
 */
-case OP_AddImm: {            /* in1 */
+case OP_AddImm: OPCODE_LABEL(AddImm) { /* in1 */
   pIn1 = &aMem[pOp->p1];
   memAboutToChange(p, pIn1);
   sqlite3VdbeMemIntegerify(pIn1);
   pIn1->u.i += pOp->p2;
-  break;
+  NEXT_OPCODE;
 }
 
 /* Opcode: MustBeInt P1 P2 * * *
@@ -1780,7 +1930,7 @@ case OP_AddImm: {            /* in1 */
 ** 强制把P1里的值转换为整形,如果P1的值不是整形而且在不丢失数据的前
 ** 提下也不能转换为整形,那就立即跳转到P2,或者P2==0时抛出一个SQLITE_MISMATCH异常
 */
-case OP_MustBeInt: {            /* jump, in1 */
+case OP_MustBeInt: OPCODE_LABEL(MustBeInt) { /* jump, in1 */
   pIn1 = &aMem[pOp->p1];
   applyAffinity(pIn1, SQLITE_AFF_NUMERIC, encoding);
   if( (pIn1->flags & MEM_Int)==0 ){
@@ -1793,7 +1943,7 @@ case OP_MustBeInt: {            /* jump, in1 */
   }else{
     MemSetTypeFlag(pIn1, MEM_Int);
   }
-  break;
+  NEXT_OPCODE;
 }
 
 #ifndef SQLITE_OMIT_FLOATING_POINT
@@ -1809,12 +1959,12 @@ case OP_MustBeInt: {            /* jump, in1 */
 ** 提取信息.为了空间利用率,这一行的值可能还是存储为整形,但是提取后我们
 ** 想让它只有一个浮点数.
 */
-case OP_RealAffinity: {                  /* in1 */
+case OP_RealAffinity: OPCODE_LABEL(RealAffinity) { /* in1 */
   pIn1 = &aMem[pOp->p1];
   if( pIn1->flags & MEM_Int ){
     sqlite3VdbeMemRealify(pIn1);
   }
-  break;
+  NEXT_OPCODE;
 }
 #endif
 
@@ -1831,7 +1981,7 @@ case OP_RealAffinity: {                  /* in1 */
 ** 转换为字符串,二进制大文件的值是不变的,只是用文本表示.
 ** 此程序无法改变NULL值,它就是NULL.
 */
-case OP_ToText: {                  /* same as TK_TO_TEXT, in1 */
+case OP_ToText: OPCODE_LABEL(ToText) { /* same as TK_TO_TEXT, in1 */
   pIn1 = &aMem[pOp->p1];
   memAboutToChange(p, pIn1);
   if( pIn1->flags & MEM_Null ) break;
@@ -1842,7 +1992,7 @@ case OP_ToText: {                  /* same as TK_TO_TEXT, in1 */
   assert( pIn1->flags & MEM_Str || db->mallocFailed );
   pIn1->flags &= ~(MEM_Int|MEM_Real|MEM_Blob|MEM_Zero);
   UPDATE_MAX_BLOBSIZE(pIn1);
-  break;
+  NEXT_OPCODE;
 }
 
 /* Opcode: ToBlob P1 * * * *
@@ -1857,7 +2007,7 @@ case OP_ToText: {                  /* same as TK_TO_TEXT, in1 */
 ** 转换为字符串,字符串是对二进制大文件进行重新解释,它所代表的数据是不变的
 ** 此程序无法改变NULL值,它就是NULL.
 */
-case OP_ToBlob: {                  /* same as TK_TO_BLOB, in1 */
+case OP_ToBlob: OPCODE_LABEL(ToBlob) { /* same as TK_TO_BLOB, in1 */
   pIn1 = &aMem[pOp->p1];
   if( pIn1->flags & MEM_Null ) break;
   if( (pIn1->flags & MEM_Blob)==0 ){
@@ -1868,7 +2018,7 @@ case OP_ToBlob: {                  /* same as TK_TO_BLOB, in1 */
     pIn1->flags &= ~(MEM_TypeMask&~MEM_Blob);
   }
   UPDATE_MAX_BLOBSIZE(pIn1);
-  break;
+  NEXT_OPCODE;
 }
 
 /* Opcode: ToNumeric P1 * * * *
@@ -1884,10 +2034,10 @@ case OP_ToBlob: {                  /* same as TK_TO_BLOB, in1 */
 ** 值是一个文本或二进制大文件，使用atoi()的等价物尝试先转换为整数,如果不能
 ** 就存储为0.就存储为0.0.此程序无法改变NULL值,它就是NULL.
 */
-case OP_ToNumeric: {                  /* same as TK_TO_NUMERIC, in1 */
+case OP_ToNumeric: OPCODE_LABEL(ToNumeric) { /* same as TK_TO_NUMERIC, in1 */
   pIn1 = &aMem[pOp->p1];
   sqlite3VdbeMemNumerify(pIn1);
-  break;
+  NEXT_OPCODE;
 }
 #endif /* SQLITE_OMIT_CAST */
 
@@ -1903,12 +2053,12 @@ case OP_ToNumeric: {                  /* same as TK_TO_NUMERIC, in1 */
 ** 值是一个文本或二进制大文件，使用atoi()的等价物尝试先转换为整数,如果不能
 ** 就存储为0.就存储为0.0.此程序无法改变NULL值,它就是NULL.
 */
-case OP_ToInt: {                  /* same as TK_TO_INT, in1 */
+case OP_ToInt: OPCODE_LABEL(ToInt) { /* same as TK_TO_INT, in1 */
   pIn1 = &aMem[pOp->p1];
   if( (pIn1->flags & MEM_Null)==0 ){
     sqlite3VdbeMemIntegerify(pIn1);
   }
-  break;
+  NEXT_OPCODE;
 }
 
 #if !defined(SQLITE_OMIT_CAST) && !defined(SQLITE_OMIT_FLOATING_POINT)
@@ -1923,14 +2073,14 @@ case OP_ToInt: {                  /* same as TK_TO_INT, in1 */
 ** 强制P1里的值为一个浮点型指针数值，如果这个值正好是整数，转换他，如果这个
 ** 值是一个文本或二进制大文件，使用atoi()的等价物尝试先转换为整数,如果不能
 ** 就存储为0.0.此程序无法改变NULL值,它就是NULL.
-* /
-case OP_ToReal: {                  /* same as TK_TO_REAL, in1 */
+*/
+case OP_ToReal: OPCODE_LABEL(ToReal) { /* same as TK_TO_REAL, in1 */
   pIn1 = &aMem[pOp->p1];
   memAboutToChange(p, pIn1);
   if( (pIn1->flags & MEM_Null)==0 ){
     sqlite3VdbeMemRealify(pIn1);
   }
-  break;
+  NEXT_OPCODE;
 }
 #endif /* !defined(SQLITE_OMIT_CAST) && !defined(SQLITE_OMIT_FLOATING_POINT) */
 
@@ -2038,12 +2188,12 @@ case OP_ToReal: {                  /* same as TK_TO_REAL, in1 */
 ** the content of register P3 is greater than or equal to the content of
 ** register P1.  See the Lt opcode for additional information.
 */
-case OP_Eq:               /* same as TK_EQ, jump, in1, in3 */
-case OP_Ne:               /* same as TK_NE, jump, in1, in3 */
-case OP_Lt:               /* same as TK_LT, jump, in1, in3 */
-case OP_Le:               /* same as TK_LE, jump, in1, in3 */
-case OP_Gt:               /* same as TK_GT, jump, in1, in3 */
-case OP_Ge: {             /* same as TK_GE, jump, in1, in3 */
+case OP_Eq: OPCODE_LABEL(Eq) /* same as TK_EQ, jump, in1, in3 */
+case OP_Ne: OPCODE_LABEL(Ne) /* same as TK_NE, jump, in1, in3 */
+case OP_Lt: OPCODE_LABEL(Lt) /* same as TK_LT, jump, in1, in3 */
+case OP_Le: OPCODE_LABEL(Le) /* same as TK_LE, jump, in1, in3 */
+case OP_Gt: OPCODE_LABEL(Gt) /* same as TK_GT, jump, in1, in3 */
+case OP_Ge: OPCODE_LABEL(Ge) { /* same as TK_GE, jump, in1, in3 */
   int res;            /* Result of the comparison of pIn1 against pIn3
                       ** 存放输入操作对象pIn1和pIn3的比较结果
                       */
@@ -2055,6 +2205,9 @@ case OP_Ge: {             /* same as TK_GE, jump, in1, in3 */
                       */
   u16 flags3;         /* Copy of initial value of pIn3->flags */
 
+#ifndef SQLITE_OMIT_SUPERINSTRUCTIONS
+op_compare:
+#endif
   pIn1 = &aMem[pOp->p1];
   pIn3 = &aMem[pOp->p3];
   flags1 = pIn1->flags;
@@ -2126,7 +2279,7 @@ case OP_Ge: {             /* same as TK_GE, jump, in1, in3 */
   */
   pIn1->flags = (pIn1->flags&~MEM_TypeMask) | (flags1&MEM_TypeMask);
   pIn3->flags = (pIn3->flags&~MEM_TypeMask) | (flags3&MEM_TypeMask);
-  break;
+  NEXT_OPCODE;
 }
 
 /* Opcode: Permutation * * * P4 *
@@ -2142,11 +2295,11 @@ case OP_Ge: {             /* same as TK_GE, jump, in1, in3 */
 ** 通常OP_Permutation操作发生在OP_Compare之前。
 **
 */
-case OP_Permutation: {
+case OP_Permutation: OPCODE_LABEL(Permutation) {
   assert( pOp->p4type==P4_INTARRAY );
   assert( pOp->p4.ai );
   aPermute = pOp->p4.ai;
-  break;
+  NEXT_OPCODE;
 }
 
 /* Opcode: Compare P1 P2 P3 P4 *
@@ -2168,7 +2321,7 @@ case OP_Permutation: {
 ** and strings are less than blobs.
 ** 这个比较是一种分类比较，所以null等于null，nulls小于数字，数字小于字符串，字符串小于blob。
 */
-case OP_Compare: {
+case OP_Compare: OPCODE_LABEL(Compare) {
   int n;
   int i;
   int p1;
@@ -2211,7 +2364,7 @@ case OP_Compare: {
     }
   }
   aPermute = 0;
-  break;
+  NEXT_OPCODE;
 }
 
 /* Opcode: Jump P1 P2 P3 * *
@@ -2221,7 +2374,7 @@ case OP_Compare: {
 ** equal to, or greater than the P2 vector, respectively.
 ** 分别跳转到的指令地址P1,P2,P3，这取决于在最近的OP_Compare指令中P1向量是小于等于P2向量，还是大于P2向量。
 */
-case OP_Jump: {             /* jump */
+case OP_Jump: OPCODE_LABEL(Jump) { /* jump */
   if( iCompare<0 ){
     pc = pOp->p1 - 1;
   }else if( iCompare==0 ){
@@ -2229,7 +2382,7 @@ case OP_Jump: {             /* jump */
   }else{
     pc = pOp->p3 - 1;
   }
-  break;
+  NEXT_OPCODE;
 }
 
 /* Opcode: And P1 P2 P3 * *
@@ -2256,8 +2409,8 @@ case OP_Jump: {             /* jump */
 ** 如果P1和P2有一个非0(真)，那么结果是1(真)，即使另一个输入为空。
 ** 一个NULL和一个假，或者两个NULL，都输出NULL。
 */
-case OP_And:              /* same as TK_AND, in1, in2, out3 */
-case OP_Or: {             /* same as TK_OR, in1, in2, out3 */
+case OP_And: OPCODE_LABEL(And) /* same as TK_AND, in1, in2, out3 */
+case OP_Or: OPCODE_LABEL(Or) { /* same as TK_OR, in1, in2, out3 */
   int v1;    /* Left operand:  0==FALSE, 1==TRUE, 2==UNKNOWN or NULL */
   int v2;    /* Right operand: 0==FALSE, 1==TRUE, 2==UNKNOWN or NULL */
 
@@ -2287,7 +2440,7 @@ case OP_Or: {             /* same as TK_OR, in1, in2, out3 */
     pOut->u.i = v1;
     MemSetTypeFlag(pOut, MEM_Int);
   }
-  break;
+  NEXT_OPCODE;
 }
 
 /* Opcode: Not P1 P2 * * *
@@ -2298,7 +2451,7 @@ case OP_Or: {             /* same as TK_OR, in1, in2, out3 */
 ** 将寄存器中P1的值解释为一个布尔值。将这个布尔值取反后存储在寄存器P2中。
 ** 如果寄存器P1中的值是NULL,则把NULL存储在P2。
 */
-case OP_Not: {                /* same as TK_NOT, in1, out2 */
+case OP_Not: OPCODE_LABEL(Not) { /* same as TK_NOT, in1, out2 */
   pIn1 = &aMem[pOp->p1];
   pOut = &aMem[pOp->p2];
   if( pIn1->flags & MEM_Null ){
@@ -2306,7 +2459,7 @@ case OP_Not: {                /* same as TK_NOT, in1, out2 */
   }else{
     sqlite3VdbeMemSetInt64(pOut, !sqlite3VdbeIntValue(pIn1));
   }
-  break;
+  NEXT_OPCODE;
 }
 
 /* Opcode: BitNot P1 P2 * * *
@@ -2317,7 +2470,7 @@ case OP_Not: {                /* same as TK_NOT, in1, out2 */
 ** 将寄存器P1的内容转换为一个整数。将P1的值按位取反后值存储到寄存器P2内。
 ** 如果寄存器P1中的值是NULL,则把NULL存储在P2。
 */
-case OP_BitNot: {             /* same as TK_BITNOT, in1, out2 */
+case OP_BitNot: OPCODE_LABEL(BitNot) { /* same as TK_BITNOT, in1, out2 */
   pIn1 = &aMem[pOp->p1];
   pOut = &aMem[pOp->p2];
   if( pIn1->flags & MEM_Null ){
@@ -2325,7 +2478,7 @@ case OP_BitNot: {             /* same as TK_BITNOT, in1, out2 */
   }else{
     sqlite3VdbeMemSetInt64(pOut, ~sqlite3VdbeIntValue(pIn1));
   }
-  break;
+  NEXT_OPCODE;
 }
 
 /* Opcode: Once P1 P2 * * *
@@ -2336,14 +2489,14 @@ case OP_BitNot: {             /* same as TK_BITNOT, in1, out2 */
 **
 ** See also: JumpOnce
 */
-case OP_Once: {             /* jump */
+case OP_Once: OPCODE_LABEL(Once) { /* jump */
   assert( pOp->p1<p->nOnceFlag );
   if( p->aOnceFlag[pOp->p1] ){
     pc = pOp->p2-1;
   }else{
     p->aOnceFlag[pOp->p1] = 1;
   }
-  break;
+  NEXT_OPCODE;
 }
 
 /* Opcode: If P1 P2 P3 * *
@@ -2362,8 +2515,8 @@ case OP_Once: {             /* jump */
 ** 如果寄存器P1的值是假就跳转到P2。如果P1的值是零，就会被认定为假。
 ** 如果P1中的值是NULL，同时P3非零，就会跳转到P2。
 */
-case OP_If:                 /* jump, in1 */
-case OP_IfNot: {            /* jump, in1 */
+case OP_If: OPCODE_LABEL(If) /* jump, in1 */
+case OP_IfNot: OPCODE_LABEL(IfNot) { /* jump, in1 */
   int c;
   pIn1 = &aMem[pOp->p1];
   if( pIn1->flags & MEM_Null ){
@@ -2379,7 +2532,7 @@ case OP_IfNot: {            /* jump, in1 */
   if( c ){
     pc = pOp->p2-1;
   }
-  break;
+  NEXT_OPCODE;
 }
 
 /* Opcode: IsNull P1 P2 * * *
@@ -2387,12 +2540,12 @@ case OP_IfNot: {            /* jump, in1 */
 ** Jump to P2 if the value in register P1 is NULL.
 ** 如果P1中的值是NULL则跳转到P2。
 */
-case OP_IsNull: {            /* same as TK_ISNULL, jump, in1 */
+case OP_IsNull: OPCODE_LABEL(IsNull) { /* same as TK_ISNULL, jump, in1 */
   pIn1 = &aMem[pOp->p1];
   if( (pIn1->flags & MEM_Null)!=0 ){
     pc = pOp->p2 - 1;
   }
-  break;
+  NEXT_OPCODE;
 }
 
 /* Opcode: NotNull P1 P2 * * *
@@ -2400,12 +2553,12 @@ case OP_IsNull: {            /* same as TK_ISNULL, jump, in1 */
 ** Jump to P2 if the value in register P1 is not NULL.
 ** 如果P1中的值是不是NULL则跳转到P2。
 */
-case OP_NotNull: {            /* same as TK_NOTNULL, jump, in1 */
+case OP_NotNull: OPCODE_LABEL(NotNull) { /* same as TK_NOTNULL, jump, in1 */
   pIn1 = &aMem[pOp->p1];
   if( (pIn1->flags & MEM_Null)==0 ){
     pc = pOp->p2 - 1;
   }
-  break;
+  NEXT_OPCODE;
 }
 
 /* Opcode: Column P1 P2 P3 P4 P5
@@ -2442,7 +2595,39 @@ case OP_NotNull: {            /* same as TK_NOTNULL, jump, in1 */
 ** 如果二进制位OPFLAG_LENGTHARG和OPFLAG_TYPEOFARG都设置在P5中，要保证它们只能作为函数length()
 ** 和函数typeof()的参数。函数length()可以忽略正在加载的二进制大对象以及所有正在加载的内容。
 */
-case OP_Column: {
+/* Opcode: ColumnCol P1 P2 P3 P4 P5
+**
+** This is a fused OP_Column that is always followed by another column
+** opcode (OP_Column, OP_ColumnCol, OP_ColumnCmp or OP_ColumnRange).  It
+** works exactly like OP_Column and then runs the following opcode without
+** going back through the dispatch.
+** sqlite3VdbeMakeReady() substitutes it for OP_Column; the code
+** generators never emit it.
+*/
+/* Opcode: ColumnCmp P1 P2 P3 P4 P5
+**
+** This is a fused OP_Column that is always followed by one of OP_Eq,
+** OP_Ne, OP_Lt, OP_Le, OP_Gt or OP_Ge.  It works exactly like OP_Column
+** and then runs the comparison without going back through the dispatch.
+** sqlite3VdbeMakeReady() substitutes it for OP_Column; the code
+** generators never emit it.
+*/
+/* Opcode: ColumnRange P1 P2 P3 P4 P5
+**
+** This is a fused OP_Column that starts a run of P4 OP_Column opcodes on
+** cursor P1 that extract columns P2, P2+1, ... into registers P3, P3+1,
+** and so on.  If the whole record is available in memory, all P4 columns
+** are extracted from a single decode of the record header and the rest
+** of the run is skipped.  Otherwise this works exactly like OP_Column.
+** sqlite3VdbeMakeReady() substitutes it for OP_Column; the code
+** generators never emit it.
+*/
+#ifndef SQLITE_OMIT_SUPERINSTRUCTIONS
+case OP_ColumnCol: OPCODE_LABEL(ColumnCol)
+case OP_ColumnCmp: OPCODE_LABEL(ColumnCmp)
+case OP_ColumnRange: OPCODE_LABEL(ColumnRange)
+#endif
+case OP_Column: OPCODE_LABEL(Column) {
   u32 payloadSize;   /* Number of bytes in the record */
   i64 payloadSize64; /* Number of bytes in the record */
   int p1;            /* P1 value of the opcode */
@@ -2489,7 +2674,9 @@ case OP_Column: {
   u32 t;             /* A type code from the record header */
   Mem *pReg;         /* PseudoTable input register */
 
-
+#ifndef SQLITE_OMIT_SUPERINSTRUCTIONS
+op_column:
+#endif
   p1 = pOp->p1;
   p2 = pOp->p2;
   pC = 0;
@@ -2549,6 +2736,15 @@ case OP_Column: {
       VVA_ONLY(rc =) sqlite3BtreeDataSize(pCrsr, &payloadSize);
       assert( rc==SQLITE_OK );   /* DataSize() cannot fail */
     }
+#ifndef SQLITE_OMIT_HASH_JOIN
+  }else if( pC->pHashJoin ){
+    /* The record is the current entry of a hash join table */
+    if( pC->nullRow ){
+      payloadSize = 0;
+    }else{
+      zRec = (char*)sqlite3VdbeHashJoinRecord(pC, &payloadSize);
+    }
+#endif
   }else if( ALWAYS(pC->pseudoTableReg>0) ){
     pReg = &aMem[pC->pseudoTableReg];
     assert( pReg->flags & MEM_Blob );
@@ -2698,13 +2894,17 @@ case OP_Column: {
       if( zIdx<zEndHdr ){
         aOffset[i] = offset;
         if( zIdx[0]<0x80 ){
+          /* Single-byte serial types are by far the most common, so size
+          ** them inline instead of calling sqlite3VdbeSerialTypeLen().  */
+          static const u8 aSize[] = { 0, 1, 2, 3, 4, 6, 8, 8, 0, 0, 0, 0 };
           t = zIdx[0];
           zIdx++;
+          szField = t>=12 ? (t-12)/2 : aSize[t];
         }else{
           zIdx += sqlite3GetVarint32(zIdx, &t);
+          szField = sqlite3VdbeSerialTypeLen(t);
         }
         aType[i] = t;
-        szField = sqlite3VdbeSerialTypeLen(t);
         offset += szField;
         if( offset<szField ){  /* True if offset overflows */
           zIdx = &zEndHdr[1];  /* Forces SQLITE_CORRUPT return below */
@@ -2742,6 +2942,36 @@ case OP_Column: {
     }
   }
 
+#ifndef SQLITE_OMIT_SUPERINSTRUCTIONS
+  /* For OP_ColumnRange, if the whole record is in memory, extract every
+  ** column of the run here and skip the OP_Column opcodes that follow.
+  ** Otherwise, or if VDBE_SLOW_DISPATCH requires every opcode to be
+  ** started from the top of the interpreter loop, extract column P2 only,
+  ** exactly as OP_Column would, and let the OP_Column opcodes that follow
+  ** extract the rest of the run.
+  */
+  if( pOp->opcode==OP_ColumnRange && zRec && !VDBE_SLOW_DISPATCH ){
+    int nRun = pOp->p4.i;   /* Number of columns in the run */
+    assert( pOp->p4type==P4_INT32 && nRun>1 && p2+nRun<=nField );
+    assert( pOp->p3+nRun-1<=p->nMem );
+    for(i=0; i<nRun; i++, pDest++){
+      if( i>0 ) memAboutToChange(p, pDest);
+      if( aOffset[p2+i] ){
+        VdbeMemRelease(pDest);
+        sqlite3VdbeSerialGet((u8*)&zRec[aOffset[p2+i]], aType[p2+i], pDest);
+        pDest->enc = encoding;
+        if( sqlite3VdbeMemMakeWriteable(pDest) ) goto no_mem;
+      }else{
+        MemSetTypeFlag(pDest, MEM_Null);
+      }
+      UPDATE_MAX_BLOBSIZE(pDest);
+      REGISTER_TRACE(pOp->p3+i, pDest);
+    }
+    pc += nRun-1;
+    NEXT_OPCODE;
+  }
+#endif
+
   /* Get the column information. If aOffset[p2] is non-zero, then
   ** deserialize the value from the record. If aOffset[p2] is zero,
   ** then there are not enough fields in the record to satisfy the
@@ -2820,7 +3050,14 @@ case OP_Column: {
 op_column_out:
   UPDATE_MAX_BLOBSIZE(pDest);
   REGISTER_TRACE(pOp->p3, pDest);
-  break;
+#ifndef SQLITE_OMIT_SUPERINSTRUCTIONS
+  if( pOp->opcode==OP_ColumnCol ){
+    FUSED_NEXT(op_column);
+  }else if( pOp->opcode==OP_ColumnCmp ){
+    FUSED_NEXT(op_compare);
+  }
+#endif
+  NEXT_OPCODE;
 }
 
 /* Opcode: Affinity P1 P2 * P4 *
@@ -2834,7 +3071,7 @@ op_column_out:
 ** P4是一个长度与P2中字符相等的字符串。字符串的第n个字符表示列的关联性，这个关联性
 ** 只用于第n个存储单元的范围内。
 */
-case OP_Affinity: {
+case OP_Affinity: OPCODE_LABEL(Affinity) {
   const char *zAffinity;   /* The affinity to be applied */
   char cAff;               /* A single character of affinity */
 
@@ -2849,7 +3086,7 @@ case OP_Affinity: {
     applyAffinity(pIn1, cAff, encoding);
     pIn1++;
   }
-  break;
+  NEXT_OPCODE;
 }
 
 /* Opcode: MakeRecord P1 P2 P3 P4 *
@@ -2873,7 +3110,7 @@ case OP_Affinity: {
 ** If P4 is NULL then all index fields have the affinity NONE.
 ** 如果P4是NULL，那么所有索引字段都与NONE相关联。
 */
-case OP_MakeRecord: {
+case OP_MakeRecord: OPCODE_LABEL(MakeRecord) {
   u8 *zNewRecord;        /* A buffer to hold the data for the new record
                          ** *zNewRecord作为缓冲变量，存放新纪录的数据
                          */
@@ -3007,7 +3244,7 @@ case OP_MakeRecord: {
   pOut->enc = SQLITE_UTF8;  /* In case the blob is ever converted to text */
   REGISTER_TRACE(pOp->p3, pOut);
   UPDATE_MAX_BLOBSIZE(pOut);
-  break;
+  NEXT_OPCODE;
 }
 
 /* Opcode: Count P1 P2 * * *
@@ -3017,7 +3254,7 @@ case OP_MakeRecord: {
 ** 存储表中或索引中已经被条目的数量(一个整数值)在表或索引打开游标P1在寄存器P2
 */
 #ifndef SQLITE_OMIT_BTREECOUNT
-case OP_Count: {         /* out2-prerelease */
+case OP_Count: OPCODE_LABEL(Count) { /* out2-prerelease */
   i64 nEntry;
   BtCursor *pCrsr;
 
@@ -3028,7 +3265,7 @@ case OP_Count: {         /* out2-prerelease */
     nEntry = 0;
   }
   pOut->u.i = nEntry;
-  break;
+  NEXT_OPCODE;
 }
 #endif
 
@@ -3040,7 +3277,7 @@ case OP_Count: {         /* out2-prerelease */
 ** 保存点的打开，释放或回滚由参数P4来指定，依赖于P1的值。当P1==0时，打开一个新的保存点。
 ** 当P1==1时，释放(提交)现有的保存点。当P1==2时，回滚现有保存点。
 */
-case OP_Savepoint: {
+case OP_Savepoint: OPCODE_LABEL(Savepoint) {
   int p1;                         /* Value of P1 operand */
   char *zName;                    /* Name of savepoint */
   int nName;
@@ -3217,15 +3454,18 @@ case OP_Savepoint: {
     }
   }
 
-  break;
+  NEXT_OPCODE;
 }
 
-/* Opcode: AutoCommit P1 P2 * * *
+/* Opcode: AutoCommit P1 P2 P3 * *
 **
 ** Set the database auto-commit flag to P1 (1 or 0). If P2 is true, roll
 ** back any currently active btree transactions. If there are any active
 ** VMs (apart from this one), then a ROLLBACK fails.  A COMMIT fails if
 ** there are active writing VMs or active VMs that use shared cache.
+**
+** If P1 is 0 and P3 is true, the transaction being opened is a
+** BEGIN CONCURRENT transaction.
 ** 设置数据库自动提交的标志值flag为P1(1或0)。如果P2是真，回退到任何一个当前正在活动的btree事务。
 ** 如果有任何一个正在活动的vm(除了当前这个)，那么回滚失败。如果存在一个进程正在对vm进行写操作，
 ** 或者某个虚拟机使用了共享缓存，那么提交操作就会失败。
@@ -3233,7 +3473,7 @@ case OP_Savepoint: {
 ** This instruction causes the VM to halt.
 ** 这个指令会导致虚拟机停止。
 */
-case OP_AutoCommit: {
+case OP_AutoCommit: OPCODE_LABEL(AutoCommit) {
   int desiredAutoCommit;
   int iRollback;
   int turnOnAC;
@@ -3283,6 +3523,7 @@ case OP_AutoCommit: {
         goto vdbe_return;
       }
     }
+    db->bConcurrent = desiredAutoCommit ? 0 : (u8)pOp->p3;
     assert( db->nStatement==0 );
     sqlite3CloseSavepoints(db);
     if( p->rc==SQLITE_OK ){
@@ -3299,7 +3540,7 @@ case OP_AutoCommit: {
 
     rc = SQLITE_ERROR;
   }
-  break;
+  NEXT_OPCODE;
 }
 
 /* Opcode: Transaction P1 P2 * * *
@@ -3344,7 +3585,7 @@ case OP_AutoCommit: {
 ** If P2 is zero, then a read-lock is obtained on the database file.
 ** 如果P2是0，则会给数据库文件加上只读锁。
 */
-case OP_Transaction: {
+case OP_Transaction: OPCODE_LABEL(Transaction) {
   Btree *pBt;
 
   assert( pOp->p1>=0 && pOp->p1<db->nDb );
@@ -3352,7 +3593,13 @@ case OP_Transaction: {
   pBt = db->aDb[pOp->p1].pBt;
 
   if( pBt ){
+    /* An INSERT, UPDATE or DELETE in autocommit mode may add its commit
+    ** to a pending WAL group commit (see wal.c). Tell the WAL module,
+    ** which decides when the read transaction is opened. */
+    int bIntent = pOp->p2 && db->autoCommit && p->changeCntOn;
+    if( bIntent ) sqlite3PagerWalWriteIntent(sqlite3BtreePager(pBt), 1);
     rc = sqlite3BtreeBeginTrans(pBt, pOp->p2);
+    if( bIntent ) sqlite3PagerWalWriteIntent(sqlite3BtreePager(pBt), 0);
     if( rc==SQLITE_BUSY ){
       p->pc = pc;
       p->rc = rc = SQLITE_BUSY;
@@ -3385,7 +3632,7 @@ case OP_Transaction: {
       p->nStmtDefCons = db->nDeferredCons;
     }
   }
-  break;
+  NEXT_OPCODE;
 }
 
 /* Opcode: ReadCookie P1 P2 P3 * *
@@ -3403,7 +3650,7 @@ case OP_Transaction: {
 ** executing this instruction.
 ** 执行该指令之前，必须给数据库加一个只读-锁(要么必须启动一个事务，要么必须有一个打开的游标)。
 */
-case OP_ReadCookie: {               /* out2-prerelease */
+case OP_ReadCookie: OPCODE_LABEL(ReadCookie) { /* out2-prerelease */
   int iMeta;
   int iDb;
   int iCookie;
@@ -3417,7 +3664,7 @@ case OP_ReadCookie: {               /* out2-prerelease */
 
   sqlite3BtreeGetMeta(db->aDb[iDb].pBt, iCookie, (u32 *)&iMeta);
   pOut->u.i = iMeta;
-  break;
+  NEXT_OPCODE;
 }
 
 /* Opcode: SetCookie P1 P2 P3 * *
@@ -3433,7 +3680,7 @@ case OP_ReadCookie: {               /* out2-prerelease */
 ** A transaction must be started before executing this opcode.
 ** 执行这个操作码之前必须有一个事务已经开始执行。
 */
-case OP_SetCookie: {       /* in3 */
+case OP_SetCookie: OPCODE_LABEL(SetCookie) { /* in3 */
   Db *pDb;
   assert( pOp->p2<SQLITE_N_BTREE_META );
   assert( pOp->p1>=0 && pOp->p1<db->nDb );
@@ -3461,7 +3708,7 @@ case OP_SetCookie: {       /* in3 */
     sqlite3ExpirePreparedStatements(db);
     p->expired = 0;
   }
-  break;
+  NEXT_OPCODE;
 }
 
 /* Opcode: VerifyCookie P1 P2 P3 * *
@@ -3488,7 +3735,7 @@ case OP_SetCookie: {       /* in3 */
 ** invoked.
 ** 在调用此操作码之前，要么需要启动一个事务，要么操作码Open需要被执行(这两个操作都是为了建立一个只读锁)。
 */
-case OP_VerifyCookie: {
+case OP_VerifyCookie: OPCODE_LABEL(VerifyCookie) {
   int iMeta;
   int iGen;
   Btree *pBt;
@@ -3530,7 +3777,7 @@ case OP_VerifyCookie: {
     p->expired = 1;
     rc = SQLITE_SCHEMA;
   }
-  break;
+  NEXT_OPCODE;
 }
 
 /* Opcode: OpenRead P1 P2 P3 P4 P5
@@ -3599,8 +3846,8 @@ case OP_VerifyCookie: {
 **
 ** See also OpenRead.
 */
-case OP_OpenRead:
-case OP_OpenWrite: {
+case OP_OpenRead: OPCODE_LABEL(OpenRead)
+case OP_OpenWrite: OPCODE_LABEL(OpenWrite) {
   int nField;
   KeyInfo *pKeyInfo;
   int p2;
@@ -3668,6 +3915,9 @@ case OP_OpenWrite: {
   if( pCur==0 ) goto no_mem;
   pCur->nullRow = 1;
   pCur->isOrdered = 1;
+#ifndef SQLITE_OMIT_STMT_PROFILE
+  pCur->pOpStat = aOpStat ? &aOpStat[pc] : 0;
+#endif
   rc = sqlite3BtreeCursor(pX, p2, wrFlag, pKeyInfo, pCur->pCursor);
   pCur->pKeyInfo = pKeyInfo;
   assert( OPFLAG_BULKCSR==BTREE_BULKLOAD );
@@ -3689,7 +3939,7 @@ case OP_OpenWrite: {
   */
   pCur->isTable = pOp->p4type!=P4_KEYINFO;
   pCur->isIndex = !pCur->isTable;
-  break;
+  NEXT_OPCODE;
 }
 /*翻译到这里，就ok了*/
 
@@ -3727,8 +3977,8 @@ case OP_OpenWrite: {
 ** 第一次使用github
 */
 
-case OP_OpenAutoindex:
-case OP_OpenEphemeral: {
+case OP_OpenAutoindex: OPCODE_LABEL(OpenAutoindex)
+case OP_OpenEphemeral: OPCODE_LABEL(OpenEphemeral) {
   VdbeCursor *pCx;
   static const int vfsFlags =
       SQLITE_OPEN_READWRITE |
@@ -3741,6 +3991,9 @@ case OP_OpenEphemeral: {
   pCx = allocateCursor(p, pOp->p1, pOp->p2, -1, 1);
   if( pCx==0 ) goto no_mem;
   pCx->nullRow = 1;
+#ifndef SQLITE_OMIT_STMT_PROFILE
+  pCx->pOpStat = aOpStat ? &aOpStat[pc] : 0;
+#endif
   rc = sqlite3BtreeOpen(db->pVfs, 0, db, &pCx->pBt,
                         BTREE_OMIT_JOURNAL | BTREE_SINGLE | pOp->p5, vfsFlags);
   if( rc==SQLITE_OK ){
@@ -3771,7 +4024,7 @@ case OP_OpenEphemeral: {
   }
   pCx->isOrdered = (pOp->p5!=BTREE_UNORDERED);
   pCx->isIndex = !pCx->isTable;
-  break;
+  NEXT_OPCODE;
 }
 
 /* Opcode: OpenSorter P1 P2 * P4 *
@@ -3780,7 +4033,7 @@ case OP_OpenEphemeral: {
 ** a transient index that is specifically designed to sort large
 ** tables using an external merge-sort algorithm.
 */
-case OP_SorterOpen: {
+case OP_SorterOpen: OPCODE_LABEL(SorterOpen) {
   VdbeCursor *pCx;
 #ifndef SQLITE_OMIT_MERGE_SORT
   pCx = allocateCursor(p, pOp->p1, pOp->p2, -1, 1);
@@ -3793,7 +4046,7 @@ case OP_SorterOpen: {
   pOp->opcode = OP_OpenEphemeral;
   pc--;
 #endif
-  break;
+  NEXT_OPCODE;
 }
 
 /* Opcode: OpenPseudo P1 P2 P3 * *
@@ -3811,7 +4064,7 @@ case OP_SorterOpen: {
 ** P3 is the number of fields in the records that will be stored by
 ** the pseudo-table.
 */
-case OP_OpenPseudo: {
+case OP_OpenPseudo: OPCODE_LABEL(OpenPseudo) {
   VdbeCursor *pCx;
 
   assert( pOp->p1>=0 );
@@ -3821,7 +4074,7 @@ case OP_OpenPseudo: {
   pCx->pseudoTableReg = pOp->p2;
   pCx->isTable = 1;
   pCx->isIndex = 0;
-  break;
+  NEXT_OPCODE;
 }
 
 /* Opcode: Close P1 * * * *
@@ -3829,11 +4082,11 @@ case OP_OpenPseudo: {
 ** Close a cursor previously opened as P1.  If P1 is not
 ** currently open, this instruction is a no-op.
 */
-case OP_Close: {
+case OP_Close: OPCODE_LABEL(Close) {
   assert( pOp->p1>=0 && pOp->p1<p->nCursor );
   sqlite3VdbeFreeCursor(p, p->apCsr[pOp->p1]);
   p->apCsr[pOp->p1] = 0;
-  break;
+  NEXT_OPCODE;
 }
 
 /* Opcode: SeekGe P1 P2 P3 P4 *
@@ -3888,10 +4141,10 @@ case OP_Close: {
 **
 ** See also: Found, NotFound, Distinct, SeekGt, SeekGe, SeekLt
 */
-case OP_SeekLt:         /* jump, in3 */
-case OP_SeekLe:         /* jump, in3 */
-case OP_SeekGe:         /* jump, in3 */
-case OP_SeekGt: {       /* jump, in3 */
+case OP_SeekLt: OPCODE_LABEL(SeekLt) /* jump, in3 */
+case OP_SeekLe: OPCODE_LABEL(SeekLe) /* jump, in3 */
+case OP_SeekGe: OPCODE_LABEL(SeekGe) /* jump, in3 */
+case OP_SeekGt: OPCODE_LABEL(SeekGt) { /* jump, in3 */
   int res;
   int oc;
   VdbeCursor *pC;
@@ -4037,7 +4290,7 @@ case OP_SeekGt: {       /* jump, in3 */
     */
     pc = pOp->p2 - 1;
   }
-  break;
+  NEXT_OPCODE;
 }
 
 /* Opcode: Seek P1 P2 * * *
@@ -4049,7 +4302,7 @@ case OP_SeekGt: {       /* jump, in3 */
 ** the cursor is used to read a record.  That way, if no reads
 ** occur, no unnecessary I/O happens.
 */
-case OP_Seek: {    /* in2 */
+case OP_Seek: OPCODE_LABEL(Seek) { /* in2 */
   VdbeCursor *pC;
 
   assert( pOp->p1>=0 && pOp->p1<p->nCursor );
@@ -4063,7 +4316,7 @@ case OP_Seek: {    /* in2 */
     pC->rowidIsValid = 0;
     pC->deferredMoveto = 1;
   }
-  break;
+  NEXT_OPCODE;
 }
   
 
@@ -4091,8 +4344,8 @@ case OP_Seek: {    /* in2 */
 **
 ** See also: Found, NotExists, IsUnique
 */
-case OP_NotFound:       /* jump, in3 */
-case OP_Found: {        /* jump, in3 */
+case OP_NotFound: OPCODE_LABEL(NotFound) /* jump, in3 */
+case OP_Found: OPCODE_LABEL(Found) { /* jump, in3 */
   int alreadyExists;
   VdbeCursor *pC;
   int res;
@@ -4149,7 +4402,7 @@ case OP_Found: {        /* jump, in3 */
   }else{
     if( !alreadyExists ) pc = pOp->p2 - 1;
   }
-  break;
+  NEXT_OPCODE;
 }
 
 /* Opcode: IsUnique P1 P2 P3 P4 *
@@ -4178,7 +4431,7 @@ case OP_Found: {        /* jump, in3 */
 **
 ** See also: NotFound, NotExists, Found
 */
-case OP_IsUnique: {        /* jump, in3 */
+case OP_IsUnique: OPCODE_LABEL(IsUnique) { /* jump, in3 */
   u16 ii;
   VdbeCursor *pCx;
   BtCursor *pCrsr;
@@ -4236,7 +4489,7 @@ case OP_IsUnique: {        /* jump, in3 */
       pIn3->u.i = r.rowid;
     }
   }
-  break;
+  NEXT_OPCODE;
 }
 
 /* Opcode: NotExists P1 P2 P3 * *
@@ -4253,7 +4506,7 @@ case OP_IsUnique: {        /* jump, in3 */
 **
 ** See also: Found, NotFound, IsUnique
 */
-case OP_NotExists: {        /* jump, in3 */
+case OP_NotExists: OPCODE_LABEL(NotExists) { /* jump, in3 */
   VdbeCursor *pC;
   BtCursor *pCrsr;
   int res;
@@ -4289,7 +4542,7 @@ case OP_NotExists: {        /* jump, in3 */
     assert( pC->rowidIsValid==0 );
     pC->seekResult = 0;
   }
-  break;
+  NEXT_OPCODE;
 }
 
 /* Opcode: Sequence P1 P2 * * *
@@ -4299,11 +4552,11 @@ case OP_NotExists: {        /* jump, in3 */
 ** The sequence number on the cursor is incremented after this
 ** instruction.  
 */
-case OP_Sequence: {           /* out2-prerelease */
+case OP_Sequence: OPCODE_LABEL(Sequence) { /* out2-prerelease */
   assert( pOp->p1>=0 && pOp->p1<p->nCursor );
   assert( p->apCsr[pOp->p1]!=0 );
   pOut->u.i = p->apCsr[pOp->p1]->seqCount++;
-  break;
+  NEXT_OPCODE;
 }
 
 
@@ -4321,7 +4574,7 @@ case OP_Sequence: {           /* out2-prerelease */
 ** generated record number. This P3 mechanism is used to help implement the
 ** AUTOINCREMENT feature.
 */
-case OP_NewRowid: {           /* out2-prerelease */
+case OP_NewRowid: OPCODE_LABEL(NewRowid) { /* out2-prerelease */
   i64 v;                 /* The new rowid */
   VdbeCursor *pC;        /* Cursor of table to get the new rowid */
   int res;               /* Result of an sqlite3BtreeLast() */
@@ -4453,7 +4706,7 @@ case OP_NewRowid: {           /* out2-prerelease */
     pC->cacheStatus = CACHE_STALE;
   }
   pOut->u.i = v;
-  break;
+  NEXT_OPCODE;
 }
 
 /* Opcode: Insert P1 P2 P3 P4 P5
@@ -4500,8 +4753,8 @@ case OP_NewRowid: {           /* out2-prerelease */
 ** This works exactly like OP_Insert except that the key is the
 ** integer value P3, not the value of the integer stored in register P3.
 */
-case OP_Insert: 
-case OP_InsertInt: {
+case OP_Insert: OPCODE_LABEL(Insert)
+case OP_InsertInt: OPCODE_LABEL(InsertInt) {
   Mem *pData;       /* MEM cell holding data for the record to be inserted */
   Mem *pKey;        /* MEM cell holding key  for the record */
   i64 iKey;         /* The integer ROWID or key for the record to be inserted */
@@ -4565,7 +4818,7 @@ case OP_InsertInt: {
     db->xUpdateCallback(db->pUpdateArg, op, zDb, zTbl, iKey);
     assert( pC->iDb>=0 );
   }
-  break;
+  NEXT_OPCODE;
 }
 
 /* Opcode: Delete P1 P2 * P4 *
@@ -4588,7 +4841,7 @@ case OP_InsertInt: {
 ** If P4 is not NULL then the P1 cursor must have been positioned
 ** using OP_NotFound prior to invoking this opcode.
 */
-case OP_Delete: {
+case OP_Delete: OPCODE_LABEL(Delete) {
   i64 iKey;
   VdbeCursor *pC;
 
@@ -4630,7 +4883,7 @@ case OP_Delete: {
     assert( pC->iDb>=0 );
   }
   if( pOp->p2 & OPFLAG_NCHANGE ) p->nChange++;
-  break;
+  NEXT_OPCODE;
 }
 /* Opcode: ResetCount * * * * *
 **
@@ -4639,10 +4892,10 @@ case OP_Delete: {
 ** Then the VMs internal change counter resets to 0.
 ** This is used by trigger programs.
 */
-case OP_ResetCount: {
+case OP_ResetCount: OPCODE_LABEL(ResetCount) {
   sqlite3VdbeSetChanges(db, p->nChange);
   p->nChange = 0;
-  break;
+  NEXT_OPCODE;
 }
 
 /* Opcode: SorterCompare P1 P2 P3
@@ -4652,7 +4905,7 @@ case OP_ResetCount: {
 ** If, excluding the rowid fields at the end, the two records are a match,
 ** fall through to the next instruction. Otherwise, jump to instruction P2.
 */
-case OP_SorterCompare: {
+case OP_SorterCompare: OPCODE_LABEL(SorterCompare) {
   VdbeCursor *pC;
   int res;
 
@@ -4663,14 +4916,14 @@ case OP_SorterCompare: {
   if( res ){
     pc = pOp->p2-1;
   }
-  break;
+  NEXT_OPCODE;
 };
 
 /* Opcode: SorterData P1 P2 * * *
 **
 ** Write into register P2 the current sorter data for sorter cursor P1.
 */
-case OP_SorterData: {
+case OP_SorterData: OPCODE_LABEL(SorterData) {
   VdbeCursor *pC;
 #ifndef SQLITE_OMIT_MERGE_SORT
   pOut = &aMem[pOp->p2];
@@ -4681,7 +4934,7 @@ case OP_SorterData: {
   pOp->opcode = OP_RowKey;
   pc--;
 #endif
-  break;
+  NEXT_OPCODE;
 }
 
 /* Opcode: RowData P1 P2 * * *
@@ -4704,8 +4957,8 @@ case OP_SorterData: {
 ** If the P1 cursor must be pointing to a valid row (not a NULL row)
 ** of a real table, not a pseudo-table.
 */
-case OP_RowKey:
-case OP_RowData: {
+case OP_RowKey: OPCODE_LABEL(RowKey)
+case OP_RowData: OPCODE_LABEL(RowData) {
   VdbeCursor *pC;
   BtCursor *pCrsr;
   u32 n;
@@ -4763,7 +5016,7 @@ case OP_RowData: {
   }
   pOut->enc = SQLITE_UTF8;  /* In case the blob is ever cast to text */
   UPDATE_MAX_BLOBSIZE(pOut);
-  break;
+  NEXT_OPCODE;
 }
 
 /* Opcode: Rowid P1 P2 * * *
@@ -4775,7 +5028,7 @@ case OP_RowData: {
 ** be a separate OP_VRowid opcode for use with virtual tables, but this
 ** one opcode now works for both table types.
 */
-case OP_Rowid: {                 /* out2-prerelease */
+case OP_Rowid: OPCODE_LABEL(Rowid) { /* out2-prerelease */
   VdbeCursor *pC;
   i64 v;
   sqlite3_vtab *pVtab;
@@ -4810,7 +5063,7 @@ case OP_Rowid: {                 /* out2-prerelease */
     }
   }
   pOut->u.i = v;
-  break;
+  NEXT_OPCODE;
 }
 
 /* Opcode: NullRow P1 * * * *
@@ -4819,7 +5072,7 @@ case OP_Rowid: {                 /* out2-prerelease */
 ** that occur while the cursor is on the null row will always
 ** write a NULL.
 */
-case OP_NullRow: {
+case OP_NullRow: OPCODE_LABEL(NullRow) {
   VdbeCursor *pC;
 
   assert( pOp->p1>=0 && pOp->p1<p->nCursor );
@@ -4831,7 +5084,7 @@ case OP_NullRow: {
   if( pC->pCursor ){
     sqlite3BtreeClearCursor(pC->pCursor);
   }
-  break;
+  NEXT_OPCODE;
 }
 
 /* Opcode: Last P1 P2 * * *
@@ -4841,8 +5094,11 @@ case OP_NullRow: {
 ** If the table or index is empty and P2>0, then jump immediately to P2.
 ** If P2 is 0 or if the table or index is not empty, fall through
 ** to the following instruction.
+**
+** As for OP_Rewind, the b-tree cursor is given the BTREE_SEQUENTIAL hint.
+** Read-ahead hints are only issued if a backward scan using Prev follows.
 */
-case OP_Last: {        /* jump */
+case OP_Last: OPCODE_LABEL(Last) { /* jump */
   VdbeCursor *pC;
   BtCursor *pCrsr;
   int res;
@@ -4853,6 +5109,7 @@ case OP_Last: {        /* jump */
   pCrsr = pC->pCursor;
   res = 0;
   if( ALWAYS(pCrsr!=0) ){
+    sqlite3BtreeCursorAddHints(pCrsr, BTREE_SEQUENTIAL);
     rc = sqlite3BtreeLast(pCrsr, &res);
   }
   pC->nullRow = (u8)res;
@@ -4862,7 +5119,7 @@ case OP_Last: {        /* jump */
   if( pOp->p2>0 && res ){
     pc = pOp->p2 - 1;
   }
-  break;
+  NEXT_OPCODE;
 }
 
 
@@ -4878,11 +5135,11 @@ case OP_Last: {        /* jump */
 ** regression tests can determine whether or not the optimizer is
 ** correctly optimizing out sorts.
 */
-case OP_SorterSort:    /* jump */
+case OP_SorterSort: OPCODE_LABEL(SorterSort) /* jump */
 #ifdef SQLITE_OMIT_MERGE_SORT
   pOp->opcode = OP_Sort;
 #endif
-case OP_Sort: {        /* jump */
+case OP_Sort: OPCODE_LABEL(Sort) { /* jump */
 #ifdef SQLITE_TEST
   sqlite3_sort_count++;
   sqlite3_search_count--;
@@ -4897,8 +5154,12 @@ case OP_Sort: {        /* jump */
 ** If the table or index is empty and P2>0, then jump immediately to P2.
 ** If P2 is 0 or if the table or index is not empty, fall through
 ** to the following instruction.
+**
+** A Rewind is normally followed by a forward scan using Next, so the
+** b-tree cursor is given the BTREE_SEQUENTIAL hint, which lets Next
+** issue read-ahead hints for upcoming leaf pages.
 */
-case OP_Rewind: {        /* jump */
+case OP_Rewind: OPCODE_LABEL(Rewind) { /* jump */
   VdbeCursor *pC;
   BtCursor *pCrsr;
   int res;
@@ -4913,6 +5174,7 @@ case OP_Rewind: {        /* jump */
   }else{
     pCrsr = pC->pCursor;
     assert( pCrsr );
+    sqlite3BtreeCursorAddHints(pCrsr, BTREE_SEQUENTIAL);
     rc = sqlite3BtreeFirst(pCrsr, &res);
     pC->atFirst = res==0 ?1:0;
     pC->deferredMoveto = 0;
@@ -4924,7 +5186,7 @@ case OP_Rewind: {        /* jump */
   if( res ){
     pc = pOp->p2 - 1;
   }
-  break;
+  NEXT_OPCODE;
 }
 
 /* Opcode: Next P1 P2 * P4 P5
@@ -4959,12 +5221,24 @@ case OP_Rewind: {        /* jump */
 ** If P5 is positive and the jump is taken, then event counter
 ** number P5-1 in the prepared statement is incremented.
 */
-case OP_SorterNext:    /* jump */
+/* Opcode: NextCol P1 P2 * P4 P5
+**
+** This is a fused OP_Next whose jump target P2 is a column opcode
+** (OP_Column, OP_ColumnCol, OP_ColumnCmp or OP_ColumnRange).  It works
+** exactly like OP_Next, and when the jump is taken it runs the column
+** opcode at P2 without going back through the dispatch.
+** sqlite3VdbeMakeReady() substitutes it for OP_Next; the code generators
+** never emit it.
+*/
+case OP_SorterNext: OPCODE_LABEL(SorterNext) /* jump */
 #ifdef SQLITE_OMIT_MERGE_SORT
   pOp->opcode = OP_Next;
 #endif
-case OP_Prev:          /* jump */
-case OP_Next: {        /* jump */
+#ifndef SQLITE_OMIT_SUPERINSTRUCTIONS
+case OP_NextCol: OPCODE_LABEL(NextCol) /* jump */
+#endif
+case OP_Prev: OPCODE_LABEL(Prev) /* jump */
+case OP_Next: OPCODE_LABEL(Next) { /* jump */
   VdbeCursor *pC;
   int res;
 
@@ -4997,7 +5271,12 @@ case OP_Next: {        /* jump */
 #endif
   }
   pC->rowidIsValid = 0;
-  break;
+#ifndef SQLITE_OMIT_SUPERINSTRUCTIONS
+  if( pOp->opcode==OP_NextCol && res==0 ){
+    FUSED_NEXT(op_column);
+  }
+#endif
+  NEXT_OPCODE;
 }
 
 /* Opcode: IdxInsert P1 P2 P3 * P5
@@ -5012,11 +5291,22 @@ case OP_Next: {        /* jump */
 ** This instruction only works for indices.  The equivalent instruction
 ** for tables is OP_Insert.
 */
-case OP_SorterInsert:       /* in2 */
+/* Opcode: SorterInsert P1 P2 P3 * *
+**
+** Register P2 holds an SQL index key made using the
+** MakeRecord instructions.  This opcode writes that key
+** into the sorter P1.  Data for the entry is nil.
+**
+** If P3 is non-zero, it is a register holding the number of
+** records that will be read back from the sorter (LIMIT plus OFFSET).
+** If that value is positive, the sorter need only retain that many
+** of the smallest keys.
+*/
+case OP_SorterInsert: OPCODE_LABEL(SorterInsert) /* in2 */
 #ifdef SQLITE_OMIT_MERGE_SORT
   pOp->opcode = OP_IdxInsert;
 #endif
-case OP_IdxInsert: {        /* in2 */
+case OP_IdxInsert: OPCODE_LABEL(IdxInsert) { /* in2 */
   VdbeCursor *pC;
   BtCursor *pCrsr;
   int nKey;
@@ -5034,6 +5324,11 @@ case OP_IdxInsert: {        /* in2 */
     rc = ExpandBlob(pIn2);
     if( rc==SQLITE_OK ){
       if( isSorter(pC) ){
+        if( pOp->p3 ){
+          assert( pOp->p3>0 && pOp->p3<=p->nMem );
+          assert( aMem[pOp->p3].flags & MEM_Int );
+          sqlite3VdbeSorterLimit(pC, aMem[pOp->p3].u.i);
+        }
         rc = sqlite3VdbeSorterWrite(db, pC, pIn2);
       }else{
         nKey = pIn2->n;
@@ -5046,7 +5341,7 @@ case OP_IdxInsert: {        /* in2 */
       }
     }
   }
-  break;
+  NEXT_OPCODE;
 }
 
 /* Opcode: Destroy P1 P2 P3 * *
@@ -5081,7 +5376,7 @@ case OP_IdxInsert: {        /* in2 */
 如果禁用AUTOVACUUM那么零存储在寄3存器P2。
 ** See also: Clear
 */
-case OP_Destroy: {     /* out2-prerelease */
+case OP_Destroy: OPCODE_LABEL(Destroy) { /* out2-prerelease */
   int iMoved;
   int iCnt;
   Vdbe *pVdbe;
@@ -5116,7 +5411,7 @@ case OP_Destroy: {     /* out2-prerelease */
     }
 #endif
   }
-  break;
+  NEXT_OPCODE;
 }
 
 /* Opcode: Clear P1 P2 P3
@@ -5142,7 +5437,7 @@ case OP_Destroy: {     /* out2-prerelease */
 
 ** See also: Destroy
 */
-case OP_Clear: {
+case OP_Clear: OPCODE_LABEL(Clear) {
   int nChange;
  
   nChange = 0;
@@ -5158,7 +5453,7 @@ case OP_Clear: {
       aMem[pOp->p3].u.i += nChange;
     }
   }
-  break;
+  NEXT_OPCODE;
 }
 
 /* Opcode: CreateTable P1 P2 * * *
@@ -5188,8 +5483,8 @@ P1 > 1。把新表的根页号写入寄存器P2。
 **
 ** See documentation on OP_CreateTable for additional information.
 */
-case OP_CreateIndex:            /* out2-prerelease */
-case OP_CreateTable: {          /* out2-prerelease */
+case OP_CreateIndex: OPCODE_LABEL(CreateIndex) /* out2-prerelease */
+case OP_CreateTable: OPCODE_LABEL(CreateTable) { /* out2-prerelease */
   int pgno;
   int flags;
   Db *pDb;
@@ -5207,7 +5502,7 @@ case OP_CreateTable: {          /* out2-prerelease */
   }
   rc = sqlite3BtreeCreateTable(pDb->pBt, &pgno, flags);
   pOut->u.i = pgno;
-  break;
+  NEXT_OPCODE;
 }
 
 /* Opcode: ParseSchema P1 * * P4 *
@@ -5222,7 +5517,7 @@ case OP_CreateTable: {          /* out2-prerelease */
 
 
 */
-case OP_ParseSchema: {
+case OP_ParseSchema: OPCODE_LABEL(ParseSchema) {
   int iDb;
   const char *zMaster;
   char *zSql;
@@ -5279,7 +5574,7 @@ case OP_ParseSchema: {
 读数据库P1的表sqlite_stat1和把那张表的内容加载到内部索引hash表。这将导致分析准备所有后续查询时使用。
 
 */
-case OP_LoadAnalysis: {
+case OP_LoadAnalysis: OPCODE_LABEL(LoadAnalysis) {
   assert( pOp->p1>=0 && pOp->p1<db->nDb );
   rc = sqlite3AnalysisLoad(db, pOp->p1);
   break;  
@@ -5294,9 +5589,9 @@ case OP_LoadAnalysis: {
 ** schema consistent with what is on disk.
 拆卸内部的描述数据库P1的P4表的数据结构(内存)。这就是以降序的索引命名，是为了保持内部表示的模式与什么是磁盘上的一致。
 */
-case OP_DropTable: {
+case OP_DropTable: OPCODE_LABEL(DropTable) {
   sqlite3UnlinkAndDeleteTable(db, pOp->p1, pOp->p4.z);
-  break;
+  NEXT_OPCODE;
 }
 
 /* Opcode: DropIndex P1 * * P4 *
@@ -5307,9 +5602,9 @@ case OP_DropTable: {
 ** schema consistent with what is on disk.
 拆卸内部的描述数据库P1的指数P4的数据结构(内存)。这就是以降序的索引命名，是为了保持内部表示的模式与什么是磁盘上的一致。
 */
-case OP_DropIndex: {
+case OP_DropIndex: OPCODE_LABEL(DropIndex) {
   sqlite3UnlinkAndDeleteIndex(db, pOp->p1, pOp->p4.z);
-  break;
+  NEXT_OPCODE;
 }
 
 /* Opcode: DropTrigger P1 * * P4 *
@@ -5321,9 +5616,9 @@ case OP_DropIndex: {
 拆卸内部的描述数据库P1的P4触发器的数据结构(内存)。这就是以降序的索引命名，是为了保持内部表示的模式与什么是磁盘上的一致。
 
 */
-case OP_DropTrigger: {
+case OP_DropTrigger: OPCODE_LABEL(DropTrigger) {
   sqlite3UnlinkAndDeleteTrigger(db, pOp->p1, pOp->p4.z);
-  break;
+  NEXT_OPCODE;
 }
 
 
@@ -5357,7 +5652,7 @@ case OP_DropTrigger: {
 ** This opcode is used to implement the integrity_check pragma.
 这个操作码是用来实现integrity_check程序的编译指示。
 */
-case OP_IntegrityCk: {
+case OP_IntegrityCk: OPCODE_LABEL(IntegrityCk) {
   int nRoot;      /* Number of tables to check.  (Number of root pages.) */
   int *aRoot;     /* Array of rootpage numbers for tables to be checked */
   int j;          /* Loop counter */
@@ -5394,7 +5689,7 @@ case OP_IntegrityCk: {
   }
   UPDATE_MAX_BLOBSIZE(pIn1);
   sqlite3VdbeChangeEncoding(pIn1, encoding);
-  break;
+  NEXT_OPCODE;
 }
 #endif /* SQLITE_OMIT_INTEGRITY_CHECK */
 
@@ -5406,7 +5701,7 @@ case OP_IntegrityCk: {
 ** An assertion fails if P2 is not an integer.
  如果P2不是整数这个断言将会失败。
 */
-case OP_RowSetAdd: {       /* in1, in2 */
+case OP_RowSetAdd: OPCODE_LABEL(RowSetAdd) { /* in1, in2 */
   pIn1 = &aMem[pOp->p1];
   pIn2 = &aMem[pOp->p2];
   assert( (pIn2->flags & MEM_Int)!=0 );
@@ -5415,7 +5710,7 @@ case OP_RowSetAdd: {       /* in1, in2 */
     if( (pIn1->flags & MEM_RowSet)==0 ) goto no_mem;
   }
   sqlite3RowSetInsert(pIn1->u.pRowSet, pIn2->u.i);
-  break;
+  NEXT_OPCODE;
 }
 
 /* Opcode: RowSetRead P1 P2 P3 * *
@@ -5425,7 +5720,7 @@ case OP_RowSetAdd: {       /* in1, in2 */
 ** unchanged and jump to instruction P2.
 从布尔指数P1里提取出最小值,把该值放进寄存器P3。或者,如果布尔指数P1最初是空的,离开P3不变然后跳转到指令P2。
 */
-case OP_RowSetRead: {       /* jump, in1, out3 */
+case OP_RowSetRead: OPCODE_LABEL(RowSetRead) { /* jump, in1, out3 */
   i64 val;
   CHECK_FOR_INTERRUPT;
   pIn1 = &aMem[pOp->p1];
@@ -5439,7 +5734,7 @@ case OP_RowSetRead: {       /* jump, in1, out3 */
     /* A value was pulled from the index */
     sqlite3VdbeMemSetInt64(&aMem[pOp->p3], val);
   }
-  break;
+  NEXT_OPCODE;
 }
 
 /* Opcode: RowSetTest P1 P2 P3 P4
@@ -5477,7 +5772,7 @@ case OP_RowSetRead: {       /* jump, in1, out3 */
 * *之前插入的一部分设置X(只有在它之前
 * *插入其他组)的一部分。
 */
-case OP_RowSetTest: {                     /* jump, in1, in3 */
+case OP_RowSetTest: OPCODE_LABEL(RowSetTest) { /* jump, in1, in3 */
   int iSet;
   int exists;
 
@@ -5510,7 +5805,7 @@ case OP_RowSetTest: {                     /* jump, in1, in3 */
   if( iSet>=0 ){
     sqlite3RowSetInsert(pIn1->u.pRowSet, pIn3->u.i);
   }
-  break;
+  NEXT_OPCODE;
 }
 
 
@@ -5539,7 +5834,7 @@ case OP_RowSetTest: {                     /* jump, in1, in3 */
 * *
 * * P4是一个指向包含触发程序的虚拟机。
 */
-case OP_Program: {        /* jump */
+case OP_Program: OPCODE_LABEL(Program) { /* jump */
   int nMem;               /* Number of memory registers for sub-program */
   int nByte;              /* Bytes of runtime space required for sub-program */
   Mem *pRt;               /* Register to allocate runtime space */
@@ -5657,12 +5952,15 @@ case OP_Program: {        /* jump */
   p->apCsr = (VdbeCursor **)&aMem[p->nMem+1];
   p->aOp = aOp = pProgram->aOp;
   p->nOp = pProgram->nOp;
+#ifndef SQLITE_OMIT_STMT_PROFILE
+  aOpStat = 0;              /* Trigger programs are not profiled */
+#endif
   p->aOnceFlag = (u8 *)&p->apCsr[p->nCursor];
   p->nOnceFlag = pProgram->nOnce;
   pc = -1;
   memset(p->aOnceFlag, 0, p->nOnceFlag);
 
-  break;
+  NEXT_OPCODE;
 }
 
 /* Opcode: Param P1 P2 * * *
@@ -5685,13 +5983,13 @@ case OP_Program: {        /* jump */
 * *的值P1参数P1参数的值
 * *叫OP_Program指令。
 */
-case OP_Param: {           /* out2-prerelease */
+case OP_Param: OPCODE_LABEL(Param) { /* out2-prerelease */
   VdbeFrame *pFrame;
   Mem *pIn;
   pFrame = p->pFrame;
   pIn = &pFrame->aMem[pOp->p1 + pFrame->aOp[pFrame->pc].p1];   
   sqlite3VdbeMemShallowCopy(pOut, pIn, MEM_Ephem);
-  break;
+  NEXT_OPCODE;
 }
 
 #endif /* #ifndef SQLITE_OMIT_TRIGGER */
@@ -5708,13 +6006,13 @@ case OP_Param: {           /* out2-prerelease */
 * *(递延外键约束)。否则,如果P1为零,
 * *声明计数器递增(直接的外键约束)。
 */
-case OP_FkCounter: {
+case OP_FkCounter: OPCODE_LABEL(FkCounter) {
   if( pOp->p1 ){
     db->nDeferredCons += pOp->p2;
   }else{
     p->nFkConstraint += pOp->p2;
   }
-  break;
+  NEXT_OPCODE;
 }
 
 /* Opcode: FkIfZero P1 P2 * * *
@@ -5735,13 +6033,13 @@ case OP_FkCounter: {
 * *零,采取跳如果声明constraint-counter是零
 * *(直接侵犯外键约束)。
 */
-case OP_FkIfZero: {         /* jump */
+case OP_FkIfZero: OPCODE_LABEL(FkIfZero) { /* jump */
   if( pOp->p1 ){
     if( db->nDeferredCons==0 ) pc = pOp->p2-1;
   }else{
     if( p->nFkConstraint==0 ) pc = pOp->p2-1;
   }
-  break;
+  NEXT_OPCODE;
 }
 #endif /* #ifndef SQLITE_OMIT_FOREIGN_KEY */
 
@@ -5763,7 +6061,7 @@ case OP_FkIfZero: {         /* jump */
 * *该指令将抛出一个错误如果没有最初记忆细胞
 * *一个整数。
 */
-case OP_MemMax: {        /* in2 */
+case OP_MemMax: OPCODE_LABEL(MemMax) { /* in2 */
   Mem *pIn1;
   VdbeFrame *pFrame;
   if( p->pFrame ){
@@ -5779,7 +6077,7 @@ case OP_MemMax: {        /* in2 */
   if( pIn1->u.i<pIn2->u.i){
     pIn1->u.i = pIn2->u.i;
   }
-  break;
+  NEXT_OPCODE;
 }
 #endif /* SQLITE_OMIT_AUTOINCREMENT */
 
@@ -5794,13 +6092,13 @@ case OP_MemMax: {        /* in2 */
 * *是违法使用这个指令寄存器,它
 * *不包含一个整数。断言故障会如果你试一试。
 */
-case OP_IfPos: {        /* jump, in1 */
+case OP_IfPos: OPCODE_LABEL(IfPos) { /* jump, in1 */
   pIn1 = &aMem[pOp->p1];
   assert( pIn1->flags&MEM_Int );
   if( pIn1->u.i>0 ){
      pc = pOp->p2 - 1;
   }
-  break;
+  NEXT_OPCODE;
 }
 
 /* Opcode: IfNeg P1 P2 * * *
@@ -5814,13 +6112,13 @@ case OP_IfPos: {        /* jump, in1 */
 * *是违法使用这个指令寄存器,它
 * *不包含一个整数。断言故障会如果你试一试。
 */
-case OP_IfNeg: {        /* jump, in1 */
+case OP_IfNeg: OPCODE_LABEL(IfNeg) { /* jump, in1 */
   pIn1 = &aMem[pOp->p1];
   assert( pIn1->flags&MEM_Int );
   if( pIn1->u.i<0 ){
      pc = pOp->p2 - 1;
   }
-  break;
+  NEXT_OPCODE;
 }
 
 /* Opcode: IfZero P1 P2 P3 * *
@@ -5836,14 +6134,14 @@ case OP_IfNeg: {        /* jump, in1 */
 * *是违法使用这个指令寄存器,它
 * *不包含一个整数。断言故障会如果你试一试。
 */
-case OP_IfZero: {        /* jump, in1 */
+case OP_IfZero: OPCODE_LABEL(IfZero) { /* jump, in1 */
   pIn1 = &aMem[pOp->p1];
   assert( pIn1->flags&MEM_Int );
   pIn1->u.i += pOp->p3;
   if( pIn1->u.i==0 ){
      pc = pOp->p2 - 1;
   }
-  break;
+  NEXT_OPCODE;
 }
 
 /* Opcode: AggStep * P2 P3 P4 P5
@@ -5863,7 +6161,7 @@ case OP_IfZero: {        /* jump, in1 */
 * * P5参数从P2和登记
 * *的继任者。
 */
-case OP_AggStep: {
+case OP_AggStep: OPCODE_LABEL(AggStep) {
   int n;
   int i;
   Mem *pMem;
@@ -5913,7 +6211,7 @@ case OP_AggStep: {
 
   sqlite3VdbeMemRelease(&ctx.s);
 
-  break;
+  NEXT_OPCODE;
 }
 
 /* Opcode: AggFinal P1 P2 * P4 *
@@ -5937,7 +6235,7 @@ case OP_AggStep: {
 * * P4的论点只是所需的退化情况
 * *阶梯函数不是之前调用。
 */
-case OP_AggFinal: {
+case OP_AggFinal: OPCODE_LABEL(AggFinal) {
   Mem *pMem;
   assert( pOp->p1>0 && pOp->p1<=p->nMem );
   pMem = &aMem[pOp->p1];
@@ -5951,8 +6249,242 @@ case OP_AggFinal: {
   if( sqlite3VdbeMemTooBig(pMem) ){
     goto too_big;
   }
-  break;
+  NEXT_OPCODE;
+}
+
+#ifndef SQLITE_OMIT_HASH_AGGREGATE
+/* Opcode: HashAggOpen P1 P2 P3 P4 *
+**
+** Open cursor P1 as an in-memory hash table used to compute a GROUP BY
+** aggregate. Each group has a key of P4 values and an accumulator state
+** of P3 registers. The state of one group at a time is kept in registers
+** P2 through P2+P3-1, where it can be used by OP_AggStep and OP_AggFinal.
+*/
+case OP_HashAggOpen: OPCODE_LABEL(HashAggOpen) {
+  VdbeCursor *pCx;
+  assert( pOp->p2>0 && pOp->p2+pOp->p3<=p->nMem+1 );
+  assert( pOp->p4type==P4_INT32 );
+  pCx = allocateCursor(p, pOp->p1, 0, -1, 0);
+  if( pCx==0 ) goto no_mem;
+  pCx->nullRow = 1;
+  rc = sqlite3VdbeHashAggInit(db, pCx, &aMem[pOp->p2], pOp->p3, pOp->p4.i);
+  NEXT_OPCODE;
+}
+
+/* Opcode: HashAggFind P1 P2 P3 * *
+**
+** Find the group of hash table P1 whose key is held in the registers
+** starting at P3, creating it if it does not already exist, and load its
+** accumulator state into the registers specified by OP_HashAggOpen.
+** The state of a newly created group is all NULL.
+**
+** If the group does not exist and the hash table has used up its memory
+** budget, no group is created and the state registers are unchanged.
+** Jump to P2 in this case so that the row may be processed some other way.
+*/
+case OP_HashAggFind: OPCODE_LABEL(HashAggFind) { /* jump */
+  VdbeCursor *pC;
+  int bFull;
+
+  pC = p->apCsr[pOp->p1];
+  assert( pC && pC->pHashAgg );
+  assert( pOp->p3>0 && pOp->p3<=p->nMem );
+  bFull = 0;
+  rc = sqlite3VdbeHashAggFind(db, pC, &aMem[pOp->p3], &bFull);
+  if( bFull ){
+#ifdef SQLITE_TEST
+    sqlite3_hashagg_spill_count++;
+#endif
+    pc = pOp->p2 - 1;
+  }
+  NEXT_OPCODE;
+}
+
+/* Opcode: HashAggSave P1 * * * *
+**
+** Move the accumulator state registers of hash table P1 back into the
+** group most recently loaded by OP_HashAggFind.
+*/
+case OP_HashAggSave: OPCODE_LABEL(HashAggSave) {
+  VdbeCursor *pC;
+
+  pC = p->apCsr[pOp->p1];
+  assert( pC && pC->pHashAgg );
+  sqlite3VdbeHashAggSave(pC);
+  NEXT_OPCODE;
+}
+
+/* Opcode: HashAggRewind P1 P2 * * *
+**
+** Load the accumulator state of the first group in hash table P1 into
+** the state registers. If the table is empty, jump to P2.
+*/
+case OP_HashAggRewind: OPCODE_LABEL(HashAggRewind) { /* jump */
+  VdbeCursor *pC;
+  int res;
+
+  pC = p->apCsr[pOp->p1];
+  assert( pC && pC->pHashAgg );
+  res = 1;
+  rc = sqlite3VdbeHashAggRewind(pC, &res);
+  if( res ){
+    pc = pOp->p2 - 1;
+  }
+  NEXT_OPCODE;
+}
+
+/* Opcode: HashAggNext P1 P2 * * *
+**
+** Load the accumulator state of the next group in hash table P1 into the
+** state registers and jump to P2. If there are no more groups, fall
+** through to the next instruction.
+*/
+case OP_HashAggNext: OPCODE_LABEL(HashAggNext) { /* jump */
+  VdbeCursor *pC;
+  int res;
+
+  pC = p->apCsr[pOp->p1];
+  assert( pC && pC->pHashAgg );
+  res = 1;
+  rc = sqlite3VdbeHashAggNext(pC, &res);
+  if( res==0 ){
+    CHECK_FOR_INTERRUPT;
+    pc = pOp->p2 - 1;
+  }
+  NEXT_OPCODE;
+}
+#endif /* SQLITE_OMIT_HASH_AGGREGATE */
+
+#ifndef SQLITE_OMIT_HASH_JOIN
+/* Opcode: HashJoinOpen P1 P2 P3 P4 *
+**
+** Open cursor P1 as an in-memory hash table used to implement an equi-join.
+** Each record inserted into the table has P2 fields, of which the left-most
+** P3 form the join key. P4 is a KeyInfo structure used to compare keys.
+**
+** The cursor may be read using OP_Column once it has been positioned by
+** OP_HashJoinSeek. If the table grows larger than the memory budget, it is
+** moved to a temporary B-tree index.
+*/
+case OP_HashJoinOpen: OPCODE_LABEL(HashJoinOpen) {
+  VdbeCursor *pCx;
+  assert( pOp->p2>pOp->p3 && pOp->p3>0 );
+  pCx = allocateCursor(p, pOp->p1, pOp->p2, -1, 0);
+  if( pCx==0 ) goto no_mem;
+  pCx->pKeyInfo = pOp->p4.pKeyInfo;
+  pCx->pKeyInfo->enc = ENC(p->db);
+  pCx->nullRow = 1;
+  rc = sqlite3VdbeHashJoinInit(db, pCx, pOp->p3);
+  NEXT_OPCODE;
+}
+
+/* Opcode: HashJoinInsert P1 P2 P3 * *
+**
+** Register P2 holds a record whose join key fields are also held in the
+** registers starting at P3. Insert the record into hash join table P1.
+*/
+case OP_HashJoinInsert: OPCODE_LABEL(HashJoinInsert) { /* in2 */
+  VdbeCursor *pC;
+
+  pC = p->apCsr[pOp->p1];
+  assert( pC && pC->pHashJoin );
+  pIn2 = &aMem[pOp->p2];
+  assert( pIn2->flags & MEM_Blob );
+  rc = ExpandBlob(pIn2);
+  if( rc==SQLITE_OK ){
+    rc = sqlite3VdbeHashJoinInsert(db, pC, pIn2, &aMem[pOp->p3]);
+  }
+  NEXT_OPCODE;
+}
+
+/* Opcode: HashJoinSeek P1 P2 P3 P4 *
+**
+** Position hash join cursor P1 on the first record whose join key matches
+** the P4 registers starting at P3. If there is no such record, set the
+** cursor to a NULL row and jump to P2.
+*/
+case OP_HashJoinSeek: OPCODE_LABEL(HashJoinSeek) { /* jump */
+  VdbeCursor *pC;
+  int res;
+
+  pC = p->apCsr[pOp->p1];
+  assert( pC && pC->pHashJoin );
+  assert( pOp->p4type==P4_INT32 );
+  res = 1;
+  rc = sqlite3VdbeHashJoinSeek(db, pC, &aMem[pOp->p3], &res);
+  pC->nullRow = (u8)res;
+  pC->cacheStatus = CACHE_STALE;
+  if( res ){
+    pc = pOp->p2 - 1;
+  }
+  NEXT_OPCODE;
+}
+
+/* Opcode: HashJoinNext P1 P2 * * *
+**
+** Advance hash join cursor P1 to the next record whose join key matches
+** the key of the most recent OP_HashJoinSeek and jump to P2. If there
+** are no more such records, fall through to the next instruction.
+*/
+case OP_HashJoinNext: OPCODE_LABEL(HashJoinNext) { /* jump */
+  VdbeCursor *pC;
+  int res;
+
+  pC = p->apCsr[pOp->p1];
+  assert( pC && pC->pHashJoin );
+  res = 1;
+  rc = sqlite3VdbeHashJoinNext(pC, &res);
+  pC->nullRow = (u8)res;
+  pC->cacheStatus = CACHE_STALE;
+  if( res==0 ){
+    CHECK_FOR_INTERRUPT;
+    pc = pOp->p2 - 1;
+  }
+  NEXT_OPCODE;
 }
+#endif /* SQLITE_OMIT_HASH_JOIN */
+
+#ifndef SQLITE_OMIT_BATCH_AGGREGATE
+/* Opcode: BatchAgg P1 P2 * P4 *
+**
+** P1 is a cursor opened on a table b-tree.  P4 is an integer array that
+** describes a set of filters of the form "column op value" and a set of
+** count(), sum(), total(), avg(), min() and max() aggregates over the rows
+** of the table that pass all of the filters.  See vdbebatch.c for details.
+**
+** Scan the whole table, decoding the columns of a leaf page worth of rows
+** at a time into arrays and applying each filter and aggregate to those
+** arrays, instead of interpreting a loop of opcodes once for each row.
+** Then store the final value of each aggregate in its register and fall
+** through to the next instruction.
+**
+** If the scan meets a row that cannot be handled this way, for example
+** one with a text value in a column that the query uses, jump to P2
+** without changing any aggregate register.  The code at P2 computes the
+** same result a row at a time.  Also jump to P2 if a progress handler is
+** registered, as the handler is only invoked from the row at a time loop.
+*/
+case OP_BatchAgg: OPCODE_LABEL(BatchAgg) { /* jump */
+  VdbeCursor *pC;
+  int bFallback;
+
+  pC = p->apCsr[pOp->p1];
+  assert( pC!=0 && pC->pCursor!=0 );
+  assert( pOp->p4type==P4_INTARRAY );
+  bFallback = 0;
+#ifndef SQLITE_OMIT_PROGRESS_CALLBACK
+  if( db->xProgress ){
+    pc = pOp->p2 - 1;
+    break;
+  }
+#endif
+  rc = sqlite3VdbeBatchAgg(p, pC, pOp->p4.ai, &bFallback);
+  if( bFallback ){
+    pc = pOp->p2 - 1;
+  }
+  NEXT_OPCODE;
+}
+#endif /* SQLITE_OMIT_BATCH_AGGREGATE */
 
 #ifndef SQLITE_OMIT_WAL
 /* Opcode: Checkpoint P1 P2 P3 * *
@@ -5974,7 +6506,7 @@ case OP_AggFinal: {
 * *完成mem(P3 + 2)。然而在一个错误,mem(P3 + 1)
 * * mem(P3 + 2)初始化为1。
 */
-case OP_Checkpoint: {
+case OP_Checkpoint: OPCODE_LABEL(Checkpoint) {
   int i;                          /* Loop counter */
   int aRes[3];                    /* Results */
   Mem *pMem;                      /* Write results here */
@@ -5993,7 +6525,7 @@ case OP_Checkpoint: {
   for(i=0, pMem = &aMem[pOp->p3]; i<3; i++, pMem++){
     sqlite3VdbeMemSetInt64(pMem, (i64)aRes[i]);
   }    
-  break;
+  NEXT_OPCODE;
 };  
 #endif
 
@@ -6017,7 +6549,7 @@ case OP_Checkpoint: {
 * *
 * *写一个字符串包含最后journal方式注册P2。
 */
-case OP_JournalMode: {    /* out2-prerelease */
+case OP_JournalMode: OPCODE_LABEL(JournalMode) { /* out2-prerelease */
   Btree *pBt;                     /* Btree to change journal mode of */
   Pager *pPager;                  /* Pager associated with pBt */
   int eNew;                       /* New journal mode */
@@ -6031,6 +6563,7 @@ case OP_JournalMode: {    /* out2-prerelease */
        || eNew==PAGER_JOURNALMODE_OFF
        || eNew==PAGER_JOURNALMODE_MEMORY
        || eNew==PAGER_JOURNALMODE_WAL
+       || eNew==PAGER_JOURNALMODE_WAL2
        || eNew==PAGER_JOURNALMODE_QUERY
   );
   assert( pOp->p1>=0 && pOp->p1<db->nDb );
@@ -6049,7 +6582,7 @@ case OP_JournalMode: {    /* out2-prerelease */
   不允许一个过渡journal_mode = WAL数据库
 * *在临时存储或者VFS不支持共享内存
   */
-  if( eNew==PAGER_JOURNALMODE_WAL
+  if( isWalMode(eNew)
    && (sqlite3Strlen30(zFilename)==0           /* Temp file */
        || !sqlite3PagerWalSupported(pPager))   /* No shared-memory support */
   ){
@@ -6057,18 +6590,18 @@ case OP_JournalMode: {    /* out2-prerelease */
   }
 
   if( (eNew!=eOld)
-   && (eOld==PAGER_JOURNALMODE_WAL || eNew==PAGER_JOURNALMODE_WAL)
+   && (isWalMode(eOld) || isWalMode(eNew))
   ){
     if( !db->autoCommit || db->activeVdbeCnt>1 ){
       rc = SQLITE_ERROR;
       sqlite3SetString(&p->zErrMsg, db, 
           "cannot change %s wal mode from within a transaction",
-          (eNew==PAGER_JOURNALMODE_WAL ? "into" : "out of")
+          (isWalMode(eNew) ? "into" : "out of")
       );
       break;
     }else{
  
-      if( eOld==PAGER_JOURNALMODE_WAL ){
+      if( isWalMode(eOld) ){
         /* If leaving WAL mode, close the log file. If successful, the call
         ** to PagerCloseWal() checkpoints and deletes the write-ahead-log 
         ** file. An EXCLUSIVE lock may still be held on the database file 
@@ -6080,7 +6613,11 @@ case OP_JournalMode: {    /* out2-prerelease */
         */
         rc = sqlite3PagerCloseWal(pPager);
         if( rc==SQLITE_OK ){
-          sqlite3PagerSetJournalMode(pPager, eNew);
+          /* When switching between wal and wal2, use DELETE mode as an
+          ** intermediate while the database header is rewritten. */
+          sqlite3PagerSetJournalMode(pPager,
+              isWalMode(eNew) ? PAGER_JOURNALMODE_DELETE : eNew
+          );
         }
       }else if( eOld==PAGER_JOURNALMODE_MEMORY ){
         /* Cannot transition directly from MEMORY to WAL.  Use mode OFF
@@ -6097,7 +6634,10 @@ case OP_JournalMode: {    /* out2-prerelease */
       */
       assert( sqlite3BtreeIsInTrans(pBt)==0 );
       if( rc==SQLITE_OK ){
-        rc = sqlite3BtreeSetVersion(pBt, (eNew==PAGER_JOURNALMODE_WAL ? 2 : 1));
+        int iVersion = 1;
+        if( eNew==PAGER_JOURNALMODE_WAL ) iVersion = 2;
+        if( eNew==PAGER_JOURNALMODE_WAL2 ) iVersion = 3;
+        rc = sqlite3BtreeSetVersion(pBt, iVersion);
       }
     }
   }
@@ -6114,7 +6654,7 @@ case OP_JournalMode: {    /* out2-prerelease */
   pOut->n = sqlite3Strlen30(pOut->z);
   pOut->enc = SQLITE_UTF8;
   sqlite3VdbeChangeEncoding(pOut, encoding);
-  break;
+  NEXT_OPCODE;
 };
 #endif /* SQLITE_OMIT_PRAGMA */
 
@@ -6126,9 +6666,9 @@ case OP_JournalMode: {    /* out2-prerelease */
 ** a transaction.
 真空整个数据库。这个操作码会导致其他虚拟机器创建和运行。它可能不是从内部一个事务。
 */
-case OP_Vacuum: {
+case OP_Vacuum: OPCODE_LABEL(Vacuum) {
   rc = sqlite3RunVacuum(&p->zErrMsg, db);
-  break;
+  NEXT_OPCODE;
 }
 #endif
 
@@ -6140,7 +6680,7 @@ case OP_Vacuum: {
 ** P2. Otherwise, fall through to the next instruction.
 执行增量真空过程的一个步骤P1数据库。如果真空完成后,跳转到指令 P2。否则,下降到下一个指令。
 */
-case OP_IncrVacuum: {        /* jump */
+case OP_IncrVacuum: OPCODE_LABEL(IncrVacuum) { /* jump */
   Btree *pBt;
 
   assert( pOp->p1>=0 && pOp->p1<db->nDb );
@@ -6151,7 +6691,7 @@ case OP_IncrVacuum: {        /* jump */
     pc = pOp->p2 - 1;
     rc = SQLITE_OK;
   }
-  break;
+  NEXT_OPCODE;
 }
 #endif
 
@@ -6171,13 +6711,13 @@ case OP_IncrVacuum: {        /* jump */
 * *然后只影响当前执行语句。
 
 */
-case OP_Expire: {
+case OP_Expire: OPCODE_LABEL(Expire) {
   if( !pOp->p1 ){
     sqlite3ExpirePreparedStatements(db);
   }else{
     p->expired = 1;
   }
-  break;
+  NEXT_OPCODE;
 }
 
 #ifndef SQLITE_OMIT_SHARED_CACHE
@@ -6203,7 +6743,7 @@ P2包含锁表的根页。
 * * P4包含一个指针表被锁的名称。这只是
 * *用于生成一个错误消息,如果不能获得锁。
 */
-case OP_TableLock: {
+case OP_TableLock: OPCODE_LABEL(TableLock) {
   u8 isWriteLock = (u8)pOp->p3;
   if( isWriteLock || 0==(db->flags&SQLITE_ReadUncommitted) ){
     int p1 = pOp->p1; 
@@ -6216,7 +6756,7 @@ case OP_TableLock: {
       sqlite3SetString(&p->zErrMsg, db, "database table is locked: %s", z);
     }
   }
-  break;
+  NEXT_OPCODE;
 }
 #endif /* SQLITE_OMIT_SHARED_CACHE */
 
@@ -6235,12 +6775,12 @@ case OP_TableLock: {
 * *在一个回调到一个虚拟表xSync()方法。如果是,这个错误
 代码将被设置为SQLITE_LOCKED * *。
 */
-case OP_VBegin: {
+case OP_VBegin: OPCODE_LABEL(VBegin) {
   VTable *pVTab;
   pVTab = pOp->p4.pVtab;
   rc = sqlite3VtabBegin(db, pVTab);
   if( pVTab ) importVtabErrMsg(p, pVTab->pVtab);
-  break;
+  NEXT_OPCODE;
 }
 #endif /* SQLITE_OMIT_VIRTUALTABLE */
 
@@ -6250,9 +6790,9 @@ case OP_VBegin: {
 ** P4 is the name of a virtual table in database P1. Call the xCreate method
 ** for that table.P4的名称是一个虚拟表在数据库P1。调用xCreate方法表
 */
-case OP_VCreate: {
+case OP_VCreate: OPCODE_LABEL(VCreate) {
   rc = sqlite3VtabCallCreate(db, pOp->p1, pOp->p4.z, &p->zErrMsg);
-  break;
+  NEXT_OPCODE;
 }
 #endif /* SQLITE_OMIT_VIRTUALTABLE */
 
@@ -6263,11 +6803,11 @@ case OP_VCreate: {
 ** of that table.
     P4是在数据库P1中的一个虚拟表的名字。调用那个表的xDestroy方法
 */
-case OP_VDestroy: {
+case OP_VDestroy: OPCODE_LABEL(VDestroy) {
   p->inVtabMethod = 2;
   rc = sqlite3VtabCallDestroy(db, pOp->p1, pOp->p4.z);
   p->inVtabMethod = 0;
-  break;
+  NEXT_OPCODE;
 }
 #endif /* SQLITE_OMIT_VIRTUALTABLE */
 
@@ -6281,7 +6821,7 @@ P4是一个虚表指针对象,一个sqlite3_vtab结构。
 * * P1是游标的数字。这个操作码打开虚拟光标
 * *表和商店,光标在P1。
 */
-case OP_VOpen: {
+case OP_VOpen: OPCODE_LABEL(VOpen) {
   VdbeCursor *pCur;
   sqlite3_vtab_cursor *pVtabCursor;
   sqlite3_vtab *pVtab;
@@ -6308,7 +6848,7 @@ case OP_VOpen: {
       pModule->xClose(pVtabCursor);
     }
   }
-  break;
+  NEXT_OPCODE;
 }
 #endif /* SQLITE_OMIT_VIRTUALTABLE */
 
@@ -6346,7 +6886,7 @@ P4 NULL或一个字符串,该字符串是由xBestIndex生成
 
 * *跳转了P2如果过滤后的结果集将是空的。
 */
-case OP_VFilter: {   /* jump */
+case OP_VFilter: OPCODE_LABEL(VFilter) { /* jump */
   int nArg;
   int iQuery;
   const sqlite3_module *pModule;
@@ -6397,7 +6937,7 @@ case OP_VFilter: {   /* jump */
   }
   pCur->nullRow = 0;
 
-  break;
+  NEXT_OPCODE;
 }
 #endif /* SQLITE_OMIT_VIRTUALTABLE */
 
@@ -6411,7 +6951,7 @@ case OP_VFilter: {   /* jump */
 * *的虚拟表的行
 * * P1游标指向到寄存器P3。
 */
-case OP_VColumn: {
+case OP_VColumn: OPCODE_LABEL(VColumn) {
   sqlite3_vtab *pVtab;
   const sqlite3_module *pModule;
   Mem *pDest;
@@ -6464,7 +7004,7 @@ case OP_VColumn: {
   if( sqlite3VdbeMemTooBig(pDest) ){
     goto too_big;
   }
-  break;
+  NEXT_OPCODE;
 }
 #endif /* SQLITE_OMIT_VIRTUALTABLE */
 
@@ -6478,7 +7018,7 @@ case OP_VColumn: {
 * *跳转指令P2。或者,如果已经达到虚拟表
 * *的结果集,然后下降到下一个指令。
 */
-case OP_VNext: {   /* jump */
+case OP_VNext: OPCODE_LABEL(VNext) { /* jump */
   sqlite3_vtab *pVtab;
   const sqlite3_module *pModule;
   int res;
@@ -6517,7 +7057,7 @@ case OP_VNext: {   /* jump */
     /* If there is data, jump to P2 */
     pc = pOp->p2 - 1;
   }
-  break;
+  NEXT_OPCODE;
 }
 #endif /* SQLITE_OMIT_VIRTUALTABLE */
 
@@ -6531,7 +7071,7 @@ P4是一个虚表指针对象,一个sqlite3_vtab结构。
 * *此操作码调用相应的xRename方法。的价值
 * *在P1通过注册为xRename zName参数的方法。
 */
-case OP_VRename: {
+case OP_VRename: OPCODE_LABEL(VRename) {
   sqlite3_vtab *pVtab;
   Mem *pName;
 
@@ -6550,7 +7090,7 @@ case OP_VRename: {
     importVtabErrMsg(p, pVtab);
     p->expired = 0;
   }
-  break;
+  NEXT_OPCODE;
 }
 #endif
 
@@ -6597,7 +7137,7 @@ P1是一个布尔标志。如果它被设置为true,xUpdate电话
 * *的值被设置为rowid刚刚插入的行。
 */
 
-case OP_VUpdate: {
+case OP_VUpdate: OPCODE_LABEL(VUpdate) {
   sqlite3_vtab *pVtab;
   sqlite3_module *pModule;
   int nArg;
@@ -6642,7 +7182,7 @@ case OP_VUpdate: {
       p->nChange++;
     }
   }
-  break;
+  NEXT_OPCODE;
 }
 #endif /* SQLITE_OMIT_VIRTUALTABLE */
 
@@ -6651,9 +7191,9 @@ case OP_VUpdate: {
 **
 ** Write the current number of pages in database P1 to memory cell P2.
 */
-case OP_Pagecount: {            /* out2-prerelease */
+case OP_Pagecount: OPCODE_LABEL(Pagecount) { /* out2-prerelease */
   pOut->u.i = sqlite3BtreeLastPage(db->aDb[pOp->p1].pBt);
-  break;
+  NEXT_OPCODE;
 }
 #endif
 
@@ -6672,7 +7212,7 @@ case OP_Pagecount: {            /* out2-prerelease */
 * *
 * *店的最大页数后注册P2的变化。
 */
-case OP_MaxPgcnt: {            /* out2-prerelease */
+case OP_MaxPgcnt: OPCODE_LABEL(MaxPgcnt) { /* out2-prerelease */
   unsigned int newMax;
   Btree *pBt;
 
@@ -6683,7 +7223,7 @@ case OP_MaxPgcnt: {            /* out2-prerelease */
     if( newMax < (unsigned)pOp->p3 ) newMax = (unsigned)pOp->p3;
   }
   pOut->u.i = sqlite3BtreeMaxPageCount(pBt, newMax);
-  break;
+  NEXT_OPCODE;
 }
 #endif
 
@@ -6696,7 +7236,7 @@ case OP_MaxPgcnt: {            /* out2-prerelease */
 如果启用了跟踪(通过sqlite3_trace())接口,然后
 * * utf - 8编码的字符串包含在P4上发出跟踪回调。
 */
-case OP_Trace: {
+case OP_Trace: OPCODE_LABEL(Trace) {
   char *zTrace;
   char *z;
 
@@ -6712,7 +7252,7 @@ case OP_Trace: {
     sqlite3DebugPrintf("SQL-trace: %s\n", zTrace);
   }
 #endif /* SQLITE_DEBUG */
-  break;
+  NEXT_OPCODE;
 }
 #endif
 
@@ -6733,9 +7273,9 @@ case OP_Trace: {
 从优化器* *这个操作码记录信息。这是
 * *无为法相同。这个opcodesnever出现在一个真实的虚拟机程序。
 */
-default: {          /* This is really OP_Noop and OP_Explain */
+default: OPCODE_LABEL(Noop) {   /* This is really OP_Noop and OP_Explain */
   assert( pOp->opcode==OP_Noop || pOp->opcode==OP_Explain );
-  break;
+  NEXT_OPCODE;
 }
 
 /*****************************************************************************
@@ -6750,6 +7290,12 @@ switch语句的情况下上面这一行,都应当缩进
 *****************************************************************************/
     }
 
+#ifndef SQLITE_OMIT_STMT_PROFILE
+    if( aOpStat ){
+      aOpStat[origPc].nCycle += sqlite3Hwtime() - start;
+      if( pc!=origPc ) aOpStat[origPc].nJump++;
+    }
+#endif
 #ifdef VDBE_PROFILE
     {
       u64 elapsed = sqlite3Hwtime() - start;
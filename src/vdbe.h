@@ -230,12 +230,43 @@ char *sqlite3VdbeExpandSql(Vdbe*, const char*);
 
 void sqlite3VdbeRecordUnpack(KeyInfo*, int, const void*, UnpackedRecord*);//给定nKey字节大小的一条记录的二进制数据存在pKey[]，通过解码记录的第四个参数来填充UnpackedRecord结构实例。
 int sqlite3VdbeRecordCompare(int, const void*, UnpackedRecord*);//这个函数主要用来比较两个表的行数或者指定的索引记录
+void sqlite3VdbeRecordCompareInit(KeyInfo*, char);
 UnpackedRecord *sqlite3VdbeAllocUnpackedRecord(KeyInfo *, char *, int, char **);//这个函数被用于给UnpackedRecord结构分配一个足够大的内存空间
 
 #ifndef SQLITE_OMIT_TRIGGER
 void sqlite3VdbeLinkSubProgram(Vdbe *, SubProgram *);//链接子程序对象作为第二个参数传递到Vdbe.pSubProgram链表
 #endif
 
+#ifndef SQLITE_OMIT_HASH_AGGREGATE
+i64 sqlite3VdbeHashAggBudget(sqlite3*, int, int);
+#endif
+#ifndef SQLITE_OMIT_HASH_JOIN
+i64 sqlite3VdbeHashJoinBudget(sqlite3*, int);
+#endif
+#ifndef SQLITE_OMIT_BATCH_AGGREGATE
+/*
+** The built-in aggregate functions that OP_BatchAgg can compute, as
+** returned by sqlite3BatchAggKind().
+*/
+#define BATCHAGG_COUNT   1   /* count(*) or count(X) */
+#define BATCHAGG_SUM     2   /* sum(X) */
+#define BATCHAGG_TOTAL   3   /* total(X) */
+#define BATCHAGG_AVG     4   /* avg(X) */
+#define BATCHAGG_MIN     5   /* min(X) */
+#define BATCHAGG_MAX     6   /* max(X) */
+#endif
+#ifndef SQLITE_OMIT_STMT_PROFILE
+void sqlite3VdbeProfileClear(sqlite3*);
+int sqlite3VdbeProfileInit(sqlite3*);
+#endif
+#ifndef SQLITE_OMIT_EXPLAIN
+void sqlite3VdbeScanStat(Vdbe*, int, int, int, int, int);
+void sqlite3VdbeScanStatEnd(Vdbe*, int);
+#else
+# define sqlite3VdbeScanStat(V,A,B,C,D,E)
+# define sqlite3VdbeScanStatEnd(V,A)
+#endif
+
 
 #ifndef NDEBUG
 void sqlite3VdbeComment(Vdbe*, const char*, ...);
@@ -37,6 +37,40 @@ typedef unsigned char Bool;
 ** Opaque类型被vdbesort.c文件中的代码使用
 */
 typedef struct VdbeSorter VdbeSorter;
+typedef struct VdbeHashAgg VdbeHashAgg;
+typedef struct VdbeHashJoin VdbeHashJoin;
+
+/*
+** Run-time profile counters for a single opcode, collected while
+** PRAGMA stmt_profile is enabled. See vdbeprofile.c.
+*/
+typedef struct VdbeOpStat VdbeOpStat;
+struct VdbeOpStat {
+  u64 nExec;            /* Number of times the opcode was run */
+  u64 nCycle;           /* Total CPU cycles spent running the opcode */
+  u64 nJump;            /* Number of times the opcode jumped */
+  u64 nPage;            /* Pages loaded by cursors opened by the opcode */
+};
+
+/*
+** EXPLAIN ANALYZE information about the loop or temp b-tree described by
+** a single OP_Explain opcode. For a loop, the OP_Explain is run once each
+** time the loop starts, and addrVisit and addrOutput are run once for
+** each row the loop visits and each row that passes its WHERE terms. The
+** opcodes in the range [addrExplain,addrEnd) make up the loop, including
+** any nested loops. For a temp b-tree, addrVisit, addrOutput and addrEnd
+** are all -1 and the counters of the opcodes that use cursor iCsr are
+** reported instead.
+*/
+typedef struct VdbeScanStat VdbeScanStat;
+struct VdbeScanStat {
+  int addrExplain;      /* Address of the OP_Explain opcode */
+  int addrVisit;        /* Run once for each row visited, or -1 */
+  int addrOutput;       /* Run once for each row output, or -1 */
+  int addrEnd;          /* First address past the end of the loop, or -1 */
+  int iCsr;             /* Cursor of the table or temp b-tree */
+  int iIdxCsr;          /* Cursor of the index used by the loop, or -1 */
+};
 
 /* Opaque type used by the explainer 这个类型被解释器使用*/
 typedef struct Explain Explain;
@@ -77,6 +111,9 @@ struct VdbeCursor {
   i64 movetoTarget;     /* Argument to the deferred sqlite3BtreeMoveto() 对推迟的方法sqlite3BtreeMoveto() 的内容提要*/
   i64 lastRowid;        /* Last rowid from a Next or NextIdx operation最后一个行id来自下一个操作 */
   VdbeSorter *pSorter;  /* Sorter object for OP_SorterOpen cursors OP_SorterOpen指针的分类对象*/
+  VdbeHashAgg *pHashAgg; /* Hash table for OP_HashAggOpen cursors */
+  VdbeHashJoin *pHashJoin; /* Hash table for OP_HashJoinOpen cursors */
+  VdbeOpStat *pOpStat;  /* Profile counters of the opening opcode, or NULL */
 
   /* Result of last sqlite3BtreeMoveto() done by an OP_NotExists or 
   ** OP_IsUnique opcode on this cursor.
@@ -382,6 +419,12 @@ struct Vdbe {
   SubProgram *pProgram;   /* Linked list of all sub-programs used by VM虚拟机使用的所有的子程序的关联列表 */
   int nOnceFlag;          /* Size of array aOnceFlag[] 数组的大小*/
   u8 *aOnceFlag;          /* Flags for OP_Once OP_Once的标记*/
+  VdbeOpStat *aOpStat;    /* Profile counters, one per aOp[] entry, or NULL */
+  u8 analyzed;            /* True once EXPLAIN ANALYZE has run the program */
+#ifndef SQLITE_OMIT_EXPLAIN
+  int nScanStat;          /* Number of entries in aScanStat[] */
+  VdbeScanStat *aScanStat;  /* EXPLAIN ANALYZE loops and temp b-trees */
+#endif
 };
 
 /*
@@ -458,6 +501,7 @@ int sqlite3VdbeTransferError(Vdbe *p);
 #ifdef SQLITE_OMIT_MERGE_SORT
 # define sqlite3VdbeSorterInit(Y,Z)      SQLITE_OK
 # define sqlite3VdbeSorterWrite(X,Y,Z)   SQLITE_OK
+# define sqlite3VdbeSorterLimit(Y,Z)
 # define sqlite3VdbeSorterClose(Y,Z)
 # define sqlite3VdbeSorterRowkey(Y,Z)    SQLITE_OK
 # define sqlite3VdbeSorterRewind(X,Y,Z)  SQLITE_OK
@@ -470,9 +514,42 @@ int sqlite3VdbeSorterRowkey(const VdbeCursor *, Mem *);
 int sqlite3VdbeSorterNext(sqlite3 *, const VdbeCursor *, int *);
 int sqlite3VdbeSorterRewind(sqlite3 *, const VdbeCursor *, int *);
 int sqlite3VdbeSorterWrite(sqlite3 *, const VdbeCursor *, Mem *);
+void sqlite3VdbeSorterLimit(const VdbeCursor *, i64);
 int sqlite3VdbeSorterCompare(const VdbeCursor *, Mem *, int *);
 #endif
 
+#ifdef SQLITE_OMIT_HASH_AGGREGATE
+# define sqlite3VdbeHashAggClose(Y,Z)
+#else
+int sqlite3VdbeHashAggInit(sqlite3 *, VdbeCursor *, Mem *, int, int);
+void sqlite3VdbeHashAggClose(sqlite3 *, VdbeCursor *);
+int sqlite3VdbeHashAggFind(sqlite3 *, const VdbeCursor *, Mem *, int *);
+void sqlite3VdbeHashAggSave(const VdbeCursor *);
+int sqlite3VdbeHashAggRewind(const VdbeCursor *, int *);
+int sqlite3VdbeHashAggNext(const VdbeCursor *, int *);
+#endif
+
+#ifdef SQLITE_OMIT_HASH_JOIN
+# define sqlite3VdbeHashJoinClose(Y,Z)
+#else
+int sqlite3VdbeHashJoinInit(sqlite3 *, VdbeCursor *, int);
+void sqlite3VdbeHashJoinClose(sqlite3 *, VdbeCursor *);
+int sqlite3VdbeHashJoinInsert(sqlite3 *, const VdbeCursor *, Mem *, Mem *);
+int sqlite3VdbeHashJoinSeek(sqlite3 *, const VdbeCursor *, Mem *, int *);
+int sqlite3VdbeHashJoinNext(const VdbeCursor *, int *);
+const u8 *sqlite3VdbeHashJoinRecord(const VdbeCursor *, u32 *);
+#endif
+
+#ifndef SQLITE_OMIT_BATCH_AGGREGATE
+int sqlite3VdbeBatchAgg(Vdbe *, VdbeCursor *, const int *, int *);
+#endif
+
+#ifdef SQLITE_OMIT_STMT_PROFILE
+# define sqlite3VdbeProfileSave(X)
+#else
+void sqlite3VdbeProfileSave(Vdbe *);
+#endif
+
 #if !defined(SQLITE_OMIT_SHARED_CACHE) && SQLITE_THREADSAFE>0
   void sqlite3VdbeEnter(Vdbe*);
   void sqlite3VdbeLeave(Vdbe*);
@@ -444,7 +444,31 @@ static int sqlite3Step(Vdbe *p){
     p->pc = 0;
   }
 #ifndef SQLITE_OMIT_EXPLAIN
-  if( p->explain ){
+  if( p->explain==3 && !p->analyzed ){
+    /* EXPLAIN ANALYZE. Run the program to completion, discarding any
+    ** result rows. Then restart the halted VM as an EXPLAIN QUERY PLAN
+    ** listing, reporting the counters collected in Vdbe.aOpStat[].
+    */
+    db->vdbeExecCnt++;
+    do{
+      rc = sqlite3VdbeExec(p);
+    }while( rc==SQLITE_ROW );
+    db->vdbeExecCnt--;
+    if( rc==SQLITE_DONE ){
+      p->rc = doWalCallbacks(db);
+      if( p->rc!=SQLITE_OK ){
+        rc = SQLITE_ERROR;
+      }else{
+        assert( p->magic==VDBE_MAGIC_HALT );
+        p->analyzed = 1;
+        p->magic = VDBE_MAGIC_RUN;
+        p->pc = 0;
+        db->activeVdbeCnt++;
+        if( p->readOnly==0 ) db->writeVdbeCnt++;
+        rc = sqlite3VdbeList(p);
+      }
+    }
+  }else if( p->explain ){
     rc = sqlite3VdbeList(p);//在虚拟机中给出程序的清单。接口和sqlite3VdbeExec()的接口一样
   }else
 #endif /* SQLITE_OMIT_EXPLAIN */
@@ -497,6 +497,101 @@ static void resolveP2Values(Vdbe *p, int *pMaxFuncArgs){
   *pMaxFuncArgs = nMaxArgs;
 }
 
+#ifndef SQLITE_OMIT_SUPERINSTRUCTIONS
+/*
+** When this global variable is non-zero, sqlite3VdbeMakeReady() does not
+** fuse opcodes.  The test harness uses it to check that a fused program
+** gives the same results as the unfused one.  Test builds only.
+*/
+#ifdef SQLITE_TEST
+int sqlite3_vdbe_nofuse = 0;
+#endif
+
+/*
+** Peephole pass that replaces the first opcode of some frequent pairs
+** with a fused opcode (a "superinstruction") that runs both halves
+** without a trip through the dispatch in between:
+**
+**     OP_Column followed by OP_Column            ->  OP_ColumnCol
+**     OP_Column followed by a comparison opcode  ->  OP_ColumnCmp
+**     OP_Next jumping to an OP_Column            ->  OP_NextCol
+**
+** A run of two or more OP_Column opcodes on one cursor that copy adjacent
+** columns into adjacent registers starts with OP_ColumnRange instead.  It
+** extracts the whole run from a single decode of the record header.
+**
+** These are the pairs at the heart of the loops built by codeOneLoopStart()
+** and selectInnerLoop().  Pair counts for a real workload can be read from
+** PRAGMA stmt_profile: the fall-through count of the instruction at addr
+** into addr+1 is calls-jumps, and the count of its jumps to P2 is jumps.
+** For example:
+**
+**     SELECT a.opcode, b.opcode, sum(a.calls-a.jumps) AS n
+**       FROM stmt_profile a JOIN stmt_profile b
+**         ON b.sql=a.sql AND b.addr=a.addr+1
+**      GROUP BY 1, 2 ORDER BY n DESC;
+**
+** Only the opcode changes.  Operands and addresses are untouched, so a
+** jump to the second half of a pair is still valid, and a fused opcode
+** falls back to behaving exactly like the opcode it replaced whenever
+** sqlite3VdbeExec() needs to see every instruction (see FUSED_NEXT).
+**
+** This routine is called by sqlite3VdbeMakeReady() after
+** resolveP2Values(), so all P2 values are real addresses.
+*/
+static void fuseOpcodes(Vdbe *p){
+  int i;
+  Op *pOp;
+  Op *aOp = p->aOp;
+  int nOp = p->nOp;
+
+  for(i=0, pOp=aOp; i<nOp-1; i++, pOp++){
+    if( pOp->opcode==OP_Column && pOp->p4type==P4_NOTUSED ){
+      /* Look for a run of OP_Column opcodes on the same cursor that copy
+      ** consecutive columns into consecutive registers.  None of them may
+      ** have a default value in P4 and only the first may clear the
+      ** pseudo-table cache.  */
+      int n = 1;
+      while( i+n<nOp && pOp[n].opcode==OP_Column
+          && pOp[n].p1==pOp->p1
+          && pOp[n].p2==pOp->p2+n
+          && pOp[n].p3==pOp->p3+n
+          && pOp[n].p4type==P4_NOTUSED
+          && (pOp[n].p5 & OPFLAG_CLEARCACHE)==0
+      ){
+        n++;
+      }
+      if( n>1 ){
+        pOp->opcode = OP_ColumnRange;
+        pOp->p4type = P4_INT32;
+        pOp->p4.i = n;
+      }
+    }
+    if( pOp->opcode==OP_Column ){
+      switch( pOp[1].opcode ){
+        case OP_Column:
+          pOp->opcode = OP_ColumnCol;
+          break;
+        case OP_Eq: case OP_Ne: case OP_Lt:
+        case OP_Le: case OP_Gt: case OP_Ge:
+          pOp->opcode = OP_ColumnCmp;
+          break;
+      }
+    }else if( pOp->opcode==OP_Next ){
+      u8 target;
+      assert( pOp->p2>=0 && pOp->p2<nOp );
+      target = aOp[pOp->p2].opcode;
+      if( target==OP_Column || target==OP_ColumnCol
+       || target==OP_ColumnCmp || target==OP_ColumnRange
+      ){
+        pOp->opcode = OP_NextCol;
+      }
+    }
+    pOp->opflags = sqlite3OpcodeProperty[pOp->opcode];
+  }
+}
+#endif /* SQLITE_OMIT_SUPERINSTRUCTIONS */
+
 /*
 ** Return the address of the next instruction to be inserted.//返回插入下一条指令的地址。
 */
@@ -1222,6 +1317,124 @@ void sqlite3VdbeFrameDelete(VdbeFrame *p){//删除vdbe结构体
 }
 
 #ifndef SQLITE_OMIT_EXPLAIN //定义一个SQLITE_OMIT_EXPLAIN
+/*
+** Record that the OP_Explain opcode at addrExplain describes a loop or
+** temp b-tree that EXPLAIN ANALYZE should report counters for. See the
+** comments above the VdbeScanStat object for the meaning of the other
+** arguments. For a loop, sqlite3VdbeScanStatEnd() must be called once
+** the code for the loop is complete.
+*/
+void sqlite3VdbeScanStat(
+  Vdbe *p,                        /* VM being constructed */
+  int addrExplain,                /* Address of the OP_Explain opcode */
+  int addrVisit,                  /* Run once for each row visited, or -1 */
+  int addrOutput,                 /* Run once for each row output, or -1 */
+  int iCsr,                       /* Cursor of the table or temp b-tree */
+  int iIdxCsr                     /* Cursor of the index, or -1 */
+){
+  int nByte = (p->nScanStat+1)*sizeof(VdbeScanStat);
+  VdbeScanStat *aNew;
+  aNew = (VdbeScanStat*)sqlite3DbRealloc(p->db, p->aScanStat, nByte);
+  if( aNew ){
+    VdbeScanStat *pNew = &aNew[p->nScanStat++];
+    pNew->addrExplain = addrExplain;
+    pNew->addrVisit = addrVisit;
+    pNew->addrOutput = addrOutput;
+    pNew->addrEnd = -1;
+    pNew->iCsr = iCsr;
+    pNew->iIdxCsr = iIdxCsr;
+    p->aScanStat = aNew;
+  }
+}
+
+/*
+** The loop described by the OP_Explain opcode at addrExplain ends at the
+** current address.
+*/
+void sqlite3VdbeScanStatEnd(Vdbe *p, int addrExplain){
+  int i;
+  for(i=p->nScanStat-1; i>=0; i--){
+    if( p->aScanStat[i].addrExplain==addrExplain ){
+      p->aScanStat[i].addrEnd = p->nOp;
+      break;
+    }
+  }
+}
+
+/*
+** Compute the EXPLAIN ANALYZE counters reported for the OP_Explain opcode
+** at addrExplain: the number of times the loop started, rows visited,
+** rows output, CPU cycles and b-tree pages loaded. Entries of aVal[] that
+** do not apply are set to -1, and reported as NULL.
+*/
+static void vdbeScanStatValues(Vdbe *p, int addrExplain, i64 *aVal){
+  VdbeOpStat *aStat = p->aOpStat;
+  VdbeScanStat *pScan = 0;
+  u64 nCycle = 0;
+  u64 nPage = 0;
+  int i;
+
+  for(i=0; i<5; i++) aVal[i] = -1;
+  for(i=0; i<p->nScanStat; i++){
+    if( p->aScanStat[i].addrExplain==addrExplain ){
+      pScan = &p->aScanStat[i];
+      break;
+    }
+  }
+  if( pScan==0 || aStat==0 ) return;
+
+  if( pScan->addrEnd>=0 ){
+    /* A loop */
+    aVal[0] = (i64)aStat[pScan->addrExplain].nExec;
+    aVal[1] = (i64)aStat[pScan->addrVisit].nExec;
+    aVal[2] = (i64)aStat[pScan->addrOutput].nExec;
+    for(i=pScan->addrExplain; i<pScan->addrEnd; i++){
+      nCycle += aStat[i].nCycle;
+    }
+  }else{
+    /* A temp b-tree. Count the rows written to it and read back from it,
+    ** and the cycles spent in the opcodes that do so. */
+    aVal[1] = aVal[2] = 0;
+    for(i=0; i<p->nOp; i++){
+      Op *pOp = &p->aOp[i];
+      if( pOp->p1!=pScan->iCsr ) continue;
+      switch( pOp->opcode ){
+        case OP_IdxInsert:
+        case OP_SorterInsert:
+          aVal[1] += (i64)aStat[i].nExec;
+          nCycle += aStat[i].nCycle;
+          break;
+        case OP_Next:
+        case OP_Prev:
+        case OP_SorterNext:
+          aVal[2] += (i64)aStat[i].nExec;
+          /* fall through */
+        case OP_Sort:
+        case OP_SorterSort:
+        case OP_Rewind:
+        case OP_Last:
+        case OP_Found:
+        case OP_NotFound:
+        case OP_SorterData:
+        case OP_RowKey:
+        case OP_Column:
+          nCycle += aStat[i].nCycle;
+          break;
+      }
+    }
+  }
+  aVal[3] = (i64)nCycle;
+
+  /* Only opcodes that open cursors have a non-zero page count */
+  for(i=0; i<p->nOp; i++){
+    int iCur = p->aOp[i].p1;
+    if( aStat[i].nPage && (iCur==pScan->iCsr || iCur==pScan->iIdxCsr) ){
+      nPage += aStat[i].nPage;
+    }
+  }
+  aVal[4] = (i64)nPage;
+}
+
 /*
 ** Give a listing of the program in the virtual machine.
 **
@@ -1236,6 +1449,11 @@ void sqlite3VdbeFrameDelete(VdbeFrame *p){//删除vdbe结构体
 **
 ** When p->explain==1, first the main program is listed, then each of
 ** the trigger subprograms are listed one by one.
+**
+** p->explain==3 is used to implement EXPLAIN ANALYZE. The program has
+** already been run to completion by sqlite3Step(). OP_Explain
+** instructions are listed as for p->explain==2, followed by the counters
+** computed by vdbeScanStatValues().
 
 **在虚拟机中给出程序的清单。接口和sqlite3VdbeExec()的接口一样。但不是运行代码，
 而是将每条指令回调一次。这个功能用来实现解释。
@@ -1265,7 +1483,7 @@ int sqlite3VdbeList(
   尽管这个操作码不使用动态字符串表示结果，但是当用户调用了sqlite3_column_text16()函数后
   结果列可能变为动态的，这是因为使用了UTF-16编码。
   */
-  releaseMemArray(pMem, 8);
+  releaseMemArray(pMem, p->explain==3 ? 9 : 8);
   p->pResultSet = 0;
 
   if( p->rc==SQLITE_NOMEM ){//当vdbe的返回值是SQLITE_NOMEM
@@ -1313,7 +1531,7 @@ int sqlite3VdbeList(
 
   do{
     i = p->pc++;
-  }while( i<nRow && p->explain==2 && p->aOp[i].opcode!=OP_Explain );
+  }while( i<nRow && p->explain>=2 && p->aOp[i].opcode!=OP_Explain );
   if( i>=nRow ){
     p->rc = SQLITE_OK;
     rc = SQLITE_DONE;
@@ -1436,7 +1654,24 @@ int sqlite3VdbeList(
       }
     }
 
-    p->nResColumn = 8 - 4*(p->explain-1);
+    if( p->explain==3 ){
+      i64 aVal[5];
+      int j;
+      vdbeScanStatValues(p, i, aVal);
+      for(j=0; j<5; j++){
+        if( aVal[j]<0 ){
+          pMem->flags = MEM_Null;
+          pMem->type = SQLITE_NULL;
+        }else{
+          pMem->flags = MEM_Int;
+          pMem->u.i = aVal[j];
+          pMem->type = SQLITE_INTEGER;
+        }
+        pMem++;
+      }
+    }
+
+    p->nResColumn = p->explain==3 ? 9 : 8 - 4*(p->explain-1);
     p->pResultSet = &p->aMem[1];
     p->rc = SQLITE_OK;
     rc = SQLITE_ROW;
@@ -1573,6 +1808,7 @@ void sqlite3VdbeRewind(Vdbe *p){
   p->cacheCtr = 1;
   p->minWriteFileFormat = 255;
   p->iStatement = 0;
+  p->analyzed = 0;
   p->nFkConstraint = 0;
 #ifdef VDBE_PROFILE
   for(i=0; i<p->nOp; i++){
@@ -1655,6 +1891,17 @@ void sqlite3VdbeMakeReady(
   zEnd = (u8*)&p->aOp[p->nOpAlloc];  /* First byte past end of zCsr[] 通过zCsr[]的第一个字节*/
 
   resolveP2Values(p, &nArg);
+#ifndef SQLITE_OMIT_SUPERINSTRUCTIONS
+  /* Programs that are listed by EXPLAIN or profiled by PRAGMA stmt_profile
+  ** are left unfused so that they show the opcodes actually generated. */
+  if( !pParse->explain && !db->bStmtProfile
+#ifdef SQLITE_TEST
+   && !sqlite3_vdbe_nofuse
+#endif
+  ){
+    fuseOpcodes(p);
+  }
+#endif
   p->usesStmtJournal = (u8)(pParse->isMultiWrite && pParse->mayAbort);
   if( pParse->explain && nMem<10 ){
     nMem = 10;
@@ -1731,6 +1978,13 @@ void sqlite3VdbeFreeCursor(Vdbe *p, VdbeCursor *pCx){
     return;
   }
   sqlite3VdbeSorterClose(p->db, pCx);
+  sqlite3VdbeHashAggClose(p->db, pCx);
+  sqlite3VdbeHashJoinClose(p->db, pCx);
+#ifndef SQLITE_OMIT_STMT_PROFILE
+  if( pCx->pOpStat && pCx->pCursor ){
+    pCx->pOpStat->nPage += sqlite3BtreeCursorFetchCount(pCx->pCursor);
+  }
+#endif
   if( pCx->pBt ){
     sqlite3BtreeClose(pCx->pBt);
     /* The pCx->pCursor will be close automatically, if it exists, by
@@ -2509,7 +2763,7 @@ int sqlite3VdbeHalt(Vdbe *p){
 	If this was an INSERT, UPDATE or DELETE and no statement transaction
     ** has been rolled back, update the database connection change-counter. 
     */
-    if( p->changeCntOn ){//changeCntOn表示可以更新改变计数器的值
+    if( p->changeCntOn && !p->analyzed ){//changeCntOn表示可以更新改变计数器的值
       if( eStatementOp!=SAVEPOINT_ROLLBACK ){//数据库不处于回滚到保存点
         sqlite3VdbeSetChanges(db, p->nChange);//更改数据库连接次数
       }else{
@@ -2645,6 +2899,12 @@ int sqlite3VdbeReset(Vdbe *p){
   */
   Cleanup(p);
 
+  /* Move the PRAGMA stmt_profile counters of this run into the profile
+  ** of the connection. */
+  if( p->aOpStat ){
+    sqlite3VdbeProfileSave(p);
+  }
+
   /* 保存在VDBE运行是产生的分析信息
   opcode：表示具体执行什么样的操作
   cnt：指令会被执行多少次
@@ -2750,6 +3010,10 @@ void sqlite3VdbeDeleteObject(sqlite3 *db, Vdbe *p){
   sqlite3DbFree(db, p->aColName);
   sqlite3DbFree(db, p->zSql);
   sqlite3DbFree(db, p->pFree);
+  sqlite3_free(p->aOpStat);
+#ifndef SQLITE_OMIT_EXPLAIN
+  sqlite3DbFree(db, p->aScanStat);
+#endif
 #if defined(SQLITE_ENABLE_TREE_EXPLAIN)
   sqlite3DbFree(db, p->zExplain);
   sqlite3DbFree(db, p->pExplain);
@@ -3283,41 +3547,23 @@ void sqlite3VdbeRecordUnpack(
   p->nField = u;
 }
 
-/* 这个函数主要用来比较两个表的行数或者指定的索引记录（例如{nKey1, pKey1} 和 pPKey2）。如果key1小于key2
-   返回时返回一个负数，key1等于key2返回值为0，key1大于key2时返回值为一个正数。{nKey1, pKey1}必须是由
-   OP_MakeRecord关于VDBE的操作码生成的二进制文件数据。pPKey2必须由一个可以被解析的key值这个key值从遵守
-   sqlite3VdbeParseRecord约束。
-   Key1和Key2没有必要包含相同数目的域值。通常来说具有更少的域值的key要比具有更多的域值的key比较的次数
-   更少。如果pPKey2能够满足UNPACKED_INCRKEY能够设置为真并且通用前缀相等，那么key1小于key2的值。
-   或者来说UNPACKED_MATCH_PREFIX flag被设置为真而且前缀相等，那么key1和key2被认为是相等的，超过通用
-   前缀的部分可以认为是忽略掉。
-** This function compares the two table rows or index records
-** specified by {nKey1, pKey1} and pPKey2.  It returns a negative, zero
-** or positive integer if key1 is less than, equal to or 
-** greater than key2.  The {nKey1, pKey1} key must be a blob
-** created by th OP_MakeRecord opcode of the VDBE.  The pPKey2
-** key must be a parsed key such as obtained from
-** sqlite3VdbeParseRecord.
-**
-** Key1 and Key2 do not have to contain the same number of fields.
-** The key with fewer fields is usually compares less than the 
-** longer key.  However if the UNPACKED_INCRKEY flags in pPKey2 is set
-** and the common prefixes are equal, then key1 is less than key2.
-** Or if the UNPACKED_MATCH_PREFIX flag is set and the prefixes are
-** equal, then the keys are considered to be equal and
-** the parts beyond the common prefix are ignored.
+/*
+** Compare the fields of record {nKey1, aKey1} starting at header offset
+** idx1 and data offset d1 against fields i and later of pPKey2.  This is
+** the generic comparison loop of sqlite3VdbeRecordCompare().  The
+** specialized comparisons below hand over to it as soon as a key does not
+** have the shape they expect.
 */
-int sqlite3VdbeRecordCompare(
-  int nKey1, const void *pKey1, /* 左key Left key */
-  UnpackedRecord *pPKey2        /* 右key Right key */
+static int vdbeRecordCompareTail(
+  int nKey1, const unsigned char *aKey1, /* Left key */
+  u32 szHdr1,        /* Number of bytes in header */
+  u32 idx1,          /* Offset into aKey1[] of next header element */
+  int d1,            /* Offset into aKey1[] of next data element */
+  int i,             /* Index of next field of pPKey2 to compare */
+  UnpackedRecord *pPKey2        /* Right key */
 ){
-  int d1;            /* 下一个数据元素在aKey[]数组中的位置偏移量Offset into aKey[] of next data element */
-  u32 idx1;          /* 下一个头元素在aKey[]数组中的偏移量 Offset into aKey[] of next header element */
-  u32 szHdr1;        /* 在header中的字节数目 Number of bytes in header */
-  int i = 0;
   int nField;
   int rc = 0;
-  const unsigned char *aKey1 = (const unsigned char *)pKey1;/*这定义了一个指针pKey1，pKey1可以指向任意类型的值但是必须是一个const*/
   KeyInfo *pKeyInfo;
   Mem mem1;
 
@@ -3342,8 +3588,6 @@ int sqlite3VdbeRecordCompare(
   */
   /*  mem1.u.i = 0;  // not needed, here to silence compiler warning */
   
-  idx1 = getVarint32(aKey1, szHdr1);
-  d1 = szHdr1;
   nField = pKeyInfo->nField;
   while( idx1<szHdr1 && i<pPKey2->nField ){
     u32 serial_type1;
@@ -3422,6 +3666,237 @@ int sqlite3VdbeRecordCompare(
   }
   return rc;
 }
+
+/*
+** Compare record {nKey1, aKey1} against pPKey2 using only the generic
+** comparison loop.
+*/
+static int vdbeRecordCompareGeneric(
+  int nKey1, const unsigned char *aKey1, /* Left key */
+  UnpackedRecord *pPKey2                 /* Right key */
+){
+  u32 szHdr1;
+  u32 idx1 = getVarint32(aKey1, szHdr1);
+  return vdbeRecordCompareTail(nKey1, aKey1, szHdr1, idx1, szHdr1, 0, pPKey2);
+}
+
+/*
+** Return the integer stored in a record field with serial type
+** serial_type, which must be one of 1 through 6, 8 or 9.  The decoding
+** is the same as in sqlite3VdbeSerialGet().
+*/
+static i64 vdbeRecordGetInt(const unsigned char *buf, u32 serial_type){
+  switch( serial_type ){
+    case 1: {
+      return (signed char)buf[0];
+    }
+    case 2: {
+      return (((signed char)buf[0])<<8) | buf[1];
+    }
+    case 3: {
+      return (((signed char)buf[0])<<16) | (buf[1]<<8) | buf[2];
+    }
+    case 4: {
+      return (buf[0]<<24) | (buf[1]<<16) | (buf[2]<<8) | buf[3];
+    }
+    case 5: {
+      u64 x = (((signed char)buf[0])<<8) | buf[1];
+      u32 y = (buf[2]<<24) | (buf[3]<<16) | (buf[4]<<8) | buf[5];
+      x = (x<<32) | y;
+      return *(i64*)&x;
+    }
+    case 6: {
+      u64 x = (buf[0]<<24) | (buf[1]<<16) | (buf[2]<<8) | buf[3];
+      u32 y = (buf[4]<<24) | (buf[5]<<16) | (buf[6]<<8) | buf[7];
+      x = (x<<32) | y;
+      return *(i64*)&x;
+    }
+    case 8: {
+      return 0;
+    }
+    default: {
+      assert( serial_type==9 );
+      return 1;
+    }
+  }
+}
+
+/*
+** Return true if the specialized comparisons may not be used to compare
+** a record of nKey1 bytes against pPKey2.  They handle only the leading
+** field themselves, so they cannot be used if pPKey2 has no fields or if
+** the leading field is the rowid that UNPACKED_PREFIX_SEARCH asks for.
+*/
+static int vdbeRecordCompareUnusual(int nKey1, const UnpackedRecord *pPKey2){
+  return nKey1<2 || pPKey2->nField<1
+      || ((pPKey2->flags & UNPACKED_PREFIX_SEARCH) && pPKey2->nField==1);
+}
+
+/*
+** Comparison used for KEYINFO_CMP_INT keys.  If the leading fields of both
+** keys are integers, compare them without going through Mem objects and
+** sqlite3MemCompare().  If they are equal, or if either of them is not an
+** integer, the rest of the comparison is done by the generic loop.
+*/
+static int vdbeRecordCompareInt(
+  int nKey1, const unsigned char *aKey1, /* Left key */
+  UnpackedRecord *pPKey2                 /* Right key */
+){
+  const Mem *pMem2 = &pPKey2->aMem[0];
+  u32 szHdr1;
+  u32 serial_type1;
+  i64 v1;
+  int rc;
+
+  if( vdbeRecordCompareUnusual(nKey1, pPKey2) ){
+    return vdbeRecordCompareGeneric(nKey1, aKey1, pPKey2);
+  }
+  szHdr1 = aKey1[0];
+  serial_type1 = aKey1[1];
+  if( szHdr1<2 || szHdr1>=0x80 || (int)szHdr1>=nKey1
+   || serial_type1<1 || serial_type1>9 || serial_type1==7
+   || (pMem2->flags & (MEM_Int|MEM_Null))!=MEM_Int
+  ){
+    return vdbeRecordCompareGeneric(nKey1, aKey1, pPKey2);
+  }
+
+  v1 = vdbeRecordGetInt(&aKey1[szHdr1], serial_type1);
+  if( v1!=pMem2->u.i ){
+    rc = v1<pMem2->u.i ? -1 : +1;
+    if( pPKey2->pKeyInfo->aSortOrder && pPKey2->pKeyInfo->aSortOrder[0] ){
+      rc = -rc;
+    }
+    return rc;
+  }
+  return vdbeRecordCompareTail(nKey1, aKey1, szHdr1, 2,
+      szHdr1 + sqlite3VdbeSerialTypeLen(serial_type1), 1, pPKey2);
+}
+
+/*
+** Comparison used for KEYINFO_CMP_TEXT keys.  If the leading fields of
+** both keys are strings, compare them with memcmp(), which is what the
+** BINARY collating sequence does.  If they are equal, or if either of
+** them is not a string, the rest of the comparison is done by the generic
+** loop.
+*/
+static int vdbeRecordCompareText(
+  int nKey1, const unsigned char *aKey1, /* Left key */
+  UnpackedRecord *pPKey2                 /* Right key */
+){
+  const Mem *pMem2 = &pPKey2->aMem[0];
+  const KeyInfo *pKeyInfo = pPKey2->pKeyInfo;
+  const CollSeq *pColl = pKeyInfo->aColl[0];
+  u32 szHdr1;
+  u32 idx1;
+  u32 serial_type1;
+  int n1;
+  int rc;
+
+  if( vdbeRecordCompareUnusual(nKey1, pPKey2)
+   || aKey1[0]>=0x80
+   || (pMem2->flags & (MEM_Null|MEM_Int|MEM_Real|MEM_Str|MEM_Blob))!=MEM_Str
+   || (pColl && pColl->enc!=pKeyInfo->enc)
+  ){
+    return vdbeRecordCompareGeneric(nKey1, aKey1, pPKey2);
+  }
+  szHdr1 = aKey1[0];
+  idx1 = 1 + getVarint32(&aKey1[1], serial_type1);
+  if( idx1>szHdr1 || serial_type1<13 || (serial_type1&1)==0 ){
+    return vdbeRecordCompareGeneric(nKey1, aKey1, pPKey2);
+  }
+  n1 = (serial_type1-13)/2;
+  if( (int)szHdr1+n1>nKey1 ){
+    return vdbeRecordCompareGeneric(nKey1, aKey1, pPKey2);
+  }
+
+  rc = memcmp(&aKey1[szHdr1], pMem2->z, n1<pMem2->n ? n1 : pMem2->n);
+  if( rc==0 ) rc = n1 - pMem2->n;
+  if( rc!=0 ){
+    if( pKeyInfo->aSortOrder && pKeyInfo->aSortOrder[0] ){
+      rc = -rc;
+    }
+    return rc;
+  }
+  return vdbeRecordCompareTail(nKey1, aKey1, szHdr1, idx1, szHdr1+n1, 1,
+                               pPKey2);
+}
+
+#ifdef SQLITE_TEST
+/*
+** When this global variable is non-zero, sqlite3VdbeRecordCompare() always
+** uses the generic comparison.  The sqlite3_record_compare_bench command in
+** test1.c uses it to time the specialized comparisons against the generic
+** one.  Test builds only.
+*/
+int sqlite3_vdbe_generic_compare = 0;
+#else
+# define sqlite3_vdbe_generic_compare 0
+#endif
+
+/*
+** Set KeyInfo.eRecCmp, the specialized comparison that
+** sqlite3VdbeRecordCompare() uses for keys described by pKeyInfo.  aff is
+** the affinity of the leading field of the keys.  Columns with INTEGER or
+** NUMERIC affinity mostly hold integers.  A TEXT leading field can be
+** compared with memcmp() only if its collating sequence is BINARY.  Both
+** specialized comparisons check the types of the values they are given
+** and fall back to the generic comparison, so a wrong guess costs a
+** little time but never changes the result.
+*/
+void sqlite3VdbeRecordCompareInit(KeyInfo *pKeyInfo, char aff){
+  pKeyInfo->eRecCmp = KEYINFO_CMP_GENERIC;
+  if( pKeyInfo->nField<1 ) return;
+  if( aff==SQLITE_AFF_INTEGER || aff==SQLITE_AFF_NUMERIC ){
+    pKeyInfo->eRecCmp = KEYINFO_CMP_INT;
+  }else if( aff==SQLITE_AFF_TEXT && sqlite3IsBinary(pKeyInfo->aColl[0]) ){
+    pKeyInfo->eRecCmp = KEYINFO_CMP_TEXT;
+  }
+}
+
+/* 这个函数主要用来比较两个表的行数或者指定的索引记录（例如{nKey1, pKey1} 和 pPKey2）。如果key1小于key2
+   返回时返回一个负数，key1等于key2返回值为0，key1大于key2时返回值为一个正数。{nKey1, pKey1}必须是由
+   OP_MakeRecord关于VDBE的操作码生成的二进制文件数据。pPKey2必须由一个可以被解析的key值这个key值从遵守
+   sqlite3VdbeParseRecord约束。
+   Key1和Key2没有必要包含相同数目的域值。通常来说具有更少的域值的key要比具有更多的域值的key比较的次数
+   更少。如果pPKey2能够满足UNPACKED_INCRKEY能够设置为真并且通用前缀相等，那么key1小于key2的值。
+   或者来说UNPACKED_MATCH_PREFIX flag被设置为真而且前缀相等，那么key1和key2被认为是相等的，超过通用
+   前缀的部分可以认为是忽略掉。
+** This function compares the two table rows or index records
+** specified by {nKey1, pKey1} and pPKey2.  It returns a negative, zero
+** or positive integer if key1 is less than, equal to or 
+** greater than key2.  The {nKey1, pKey1} key must be a blob
+** created by th OP_MakeRecord opcode of the VDBE.  The pPKey2
+** key must be a parsed key such as obtained from
+** sqlite3VdbeParseRecord.
+**
+** Key1 and Key2 do not have to contain the same number of fields.
+** The key with fewer fields is usually compares less than the 
+** longer key.  However if the UNPACKED_INCRKEY flags in pPKey2 is set
+** and the common prefixes are equal, then key1 is less than key2.
+** Or if the UNPACKED_MATCH_PREFIX flag is set and the prefixes are
+** equal, then the keys are considered to be equal and
+** the parts beyond the common prefix are ignored.
+**
+** The comparison used depends on pPKey2->pKeyInfo->eRecCmp, which
+** sqlite3VdbeRecordCompareInit() sets once for each KeyInfo.
+*/
+int sqlite3VdbeRecordCompare(
+  int nKey1, const void *pKey1, /* 左key Left key */
+  UnpackedRecord *pPKey2        /* 右key Right key */
+){
+  const unsigned char *aKey1 = (const unsigned char *)pKey1;
+  if( !sqlite3_vdbe_generic_compare ){
+    switch( pPKey2->pKeyInfo->eRecCmp ){
+      case KEYINFO_CMP_INT: {
+        return vdbeRecordCompareInt(nKey1, aKey1, pPKey2);
+      }
+      case KEYINFO_CMP_TEXT: {
+        return vdbeRecordCompareText(nKey1, aKey1, pPKey2);
+      }
+    }
+  }
+  return vdbeRecordCompareGeneric(nKey1, aKey1, pPKey2);
+}
  
 
 /*指针pCur指向一个由OP_MakeRecord操作码创造的索引项。读取rowid的值（记录中的最后一个域）并且将这个
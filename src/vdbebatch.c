@@ -0,0 +1,556 @@
+/*
+** 2012 October 18
+**
+** The author disclaims copyright to this source code.  In place of
+** a legal notice, here is a blessing:
+**
+**    May you do good and not evil.
+**    May you find forgiveness for yourself and forgive others.
+**    May you share freely, never taking more than you give.
+**
+*************************************************************************
+** This file contains code used by the OP_BatchAgg opcode to evaluate
+** simple aggregate queries over a single table a batch of rows at a time.
+**
+** A query such as
+**
+**     SELECT sum(x), count(*) FROM t WHERE y > ?
+**
+** normally runs OP_Column, OP_Gt, OP_AggStep and OP_Next once for each
+** row of the table, and most of its time is spent in sqlite3VdbeExec()
+** rather than on the data. OP_BatchAgg instead asks the b-tree layer for
+** the records of up to BATCH_NROW consecutive rows of a leaf page, decodes
+** the columns it needs into one array per column, and then applies each
+** filter and each accumulator to a whole array at once:
+**
+**     for each batch of rows:
+**       decode the columns used into BatchCol.aType/aInt/aReal
+**       start with a selection vector holding every row of the batch
+**       for each filter "column op value":
+**         drop from the selection vector the rows that fail the filter
+**       for each aggregate:
+**         accumulate the column over the rows in the selection vector
+**
+** Only the integer and floating point values that the built-in count(),
+** sum(), total(), avg(), min() and max() aggregates handle identically
+** to a numeric comparison are supported. As soon as the scan meets
+** anything else (a text or blob value in a column used by the query, a
+** record that is shorter than the table or whose data spills onto
+** overflow pages, a comparison value that is not a number, or an integer
+** overflow in sum()) the results so far are discarded and the caller
+** reruns the query using the normal row at a time loop, which is coded
+** directly after OP_BatchAgg. The accumulators follow the same sequence of
+** operations as sumStep(), countStep() and minmaxStep() in func.c, so the
+** results of both strategies are identical.
+**
+** The query is described to OP_BatchAgg by an array of integers built by
+** sqlite3Select() (see batchAggregate() in select.c):
+**
+**     aSpec[0]              Number of slots (distinct columns decoded), nSlot
+**     aSpec[1]              Number of filters, nFilter
+**     aSpec[2]              Number of aggregates, nAgg
+**     2 ints per slot       Table column number, column affinity
+**     3 ints per filter     Slot, TK_xx comparison, value register
+**     3 ints per aggregate  BATCHAGG_xx code, slot or -1, result register
+**
+** The value register of a TK_ISNULL or TK_NOTNULL filter is not used.
+*/
+#include "sqliteInt.h"
+#include "vdbeInt.h"
+
+#ifndef SQLITE_OMIT_BATCH_AGGREGATE
+
+/*
+** The maximum number of rows decoded in one batch. Leaf pages seldom hold
+** more than this many rows, so that a batch is usually a whole page.
+*/
+#ifndef BATCH_NROW
+# define BATCH_NROW 256
+#endif
+
+/*
+** Values of BatchCol.aType[].
+*/
+#define BATCH_NULL  0
+#define BATCH_INT   1
+#define BATCH_REAL  2
+
+/*
+** The decoded values of one column for the rows of the current batch.
+** If aType[i] is BATCH_INT the value of row i is in aInt[i]. If it is
+** BATCH_REAL the value is in aReal[i].
+*/
+typedef struct BatchCol BatchCol;
+struct BatchCol {
+  u8 aType[BATCH_NROW];
+  i64 aInt[BATCH_NROW];
+  double aReal[BATCH_NROW];
+};
+
+/*
+** A filter "column op value", with the value already converted to a
+** number.
+*/
+typedef struct BatchFilter BatchFilter;
+struct BatchFilter {
+  BatchCol *pCol;       /* Column compared */
+  u8 mask;              /* Set of results of batchCompare() that pass */
+  u8 eType;             /* BATCH_INT or BATCH_REAL */
+  i64 iVal;             /* Value compared against if eType==BATCH_INT */
+  double rVal;          /* Value compared against if eType==BATCH_REAL */
+};
+
+/*
+** The state of one aggregate.  The fields cnt, iSum, rSum, approx and
+** overflow have the same meaning as those of SumCtx in func.c.  The
+** fields eBest, iBest and rBest hold the current result of a min() or
+** max() aggregate.
+*/
+typedef struct BatchAcc BatchAcc;
+struct BatchAcc {
+  int eKind;            /* BATCHAGG_xx code */
+  BatchCol *pCol;       /* Column aggregated, or NULL for count(*) */
+  int iReg;             /* Register to store the result in */
+  i64 cnt;              /* Number of non-NULL values seen */
+  i64 iSum;             /* Integer sum */
+  double rSum;          /* Floating point sum */
+  u8 approx;            /* True if a non-integer value was seen */
+  u8 overflow;          /* True if iSum overflowed */
+  u8 eBest;             /* Type of the min() or max() so far */
+  i64 iBest;            /* min() or max() so far if eBest==BATCH_INT */
+  double rBest;         /* min() or max() so far if eBest==BATCH_REAL */
+};
+
+/*
+** Bits of BatchFilter.mask. The result of a comparison that returned
+** less than, equal to or greater than zero passes the filter if the
+** corresponding bit is set.
+*/
+#define BATCH_LT  0x01
+#define BATCH_EQ  0x02
+#define BATCH_GT  0x04
+
+/*
+** Compare two numbers in the same way as sqlite3MemCompare(): as 64-bit
+** integers if both are integers, or as doubles otherwise.  Return one of
+** BATCH_LT, BATCH_EQ or BATCH_GT.
+*/
+static int batchCompare(
+  int eType1, i64 i1, double r1,
+  int eType2, i64 i2, double r2
+){
+  if( eType1==BATCH_INT && eType2==BATCH_INT ){
+    return i1<i2 ? BATCH_LT : (i1>i2 ? BATCH_GT : BATCH_EQ);
+  }
+  if( eType1==BATCH_INT ) r1 = (double)i1;
+  if( eType2==BATCH_INT ) r2 = (double)i2;
+  return r1<r2 ? BATCH_LT : (r1>r2 ? BATCH_GT : BATCH_EQ);
+}
+
+/*
+** Decode the columns used by the query from the record aRec of nRec
+** bytes into row iRow of the column arrays. aSlot[] maps each of the
+** first nField columns of the table to a BatchCol, or to NULL if the
+** column is not used. abReal[] is true for each column with REAL
+** affinity, the integer values of which are converted to floating point
+** just as OP_RealAffinity does. Both aInt[] and aReal[] are set for each
+** non-NULL value so that either may be read without checking aType[].
+**
+** Return 0 if successful, or 1 if the record holds a value that cannot
+** be decoded here.
+*/
+static int batchDecode(
+  const u8 *aRec,
+  u32 nRec,
+  int iRow,
+  BatchCol **aSlot,
+  const u8 *abReal,
+  int nField
+){
+  u32 szHdr;            /* Size of the record header in bytes */
+  u32 iHdr;             /* Offset of the next serial type in the header */
+  u32 iOff;             /* Offset of the next field in the body */
+  int i;
+
+  iHdr = getVarint32(aRec, szHdr);
+  if( szHdr>nRec || szHdr<iHdr ) return 1;
+  iOff = szHdr;
+  for(i=0; i<nField; i++){
+    u32 t;
+    u32 n;
+    BatchCol *pCol;
+    if( iHdr>=szHdr ) return 1;
+    iHdr += getVarint32(&aRec[iHdr], t);
+    n = sqlite3VdbeSerialTypeLen(t);
+    pCol = aSlot[i];
+    if( pCol ){
+      Mem m;
+      if( t>=10 || iOff+n>nRec ) return 1;
+      m.flags = 0;
+      sqlite3VdbeSerialGet(&aRec[iOff], t, &m);
+      if( m.flags & MEM_Int ){
+        pCol->aType[iRow] = abReal[i] ? BATCH_REAL : BATCH_INT;
+        pCol->aInt[iRow] = m.u.i;
+        pCol->aReal[iRow] = (double)m.u.i;
+      }else if( m.flags & MEM_Real ){
+        pCol->aType[iRow] = BATCH_REAL;
+        pCol->aInt[iRow] = 0;
+        pCol->aReal[iRow] = m.r;
+      }else{
+        pCol->aType[iRow] = BATCH_NULL;
+      }
+    }
+    iOff += n;
+  }
+  return 0;
+}
+
+/*
+** Remove from the selection vector aSel[] of *pnSel rows those that do
+** not pass filter pF.
+*/
+static void batchFilter(const BatchFilter *pF, u16 *aSel, int *pnSel){
+  const BatchCol *pCol = pF->pCol;
+  int nSel = *pnSel;
+  int i, j;
+
+  if( pF->mask==0 ){
+    /* TK_ISNULL */
+    for(i=j=0; i<nSel; i++){
+      if( pCol->aType[aSel[i]]==BATCH_NULL ) aSel[j++] = aSel[i];
+    }
+  }else if( pF->mask==(BATCH_LT|BATCH_EQ|BATCH_GT) ){
+    /* TK_NOTNULL */
+    for(i=j=0; i<nSel; i++){
+      if( pCol->aType[aSel[i]]!=BATCH_NULL ) aSel[j++] = aSel[i];
+    }
+  }else if( pF->eType==BATCH_INT ){
+    /* The common case of an integer compared against an integer column
+    ** is given its own loop. */
+    const i64 iVal = pF->iVal;
+    for(i=j=0; i<nSel; i++){
+      int k = aSel[i];
+      int eType = pCol->aType[k];
+      int c;
+      if( eType==BATCH_INT ){
+        i64 v = pCol->aInt[k];
+        c = v<iVal ? BATCH_LT : (v>iVal ? BATCH_GT : BATCH_EQ);
+      }else if( eType==BATCH_REAL ){
+        c = batchCompare(BATCH_REAL, 0, pCol->aReal[k], BATCH_INT, iVal, 0.0);
+      }else{
+        continue;
+      }
+      if( pF->mask & c ) aSel[j++] = k;
+    }
+  }else{
+    for(i=j=0; i<nSel; i++){
+      int k = aSel[i];
+      int eType = pCol->aType[k];
+      if( eType!=BATCH_NULL
+       && (pF->mask & batchCompare(eType, pCol->aInt[k], pCol->aReal[k],
+                                   BATCH_REAL, 0, pF->rVal))
+      ){
+        aSel[j++] = k;
+      }
+    }
+  }
+  *pnSel = j;
+}
+
+/*
+** Add the values of the nSel rows in selection vector aSel[] to
+** accumulator pAcc.
+*/
+static void batchAccumulate(BatchAcc *pAcc, const u16 *aSel, int nSel){
+  const BatchCol *pCol = pAcc->pCol;
+  int i;
+
+  if( pCol==0 ){
+    /* count(*) */
+    pAcc->cnt += nSel;
+    return;
+  }
+  switch( pAcc->eKind ){
+    case BATCHAGG_COUNT: {
+      for(i=0; i<nSel; i++){
+        if( pCol->aType[aSel[i]]!=BATCH_NULL ) pAcc->cnt++;
+      }
+      break;
+    }
+    case BATCHAGG_SUM:
+    case BATCHAGG_TOTAL:
+    case BATCHAGG_AVG: {
+      for(i=0; i<nSel; i++){
+        int k = aSel[i];
+        if( pCol->aType[k]==BATCH_INT ){
+          i64 v = pCol->aInt[k];
+          pAcc->cnt++;
+          pAcc->rSum += v;
+          if( (pAcc->approx|pAcc->overflow)==0
+           && sqlite3AddInt64(&pAcc->iSum, v)
+          ){
+            pAcc->overflow = 1;
+          }
+        }else if( pCol->aType[k]==BATCH_REAL ){
+          pAcc->cnt++;
+          pAcc->rSum += pCol->aReal[k];
+          pAcc->approx = 1;
+        }
+      }
+      break;
+    }
+    default: {
+      /* min() keeps the first of several equal values, as does max(). */
+      int cWant = pAcc->eKind==BATCHAGG_MIN ? BATCH_GT : BATCH_LT;
+      assert( pAcc->eKind==BATCHAGG_MIN || pAcc->eKind==BATCHAGG_MAX );
+      for(i=0; i<nSel; i++){
+        int k = aSel[i];
+        int eType = pCol->aType[k];
+        if( eType==BATCH_NULL ) continue;
+        if( pAcc->eBest==BATCH_NULL
+         || batchCompare(pAcc->eBest, pAcc->iBest, pAcc->rBest,
+                         eType, pCol->aInt[k], pCol->aReal[k])==cWant
+        ){
+          pAcc->eBest = (u8)eType;
+          pAcc->iBest = pCol->aInt[k];
+          pAcc->rBest = pCol->aReal[k];
+        }
+      }
+      break;
+    }
+  }
+}
+
+/*
+** Store the final value of accumulator pAcc in register pOut, as the
+** xFinalize method of the corresponding built-in aggregate would.
+*/
+static void batchFinalize(const BatchAcc *pAcc, Mem *pOut){
+  switch( pAcc->eKind ){
+    case BATCHAGG_COUNT: {
+      sqlite3VdbeMemSetInt64(pOut, pAcc->cnt);
+      break;
+    }
+    case BATCHAGG_SUM: {
+      assert( pAcc->overflow==0 );
+      if( pAcc->cnt==0 ){
+        sqlite3VdbeMemSetNull(pOut);
+      }else if( pAcc->approx ){
+        sqlite3VdbeMemSetDouble(pOut, pAcc->rSum);
+      }else{
+        sqlite3VdbeMemSetInt64(pOut, pAcc->iSum);
+      }
+      break;
+    }
+    case BATCHAGG_TOTAL: {
+      sqlite3VdbeMemSetDouble(pOut, pAcc->rSum);
+      break;
+    }
+    case BATCHAGG_AVG: {
+      if( pAcc->cnt==0 ){
+        sqlite3VdbeMemSetNull(pOut);
+      }else{
+        sqlite3VdbeMemSetDouble(pOut, pAcc->rSum/(double)pAcc->cnt);
+      }
+      break;
+    }
+    default: {
+      if( pAcc->eBest==BATCH_INT ){
+        sqlite3VdbeMemSetInt64(pOut, pAcc->iBest);
+      }else if( pAcc->eBest==BATCH_REAL ){
+        sqlite3VdbeMemSetDouble(pOut, pAcc->rBest);
+      }else{
+        sqlite3VdbeMemSetNull(pOut);
+      }
+      break;
+    }
+  }
+}
+
+/*
+** Initialize filter pF to compare column pCol using operator op against
+** the value in register pVal.  aff is the affinity of the column.  pVal
+** is NULL if op is TK_ISNULL or TK_NOTNULL.
+**
+** Return 0 if successful, 1 if the filter can never be true (the value is
+** NULL), or 2 if the value is not a number.
+*/
+static int batchFilterInit(
+  BatchFilter *pF,
+  BatchCol *pCol,
+  int op,
+  Mem *pVal,
+  char aff,
+  u8 enc
+){
+  memset(pF, 0, sizeof(*pF));
+  pF->pCol = pCol;
+  switch( op ){
+    case TK_ISNULL:  pF->mask = 0;                              return 0;
+    case TK_NOTNULL: pF->mask = BATCH_LT|BATCH_EQ|BATCH_GT;     return 0;
+    case TK_EQ:      pF->mask = BATCH_EQ;                       break;
+    case TK_NE:      pF->mask = BATCH_LT|BATCH_GT;              break;
+    case TK_LT:      pF->mask = BATCH_LT;                       break;
+    case TK_LE:      pF->mask = BATCH_LT|BATCH_EQ;              break;
+    case TK_GT:      pF->mask = BATCH_GT;                       break;
+    default:         assert( op==TK_GE );
+                     pF->mask = BATCH_GT|BATCH_EQ;              break;
+  }
+
+  /* The comparison opcodes apply the column affinity to the value before
+  ** comparing, so that a numeric column compared against the string '10'
+  ** is compared against the number 10. */
+  if( aff>=SQLITE_AFF_NUMERIC ){
+    sqlite3ValueApplyAffinity(pVal, aff, enc);
+  }
+  if( pVal->flags & MEM_Null ) return 1;
+  if( pVal->flags & MEM_Int ){
+    pF->eType = BATCH_INT;
+    pF->iVal = pVal->u.i;
+  }else if( pVal->flags & MEM_Real ){
+    pF->eType = BATCH_REAL;
+    pF->rVal = pVal->r;
+  }else{
+    return 2;
+  }
+  return 0;
+}
+
+/*
+** This is the implementation of OP_BatchAgg.  Scan the table b-tree
+** opened by cursor pC and compute the aggregates described by aSpec[] (see
+** the header comment of this file) over those rows that pass all of its
+** filters, storing each result in its register of p->aMem[].
+**
+** If the scan meets a row or a value that cannot be handled here, set
+** *pbFallback to true and leave all registers unchanged other than
+** the filter value registers, to which the column affinity may have been
+** applied. Return an SQLite error code if an error occurs, or SQLITE_OK
+** otherwise.
+*/
+int sqlite3VdbeBatchAgg(
+  Vdbe *p,                        /* The VM */
+  VdbeCursor *pC,                 /* Cursor open on the table b-tree */
+  const int *aSpec,               /* Description of the query */
+  int *pbFallback                 /* OUT: True to use the row at a time loop */
+){
+  sqlite3 *db = p->db;
+  BtCursor *pCrsr = pC->pCursor;
+  const int nSlot = aSpec[0];
+  const int nFilter = aSpec[1];
+  const int nAgg = aSpec[2];
+  const int *aSlotSpec = &aSpec[3];
+  const int *aFilterSpec = &aSlotSpec[nSlot*2];
+  const int *aAggSpec = &aFilterSpec[nFilter*3];
+  BatchCol *aCol;                 /* One column array per slot */
+  BatchFilter *aFilter;           /* Filters */
+  BatchAcc *aAcc;                 /* Accumulators */
+  const u8 **aRec;                /* Records of the current batch */
+  BatchCol **apField;             /* Slot of each table column, or NULL */
+  u32 *anRec;                     /* Sizes of the records in aRec[] */
+  u16 *aSel;                      /* Selection vector */
+  u8 *abReal;                     /* True for each REAL affinity column */
+  int nField = 0;                 /* Number of leading table columns decoded */
+  int bFallback = 0;              /* True to use the row at a time loop */
+  int res = 1;
+  int rc = SQLITE_OK;
+  int i;
+
+  assert( pCrsr!=0 );
+  *pbFallback = 0;
+  for(i=0; i<nSlot; i++){
+    if( aSlotSpec[i*2]>=nField ) nField = aSlotSpec[i*2]+1;
+  }
+
+  /* Allocate all of the above arrays in a single block.  The arrays with
+  ** the strictest alignment requirements come first. */
+  aCol = (BatchCol*)sqlite3DbMallocZero(db,
+      sizeof(BatchCol)*nSlot + sizeof(BatchFilter)*nFilter
+      + sizeof(BatchAcc)*nAgg + (sizeof(u8*)+sizeof(u32)+sizeof(u16))*BATCH_NROW
+      + (sizeof(BatchCol*)+1)*nField
+  );
+  if( aCol==0 ) return SQLITE_NOMEM;
+  aFilter = (BatchFilter*)&aCol[nSlot];
+  aAcc = (BatchAcc*)&aFilter[nFilter];
+  aRec = (const u8**)&aAcc[nAgg];
+  apField = (BatchCol**)&aRec[BATCH_NROW];
+  anRec = (u32*)&apField[nField];
+  aSel = (u16*)&anRec[BATCH_NROW];
+  abReal = (u8*)&aSel[BATCH_NROW];
+
+  for(i=0; i<nSlot; i++){
+    int iCol = aSlotSpec[i*2];
+    apField[iCol] = &aCol[i];
+    abReal[iCol] = aSlotSpec[i*2+1]==SQLITE_AFF_REAL;
+  }
+  for(i=0; i<nFilter; i++){
+    const int *a = &aFilterSpec[i*3];
+    Mem *pVal = 0;
+    if( a[1]!=TK_ISNULL && a[1]!=TK_NOTNULL ) pVal = &p->aMem[a[2]];
+    switch( batchFilterInit(&aFilter[i], &aCol[a[0]], a[1], pVal,
+                            (char)aSlotSpec[a[0]*2+1], ENC(db)) ){
+      case 1:  res = -1;       break;    /* No row can pass this filter */
+      case 2:  bFallback = 1;  break;
+    }
+  }
+  for(i=0; i<nAgg; i++){
+    const int *a = &aAggSpec[i*3];
+    aAcc[i].eKind = a[0];
+    aAcc[i].pCol = a[1]<0 ? 0 : &aCol[a[1]];
+    aAcc[i].iReg = a[2];
+  }
+
+  if( res>0 && !bFallback ){
+    rc = sqlite3BtreeFirst(pCrsr, &res);
+  }
+  while( rc==SQLITE_OK && res==0 ){
+    int nRow;
+    int nSel;
+
+    if( db->u1.isInterrupted ){
+      rc = SQLITE_INTERRUPT;
+      break;
+    }
+    rc = sqlite3BtreeLeafBatch(pCrsr, BATCH_NROW, aRec, anRec, &nRow);
+    if( rc!=SQLITE_OK ) break;
+    if( nRow==0 ){
+      /* The current row spills onto an overflow page */
+      bFallback = 1;
+      break;
+    }
+    for(i=0; i<nRow; i++){
+      if( batchDecode(aRec[i], anRec[i], i, apField, abReal, nField) ) break;
+      aSel[i] = (u16)i;
+    }
+    if( i<nRow ){
+      bFallback = 1;
+      break;
+    }
+    nSel = nRow;
+    for(i=0; i<nFilter && nSel>0; i++){
+      batchFilter(&aFilter[i], aSel, &nSel);
+    }
+    for(i=0; i<nAgg && nSel>0; i++){
+      batchAccumulate(&aAcc[i], aSel, nSel);
+    }
+    rc = sqlite3BtreeNext(pCrsr, &res);
+  }
+
+  /* Let sum() report an integer overflow the usual way */
+  for(i=0; i<nAgg; i++){
+    if( aAcc[i].eKind==BATCHAGG_SUM && aAcc[i].overflow ) bFallback = 1;
+  }
+  if( rc==SQLITE_OK && !bFallback ){
+    for(i=0; i<nAgg; i++){
+      batchFinalize(&aAcc[i], &p->aMem[aAcc[i].iReg]);
+    }
+  }
+  pC->cacheStatus = CACHE_STALE;
+  pC->nullRow = 1;
+
+  sqlite3DbFree(db, aCol);
+  *pbFallback = bFallback;
+  return rc;
+}
+
+#endif /* SQLITE_OMIT_BATCH_AGGREGATE */
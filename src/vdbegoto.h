@@ -0,0 +1,336 @@
+/*
+** 2012 October 24
+**
+** The author disclaims copyright to this source code.  In place of
+** a legal notice, here is a blessing:
+**
+**    May you do good and not evil.
+**    May you find forgiveness for yourself and forgive others.
+**    May you share freely, never taking more than you give.
+**
+*************************************************************************
+** This file holds the initializer for the aOpTarget[] jump table used by
+** the computed-goto dispatch in sqlite3VdbeExec().  It is included from
+** the middle of that function in vdbe.c and is not a stand-alone header.
+**
+** There is one entry for each "case OP_xxx:" in the big switch statement
+** of vdbe.c, wrapped in the same #if blocks as the case itself.  Opcodes
+** that are handled by the "default:" case (OP_Noop and OP_Explain) are
+** listed at the end.  Whenever a case is added to or removed from the
+** switch, regenerate the body of this file with:
+**
+**   awk '/^    switch\( pOp->opcode \)/,/^default:/ {
+**     if( /^#(if|ifdef|ifndef|else|elif|endif)/ ) print;
+**     else if( /^case OP_/ ){ sub(":.*","",$2); print "  ["$2"] = &&L_"$2","; }
+**   }' vdbe.c
+*/
+  [OP_Goto] = &&L_OP_Goto,
+  [OP_Gosub] = &&L_OP_Gosub,
+  [OP_Return] = &&L_OP_Return,
+  [OP_Yield] = &&L_OP_Yield,
+  [OP_HaltIfNull] = &&L_OP_HaltIfNull,
+  [OP_Halt] = &&L_OP_Halt,
+#ifndef SQLITE_OMIT_STMT_PROFILE
+#endif
+  [OP_Integer] = &&L_OP_Integer,
+  [OP_Int64] = &&L_OP_Int64,
+#ifndef SQLITE_OMIT_FLOATING_POINT
+  [OP_Real] = &&L_OP_Real,
+#endif
+  [OP_String8] = &&L_OP_String8,
+#ifndef SQLITE_OMIT_UTF16
+#endif
+  [OP_String] = &&L_OP_String,
+  [OP_Null] = &&L_OP_Null,
+  [OP_Blob] = &&L_OP_Blob,
+  [OP_Variable] = &&L_OP_Variable,
+  [OP_Move] = &&L_OP_Move,
+#ifdef SQLITE_DEBUG
+#endif
+  [OP_Copy] = &&L_OP_Copy,
+  [OP_SCopy] = &&L_OP_SCopy,
+#ifdef SQLITE_DEBUG
+#endif
+  [OP_ResultRow] = &&L_OP_ResultRow,
+  [OP_Concat] = &&L_OP_Concat,
+  [OP_Add] = &&L_OP_Add,
+  [OP_Subtract] = &&L_OP_Subtract,
+  [OP_Multiply] = &&L_OP_Multiply,
+  [OP_Divide] = &&L_OP_Divide,
+  [OP_Remainder] = &&L_OP_Remainder,
+#ifdef SQLITE_OMIT_FLOATING_POINT
+#else
+#endif
+  [OP_CollSeq] = &&L_OP_CollSeq,
+  [OP_Function] = &&L_OP_Function,
+#if 0
+#endif
+  [OP_BitAnd] = &&L_OP_BitAnd,
+  [OP_BitOr] = &&L_OP_BitOr,
+  [OP_ShiftLeft] = &&L_OP_ShiftLeft,
+  [OP_ShiftRight] = &&L_OP_ShiftRight,
+  [OP_AddImm] = &&L_OP_AddImm,
+  [OP_MustBeInt] = &&L_OP_MustBeInt,
+#ifndef SQLITE_OMIT_FLOATING_POINT
+  [OP_RealAffinity] = &&L_OP_RealAffinity,
+#endif
+#ifndef SQLITE_OMIT_CAST
+  [OP_ToText] = &&L_OP_ToText,
+  [OP_ToBlob] = &&L_OP_ToBlob,
+  [OP_ToNumeric] = &&L_OP_ToNumeric,
+#endif /* SQLITE_OMIT_CAST */
+  [OP_ToInt] = &&L_OP_ToInt,
+#if !defined(SQLITE_OMIT_CAST) && !defined(SQLITE_OMIT_FLOATING_POINT)
+  [OP_ToReal] = &&L_OP_ToReal,
+#endif /* !defined(SQLITE_OMIT_CAST) && !defined(SQLITE_OMIT_FLOATING_POINT) */
+  [OP_Eq] = &&L_OP_Eq,
+  [OP_Ne] = &&L_OP_Ne,
+  [OP_Lt] = &&L_OP_Lt,
+  [OP_Le] = &&L_OP_Le,
+  [OP_Gt] = &&L_OP_Gt,
+  [OP_Ge] = &&L_OP_Ge,
+#ifndef SQLITE_OMIT_SUPERINSTRUCTIONS
+#endif
+  [OP_Permutation] = &&L_OP_Permutation,
+  [OP_Compare] = &&L_OP_Compare,
+#if SQLITE_DEBUG
+#endif /* SQLITE_DEBUG */
+  [OP_Jump] = &&L_OP_Jump,
+  [OP_And] = &&L_OP_And,
+  [OP_Or] = &&L_OP_Or,
+  [OP_Not] = &&L_OP_Not,
+  [OP_BitNot] = &&L_OP_BitNot,
+  [OP_Once] = &&L_OP_Once,
+  [OP_If] = &&L_OP_If,
+  [OP_IfNot] = &&L_OP_IfNot,
+#ifdef SQLITE_OMIT_FLOATING_POINT
+#else
+#endif
+  [OP_IsNull] = &&L_OP_IsNull,
+  [OP_NotNull] = &&L_OP_NotNull,
+#ifndef SQLITE_OMIT_SUPERINSTRUCTIONS
+  [OP_ColumnCol] = &&L_OP_ColumnCol,
+  [OP_ColumnCmp] = &&L_OP_ColumnCmp,
+  [OP_ColumnRange] = &&L_OP_ColumnRange,
+#endif
+  [OP_Column] = &&L_OP_Column,
+#ifndef SQLITE_OMIT_SUPERINSTRUCTIONS
+#endif
+#ifndef SQLITE_OMIT_VIRTUALTABLE
+#endif
+#ifndef SQLITE_OMIT_HASH_JOIN
+#endif
+#ifndef SQLITE_OMIT_SUPERINSTRUCTIONS
+#endif
+#ifndef SQLITE_OMIT_SUPERINSTRUCTIONS
+#endif
+  [OP_Affinity] = &&L_OP_Affinity,
+  [OP_MakeRecord] = &&L_OP_MakeRecord,
+#ifndef SQLITE_OMIT_BTREECOUNT
+  [OP_Count] = &&L_OP_Count,
+#endif
+  [OP_Savepoint] = &&L_OP_Savepoint,
+#ifndef SQLITE_OMIT_VIRTUALTABLE
+#endif
+  [OP_AutoCommit] = &&L_OP_AutoCommit,
+#if 0
+#endif
+  [OP_Transaction] = &&L_OP_Transaction,
+  [OP_ReadCookie] = &&L_OP_ReadCookie,
+  [OP_SetCookie] = &&L_OP_SetCookie,
+  [OP_VerifyCookie] = &&L_OP_VerifyCookie,
+  [OP_OpenRead] = &&L_OP_OpenRead,
+  [OP_OpenWrite] = &&L_OP_OpenWrite,
+#ifndef SQLITE_OMIT_STMT_PROFILE
+#endif
+  [OP_OpenAutoindex] = &&L_OP_OpenAutoindex,
+  [OP_OpenEphemeral] = &&L_OP_OpenEphemeral,
+#ifndef SQLITE_OMIT_STMT_PROFILE
+#endif
+  [OP_SorterOpen] = &&L_OP_SorterOpen,
+#ifndef SQLITE_OMIT_MERGE_SORT
+#else
+#endif
+  [OP_OpenPseudo] = &&L_OP_OpenPseudo,
+  [OP_Close] = &&L_OP_Close,
+  [OP_SeekLt] = &&L_OP_SeekLt,
+  [OP_SeekLe] = &&L_OP_SeekLe,
+  [OP_SeekGe] = &&L_OP_SeekGe,
+  [OP_SeekGt] = &&L_OP_SeekGt,
+#ifdef SQLITE_DEBUG
+#endif
+#ifdef SQLITE_TEST
+#endif
+  [OP_Seek] = &&L_OP_Seek,
+  [OP_NotFound] = &&L_OP_NotFound,
+  [OP_Found] = &&L_OP_Found,
+#ifdef SQLITE_TEST
+#endif
+#ifdef SQLITE_DEBUG
+#endif
+  [OP_IsUnique] = &&L_OP_IsUnique,
+#ifdef SQLITE_DEBUG
+#endif
+  [OP_NotExists] = &&L_OP_NotExists,
+  [OP_Sequence] = &&L_OP_Sequence,
+  [OP_NewRowid] = &&L_OP_NewRowid,
+#ifdef SQLITE_32BIT_ROWID
+#else
+#endif
+#ifndef SQLITE_OMIT_AUTOINCREMENT
+#endif
+  [OP_Insert] = &&L_OP_Insert,
+  [OP_InsertInt] = &&L_OP_InsertInt,
+  [OP_Delete] = &&L_OP_Delete,
+  [OP_ResetCount] = &&L_OP_ResetCount,
+  [OP_SorterCompare] = &&L_OP_SorterCompare,
+  [OP_SorterData] = &&L_OP_SorterData,
+#ifndef SQLITE_OMIT_MERGE_SORT
+#else
+#endif
+  [OP_RowKey] = &&L_OP_RowKey,
+  [OP_RowData] = &&L_OP_RowData,
+  [OP_Rowid] = &&L_OP_Rowid,
+#ifndef SQLITE_OMIT_VIRTUALTABLE
+#endif /* SQLITE_OMIT_VIRTUALTABLE */
+  [OP_NullRow] = &&L_OP_NullRow,
+  [OP_Last] = &&L_OP_Last,
+  [OP_SorterSort] = &&L_OP_SorterSort,
+#ifdef SQLITE_OMIT_MERGE_SORT
+#endif
+  [OP_Sort] = &&L_OP_Sort,
+#ifdef SQLITE_TEST
+#endif
+  [OP_Rewind] = &&L_OP_Rewind,
+  [OP_SorterNext] = &&L_OP_SorterNext,
+#ifdef SQLITE_OMIT_MERGE_SORT
+#endif
+#ifndef SQLITE_OMIT_SUPERINSTRUCTIONS
+  [OP_NextCol] = &&L_OP_NextCol,
+#endif
+  [OP_Prev] = &&L_OP_Prev,
+  [OP_Next] = &&L_OP_Next,
+#ifdef SQLITE_TEST
+#endif
+#ifndef SQLITE_OMIT_SUPERINSTRUCTIONS
+#endif
+  [OP_SorterInsert] = &&L_OP_SorterInsert,
+#ifdef SQLITE_OMIT_MERGE_SORT
+#endif
+  [OP_IdxInsert] = &&L_OP_IdxInsert,
+  [OP_Destroy] = &&L_OP_Destroy,
+#ifndef SQLITE_OMIT_VIRTUALTABLE
+#else
+#endif
+#ifndef SQLITE_OMIT_AUTOVACUUM
+#endif
+  [OP_Clear] = &&L_OP_Clear,
+  [OP_CreateIndex] = &&L_OP_CreateIndex,
+  [OP_CreateTable] = &&L_OP_CreateTable,
+  [OP_ParseSchema] = &&L_OP_ParseSchema,
+#ifdef SQLITE_DEBUG
+#endif
+#if !defined(SQLITE_OMIT_ANALYZE)
+  [OP_LoadAnalysis] = &&L_OP_LoadAnalysis,
+#endif /* !defined(SQLITE_OMIT_ANALYZE) */
+  [OP_DropTable] = &&L_OP_DropTable,
+  [OP_DropIndex] = &&L_OP_DropIndex,
+  [OP_DropTrigger] = &&L_OP_DropTrigger,
+#ifndef SQLITE_OMIT_INTEGRITY_CHECK
+  [OP_IntegrityCk] = &&L_OP_IntegrityCk,
+#endif /* SQLITE_OMIT_INTEGRITY_CHECK */
+  [OP_RowSetAdd] = &&L_OP_RowSetAdd,
+  [OP_RowSetRead] = &&L_OP_RowSetRead,
+  [OP_RowSetTest] = &&L_OP_RowSetTest,
+#ifndef SQLITE_OMIT_TRIGGER
+  [OP_Program] = &&L_OP_Program,
+#ifndef SQLITE_OMIT_STMT_PROFILE
+#endif
+  [OP_Param] = &&L_OP_Param,
+#endif /* #ifndef SQLITE_OMIT_TRIGGER */
+#ifndef SQLITE_OMIT_FOREIGN_KEY
+  [OP_FkCounter] = &&L_OP_FkCounter,
+  [OP_FkIfZero] = &&L_OP_FkIfZero,
+#endif /* #ifndef SQLITE_OMIT_FOREIGN_KEY */
+#ifndef SQLITE_OMIT_AUTOINCREMENT
+  [OP_MemMax] = &&L_OP_MemMax,
+#endif /* SQLITE_OMIT_AUTOINCREMENT */
+  [OP_IfPos] = &&L_OP_IfPos,
+  [OP_IfNeg] = &&L_OP_IfNeg,
+  [OP_IfZero] = &&L_OP_IfZero,
+  [OP_AggStep] = &&L_OP_AggStep,
+  [OP_AggFinal] = &&L_OP_AggFinal,
+#ifndef SQLITE_OMIT_HASH_AGGREGATE
+  [OP_HashAggOpen] = &&L_OP_HashAggOpen,
+  [OP_HashAggFind] = &&L_OP_HashAggFind,
+  [OP_HashAggSave] = &&L_OP_HashAggSave,
+  [OP_HashAggRewind] = &&L_OP_HashAggRewind,
+  [OP_HashAggNext] = &&L_OP_HashAggNext,
+#endif /* SQLITE_OMIT_HASH_AGGREGATE */
+#ifndef SQLITE_OMIT_HASH_JOIN
+  [OP_HashJoinOpen] = &&L_OP_HashJoinOpen,
+  [OP_HashJoinInsert] = &&L_OP_HashJoinInsert,
+  [OP_HashJoinSeek] = &&L_OP_HashJoinSeek,
+  [OP_HashJoinNext] = &&L_OP_HashJoinNext,
+#endif /* SQLITE_OMIT_HASH_JOIN */
+#ifndef SQLITE_OMIT_BATCH_AGGREGATE
+  [OP_BatchAgg] = &&L_OP_BatchAgg,
+#endif /* SQLITE_OMIT_BATCH_AGGREGATE */
+#ifndef SQLITE_OMIT_WAL
+  [OP_Checkpoint] = &&L_OP_Checkpoint,
+#endif
+#ifndef SQLITE_OMIT_PRAGMA
+  [OP_JournalMode] = &&L_OP_JournalMode,
+#ifndef SQLITE_OMIT_WAL
+#endif /* ifndef SQLITE_OMIT_WAL */
+#endif /* SQLITE_OMIT_PRAGMA */
+#if !defined(SQLITE_OMIT_VACUUM) && !defined(SQLITE_OMIT_ATTACH)
+  [OP_Vacuum] = &&L_OP_Vacuum,
+#endif
+#if !defined(SQLITE_OMIT_AUTOVACUUM)
+  [OP_IncrVacuum] = &&L_OP_IncrVacuum,
+#endif
+  [OP_Expire] = &&L_OP_Expire,
+#ifndef SQLITE_OMIT_SHARED_CACHE
+  [OP_TableLock] = &&L_OP_TableLock,
+#endif /* SQLITE_OMIT_SHARED_CACHE */
+#ifndef SQLITE_OMIT_VIRTUALTABLE
+  [OP_VBegin] = &&L_OP_VBegin,
+#endif /* SQLITE_OMIT_VIRTUALTABLE */
+#ifndef SQLITE_OMIT_VIRTUALTABLE
+  [OP_VCreate] = &&L_OP_VCreate,
+#endif /* SQLITE_OMIT_VIRTUALTABLE */
+#ifndef SQLITE_OMIT_VIRTUALTABLE
+  [OP_VDestroy] = &&L_OP_VDestroy,
+#endif /* SQLITE_OMIT_VIRTUALTABLE */
+#ifndef SQLITE_OMIT_VIRTUALTABLE
+  [OP_VOpen] = &&L_OP_VOpen,
+#endif /* SQLITE_OMIT_VIRTUALTABLE */
+#ifndef SQLITE_OMIT_VIRTUALTABLE
+  [OP_VFilter] = &&L_OP_VFilter,
+#endif /* SQLITE_OMIT_VIRTUALTABLE */
+#ifndef SQLITE_OMIT_VIRTUALTABLE
+  [OP_VColumn] = &&L_OP_VColumn,
+#endif /* SQLITE_OMIT_VIRTUALTABLE */
+#ifndef SQLITE_OMIT_VIRTUALTABLE
+  [OP_VNext] = &&L_OP_VNext,
+#endif /* SQLITE_OMIT_VIRTUALTABLE */
+#ifndef SQLITE_OMIT_VIRTUALTABLE
+  [OP_VRename] = &&L_OP_VRename,
+#endif
+#ifndef SQLITE_OMIT_VIRTUALTABLE
+  [OP_VUpdate] = &&L_OP_VUpdate,
+#endif /* SQLITE_OMIT_VIRTUALTABLE */
+#ifndef  SQLITE_OMIT_PAGER_PRAGMAS
+  [OP_Pagecount] = &&L_OP_Pagecount,
+#endif
+#ifndef  SQLITE_OMIT_PAGER_PRAGMAS
+  [OP_MaxPgcnt] = &&L_OP_MaxPgcnt,
+#endif
+#ifndef SQLITE_OMIT_TRACE
+  [OP_Trace] = &&L_OP_Trace,
+#ifdef SQLITE_DEBUG
+#endif /* SQLITE_DEBUG */
+#endif
+  [OP_Noop] = &&L_OP_Noop,
+  [OP_Explain] = &&L_OP_Noop,
@@ -0,0 +1,829 @@
+/*
+** 2012 October 12
+**
+** The author disclaims copyright to this source code.  In place of
+** a legal notice, here is a blessing:
+**
+**    May you do good and not evil.
+**    May you find forgiveness for yourself and forgive others.
+**    May you share freely, never taking more than you give.
+**
+*************************************************************************
+** This file contains code for the in-memory hash tables used by the VDBE.
+**
+** The VdbeHashAgg object is used in concert with a VdbeCursor to compute
+** GROUP BY aggregates using a hash table instead of sorting every input
+** row. The VdbeHashJoin object is used in concert with a VdbeCursor to
+** implement an equi-join by probing a hash table built from the inner
+** table, instead of seeking a transient B-tree index.
+**
+** HASH AGGREGATES
+**
+** Each group in the table has a key of VdbeHashAgg.nKey values and a
+** block of VdbeHashAgg.nReg memory cells holding the accumulator state of
+** the group (the AggInfo_col and AggInfo_func registers of the query).
+** The state is swapped in and out of a fixed range of VM registers, so
+** that the existing OP_AggStep/OP_AggFinal code can be used unchanged:
+**
+**   OP_HashAggFind   locates (or creates) the group for the current key
+**                    and moves its state into the registers.
+**   OP_HashAggSave   moves the registers back into the current group.
+**   OP_HashAggRewind
+**   OP_HashAggNext   move the state of each group in turn into the
+**                    registers so that it can be finalized and output.
+**
+** The memory used by the table is limited to the same budget the sorter
+** uses for a single in-memory run (cache_size pages).  The memory held by
+** the state of each group is measured again each time it is saved, so a
+** group whose state grows is charged for it.  Once the budget is
+** exhausted no new groups are created.  Rows that belong to groups not
+** already in the table are reported to the caller, which spills them to
+** the external sorter and aggregates them using the usual sort-based
+** algorithm after the hash groups have been output.
+**
+** HASH JOINS
+**
+** The build side of a hash join is a set of records, each of which has
+** the join key as its left-most nKey fields (the same layout as a record
+** of an automatic index). Records are kept in an in-memory hash table on
+** the hash of their key. If the memory used by the records exceeds the
+** budget, they are all moved into a temporary B-tree index, and further
+** records are inserted into and probes answered from that index. In that
+** case the join costs about what the automatic index would have, plus the
+** work done on the hash table before the budget ran out.
+*/
+#include "sqliteInt.h"
+#include "vdbeInt.h"
+
+#if !defined(SQLITE_OMIT_HASH_AGGREGATE) || !defined(SQLITE_OMIT_HASH_JOIN)
+
+/*
+** Minimum number of pages worth of memory that a hash table may use.
+** This matches SORTER_MIN_WORKING in vdbesort.c.
+*/
+#define HASH_MIN_WORKING 10
+
+/*
+** Mix nByte bytes of data at z into hash value h.
+*/
+static u32 vdbeHashBytes(u32 h, const u8 *z, int nByte){
+  int i;
+  for(i=0; i<nByte; i++){
+    h = (h<<3) ^ (h>>29) ^ z[i];
+  }
+  return h;
+}
+
+/*
+** Mix the integer value iVal into hash value h.
+*/
+static u32 vdbeHashInt(u32 h, i64 iVal){
+  u32 x = (u32)iVal ^ (u32)(((u64)iVal)>>32);
+  x *= 0x9e3779b1;
+  return (h<<7) ^ (h>>25) ^ x;
+}
+
+/*
+** Return a hash of the nKey values in aKey[]. Values that compare equal
+** using sqlite3MemCompare() with a BINARY (or no) collating sequence
+** always hash to the same value. In particular a REAL that holds an
+** integer value hashes in the same way as the corresponding INTEGER.
+**
+** Text values are converted to the database encoding and zero-blobs are
+** expanded first, so that equal values have identical bytes. SQLITE_NOMEM
+** is returned if this fails.
+*/
+static int vdbeHashKey(sqlite3 *db, Mem *aKey, int nKey, u32 *piHash){
+  u32 h = 0;
+  int i;
+  for(i=0; i<nKey; i++){
+    Mem *p = &aKey[i];
+    int f = p->flags;
+    if( f & MEM_Null ){
+      h = vdbeHashInt(h, 0);
+    }else if( f & MEM_Int ){
+      h = vdbeHashInt(h, p->u.i);
+    }else if( f & MEM_Real ){
+      double r = p->r;
+      if( r>=-9.2e18 && r<=9.2e18 && (double)(i64)r==r ){
+        h = vdbeHashInt(h, (i64)r);
+      }else{
+        h = vdbeHashBytes(h, (const u8 *)&r, sizeof(r));
+      }
+    }else{
+      assert( f & (MEM_Str|MEM_Blob) );
+      if( f & MEM_Str ){
+        if( sqlite3VdbeChangeEncoding(p, ENC(db)) ) return SQLITE_NOMEM;
+      }else if( f & MEM_Zero ){
+        if( sqlite3VdbeMemExpandBlob(p) ) return SQLITE_NOMEM;
+      }
+      h = vdbeHashBytes(h, (const u8 *)p->z, p->n);
+    }
+  }
+  /* Mix the bits, so that the low bits used to select a hash slot depend
+  ** on every byte of the key, not just the last few. */
+  h ^= h>>16;
+  h *= 0x85ebca6b;
+  h ^= h>>13;
+  h *= 0xc2b2ae35;
+  h ^= h>>16;
+  *piHash = h;
+  return SQLITE_OK;
+}
+
+/*
+** Return the number of bytes of memory a hash table may use before it
+** stops growing (a hash aggregate) or starts spilling to disk (a hash
+** join). This is the same budget the sorter uses for one in-memory run.
+*/
+static i64 vdbeHashMaxByte(sqlite3 *db){
+  int pgsz;                       /* Page size of main database */
+  int mxCache;                    /* Cache size */
+
+  pgsz = sqlite3BtreeGetPageSize(db->aDb[0].pBt);
+  mxCache = db->aDb[0].pSchema->cache_size;
+  if( mxCache<HASH_MIN_WORKING ) mxCache = HASH_MIN_WORKING;
+  return (i64)mxCache * pgsz;
+}
+
+#endif /* !SQLITE_OMIT_HASH_AGGREGATE || !SQLITE_OMIT_HASH_JOIN */
+
+/************************** Hash aggregates *******************************/
+#ifndef SQLITE_OMIT_HASH_AGGREGATE
+
+typedef struct HashAggGroup HashAggGroup;
+
+/*
+** A single group.  The aKey[] and aReg[] arrays are allocated as part
+** of the same block of memory as the HashAggGroup structure itself.
+*/
+struct HashAggGroup {
+  u32 iHash;                      /* Hash of aKey[] */
+  HashAggGroup *pHashNext;        /* Next group in the same hash slot */
+  HashAggGroup *pNext;            /* Next group in order of creation */
+  Mem *aKey;                      /* Key values (nKey entries) */
+  Mem *aReg;                      /* Accumulator state (nReg entries) */
+  int nState;                     /* Bytes of aReg[] counted in nByte */
+};
+
+/*
+** Main hash aggregate structure. All groups are kept in memory.
+*/
+struct VdbeHashAgg {
+  int nKey;                       /* Number of key values per group */
+  int nReg;                       /* Number of state registers per group */
+  Mem *aReg;                      /* First VM register of the state block */
+  int nGroup;                     /* Number of groups in the table */
+  int nSlot;                      /* Number of entries in aSlot[] */
+  HashAggGroup **aSlot;           /* Hash table */
+  HashAggGroup *pFirst;           /* First group created */
+  HashAggGroup *pLast;            /* Last group created */
+  HashAggGroup *pCurrent;         /* Group whose state is in aReg[] */
+  i64 nByte;                      /* Approximate memory used by all groups */
+  i64 mxByte;                     /* Stop creating groups past this size */
+  u8 bFull;                       /* True once the budget has been reached */
+};
+
+/*
+** Initial number of slots in VdbeHashAgg.aSlot[].
+*/
+#define HASHAGG_INIT_SLOT 64
+
+/*
+** Return true if the key of group pGroup is equal to aKey[].
+*/
+static int vdbeHashAggKeyEq(HashAggGroup *pGroup, Mem *aKey, int nKey){
+  int i;
+  for(i=0; i<nKey; i++){
+    if( sqlite3MemCompare(&pGroup->aKey[i], &aKey[i], 0)!=0 ) return 0;
+  }
+  return 1;
+}
+
+/*
+** Double the size of the hash table. If a malloc fails the table is
+** left as it is (it still works, just with longer chains).
+*/
+static void vdbeHashAggRehash(sqlite3 *db, VdbeHashAgg *pHash){
+  int nNew = pHash->nSlot*2;
+  HashAggGroup **aNew;
+  HashAggGroup *pGroup;
+
+  aNew = (HashAggGroup **)sqlite3DbMallocZero(db, nNew*sizeof(HashAggGroup*));
+  if( aNew==0 ) return;
+  for(pGroup=pHash->pFirst; pGroup; pGroup=pGroup->pNext){
+    int iSlot = pGroup->iHash % nNew;
+    pGroup->pHashNext = aNew[iSlot];
+    aNew[iSlot] = pGroup;
+  }
+  sqlite3DbFree(db, pHash->aSlot);
+  pHash->aSlot = aNew;
+  pHash->nSlot = nNew;
+}
+
+/*
+** Return the approximate number of groups with nKey key values and nReg
+** state registers each that fit in the memory budget of a hash aggregate
+** table. This is used by the query planner to decide whether or not a
+** GROUP BY should be computed using a hash table.
+*/
+i64 sqlite3VdbeHashAggBudget(sqlite3 *db, int nKey, int nReg){
+  i64 nByte = sizeof(HashAggGroup) + (nKey+nReg)*sizeof(Mem);
+  return vdbeHashMaxByte(db) / nByte;
+}
+
+/*
+** Initialize the hash aggregate for cursor pCsr. Each group has a key
+** of nKey values and nReg state registers, which are swapped in and out
+** of registers aReg[0..nReg-1].
+*/
+int sqlite3VdbeHashAggInit(
+  sqlite3 *db,                    /* Database handle */
+  VdbeCursor *pCsr,               /* Cursor that will own the table */
+  Mem *aReg,                      /* First register of the state block */
+  int nReg,                       /* Number of state registers */
+  int nKey                        /* Number of key values */
+){
+  VdbeHashAgg *pHash;             /* The new hash table */
+
+  assert( pCsr->pHashAgg==0 && nKey>0 && nReg>0 );
+  pCsr->pHashAgg = pHash = sqlite3DbMallocZero(db, sizeof(VdbeHashAgg));
+  if( pHash==0 ) return SQLITE_NOMEM;
+  pHash->aSlot = (HashAggGroup **)sqlite3DbMallocZero(db,
+      HASHAGG_INIT_SLOT*sizeof(HashAggGroup*)
+  );
+  if( pHash->aSlot==0 ) return SQLITE_NOMEM;
+  pHash->nSlot = HASHAGG_INIT_SLOT;
+  pHash->nKey = nKey;
+  pHash->nReg = nReg;
+  pHash->aReg = aReg;
+  pHash->mxByte = vdbeHashMaxByte(db);
+  return SQLITE_OK;
+}
+
+/*
+** Release all memory used by the group pGroup, including the aggregate
+** contexts of any state that has not been finalized.
+*/
+static void vdbeHashAggGroupFree(sqlite3 *db, VdbeHashAgg *pHash,
+                                 HashAggGroup *pGroup){
+  int i;
+  for(i=0; i<pHash->nKey; i++) sqlite3VdbeMemRelease(&pGroup->aKey[i]);
+  for(i=0; i<pHash->nReg; i++) sqlite3VdbeMemRelease(&pGroup->aReg[i]);
+  sqlite3DbFree(db, pGroup);
+}
+
+/*
+** Free any hash aggregate table associated with cursor pCsr.
+*/
+void sqlite3VdbeHashAggClose(sqlite3 *db, VdbeCursor *pCsr){
+  VdbeHashAgg *pHash = pCsr->pHashAgg;
+  if( pHash ){
+    HashAggGroup *pGroup;
+    HashAggGroup *pNext;
+    for(pGroup=pHash->pFirst; pGroup; pGroup=pNext){
+      pNext = pGroup->pNext;
+      vdbeHashAggGroupFree(db, pHash, pGroup);
+    }
+    sqlite3DbFree(db, pHash->aSlot);
+    sqlite3DbFree(db, pHash);
+    pCsr->pHashAgg = 0;
+  }
+}
+
+/*
+** Move the state of group pGroup into the state registers.
+*/
+static void vdbeHashAggLoad(VdbeHashAgg *pHash, HashAggGroup *pGroup){
+  int i;
+  for(i=0; i<pHash->nReg; i++){
+    sqlite3VdbeMemMove(&pHash->aReg[i], &pGroup->aReg[i]);
+  }
+  pHash->pCurrent = pGroup;
+}
+
+/*
+** Find the group with key aKey[0..nKey-1], creating it if necessary, and
+** move its state into the state registers. Text key values are converted
+** to the database encoding before hashing.
+**
+** If the group does not exist and the memory budget has been reached,
+** the registers are not modified and *pbFull is set to true. Otherwise
+** *pbFull is set to false.
+*/
+int sqlite3VdbeHashAggFind(
+  sqlite3 *db,                    /* Database handle */
+  const VdbeCursor *pCsr,         /* Hash aggregate cursor */
+  Mem *aKey,                      /* Key values */
+  int *pbFull                     /* OUT: True if the group was not found */
+){
+  VdbeHashAgg *pHash = pCsr->pHashAgg;
+  HashAggGroup *pGroup;
+  u32 iHash;
+  int i;
+  int nByte;
+
+  assert( pHash && pHash->pCurrent==0 );
+  *pbFull = 0;
+  if( vdbeHashKey(db, aKey, pHash->nKey, &iHash) ) return SQLITE_NOMEM;
+  for(pGroup=pHash->aSlot[iHash % pHash->nSlot]; pGroup;
+      pGroup=pGroup->pHashNext){
+    if( pGroup->iHash==iHash && vdbeHashAggKeyEq(pGroup, aKey, pHash->nKey) ){
+      vdbeHashAggLoad(pHash, pGroup);
+      return SQLITE_OK;
+    }
+  }
+
+  if( pHash->bFull ){
+    *pbFull = 1;
+    return SQLITE_OK;
+  }
+
+  /* Create a new group. Its state starts out as all NULL values, which
+  ** is the same as the state left behind by resetAccumulator().  */
+  nByte = sizeof(HashAggGroup) + (pHash->nKey+pHash->nReg)*sizeof(Mem);
+  pGroup = (HashAggGroup *)sqlite3DbMallocZero(db, nByte);
+  if( pGroup==0 ) return SQLITE_NOMEM;
+  pGroup->iHash = iHash;
+  pGroup->aKey = (Mem *)&pGroup[1];
+  pGroup->aReg = &pGroup->aKey[pHash->nKey];
+  for(i=0; i<pHash->nKey+pHash->nReg; i++){
+    pGroup->aKey[i].flags = MEM_Null;
+    pGroup->aKey[i].db = db;
+  }
+  for(i=0; i<pHash->nKey; i++){
+    if( sqlite3VdbeMemCopy(&pGroup->aKey[i], &aKey[i]) ){
+      vdbeHashAggGroupFree(db, pHash, pGroup);
+      return SQLITE_NOMEM;
+    }
+    if( pGroup->aKey[i].zMalloc ){
+      nByte += sqlite3DbMallocSize(db, pGroup->aKey[i].zMalloc);
+    }
+  }
+  pGroup->pHashNext = pHash->aSlot[iHash % pHash->nSlot];
+  pHash->aSlot[iHash % pHash->nSlot] = pGroup;
+  if( pHash->pLast ){
+    pHash->pLast->pNext = pGroup;
+  }else{
+    pHash->pFirst = pGroup;
+  }
+  pHash->pLast = pGroup;
+  pHash->nGroup++;
+  pHash->nByte += nByte;
+  if( pHash->nByte>=pHash->mxByte ) pHash->bFull = 1;
+  if( pHash->nGroup>pHash->nSlot ) vdbeHashAggRehash(db, pHash);
+
+  for(i=0; i<pHash->nReg; i++){
+    sqlite3VdbeMemSetNull(&pHash->aReg[i]);
+  }
+  pHash->pCurrent = pGroup;
+  return SQLITE_OK;
+}
+
+/*
+** Move the contents of the state registers back into the group most
+** recently located by sqlite3VdbeHashAggFind(), and charge the memory
+** now held by its state (including aggregate contexts) to the budget.
+*/
+void sqlite3VdbeHashAggSave(const VdbeCursor *pCsr){
+  VdbeHashAgg *pHash = pCsr->pHashAgg;
+  HashAggGroup *pGroup = pHash->pCurrent;
+  int i;
+  int nState = 0;
+  assert( pGroup );
+  for(i=0; i<pHash->nReg; i++){
+    Mem *pMem = &pGroup->aReg[i];
+    sqlite3VdbeMemMove(pMem, &pHash->aReg[i]);
+    if( pMem->zMalloc ){
+      nState += sqlite3DbMallocSize(pMem->db, pMem->zMalloc);
+    }
+  }
+  pHash->nByte += nState - pGroup->nState;
+  pGroup->nState = nState;
+  if( pHash->nByte>=pHash->mxByte ) pHash->bFull = 1;
+  pHash->pCurrent = 0;
+}
+
+/*
+** Move the state of the first group into the state registers. Set *pbEof
+** to true if the table contains no groups.
+*/
+int sqlite3VdbeHashAggRewind(const VdbeCursor *pCsr, int *pbEof){
+  VdbeHashAgg *pHash = pCsr->pHashAgg;
+  assert( pHash->pCurrent==0 );
+  if( pHash->pFirst==0 ){
+    *pbEof = 1;
+  }else{
+    *pbEof = 0;
+    vdbeHashAggLoad(pHash, pHash->pFirst);
+  }
+  return SQLITE_OK;
+}
+
+/*
+** Advance to the next group and move its state into the state registers,
+** overwriting the (finalized) state of the previous group. Set *pbEof to
+** true if there are no more groups.
+*/
+int sqlite3VdbeHashAggNext(const VdbeCursor *pCsr, int *pbEof){
+  VdbeHashAgg *pHash = pCsr->pHashAgg;
+  HashAggGroup *pNext;
+  assert( pHash->pCurrent );
+  pNext = pHash->pCurrent->pNext;
+  if( pNext==0 ){
+    pHash->pCurrent = 0;
+    *pbEof = 1;
+  }else{
+    *pbEof = 0;
+    vdbeHashAggLoad(pHash, pNext);
+  }
+  return SQLITE_OK;
+}
+
+#endif /* #ifndef SQLITE_OMIT_HASH_AGGREGATE */
+
+/***************************** Hash joins *********************************/
+#ifndef SQLITE_OMIT_HASH_JOIN
+
+typedef struct HashJoinEntry HashJoinEntry;
+
+/*
+** Initial number of slots in VdbeHashJoin.aSlot[].
+*/
+#define HASHJOIN_INIT_SLOT 64
+
+/*
+** A single build-side record. For records in the hash table, aRec points
+** to the space immediately following this structure. Once the table has
+** been moved to a B-tree, VdbeHashJoin.sEntry describes the current
+** B-tree entry and its aRec points to VdbeHashJoin.aBuf.
+*/
+struct HashJoinEntry {
+  u32 iHash;                      /* Hash of the key fields */
+  int nRec;                       /* Size of aRec[] in bytes */
+  u8 *aRec;                       /* The record */
+  HashJoinEntry *pNext;           /* Next entry in the same hash slot */
+};
+
+/*
+** Main hash join structure. The records are held in the hash table aSlot[]
+** until their size exceeds the memory budget, and in the temporary B-tree
+** index pBt from then on.
+*/
+struct VdbeHashJoin {
+  int nKey;                       /* Number of key fields per record */
+  int nEntry;                     /* Number of entries in aSlot[] */
+  int nSlot;                      /* Number of slots in aSlot[] */
+  HashJoinEntry **aSlot;          /* Hash table */
+  i64 nByte;                      /* Memory used by all entries */
+  i64 mxByte;                     /* Move to a B-tree past this size */
+  UnpackedRecord *pProbe;         /* The key of the current probe */
+  u32 iProbeHash;                 /* Hash of pProbe */
+  HashJoinEntry *pCurrent;        /* Current entry, or NULL */
+  Btree *pBt;                     /* Temporary B-tree index, or NULL */
+  BtCursor *pCursor;              /* Cursor open on pBt, or NULL */
+  HashJoinEntry sEntry;           /* Current entry of pCursor */
+  u8 *aBuf;                       /* Copy of the key of sEntry */
+  int nBuf;                       /* Allocated size of aBuf[] */
+};
+
+/*
+** Return the approximate number of build-side rows with nColumn columns
+** each that fit in the memory budget of a hash join table. This is used by
+** the query planner to estimate whether or not a hash join will be moved
+** to a B-tree.
+*/
+i64 sqlite3VdbeHashJoinBudget(sqlite3 *db, int nColumn){
+  i64 nByte = sizeof(HashJoinEntry) + 8*(nColumn+1);
+  return vdbeHashMaxByte(db) / nByte;
+}
+
+/*
+** Initialize the hash join table for cursor pCsr. Records inserted into
+** the table have their join key in the left-most nKey fields, which are
+** compared using pCsr->pKeyInfo.
+*/
+int sqlite3VdbeHashJoinInit(sqlite3 *db, VdbeCursor *pCsr, int nKey){
+  VdbeHashJoin *pHash;
+  char *d;
+  int i;
+
+  assert( pCsr->pHashJoin==0 && pCsr->pKeyInfo && nKey>0 );
+  assert( nKey<=pCsr->pKeyInfo->nField );
+  pCsr->pHashJoin = pHash = sqlite3DbMallocZero(db, sizeof(VdbeHashJoin));
+  if( pHash==0 ) return SQLITE_NOMEM;
+  pHash->aSlot = (HashJoinEntry **)sqlite3DbMallocZero(db,
+      HASHJOIN_INIT_SLOT*sizeof(HashJoinEntry*)
+  );
+  if( pHash->aSlot==0 ) return SQLITE_NOMEM;
+  pHash->nSlot = HASHJOIN_INIT_SLOT;
+  pHash->nKey = nKey;
+  pHash->mxByte = vdbeHashMaxByte(db);
+  pHash->pProbe = sqlite3VdbeAllocUnpackedRecord(pCsr->pKeyInfo, 0, 0, &d);
+  if( pHash->pProbe==0 ) return SQLITE_NOMEM;
+  assert( pHash->pProbe==(UnpackedRecord *)d );
+  pHash->pProbe->nField = (u16)nKey;
+  pHash->pProbe->flags = UNPACKED_PREFIX_MATCH;
+  for(i=0; i<nKey; i++){
+    Mem *pMem = &pHash->pProbe->aMem[i];
+    memset(pMem, 0, sizeof(Mem));
+    pMem->flags = MEM_Null;
+    pMem->db = db;
+  }
+  return SQLITE_OK;
+}
+
+/*
+** Free all entries of the hash table of pHash, and the table itself.
+*/
+static void vdbeHashJoinFreeEntries(sqlite3 *db, VdbeHashJoin *pHash){
+  int i;
+  for(i=0; i<pHash->nSlot; i++){
+    HashJoinEntry *p;
+    HashJoinEntry *pNext;
+    for(p=pHash->aSlot[i]; p; p=pNext){
+      pNext = p->pNext;
+      sqlite3DbFree(db, p);
+    }
+  }
+  sqlite3DbFree(db, pHash->aSlot);
+  pHash->aSlot = 0;
+  pHash->nSlot = 0;
+  pHash->nEntry = 0;
+  pHash->nByte = 0;
+}
+
+/*
+** Free any hash join table associated with cursor pCsr.
+*/
+void sqlite3VdbeHashJoinClose(sqlite3 *db, VdbeCursor *pCsr){
+  VdbeHashJoin *pHash = pCsr->pHashJoin;
+  if( pHash ){
+    int i;
+    vdbeHashJoinFreeEntries(db, pHash);
+    if( pHash->pCursor ){
+      sqlite3BtreeCloseCursor(pHash->pCursor);
+      sqlite3DbFree(db, pHash->pCursor);
+    }
+    if( pHash->pBt ){
+      sqlite3BtreeClose(pHash->pBt);
+    }
+    sqlite3_free(pHash->aBuf);
+    if( pHash->pProbe ){
+      for(i=0; i<pHash->nKey; i++){
+        sqlite3VdbeMemRelease(&pHash->pProbe->aMem[i]);
+      }
+      sqlite3DbFree(db, pHash->pProbe);
+    }
+    sqlite3DbFree(db, pHash);
+    pCsr->pHashJoin = 0;
+  }
+}
+
+/*
+** Double the number of slots in the hash table of pHash. If a malloc
+** fails the table is left as it is (it still works, just with longer
+** chains).
+*/
+static void vdbeHashJoinRehash(sqlite3 *db, VdbeHashJoin *pHash){
+  int nNew = pHash->nSlot*2;
+  HashJoinEntry **aNew;
+  int i;
+
+  aNew = (HashJoinEntry **)sqlite3DbMallocZero(db, nNew*sizeof(HashJoinEntry*));
+  if( aNew==0 ) return;
+  for(i=0; i<pHash->nSlot; i++){
+    HashJoinEntry *p;
+    HashJoinEntry *pNext;
+    for(p=pHash->aSlot[i]; p; p=pNext){
+      pNext = p->pNext;
+      p->pNext = aNew[p->iHash % nNew];
+      aNew[p->iHash % nNew] = p;
+    }
+  }
+  sqlite3DbFree(db, pHash->aSlot);
+  pHash->aSlot = aNew;
+  pHash->nSlot = nNew;
+}
+
+/*
+** Move all entries of the hash table of cursor pCsr into a new temporary
+** B-tree index, the same structure an automatic index uses, and free the
+** hash table. This is done once the table exceeds its memory budget. Each
+** probe then costs one B-tree seek, and the build side is written out
+** once, instead of spilled parts of it being read back again and again.
+*/
+static int vdbeHashJoinToBtree(sqlite3 *db, const VdbeCursor *pCsr){
+  static const int vfsFlags =
+      SQLITE_OPEN_READWRITE |
+      SQLITE_OPEN_CREATE |
+      SQLITE_OPEN_EXCLUSIVE |
+      SQLITE_OPEN_DELETEONCLOSE |
+      SQLITE_OPEN_TRANSIENT_DB;
+  VdbeHashJoin *pHash = pCsr->pHashJoin;
+  int pgno;
+  int rc;
+  int i;
+
+  assert( pHash->pBt==0 && pHash->pCursor==0 );
+  pHash->pCursor = (BtCursor *)sqlite3DbMallocRaw(db, sqlite3BtreeCursorSize());
+  if( pHash->pCursor==0 ) return SQLITE_NOMEM;
+  sqlite3BtreeCursorZero(pHash->pCursor);
+  rc = sqlite3BtreeOpen(db->pVfs, 0, db, &pHash->pBt,
+                        BTREE_OMIT_JOURNAL | BTREE_SINGLE, vfsFlags);
+  if( rc==SQLITE_OK ){
+    rc = sqlite3BtreeBeginTrans(pHash->pBt, 1);
+  }
+  if( rc==SQLITE_OK ){
+    rc = sqlite3BtreeCreateTable(pHash->pBt, &pgno, BTREE_BLOBKEY);
+  }
+  if( rc==SQLITE_OK ){
+    rc = sqlite3BtreeCursor(pHash->pBt, pgno, 1, pCsr->pKeyInfo,
+                            pHash->pCursor);
+  }
+  for(i=0; rc==SQLITE_OK && i<pHash->nSlot; i++){
+    HashJoinEntry *p;
+    for(p=pHash->aSlot[i]; rc==SQLITE_OK && p; p=p->pNext){
+      rc = sqlite3BtreeInsert(pHash->pCursor, p->aRec, p->nRec, 0, 0, 0, 0, 0);
+    }
+  }
+  vdbeHashJoinFreeEntries(db, pHash);
+  return rc;
+}
+
+/*
+** Add the record in pRec, whose key is held in aKey[0..nKey-1], to the
+** hash join table of cursor pCsr.
+*/
+int sqlite3VdbeHashJoinInsert(
+  sqlite3 *db,                    /* Database handle */
+  const VdbeCursor *pCsr,         /* Hash join cursor */
+  Mem *pRec,                      /* Record to insert */
+  Mem *aKey                       /* Key fields of pRec */
+){
+  VdbeHashJoin *pHash = pCsr->pHashJoin;
+  HashJoinEntry *pEntry;
+  u32 iHash;
+  int iSlot;
+  int nByte;
+
+  assert( pHash && (pRec->flags & MEM_Blob) );
+  if( pHash->pCursor ){
+    return sqlite3BtreeInsert(pHash->pCursor, pRec->z, pRec->n, 0, 0, 0, 0, 0);
+  }
+  if( vdbeHashKey(db, aKey, pHash->nKey, &iHash) ) return SQLITE_NOMEM;
+
+  nByte = sizeof(HashJoinEntry) + pRec->n;
+  pEntry = (HashJoinEntry *)sqlite3DbMallocRaw(db, nByte);
+  if( pEntry==0 ) return SQLITE_NOMEM;
+  pEntry->iHash = iHash;
+  pEntry->nRec = pRec->n;
+  pEntry->aRec = (u8 *)&pEntry[1];
+  memcpy(pEntry->aRec, pRec->z, pRec->n);
+  iSlot = iHash % pHash->nSlot;
+  pEntry->pNext = pHash->aSlot[iSlot];
+  pHash->aSlot[iSlot] = pEntry;
+  pHash->nEntry++;
+  pHash->nByte += sqlite3DbMallocSize(db, pEntry);
+  if( pHash->nByte>pHash->mxByte ){
+    return vdbeHashJoinToBtree(db, pCsr);
+  }
+  if( pHash->nEntry>pHash->nSlot ) vdbeHashJoinRehash(db, pHash);
+  return SQLITE_OK;
+}
+
+/*
+** Return true if entry pEntry matches the key of the current probe.
+*/
+static int vdbeHashJoinMatch(VdbeHashJoin *pHash, HashJoinEntry *pEntry){
+  return pEntry->iHash==pHash->iProbeHash
+      && sqlite3VdbeRecordCompare(pEntry->nRec, pEntry->aRec, pHash->pProbe)==0;
+}
+
+/*
+** The B-tree cursor of pHash has just been moved. If it points to an entry
+** that matches the key of the current probe, make that entry the current
+** entry and set *pRes to 0. Otherwise set *pRes to 1.
+*/
+static int vdbeHashJoinBtreeLoad(VdbeHashJoin *pHash, int *pRes){
+  BtCursor *pCur = pHash->pCursor;
+  i64 nKey;
+  int rc;
+
+  *pRes = 1;
+  pHash->pCurrent = 0;
+  if( sqlite3BtreeEof(pCur) ) return SQLITE_OK;
+  rc = sqlite3BtreeKeySize(pCur, &nKey);
+  if( rc!=SQLITE_OK ) return rc;
+  if( nKey>pHash->nBuf ){
+    u8 *aNew = (u8 *)sqlite3_realloc(pHash->aBuf, (int)nKey);
+    if( aNew==0 ) return SQLITE_NOMEM;
+    pHash->aBuf = aNew;
+    pHash->nBuf = (int)nKey;
+  }
+  rc = sqlite3BtreeKey(pCur, 0, (u32)nKey, pHash->aBuf);
+  if( rc!=SQLITE_OK ) return rc;
+  if( sqlite3VdbeRecordCompare((int)nKey, pHash->aBuf, pHash->pProbe)==0 ){
+    pHash->sEntry.nRec = (int)nKey;
+    pHash->sEntry.aRec = pHash->aBuf;
+    pHash->pCurrent = &pHash->sEntry;
+    *pRes = 0;
+  }
+  return SQLITE_OK;
+}
+
+/*
+** Search hash join table pCsr for the first record whose key matches
+** aKey[0..nKey-1]. Set *pRes to 0 if one is found, or to 1 otherwise.
+*/
+int sqlite3VdbeHashJoinSeek(
+  sqlite3 *db,                    /* Database handle */
+  const VdbeCursor *pCsr,         /* Hash join cursor */
+  Mem *aKey,                      /* Key to search for */
+  int *pRes                       /* OUT: 0 if a match was found */
+){
+  VdbeHashJoin *pHash = pCsr->pHashJoin;
+  HashJoinEntry *pEntry;
+  int i;
+
+  *pRes = 1;
+  pHash->pCurrent = 0;
+  for(i=0; i<pHash->nKey; i++){
+    if( sqlite3VdbeMemCopy(&pHash->pProbe->aMem[i], &aKey[i]) ){
+      return SQLITE_NOMEM;
+    }
+  }
+
+  if( vdbeHashKey(db, pHash->pProbe->aMem, pHash->nKey, &pHash->iProbeHash) ){
+    return SQLITE_NOMEM;
+  }
+
+  if( pHash->pCursor ){
+    /* Without UNPACKED_PREFIX_MATCH, a record whose key fields equal the
+    ** probe compares larger than it, so the cursor is left on or just
+    ** before the first match. */
+    int res = 0;
+    int rc;
+    pHash->pProbe->flags = 0;
+    rc = sqlite3BtreeMovetoUnpacked(pHash->pCursor, pHash->pProbe, 0, 0, &res);
+    pHash->pProbe->flags = UNPACKED_PREFIX_MATCH;
+    if( rc==SQLITE_OK && res<0 ){
+      rc = sqlite3BtreeNext(pHash->pCursor, &res);
+    }
+    if( rc==SQLITE_OK ){
+      rc = vdbeHashJoinBtreeLoad(pHash, pRes);
+    }
+    return rc;
+  }
+
+  for(pEntry=pHash->aSlot[pHash->iProbeHash % pHash->nSlot]; pEntry;
+      pEntry=pEntry->pNext){
+    if( vdbeHashJoinMatch(pHash, pEntry) ){
+      pHash->pCurrent = pEntry;
+      *pRes = 0;
+      break;
+    }
+  }
+  return SQLITE_OK;
+}
+
+/*
+** Advance to the next record whose key matches the key passed to the
+** most recent sqlite3VdbeHashJoinSeek(). Set *pRes to 0 if there is one,
+** or to 1 otherwise.
+*/
+int sqlite3VdbeHashJoinNext(const VdbeCursor *pCsr, int *pRes){
+  VdbeHashJoin *pHash = pCsr->pHashJoin;
+  HashJoinEntry *pEntry;
+
+  *pRes = 1;
+  if( pHash->pCurrent==0 ) return SQLITE_OK;
+  if( pHash->pCursor ){
+    int bEof = 0;
+    int rc = sqlite3BtreeNext(pHash->pCursor, &bEof);
+    if( rc==SQLITE_OK ){
+      rc = vdbeHashJoinBtreeLoad(pHash, pRes);
+    }
+    return rc;
+  }
+  for(pEntry=pHash->pCurrent->pNext; pEntry; pEntry=pEntry->pNext){
+    if( vdbeHashJoinMatch(pHash, pEntry) ) break;
+  }
+  pHash->pCurrent = pEntry;
+  if( pEntry ) *pRes = 0;
+  return SQLITE_OK;
+}
+
+/*
+** Return a pointer to the current record of hash join cursor pCsr and
+** set *pnRec to its size in bytes. The pointer remains valid until the
+** cursor is moved.
+*/
+const u8 *sqlite3VdbeHashJoinRecord(const VdbeCursor *pCsr, u32 *pnRec){
+  HashJoinEntry *pEntry = pCsr->pHashJoin->pCurrent;
+  assert( pEntry );
+  *pnRec = (u32)pEntry->nRec;
+  return pEntry->aRec;
+}
+
+#endif /* #ifndef SQLITE_OMIT_HASH_JOIN */
@@ -0,0 +1,409 @@
+/*
+** 2012 November 2
+**
+** The author disclaims copyright to this source code.  In place of
+** a legal notice, here is a blessing:
+**
+**    May you do good and not evil.
+**    May you find forgiveness for yourself and forgive others.
+**    May you share freely, never taking more than you give.
+**
+*************************************************************************
+** This file contains code used to collect per-opcode run-time profiles of
+** prepared statements, and the "stmt_profile" virtual table that is used
+** to read them.
+**
+** While PRAGMA stmt_profile is on, sqlite3VdbeExec() counts the number of
+** times each opcode of a statement is run, the number of times it jumps
+** and the CPU cycles spent in it (as measured by sqlite3Hwtime()). Each
+** b-tree cursor also counts the pages it loads, and adds the count to the
+** opcode that opened it when it is closed. The counters are kept in the
+** Vdbe.aOpStat[] array, which is allocated the first time the statement
+** is run with profiling enabled.
+**
+** Each time a statement is reset, sqlite3VdbeProfileSave() adds its
+** counters to a VdbeProfile object kept by the database connection in the
+** sqlite3.aStmtProfile hash table, keyed by the SQL text of the statement.
+** Only statements prepared with sqlite3_prepare_v2() or
+** sqlite3_prepare16_v2() have their SQL text available and are profiled.
+** If a statement is prepared again and its program has a different size,
+** the old profile is discarded. Trigger programs are not profiled.
+**
+** The profiles are read using a virtual table:
+**
+**   CREATE VIRTUAL TABLE temp.prof USING stmt_profile;
+**   SELECT sql, addr, opcode, calls, cycles FROM prof ORDER BY cycles DESC;
+**
+** The table has one row for each opcode of each profiled statement. For
+** an OP_Next or OP_Prev opcode, "jumps" is the number of rows the loop
+** visited after the first. For an OP_ResultRow opcode, "calls" is the
+** number of rows returned. For an opcode that opens a b-tree cursor
+** (OP_OpenRead, OP_OpenWrite, OP_OpenEphemeral or OP_OpenAutoindex),
+** "pages" is the number of pages the cursor loaded. The "cycles" column
+** is zero on platforms for which hwtime.h has no cycle counter.
+**
+** Setting PRAGMA stmt_profile to off discards all profiles.
+*/
+#include "sqliteInt.h"
+#include "vdbeInt.h"
+
+#ifndef SQLITE_OMIT_STMT_PROFILE
+
+typedef struct VdbeProfile VdbeProfile;
+typedef struct VdbeProfileOp VdbeProfileOp;
+
+/*
+** The profile of a single opcode.
+*/
+struct VdbeProfileOp {
+  u8 opcode;                      /* The opcode */
+  int p1, p2, p3;                 /* Operands of the opcode */
+  VdbeOpStat s;                   /* Counters */
+};
+
+/*
+** The profile of a single statement. The SQL text is stored in the same
+** allocation, following aOp[nOp-1].
+*/
+struct VdbeProfile {
+  char *zSql;                     /* SQL text, the hash table key */
+  int nSql;                       /* Length of zSql in bytes */
+  int nByte;                      /* Size of this allocation */
+  u64 nRun;                       /* Number of runs profiled */
+  int nOp;                        /* Number of entries in aOp[] */
+  VdbeProfileOp aOp[1];           /* One entry for each opcode */
+};
+
+/*
+** Add the counters in p->aOpStat[] to the profile of statement p, then
+** zero them. Nothing is added if PRAGMA stmt_profile has been turned off
+** since the statement was run, or if the statement has no SQL text.
+*/
+void sqlite3VdbeProfileSave(Vdbe *p){
+  sqlite3 *db = p->db;
+  int i;
+
+  assert( p->aOpStat );
+  if( db->bStmtProfile && p->zSql && p->nOp>0 ){
+    int nSql = sqlite3Strlen30(p->zSql);
+    VdbeProfile *pProf;
+
+    pProf = (VdbeProfile*)sqlite3HashFind(&db->aStmtProfile, p->zSql, nSql);
+    if( pProf && (pProf->nOp!=p->nOp || strcmp(pProf->zSql, p->zSql)) ){
+      sqlite3HashInsert(&db->aStmtProfile, pProf->zSql, pProf->nSql, 0);
+      sqlite3_free(pProf);
+      pProf = 0;
+    }
+    if( pProf==0 ){
+      int nByte = sizeof(VdbeProfile) + (p->nOp-1)*sizeof(VdbeProfileOp)
+                + nSql + 1;
+      pProf = (VdbeProfile*)sqlite3MallocZero(nByte);
+      if( pProf ){
+        pProf->zSql = (char*)&pProf->aOp[p->nOp];
+        memcpy(pProf->zSql, p->zSql, nSql+1);
+        pProf->nSql = nSql;
+        pProf->nByte = nByte;
+        pProf->nOp = p->nOp;
+        for(i=0; i<p->nOp; i++){
+          VdbeOp *pOp = &p->aOp[i];
+          pProf->aOp[i].opcode = pOp->opcode;
+          pProf->aOp[i].p1 = pOp->p1;
+          pProf->aOp[i].p2 = pOp->p2;
+          pProf->aOp[i].p3 = pOp->p3;
+        }
+        if( pProf==sqlite3HashInsert(&db->aStmtProfile, pProf->zSql, nSql,
+                                     pProf) ){
+          /* Malloc failed within the hash table */
+          sqlite3_free(pProf);
+          pProf = 0;
+        }
+      }
+    }
+    if( pProf ){
+      pProf->nRun++;
+      for(i=0; i<p->nOp; i++){
+        VdbeOpStat *pTo = &pProf->aOp[i].s;
+        VdbeOpStat *pFrom = &p->aOpStat[i];
+        pTo->nExec += pFrom->nExec;
+        pTo->nCycle += pFrom->nCycle;
+        pTo->nJump += pFrom->nJump;
+        pTo->nPage += pFrom->nPage;
+      }
+    }
+  }
+  memset(p->aOpStat, 0, p->nOp*sizeof(VdbeOpStat));
+}
+
+/*
+** Discard all statement profiles collected by database connection db.
+*/
+void sqlite3VdbeProfileClear(sqlite3 *db){
+  HashElem *pElem;
+  for(pElem=sqliteHashFirst(&db->aStmtProfile); pElem;
+      pElem=sqliteHashNext(pElem)){
+    sqlite3_free(sqliteHashData(pElem));
+  }
+  sqlite3HashClear(&db->aStmtProfile);
+}
+
+#ifndef SQLITE_OMIT_VIRTUALTABLE
+
+#define VTAB_SCHEMA                                                          \
+  "CREATE TABLE xx( "                                                        \
+  "  sql        STRING,           /* SQL text of the statement */"           \
+  "  addr       INTEGER,          /* Address of the opcode */"               \
+  "  opcode     STRING,           /* Name of the opcode */"                  \
+  "  p1         INTEGER,          /* First operand */"                       \
+  "  p2         INTEGER,          /* Second operand */"                      \
+  "  p3         INTEGER,          /* Third operand */"                       \
+  "  runs       INTEGER,          /* Number of times the statement ran */"   \
+  "  calls      INTEGER,          /* Number of times the opcode ran */"      \
+  "  cycles     INTEGER,          /* CPU cycles spent in the opcode */"      \
+  "  jumps      INTEGER,          /* Number of times the opcode jumped */"   \
+  "  pages      INTEGER           /* Pages loaded by the opened cursor */"   \
+  ");"
+
+typedef struct ProfileTable ProfileTable;
+typedef struct ProfileCursor ProfileCursor;
+
+struct ProfileTable {
+  sqlite3_vtab base;
+  sqlite3 *db;
+};
+
+/*
+** A cursor iterates through a copy of the profiles taken by xFilter, as
+** the profiles themselves may be modified or freed while it is open.
+*/
+struct ProfileCursor {
+  sqlite3_vtab_cursor base;
+  VdbeProfile **apProf;           /* Copies of all profiles */
+  int nProf;                      /* Number of entries in apProf[] */
+  int iProf;                      /* Current profile */
+  int iOp;                        /* Current opcode of profile iProf */
+  sqlite3_int64 iRowid;           /* Rowid of current row */
+};
+
+/*
+** Connect to or create a stmt_profile virtual table.
+*/
+static int profileConnect(
+  sqlite3 *db,
+  void *pAux,
+  int argc, const char *const*argv,
+  sqlite3_vtab **ppVtab,
+  char **pzErr
+){
+  ProfileTable *pTab;
+  int rc;
+
+  pTab = (ProfileTable *)sqlite3_malloc(sizeof(ProfileTable));
+  if( pTab==0 ) return SQLITE_NOMEM;
+  memset(pTab, 0, sizeof(ProfileTable));
+  pTab->db = db;
+
+  rc = sqlite3_declare_vtab(db, VTAB_SCHEMA);
+  if( rc!=SQLITE_OK ){
+    sqlite3_free(pTab);
+    return rc;
+  }
+  *ppVtab = &pTab->base;
+  return SQLITE_OK;
+}
+
+/*
+** Disconnect from or destroy a stmt_profile virtual table.
+*/
+static int profileDisconnect(sqlite3_vtab *pVtab){
+  sqlite3_free(pVtab);
+  return SQLITE_OK;
+}
+
+/*
+** There is no "best-index". This virtual table always does a linear
+** scan of the profiles.
+*/
+static int profileBestIndex(sqlite3_vtab *tab, sqlite3_index_info *pIdxInfo){
+  pIdxInfo->estimatedCost = 1000.0;
+  return SQLITE_OK;
+}
+
+/*
+** Open a new stmt_profile cursor.
+*/
+static int profileOpen(sqlite3_vtab *pVTab, sqlite3_vtab_cursor **ppCursor){
+  ProfileCursor *pCsr;
+
+  pCsr = (ProfileCursor *)sqlite3_malloc(sizeof(ProfileCursor));
+  if( pCsr==0 ) return SQLITE_NOMEM;
+  memset(pCsr, 0, sizeof(ProfileCursor));
+  pCsr->base.pVtab = pVTab;
+  *ppCursor = (sqlite3_vtab_cursor *)pCsr;
+  return SQLITE_OK;
+}
+
+static void profileResetCsr(ProfileCursor *pCsr){
+  int i;
+  for(i=0; i<pCsr->nProf; i++){
+    sqlite3_free(pCsr->apProf[i]);
+  }
+  sqlite3_free(pCsr->apProf);
+  pCsr->apProf = 0;
+  pCsr->nProf = 0;
+  pCsr->iProf = 0;
+  pCsr->iOp = 0;
+  pCsr->iRowid = 0;
+}
+
+/*
+** Close a stmt_profile cursor.
+*/
+static int profileClose(sqlite3_vtab_cursor *pCursor){
+  ProfileCursor *pCsr = (ProfileCursor *)pCursor;
+  profileResetCsr(pCsr);
+  sqlite3_free(pCsr);
+  return SQLITE_OK;
+}
+
+static int profileNext(sqlite3_vtab_cursor *pCursor){
+  ProfileCursor *pCsr = (ProfileCursor *)pCursor;
+  pCsr->iRowid++;
+  pCsr->iOp++;
+  if( pCsr->iOp>=pCsr->apProf[pCsr->iProf]->nOp ){
+    pCsr->iProf++;
+    pCsr->iOp = 0;
+  }
+  return SQLITE_OK;
+}
+
+static int profileEof(sqlite3_vtab_cursor *pCursor){
+  ProfileCursor *pCsr = (ProfileCursor *)pCursor;
+  return pCsr->iProf>=pCsr->nProf;
+}
+
+static int profileFilter(
+  sqlite3_vtab_cursor *pCursor,
+  int idxNum, const char *idxStr,
+  int argc, sqlite3_value **argv
+){
+  ProfileCursor *pCsr = (ProfileCursor *)pCursor;
+  sqlite3 *db = ((ProfileTable *)pCursor->pVtab)->db;
+  Hash *pHash = &db->aStmtProfile;
+  HashElem *pElem;
+  int n = 0;
+
+  profileResetCsr(pCsr);
+  if( pHash->count==0 ) return SQLITE_OK;
+  pCsr->apProf = (VdbeProfile **)sqlite3_malloc(
+      pHash->count*sizeof(VdbeProfile *)
+  );
+  if( pCsr->apProf==0 ) return SQLITE_NOMEM;
+  for(pElem=sqliteHashFirst(pHash); pElem; pElem=sqliteHashNext(pElem)){
+    VdbeProfile *pProf = (VdbeProfile *)sqliteHashData(pElem);
+    VdbeProfile *pCopy = (VdbeProfile *)sqlite3_malloc(pProf->nByte);
+    if( pCopy==0 ){
+      pCsr->nProf = n;
+      profileResetCsr(pCsr);
+      return SQLITE_NOMEM;
+    }
+    memcpy(pCopy, pProf, pProf->nByte);
+    pCopy->zSql = (char*)&pCopy->aOp[pCopy->nOp];
+    pCsr->apProf[n++] = pCopy;
+  }
+  pCsr->nProf = n;
+  return SQLITE_OK;
+}
+
+static int profileColumn(
+  sqlite3_vtab_cursor *pCursor,
+  sqlite3_context *ctx,
+  int i
+){
+  ProfileCursor *pCsr = (ProfileCursor *)pCursor;
+  VdbeProfile *pProf = pCsr->apProf[pCsr->iProf];
+  VdbeProfileOp *pOp = &pProf->aOp[pCsr->iOp];
+  switch( i ){
+    case 0:            /* sql */
+      sqlite3_result_text(ctx, pProf->zSql, pProf->nSql, SQLITE_TRANSIENT);
+      break;
+    case 1:            /* addr */
+      sqlite3_result_int(ctx, pCsr->iOp);
+      break;
+    case 2:            /* opcode */
+#if !defined(SQLITE_OMIT_EXPLAIN) || !defined(NDEBUG) \
+     || defined(VDBE_PROFILE) || defined(SQLITE_DEBUG)
+      sqlite3_result_text(ctx, sqlite3OpcodeName(pOp->opcode), -1,
+                          SQLITE_STATIC);
+#endif
+      break;
+    case 3:            /* p1 */
+      sqlite3_result_int(ctx, pOp->p1);
+      break;
+    case 4:            /* p2 */
+      sqlite3_result_int(ctx, pOp->p2);
+      break;
+    case 5:            /* p3 */
+      sqlite3_result_int(ctx, pOp->p3);
+      break;
+    case 6:            /* runs */
+      sqlite3_result_int64(ctx, (sqlite3_int64)pProf->nRun);
+      break;
+    case 7:            /* calls */
+      sqlite3_result_int64(ctx, (sqlite3_int64)pOp->s.nExec);
+      break;
+    case 8:            /* cycles */
+      sqlite3_result_int64(ctx, (sqlite3_int64)pOp->s.nCycle);
+      break;
+    case 9:            /* jumps */
+      sqlite3_result_int64(ctx, (sqlite3_int64)pOp->s.nJump);
+      break;
+    case 10:           /* pages */
+      sqlite3_result_int64(ctx, (sqlite3_int64)pOp->s.nPage);
+      break;
+  }
+  return SQLITE_OK;
+}
+
+static int profileRowid(sqlite3_vtab_cursor *pCursor, sqlite_int64 *pRowid){
+  ProfileCursor *pCsr = (ProfileCursor *)pCursor;
+  *pRowid = pCsr->iRowid;
+  return SQLITE_OK;
+}
+
+#endif /* SQLITE_OMIT_VIRTUALTABLE */
+
+/*
+** Register the stmt_profile virtual table module with database connection
+** db. This is called by openDatabase().
+*/
+int sqlite3VdbeProfileInit(sqlite3 *db){
+  int rc = SQLITE_OK;
+#ifndef SQLITE_OMIT_VIRTUALTABLE
+  static sqlite3_module profile_module = {
+    0,                            /* iVersion */
+    profileConnect,               /* xCreate */
+    profileConnect,               /* xConnect */
+    profileBestIndex,             /* xBestIndex */
+    profileDisconnect,            /* xDisconnect */
+    profileDisconnect,            /* xDestroy */
+    profileOpen,                  /* xOpen - open a cursor */
+    profileClose,                 /* xClose - close a cursor */
+    profileFilter,                /* xFilter - configure scan constraints */
+    profileNext,                  /* xNext - advance a cursor */
+    profileEof,                   /* xEof - check for end of scan */
+    profileColumn,                /* xColumn - read data */
+    profileRowid,                 /* xRowid - read data */
+    0,                            /* xUpdate */
+    0,                            /* xBegin */
+    0,                            /* xSync */
+    0,                            /* xCommit */
+    0,                            /* xRollback */
+    0,                            /* xFindMethod */
+    0,                            /* xRename */
+  };
+  rc = sqlite3_create_module(db, "stmt_profile", &profile_module, 0);
+#endif
+  return rc;
+}
+
+#endif /* SQLITE_OMIT_STMT_PROFILE */
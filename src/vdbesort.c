@@ -23,6 +23,8 @@
 typedef struct VdbeSorterIter VdbeSorterIter;//an iterator for a PMA
 typedef struct SorterRecord SorterRecord;//sorter记录
 typedef struct FileWriter FileWriter;//用来往文件中进行写操作的结构体
+typedef struct SorterMerger SorterMerger;
+typedef struct SorterThread SorterThread;
 
 /*
 ** NOTES ON DATA STRUCTURE USED FOR N-WAY MERGES:——N路归并算法及数据结构说明
@@ -114,24 +116,57 @@ typedef struct FileWriter FileWriter;//用来往文件中进行写操作的结
 　　也就是说，我们每次前进到ｓｏｒｔｅｒ的下一个元素，需要做log2(N)次的ｋｅｙ值比较，这里Ｎ是要被合并的段的数量
 　　
 */
+
+/*
+** NOTES ON WORKER THREADS:
+**
+** If the SQLITE_LIMIT_WORKER_THREADS limit of the database connection is
+** greater than zero (see "PRAGMA threads"), the sorter uses up to that
+** many auxiliary threads.  Each thread owns a SorterThread slot with its
+** own temporary file.  When the in-memory list grows large enough to be
+** flushed, it is handed to the next slot in round-robin order and that
+** slot's thread sorts it and appends it to its file as a PMA, while the
+** VDBE thread goes on accumulating the next list.
+**
+** When sqlite3VdbeSorterRewind() is called, each slot whose file holds
+** too many PMAs for a single final merge reduces them, again in its own
+** thread, using the multi-pass merge described above.  The final merge
+** of the remaining (at most SORTER_MAX_MERGE_COUNT) PMAs is performed
+** incrementally by the VDBE thread as sqlite3VdbeSorterNext() is called.
+**
+** Worker threads never touch the database connection.  They allocate
+** memory using sqlite3Malloc() and compare keys using a copy of the
+** cursor KeyInfo whose db field is NULL.  Any user-defined collation
+** sequences used by the sort must therefore be threadsafe.
+**
+** If SQLITE_LIMIT_WORKER_THREADS is zero, or if the library is not
+** threadsafe, there is a single slot and all the work is done by the
+** VDBE thread in exactly the same order.
+*/
 //结构体定义1：
 struct VdbeSorter {
-  i64 iWriteOff;                  /* Current write offset WITHIN FILE PTEMP1 ——文件ptemp1（存储PMA的文件）中，当前的写偏移量*/
-  i64 iReadOff;                   /* Current read offset within file pTemp1 ——文件ptemp1（PMA file 1）中，当前的读偏移量*/
   int nInMemory;                  /* Current size of pRecord list as PMA ——作为PMA的pRecord list的当前大小*/
-  int nTree;                      /* Used size of aTree/aIter (power of 2) ——aTree/aIter的已用大小（2的幂）*/
-  int nPMA;                       /* Number of PMAs stored in pTemp1 ——文件pTemp1中存储的PMA的数量*/
   int mnPmaSize;                  /* Minimum PMA size, in bytes */
   int mxPmaSize;                  /* Maximum PMA size, in bytes.  0==no limit */
-  VdbeSorterIter *aIter;          /* Array of iterators to merge ——存储要合并到一起的iterator的VdbeSorterIter类型的数组*/
-  int *aTree;                     /* Current state of incremental merge ——增量合并的当前状态*/
-  sqlite3_file *pTemp1;           /* PMA file 1 ——指向存储PMA的文件的指针*/
+  int pgsz;                       /* Main database page size (I/O buffer size) */
+  int bUsePMA;                    /* True if one or more PMAs have been written */
+  int nWorker;                    /* Number of auxiliary worker threads */
+  int nThread;                    /* Size of aThread[] (nWorker or 1) */
+  int iPrev;                      /* Slot that most recently received a list */
+  int eHeap;                      /* SORTER_HEAP_UNKNOWN, _ON or _OFF */
+  i64 nLimit;                     /* Records to retain in top-N mode */
+  int nHeap;                      /* Number of records in aHeap[] */
+  int nHeapAlloc;                 /* Allocated size of aHeap[] */
+  SorterRecord **aHeap;           /* Max-heap of retained records */
+  SorterThread *aThread;          /* Array of nThread PMA-writing slots */
+  SorterMerger *pMerger;          /* Final incremental merge, or NULL */
   SorterRecord *pRecord;          /* Head of in-memory record list ——内存中记录列表的头*/
   UnpackedRecord *pUnpacked;      /* Used to unpack keys ——用来解包keys*/
+  KeyInfo *pKeyInfo;              /* Copy of cursor KeyInfo for worker threads */
 };
 
 /*
-** The following type is an iterator for a PMA. It caches the current key in 
+** The following type is an iterator for a PMA. It caches the current key in
 ** variables nKey/aKey. If the iterator is at EOF, pFile（此指针所指的地方是ｉｔｅｒａｔｏｒ开始读的地方）==0.
 */
 //结构体定义2：
@@ -147,15 +182,63 @@ struct VdbeSorterIter {           /*★这是本源文件开头处声明的第1
   int nBuffer;                    /* Size of read buffer in bytes 读缓存的字节数*/
 };
 
+/*
+** An instance of this object is used to merge the keys read by up to
+** SORTER_MAX_MERGE_COUNT iterators into a single sorted stream, as
+** described by the "NOTES ON DATA STRUCTURE USED FOR N-WAY MERGES"
+** comment above. Each thread that merges PMAs uses its own merger.
+*/
+struct SorterMerger {
+  int nTree;                      /* Used size of aTree/aIter (power of 2) ——aTree/aIter的已用大小（2的幂）*/
+  int *aTree;                     /* Current state of incremental merge ——增量合并的当前状态*/
+  VdbeSorterIter *aIter;          /* Array of iterators to merge ——存储要合并到一起的iterator的VdbeSorterIter类型的数组*/
+  KeyInfo *pKeyInfo;              /* Used to compare keys */
+  UnpackedRecord *pUnpacked;      /* Used to unpack keys */
+};
+
+/*
+** Each VdbeSorter owns one or more of the following objects. Each one
+** represents a temporary file of PMAs and, if worker threads are in use,
+** the thread (if any) currently sorting or merging records into it.
+**
+** While pThread is not NULL, all fields other than pThread belong to the
+** worker thread. The VDBE thread may only access them after the worker
+** has been joined by vdbeSorterJoinThread().
+*/
+struct SorterThread {
+  SQLiteThread *pThread;          /* Running worker thread, or NULL */
+  int eWork;                      /* SORTER_THREAD_SORT or _REDUCE */
+  int rc;                         /* Result of the most recent job */
+  KeyInfo *pKeyInfo;              /* Used to compare keys */
+  UnpackedRecord *pUnpacked;      /* Used to unpack keys */
+  SorterRecord *pList;            /* List of records to sort and write */
+  int nInMemory;                  /* Size of pList as a PMA, in bytes */
+  int pgsz;                       /* Size of I/O buffers, in bytes */
+  int nTarget;                    /* Reduce the PMA count to this or fewer */
+  int nPMA;                       /* Number of PMAs stored in pTemp1 */
+  sqlite3_file *pTemp1;           /* File containing PMAs */
+  i64 iTemp1Off;                  /* Offset of end of last PMA in pTemp1 */
+  sqlite3_file *pTemp2;           /* Scratch file used by _REDUCE jobs */
+};
+
+/* Values for VdbeSorter.eHeap */
+#define SORTER_HEAP_UNKNOWN  0    /* Top-N mode not yet decided */
+#define SORTER_HEAP_ON       1    /* Records are kept in aHeap[] */
+#define SORTER_HEAP_OFF      2    /* Records are kept in pRecord */
+
+/* Values for SorterThread.eWork */
+#define SORTER_THREAD_SORT   1    /* Sort pList and append it to pTemp1 */
+#define SORTER_THREAD_REDUCE 2    /* Merge PMAs until nPMA<=nTarget */
+
 /*
 ** An instance of this structure is used to organize the stream of records
 ** being written to files by the merge-sort code into aligned, page-sized
 ** blocks.  Doing all I/O in aligned page-sized blocks helps I/O to go
 ** faster on many operating systems.
    下面这个结构体的实例用来组织记录流，这些记录流将按照mergecod的算法写入到文件中的对齐的、页面大小的块中。
-*/ 
+*/
 //结构体定义3：
-struct FileWriter {               /*★这是本源文件开头处声明的第3个结构体的定义
+struct FileWriter {               /*★这是本源文件开头处声明的第3个结构体的定义*/
   int eFWErr;                     /* Non-zero if in an error state 当处于错误状态时是个非零值*/
   u8 *aBuffer;                    /* Pointer to write buffer 指向写缓存的指针*/
   int nBuffer;                    /* Size of write buffer in bytes 写缓存的字节数*/
@@ -167,9 +250,12 @@ struct FileWriter {               /*★这是本源文件开头处声明的第3
 
 /*
 ** A structure to store a single record. All in-memory records are connected
-** together into a linked list headed at VdbeSorter.pRecord using the 
+** together into a linked list headed at VdbeSorter.pRecord using the
 ** SorterRecord.pNext pointer.
    下面这个结构体用来存储一个单独的记录。所有内存中的记录被连接成一个链表，链表的头SorterRecord *pRecord由指针SorterRecord *pNext指向。
+**
+** Records are allocated using sqlite3Malloc(), not sqlite3DbMallocRaw(),
+** as they may be freed by a worker thread.
 */
 //结构体定义4：
 struct SorterRecord {//*★这是本源文件开头处声明的第2个结构体的定义
@@ -185,14 +271,14 @@ struct SorterRecord {//*★这是本源文件开头处声明的第2个结构体
 #define SORTER_MAX_MERGE_COUNT 16//一趟算法里所允许归并的最大段数
 
 /*
-** Free all memory belonging to the VdbeSorterIter object passed as the second
+** Free all memory belonging to the VdbeSorterIter object passed as the
 ** argument. All structure fields are set to zero before returning.
-   释放由第二个参数VdbeSorterIter *pIter指向的VdbeSorterIter对象的内存空间
+   释放由参数VdbeSorterIter *pIter指向的VdbeSorterIter对象的内存空间
 */
-//函数定义1：该方法的功能就是释放由第二个参数VdbeSorterIter *pIter指向的VdbeSorterIter实例的内存空间
-static void vdbeSorterIterZero(sqlite3 *db, VdbeSorterIter *pIter){//该函数被定义的第十个函数调用了
-  sqlite3DbFree(db, pIter->aAlloc);
-  sqlite3DbFree(db, pIter->aBuffer);
+//函数定义1：该方法的功能就是释放由参数VdbeSorterIter *pIter指向的VdbeSorterIter实例的内存空间
+static void vdbeSorterIterZero(VdbeSorterIter *pIter){
+  sqlite3_free(pIter->aAlloc);
+  sqlite3_free(pIter->aBuffer);
   memset(pIter, 0, sizeof(VdbeSorterIter));
 }
 
@@ -210,7 +296,6 @@ static void vdbeSorterIterZero(sqlite3 *db, VdbeSorterIter *pIter){//该函数
 //下面是函数vdbeSorterIterRead()
 //函数定义2：
 static int vdbeSorterIterRead(
-  sqlite3 *db,                    /* Database handle (for malloc)针对malloc的数据库句柄 */
   VdbeSorterIter *p,              /* Iterator 迭代器的指针*/
   int nByte,                      /* Bytes of data to read 要读的数据的字节数*/
   u8 **ppOut                      /* OUT: Pointer to buffer containing data 指向包含数据的缓存的指针 */
@@ -220,9 +305,9 @@ static int vdbeSorterIterRead(
   int nAvail;                     /* Bytes of data available in buffer 缓存中可用的数据的字节数*/
   assert( p->aBuffer );
 
-  /* If there is no more data to be read from the buffer, read the next 
+  /* If there is no more data to be read from the buffer, read the next
   ** p->nBuffer bytes of data from the file into it. Or, if there are less
-  ** than p->nBuffer bytes remaining in the PMA, read all remaining data.  
+  ** than p->nBuffer bytes remaining in the PMA, read all remaining data.
      如果缓存中没有数据可读了，就从文件中读出接下来的大小等于nBuffer字节的数据存入缓存中，
 	 如果PMA中的字节数小于nBuffer，就把剩下的所有数据读出来。
   */
@@ -234,7 +319,7 @@ static int vdbeSorterIterRead(
     /* Determine how many bytes of data to read. 决定要读的字节数*/
     nRead = (int)(p->iEof - p->iReadOff);//这个差表示能读到的最大的数据量
     if( nRead>p->nBuffer ) nRead = p->nBuffer;//但是一次最多能读的数据量为缓存的容量，所以当能读到的最大的数据量>缓存容量时，令要从数据库中读的数据量大小大小等于缓存的容量。
-    
+
 	assert( nRead>0 );
 
     /* Read data from the file. Return early if an error occurs. 从文件中读数据，如果发生错误就提前返回*/
@@ -246,8 +331,8 @@ static int vdbeSorterIterRead(
 
   if( nByte<=nAvail ){//要读的数据的字节数小于或等于缓存中的可用的数据量
     /* The requested data is available in the in-memory buffer. In this
-    ** case there is no need to make a copy of the data, just return a 
-    ** pointer into the buffer to the caller.  
+    ** case there is no need to make a copy of the data, just return a
+    ** pointer into the buffer to the caller.
 	** 需要的数据全都在内存的缓存中，这种情况下，就没必要在对数据进行备份，只需把指向缓存的一个指针返回给调用者即可
 	*/
     *ppOut = &p->aBuffer[iBuf];//指向包含数据的缓存的指针=vdbesorteriter的读缓存[iBuf（一般就等于当前读偏移量）]
@@ -255,7 +340,7 @@ static int vdbeSorterIterRead(
   }else{
     /* The requested data is not all available in the in-memory buffer.
     ** In this case, allocate space at p->aAlloc[] to copy the requested
-    ** range into. Then return a copy of pointer p->aAlloc to the caller.  
+    ** range into. Then return a copy of pointer p->aAlloc to the caller.
 	** 需要的数据不全在内存的缓存中，这种情况下，在p->aAlloc[]中分配空间，用来把需要的数据拷贝进来
 	** 最后，返回指针p->aAlloc的一个副本给调用者
 	*/
@@ -263,10 +348,12 @@ static int vdbeSorterIterRead(
 
     /* Extend the p->aAlloc[] allocation if required. 若有必要（当aAlloc[]的大小小于要读的数据的字节数），扩展p->aAlloc[]的大小*/
     if( p->nAlloc<nByte ){
+      u8 *aNew;
       int nNew = p->nAlloc*2;
       while( nByte>nNew ) nNew = nNew*2;
-      p->aAlloc = sqlite3DbReallocOrFree(db, p->aAlloc, nNew);
-      if( !p->aAlloc ) return SQLITE_NOMEM;
+      aNew = sqlite3_realloc(p->aAlloc, nNew);
+      if( !aNew ) return SQLITE_NOMEM;
+      p->aAlloc = aNew;
       p->nAlloc = nNew;
     }
 
@@ -277,7 +364,7 @@ static int vdbeSorterIterRead(
     nRem = nByte - nAvail;
 
     /* The following loop copies up to p->nBuffer bytes per iteration into
-    ** the p->aAlloc[] buffer.  
+    ** the p->aAlloc[] buffer.
 	下面这个循环，在每次迭代过程中，都把至多p->nBuffer（写缓存字节数）个字节拷贝到p->aAlloc[]缓存中*/
     while( nRem>0 ){//只要余下的、要复制的字节数目大于零就循环，一直拷贝
       int rc;                     /* vdbeSorterIterRead() return code */
@@ -286,7 +373,7 @@ static int vdbeSorterIterRead(
 
       nCopy = nRem;
       if( nRem>p->nBuffer ) nCopy = p->nBuffer;
-      rc = vdbeSorterIterRead(db, p, nCopy, &aNext);
+      rc = vdbeSorterIterRead(p, nCopy, &aNext);
       if( rc!=SQLITE_OK ) return rc;
       assert( aNext!=p->aAlloc );
       memcpy(&p->aAlloc[nByte - nRem], aNext, nCopy);
@@ -308,7 +395,7 @@ static int vdbeSorterIterRead(
    并使指针pnOut指向读出来的这个数
 */
 //函数定义3：
-static int vdbeSorterIterVarint(sqlite3 *db, VdbeSorterIter *p, u64 *pnOut){
+static int vdbeSorterIterVarint(VdbeSorterIter *p, u64 *pnOut){
   int iBuf;
 
   iBuf = p->iReadOff % p->nBuffer;//当前读偏移量 模上 读缓存的字节数，结果是p->iReadOff或0(和函数定义2中的定义相同)
@@ -318,7 +405,7 @@ static int vdbeSorterIterVarint(sqlite3 *db, VdbeSorterIter *p, u64 *pnOut){
     u8 aVarint[16], *a;
     int i = 0, rc;
     do{
-      rc = vdbeSorterIterRead(db, p, 1, &a);//调用函数定义2中定义的函数
+      rc = vdbeSorterIterRead(p, 1, &a);//调用函数定义2中定义的函数
       if( rc ) return rc;
       aVarint[(i++)&0xf] = a[0];
     }while( (a[0]&0x80)!=0 );
@@ -337,7 +424,6 @@ static int vdbeSorterIterVarint(sqlite3 *db, VdbeSorterIter *p, u64 *pnOut){
 */
 //函数定义4：
 static int vdbeSorterIterNext(
-  sqlite3 *db,                    /* Database handle (for sqlite3DbMalloc() ) 针对sqlite3DbMalloc()的数据库句柄*/
   VdbeSorterIter *pIter           /* Iterator to advance 要前进的迭代器*/
 )
 {
@@ -346,14 +432,14 @@ static int vdbeSorterIterNext(
 
   if( pIter->iReadOff>=pIter->iEof ){
     /* This is an EOF condition 这是一个EOF条件*/
-    vdbeSorterIterZero(db, pIter);//if后的条件表示当前的度偏移量大于或等于iEof；这种情况下就调用上面已经给出定义的函数vdbeSorterIterZero(db, pIter)
+    vdbeSorterIterZero(pIter);//if后的条件表示当前的度偏移量大于或等于iEof；这种情况下就调用上面已经给出定义的函数vdbeSorterIterZero(pIter)
     return SQLITE_OK;
   }
 
-  rc = vdbeSorterIterVarint(db, pIter, &nRec);//调用上面已经给出定义的函数vdbeSorterIterVarint()
+  rc = vdbeSorterIterVarint(pIter, &nRec);//调用上面已经给出定义的函数vdbeSorterIterVarint()
   if( rc==SQLITE_OK ){
     pIter->nKey = (int)nRec;//nKey指的是Key占用的字节数。
-    rc = vdbeSorterIterRead(db, pIter, (int)nRec, &pIter->aKey);//调用上面已经给出定义的函数vdbeSorterIterRead()
+    rc = vdbeSorterIterRead(pIter, (int)nRec, &pIter->aKey);//调用上面已经给出定义的函数vdbeSorterIterRead()
   }
 
   return rc;
@@ -361,35 +447,34 @@ static int vdbeSorterIterNext(
 
 /*
 ** Initialize iterator pIter to scan through the PMA stored in file pFile
-** starting at offset iStart and ending at offset iEof-1. 
-** 初始化一个用来扫描文件pFile中PMA的迭代器pIter，扫描的开始和结束位置是：开始于偏移量位iStart的位置，结束于偏移量为iEof-1的位置    
+** starting at offset iStart. Parameter iFileEof is the offset of the end
+** of the last PMA in pFile and nBuf the size of the read buffer to use.
+** 初始化一个用来扫描文件pFile中PMA的迭代器pIter，扫描开始于偏移量位iStart的位置
 ** This function leaves the iterator pointing to the first key in the PMA (or EOF if the PMA is empty).
 ** 这个函数最后会使迭代器指向对应PMA的第一个位置（或EOF位置，如果ＰＭＡ＼是空的话）。
 */
 //函数定义5：
 static int vdbeSorterIterInit(
-  sqlite3 *db,                    /* Database handle 数据库句柄*/
-  const VdbeSorter *pSorter,      /* Sorter object ——VdbeSorter的一个实例*/
+  sqlite3_file *pFile,            /* File containing the PMA */
+  i64 iFileEof,                   /* Offset of end of data in pFile */
+  int nBuf,                       /* Size of read buffer in bytes */
   i64 iStart,                     /* Start offset in pFile ——pFile中的初始偏移量*/
   VdbeSorterIter *pIter,          /* Iterator to populate 要增添的迭代器*/
   i64 *pnByte                     /* IN/OUT: Increment this value by PMA size 以ＰＭＡ的大小为单位增加变量pnByte的值*/
 ){
   int rc = SQLITE_OK;
-  int nBuf;
-
-  nBuf = sqlite3BtreeGetPageSize(db->aDb[0].pBt);
 
-  assert( pSorter->iWriteOff>iStart );
+  assert( iFileEof>iStart );
   assert( pIter->aAlloc==0 );
   assert( pIter->aBuffer==0 );
-  pIter->pFile = pSorter->pTemp1;//pFile:此指针所指的地方是iterator开始读的地方;*pTemp1:PMA file 1 ——指向存储PMA的文件的指针*/
+  pIter->pFile = pFile;//pFile:此指针所指的地方是iterator开始读的地方
   pIter->iReadOff = iStart;//iStart是pFile中的初始偏移量
   pIter->nAlloc = 128;//aAlloc处空间的字节数
-  pIter->aAlloc = (u8 *)sqlite3DbMallocRaw(db, pIter->nAlloc);//aAlloc——Allocated space已经分配出去的空间
+  pIter->aAlloc = (u8 *)sqlite3Malloc(pIter->nAlloc);//aAlloc——Allocated space已经分配出去的空间
   pIter->nBuffer = nBuf;//int nBuffer——Size of read buffer in bytes 读缓存的字节数
-  pIter->aBuffer = (u8 *)sqlite3DbMallocRaw(db, nBuf);//*aBuffer——Current read buffer指向当前的读缓存
+  pIter->aBuffer = (u8 *)sqlite3Malloc(nBuf);//*aBuffer——Current read buffer指向当前的读缓存
 
-  if( !pIter->aBuffer ){
+  if( !pIter->aBuffer || !pIter->aAlloc ){
     rc = SQLITE_NOMEM;//一个含义不是OK的return code
   }else{
     int iBuf;
@@ -397,65 +482,61 @@ static int vdbeSorterIterInit(
     iBuf = iStart % nBuf;
     if( iBuf ){
       int nRead = nBuf - iBuf;
-      if( (iStart + nRead) > pSorter->iWriteOff ){
-        nRead = (int)(pSorter->iWriteOff - iStart);
+      if( (iStart + nRead) > iFileEof ){
+        nRead = (int)(iFileEof - iStart);
       }
-      rc = sqlite3OsRead(
-          pSorter->pTemp1, &pIter->aBuffer[iBuf], nRead, iStart
-      );
+      rc = sqlite3OsRead(pFile, &pIter->aBuffer[iBuf], nRead, iStart);
       assert( rc!=SQLITE_IOERR_SHORT_READ );
     }
 
     if( rc==SQLITE_OK ){
       u64 nByte;                       /* Size of PMA in bytes ——PMA的字节数大小*/
-      pIter->iEof = pSorter->iWriteOff;
-      rc = vdbeSorterIterVarint(db, pIter, &nByte);
+      pIter->iEof = iFileEof;
+      rc = vdbeSorterIterVarint(pIter, &nByte);
       pIter->iEof = pIter->iReadOff + nByte;
       *pnByte += nByte;
     }
   }
 
   if( rc==SQLITE_OK ){
-    rc = vdbeSorterIterNext(db, pIter);
+    rc = vdbeSorterIterNext(pIter);
   }
   return rc;
 }
 
 
 /*
-** Compare key1 (buffer pKey1, size nKey1 bytes) with key2 (buffer pKey2, 
+** Compare key1 (buffer pKey1, size nKey1 bytes) with key2 (buffer pKey2,
 ** size nKey2 bytes).  Argument pKeyInfo supplies the collation functions
 ** used by the comparison. If an error occurs, return an SQLite error code.
 ** Otherwise, return SQLITE_OK and set *pRes to a negative, zero or positive
 ** value, depending on whether key1 is smaller, equal to or larger than key2.
 **　下面的函数用来比较key1和key2。参数pKeyInfo提供比较时要使用的校对功能。如果有错误发生就返回一个SQLite错误码，
 　　否则就返回SQLITE_OK，并给*pRes赋值，如果ｋｅｙ１小，就赋负值，如果二者相等就赋０，若ｋｅｙ１大，就赋正值。
-** If the bOmitRowid argument is non-zero, assume both keys end in a rowid　field. For the purposes of the comparison, ignore it. 
+** If the bOmitRowid argument is non-zero, assume both keys end in a rowid　field. For the purposes of the comparison, ignore it.
 　　如果函数的参数bOmitRowid是非零的，就假设两个ｋｅｙｓ在ｒｏｗｉｄ域结尾。基于比较的目的，忽略这种情况。
-** 
-　　
+**
+
 **　Also, if bOmitRowid　is true and key1 contains even a single NULL value,
 **  it is considered to　be less than key2. Even if key2 also contains NULL values.
 ** 如果bOmitRowid是真值，ｋｅｙ１仅含有一个单独的ＮＵＬＬ值，那么ｋｅｙ１小于ｋｅｙ２，甚至在ｋｅｙ２也包含一个ＮＵＬＬ值得情况下。
-** If pKey2 is passed a NULL pointer, then it is assumed that the pCsr->aSpace
-** has been allocated and contains an unpacked record that is used as key2.
-**　如果ｐＫｅｙ２由一个空指针代表，则假设pCsr->aSpace已经被分配并包含一个未包装的记录，被当做ｋｅｙ２使用。
+** If pKey2 is passed a NULL pointer, then it is assumed that r2 already
+** contains an unpacked copy of key2.
+**　如果ｐＫｅｙ２由一个空指针代表，则假设r2已经包含一个未包装的记录，被当做ｋｅｙ２使用。
 */
 //函数定义6：
 static void vdbeSorterCompare(
-  const VdbeCursor *pCsr,         /* Cursor object (for pKeyInfo) 针对pKeyInfo的游标实例*/
+  KeyInfo *pKeyInfo,              /* Collation functions etc. */
+  UnpackedRecord *r2,             /* Space to unpack key2 into */
   int bOmitRowid,                 /* Ignore rowid field at end of keys 忽略ｋｅｙｓ结尾处的ｒｏｗｉｄ域*/
   const void *pKey1, int nKey1,   /* Left side of comparison 要比较的一方*/
   const void *pKey2, int nKey2,   /* Right side of comparison 要比较的另一方*/
   int *pRes                       /* OUT: Result of comparison 储存比较后所得结果*/
 )
 {
-  KeyInfo *pKeyInfo = pCsr->pKeyInfo;
-  VdbeSorter *pSorter = pCsr->pSorter;
-  UnpackedRecord *r2 = pSorter->pUnpacked;
   int i;
 
-  if( pKey2 ){　
+  if( pKey2 ){
     sqlite3VdbeRecordUnpack(pKeyInfo, nKey2, pKey2, r2);
   }
 
@@ -475,32 +556,31 @@ static void vdbeSorterCompare(
 }
 
 /*
-** This function is called to compare two iterator keys when merging 
-** multiple b-tree segments. Parameter iOut is the index of the aTree[] 
+** This function is called to compare two iterator keys when merging
+** multiple b-tree segments. Parameter iOut is the index of the aTree[]
 ** value to recalculate.
 　　这个函数在合并多元ｂ树段 时被调用。参数iOut是aTree[]中要被重新计算值的元素的下标值（结合开头时讲的N路归并算法，数组aTree[]是需要更新的）。
 */
 //函数定义7：
-static int vdbeSorterDoCompare(const VdbeCursor *pCsr, int iOut){
-  VdbeSorter *pSorter = pCsr->pSorter;
+static int vdbeSorterDoCompare(SorterMerger *pMerger, int iOut){
   int i1;
   int i2;
   int iRes;
   VdbeSorterIter *p1;
   VdbeSorterIter *p2;
 
-  assert( iOut<pSorter->nTree && iOut>0 );
+  assert( iOut<pMerger->nTree && iOut>0 );
 
-  if( iOut>=(pSorter->nTree/2) ){
-    i1 = (iOut - pSorter->nTree/2) * 2;
+  if( iOut>=(pMerger->nTree/2) ){
+    i1 = (iOut - pMerger->nTree/2) * 2;
     i2 = i1 + 1;
   }else{
-    i1 = pSorter->aTree[iOut*2];
-    i2 = pSorter->aTree[iOut*2+1];
+    i1 = pMerger->aTree[iOut*2];
+    i2 = pMerger->aTree[iOut*2+1];
   }
 
-  p1 = &pSorter->aIter[i1];
-  p2 = &pSorter->aIter[i2];
+  p1 = &pMerger->aIter[i1];
+  p2 = &pMerger->aIter[i2];
 
   if( p1->pFile==0 ){
     iRes = i2;
@@ -508,9 +588,9 @@ static int vdbeSorterDoCompare(const VdbeCursor *pCsr, int iOut){
     iRes = i1;
   }else{
     int res;
-    assert( pCsr->pSorter->pUnpacked!=0 );  /* allocated in vdbeSorterMerge()部署在函数vdbeSorterMerge()中 */
-    vdbeSorterCompare(
-        pCsr, 0, p1->aKey, p1->nKey, p2->aKey, p2->nKey, &res
+    assert( pMerger->pUnpacked!=0 );
+    vdbeSorterCompare(pMerger->pKeyInfo, pMerger->pUnpacked, 0,
+        p1->aKey, p1->nKey, p2->aKey, p2->nKey, &res
     );
     if( res<=0 ){
       iRes = i1;
@@ -519,38 +599,163 @@ static int vdbeSorterDoCompare(const VdbeCursor *pCsr, int iOut){
     }
   }
 
-  pSorter->aTree[iOut] = iRes;
+  pMerger->aTree[iOut] = iRes;
   return SQLITE_OK;
 }
 
+/*
+** Allocate a new merger object with space for nIter iterators. Keys are
+** compared using pKeyInfo, unpacking them into pUnpacked. Return NULL
+** if a malloc fails.
+*/
+static SorterMerger *vdbeSorterMergerNew(
+  int nIter,                      /* Number of iterators required */
+  KeyInfo *pKeyInfo,              /* Used to compare keys */
+  UnpackedRecord *pUnpacked       /* Used to unpack keys */
+){
+  int N = 2;                      /* Power of 2 >= nIter ；2的幂>= nIter*/
+  int nByte;                      /* Bytes of space required for aIter/aTree */
+  SorterMerger *pNew;
+
+  assert( nIter>0 && nIter<=SORTER_MAX_MERGE_COUNT );
+  while( N<nIter ) N += N;
+  nByte = sizeof(SorterMerger) + N * (sizeof(int) + sizeof(VdbeSorterIter));
+  pNew = (SorterMerger *)sqlite3MallocZero(nByte);
+  if( pNew ){
+    pNew->nTree = N;
+    pNew->aIter = (VdbeSorterIter *)&pNew[1];
+    pNew->aTree = (int *)&pNew->aIter[N];
+    pNew->pKeyInfo = pKeyInfo;
+    pNew->pUnpacked = pUnpacked;
+  }
+  return pNew;
+}
+
+/*
+** Free a merger object allocated by vdbeSorterMergerNew() and all of its
+** iterators.
+*/
+static void vdbeSorterMergerFree(SorterMerger *pMerger){
+  if( pMerger ){
+    int i;
+    for(i=0; i<pMerger->nTree; i++){
+      vdbeSorterIterZero(&pMerger->aIter[i]);
+    }
+    sqlite3_free(pMerger);
+  }
+}
+
+/*
+** Initialize the aTree[] array of a merger once its iterators have been
+** initialized.
+*/
+static int vdbeSorterMergerInit(SorterMerger *pMerger){
+  int rc = SQLITE_OK;
+  int i;
+  for(i=pMerger->nTree-1; rc==SQLITE_OK && i>0; i--){
+    rc = vdbeSorterDoCompare(pMerger, i);
+  }
+  return rc;
+}
+
+/*
+** Advance a merger to its next key. Set *pbEof to true if there are no
+** more keys to return.
+*/
+static int vdbeSorterMergerNext(SorterMerger *pMerger, int *pbEof){
+  int iPrev = pMerger->aTree[1];  /* Index of iterator to advance 要前进的迭代器的下标*/
+  int i;                          /* Index of aTree[] to recalculate 要重算的数组aTree[]中元素的下标*/
+  int rc;                         /* Return code */
+
+  rc = vdbeSorterIterNext(&pMerger->aIter[iPrev]);
+  for(i=(pMerger->nTree+iPrev)/2; rc==SQLITE_OK && i>0; i=i/2){
+    rc = vdbeSorterDoCompare(pMerger, i);
+  }
+
+  *pbEof = (pMerger->aIter[pMerger->aTree[1]].pFile==0);
+  return rc;
+}
+
 /*
 ** Initialize the temporary index cursor just opened as a sorter cursor.——初始化临时索引游标，使之作为sorter游标
+**
+** If the SQLITE_LIMIT_WORKER_THREADS limit is greater than zero, this
+** function also makes a copy of the cursor KeyInfo with a NULL db
+** pointer for use by worker threads.
 */
 //函数定义8：
 int sqlite3VdbeSorterInit(sqlite3 *db, VdbeCursor *pCsr){
   int pgsz;                       /* Page size of main database 主数据库的页大小*/
   int mxCache;                    /* Cache size ——Ｃａｃｈｅ缓存大小*/
   VdbeSorter *pSorter;            /* The new sorter 指向新ｓｏｒｔｅｒ的指针*/
+  KeyInfo *pKeyInfo;              /* KeyInfo used by PMA writers */
   char *d;                        /* Dummy */
+  int i;
 
   assert( pCsr->pKeyInfo && pCsr->pBt==0 );
   pCsr->pSorter = pSorter = sqlite3DbMallocZero(db, sizeof(VdbeSorter));
   if( pSorter==0 ){
     return SQLITE_NOMEM;
   }
-  
+
   pSorter->pUnpacked = sqlite3VdbeAllocUnpackedRecord(pCsr->pKeyInfo, 0, 0, &d);
   if( pSorter->pUnpacked==0 ) return SQLITE_NOMEM;
   assert( pSorter->pUnpacked==(UnpackedRecord *)d );
 
+  pgsz = sqlite3BtreeGetPageSize(db->aDb[0].pBt);
+  pSorter->pgsz = pgsz;
   if( !sqlite3TempInMemory(db) ){
-    pgsz = sqlite3BtreeGetPageSize(db->aDb[0].pBt);
     pSorter->mnPmaSize = SORTER_MIN_WORKING * pgsz;
     mxCache = db->aDb[0].pSchema->cache_size;
     if( mxCache<SORTER_MIN_WORKING ) mxCache = SORTER_MIN_WORKING;
     pSorter->mxPmaSize = mxCache * pgsz;
   }
 
+  /* Worker threads are only used if the library is threadsafe. Each one
+  ** gets its own slot. If there are no workers, a single slot is used by
+  ** the VDBE thread.  */
+  pKeyInfo = pCsr->pKeyInfo;
+  if( sqlite3GlobalConfig.bCoreMutex && pSorter->mxPmaSize>0 ){
+    pSorter->nWorker = db->aLimit[SQLITE_LIMIT_WORKER_THREADS];
+  }
+
+  /* The final merge reads at least one PMA from each slot, so there may
+  ** not be more slots than SORTER_MAX_MERGE_COUNT. */
+  if( pSorter->nWorker>SORTER_MAX_MERGE_COUNT ){
+    pSorter->nWorker = SORTER_MAX_MERGE_COUNT;
+  }
+  if( pSorter->nWorker>0 ){
+    int nField = pKeyInfo->nField;
+    int nByte = sizeof(KeyInfo) + (nField-1)*sizeof(CollSeq*) + nField;
+    pKeyInfo = (KeyInfo *)sqlite3DbMallocRaw(db, nByte);
+    if( pKeyInfo==0 ) return SQLITE_NOMEM;
+    memcpy(pKeyInfo, pCsr->pKeyInfo, nByte - nField);
+    if( pCsr->pKeyInfo->aSortOrder ){
+      pKeyInfo->aSortOrder = (u8 *)&pKeyInfo->aColl[nField];
+      memcpy(pKeyInfo->aSortOrder, pCsr->pKeyInfo->aSortOrder, nField);
+    }
+    pKeyInfo->db = 0;
+    pSorter->pKeyInfo = pKeyInfo;
+  }
+  pSorter->nThread = pSorter->nWorker>0 ? pSorter->nWorker : 1;
+  pSorter->aThread = (SorterThread *)sqlite3DbMallocZero(db,
+      pSorter->nThread * sizeof(SorterThread)
+  );
+  if( pSorter->aThread==0 ) return SQLITE_NOMEM;
+  pSorter->iPrev = pSorter->nThread-1;
+
+  /* Every slot is given its KeyInfo before any allocation that might fail,
+  ** as sqlite3VdbeSorterClose() uses it to free the slot's pUnpacked. */
+  for(i=0; i<pSorter->nThread; i++){
+    pSorter->aThread[i].pKeyInfo = pKeyInfo;
+    pSorter->aThread[i].pgsz = pgsz;
+  }
+  for(i=0; i<pSorter->nThread; i++){
+    SorterThread *pThread = &pSorter->aThread[i];
+    pThread->pUnpacked = sqlite3VdbeAllocUnpackedRecord(pKeyInfo, 0, 0, &d);
+    if( pThread->pUnpacked==0 ) return SQLITE_NOMEM;
+  }
+
   return SQLITE_OK;
 }
 
@@ -558,15 +763,31 @@ int sqlite3VdbeSorterInit(sqlite3 *db, VdbeCursor *pCsr){
 ** Free the list of sorted records starting at pRecord.——下面的函数的功能：从pRecord所指的地方开始释放已排好序的记录列表
 */
 //函数定义9：
-static void vdbeSorterRecordFree(sqlite3 *db, SorterRecord *pRecord){//被函数10调用了的
+static void vdbeSorterRecordFree(SorterRecord *pRecord){//被函数10调用了的
   SorterRecord *p;
   SorterRecord *pNext;
   for(p=pRecord; p; p=pNext){
     pNext = p->pNext;
-    sqlite3DbFree(db, p);
+    sqlite3_free(p);
   }
 }
 
+/*
+** Wait for the worker thread (if any) running in slot pThread to finish.
+** Return the result of the job it was running, or SQLITE_OK if there
+** was no such thread.
+*/
+static int vdbeSorterJoinThread(SorterThread *pThread){
+  int rc = SQLITE_OK;
+  if( pThread->pThread ){
+    void *pRet;
+    rc = sqlite3ThreadJoin(pThread->pThread, &pRet);
+    pThread->pThread = 0;
+    if( rc==SQLITE_OK ) rc = pThread->rc;
+  }
+  return rc;
+}
+
 /*
 ** Free any cursor components allocated by sqlite3VdbeSorterXXX routines.
 	释放任何一个由sqlite3VdbeSorterXXX routine部署的游标元素
@@ -575,18 +796,30 @@ static void vdbeSorterRecordFree(sqlite3 *db, SorterRecord *pRecord){//被函数
 void sqlite3VdbeSorterClose(sqlite3 *db, VdbeCursor *pCsr){
   VdbeSorter *pSorter = pCsr->pSorter;
   if( pSorter ){
-    if( pSorter->aIter ){
-      int i;
-      for(i=0; i<pSorter->nTree; i++){
-        vdbeSorterIterZero(db, &pSorter->aIter[i]);//调用了本源文件之前定义的一个函数vdbeSorterIterZero()
+    int i;
+    if( pSorter->aThread ){
+      for(i=0; i<pSorter->nThread; i++){
+        SorterThread *pThread = &pSorter->aThread[i];
+        vdbeSorterJoinThread(pThread);
+        vdbeSorterRecordFree(pThread->pList);
+        if( pThread->pTemp1 ) sqlite3OsCloseFree(pThread->pTemp1);
+        if( pThread->pTemp2 ) sqlite3OsCloseFree(pThread->pTemp2);
+        /* pUnpacked was allocated using pKeyInfo->db, which is NULL for
+        ** the private KeyInfo copy used when there are worker threads. */
+        sqlite3DbFree(pThread->pKeyInfo->db, pThread->pUnpacked);
       }
-      sqlite3DbFree(db, pSorter->aIter);
+      sqlite3DbFree(db, pSorter->aThread);
     }
-    if( pSorter->pTemp1 ){
-      sqlite3OsCloseFree(pSorter->pTemp1);
+    if( pSorter->aHeap ){
+      for(i=0; i<pSorter->nHeap; i++){
+        sqlite3_free(pSorter->aHeap[i]);
+      }
+      sqlite3_free(pSorter->aHeap);
     }
-    vdbeSorterRecordFree(db, pSorter->pRecord);//调用了本源文件之前定义的一个函数vdbeSorterRecordFree()
+    vdbeSorterMergerFree(pSorter->pMerger);//调用了本源文件之前定义的一个函数vdbeSorterMergerFree()
+    vdbeSorterRecordFree(pSorter->pRecord);//调用了本源文件之前定义的一个函数vdbeSorterRecordFree()
     sqlite3DbFree(db, pSorter->pUnpacked);
+    sqlite3DbFree(db, pSorter->pKeyInfo);
     sqlite3DbFree(db, pSorter);
     pCsr->pSorter = 0;
   }
@@ -616,7 +849,8 @@ static int vdbeSorterOpenTempFile(sqlite3 *db, sqlite3_file **ppFile){
 */
 //函数定义12：
 static void vdbeSorterMerge(
-  const VdbeCursor *pCsr,         /* For pKeyInfo */
+  KeyInfo *pKeyInfo,              /* Used to compare records */
+  UnpackedRecord *pUnpacked,      /* Used to unpack records */
   SorterRecord *p1,               /* First list to merge 参与合并的第一个列表*/
   SorterRecord *p2,               /* Second list to merge 参与合并的第二个列表*/
   SorterRecord **ppOut            /* OUT: Head of merged list 返回的：指向合并后的列表的头的指针*/
@@ -627,7 +861,9 @@ static void vdbeSorterMerge(
 
   while( p1 && p2 ){
     int res;
-    vdbeSorterCompare(pCsr, 0, p1->pVal, p1->nVal, pVal2, p2->nVal, &res);
+    vdbeSorterCompare(
+        pKeyInfo, pUnpacked, 0, p1->pVal, p1->nVal, pVal2, p2->nVal, &res
+    );
     if( res<=0 ){
       *pp = p1;
       pp = &p1->pNext;
@@ -646,29 +882,32 @@ static void vdbeSorterMerge(
 }
 
 /*
-** Sort the linked list of records headed at pCsr->pRecord. Return SQLITE_OK
+** Sort the linked list of records headed at *ppList. Return SQLITE_OK
 ** if successful, or an SQLite error code (i.e. SQLITE_NOMEM) if an error
 ** occurs.
-　　对头在pCsr->pRecord处的记录链表排序。成功就返回SQLITE_OK；否则，返回SQLite错误码
+　　对头在*ppList处的记录链表排序。成功就返回SQLITE_OK；否则，返回SQLite错误码
 */
 //函数定义13：
-static int vdbeSorterSort(const VdbeCursor *pCsr){
+static int vdbeSorterSort(
+  KeyInfo *pKeyInfo,              /* Used to compare records */
+  UnpackedRecord *pUnpacked,      /* Used to unpack records */
+  SorterRecord **ppList           /* IN/OUT: List to sort */
+){
   int i;
   SorterRecord **aSlot;
   SorterRecord *p;
-  VdbeSorter *pSorter = pCsr->pSorter;
 
   aSlot = (SorterRecord **)sqlite3MallocZero(64 * sizeof(SorterRecord *));
   if( !aSlot ){
     return SQLITE_NOMEM;
   }
 
-  p = pSorter->pRecord;
+  p = *ppList;
   while( p ){
     SorterRecord *pNext = p->pNext;
     p->pNext = 0;
     for(i=0; aSlot[i]; i++){
-      vdbeSorterMerge(pCsr, p, aSlot[i], &p);
+      vdbeSorterMerge(pKeyInfo, pUnpacked, p, aSlot[i], &p);
       aSlot[i] = 0;
     }
     aSlot[i] = p;
@@ -677,9 +916,9 @@ static int vdbeSorterSort(const VdbeCursor *pCsr){
 
   p = 0;
   for(i=0; i<64; i++){
-    vdbeSorterMerge(pCsr, p, aSlot[i], &p);//调用上一个定义的函数
+    vdbeSorterMerge(pKeyInfo, pUnpacked, p, aSlot[i], &p);//调用上一个定义的函数
   }
-  pSorter->pRecord = p;
+  *ppList = p;
 
   sqlite3_free(aSlot);
   return SQLITE_OK;
@@ -690,15 +929,13 @@ static int vdbeSorterSort(const VdbeCursor *pCsr){
 */
 //函数定义14：
 static void fileWriterInit(
-  sqlite3 *db,                    /* Database (for malloc) 针对malloc的数据库*/
+  int nBuf,                       /* Size of write buffer in bytes */
   sqlite3_file *pFile,            /* File to write to 指向要被写入数据的文件的指针*/
   FileWriter *p,                  /* Object to populate 要增添的对象*/
   i64 iStart                      /* Offset of pFile to begin writing at 文件中，开始写的位置的偏移量*/
 ){
-  int nBuf = sqlite3BtreeGetPageSize(db->aDb[0].pBt);
-
   memset(p, 0, sizeof(FileWriter));
-  p->aBuffer = (u8 *)sqlite3DbMallocRaw(db, nBuf);
+  p->aBuffer = (u8 *)sqlite3Malloc(nBuf);
   if( !p->aBuffer ){
     p->eFWErr = SQLITE_NOMEM;
   }else{
@@ -727,8 +964,8 @@ static void fileWriterWrite(FileWriter *p, u8 *pData, int nData){
     memcpy(&p->aBuffer[p->iBufEnd], &pData[nData-nRem], nCopy);
     p->iBufEnd += nCopy;
     if( p->iBufEnd==p->nBuffer ){
-      p->eFWErr = sqlite3OsWrite(p->pFile, 
-          &p->aBuffer[p->iBufStart], p->iBufEnd - p->iBufStart, 
+      p->eFWErr = sqlite3OsWrite(p->pFile,
+          &p->aBuffer[p->iBufStart], p->iBufEnd - p->iBufStart,
           p->iWriteOff + p->iBufStart
       );
       p->iBufStart = p->iBufEnd = 0;
@@ -752,38 +989,39 @@ static void fileWriterWrite(FileWriter *p, u8 *pData, int nData){
 
 */
 //函数定义16：
-static int fileWriterFinish(sqlite3 *db, FileWriter *p, i64 *piEof){
+static int fileWriterFinish(FileWriter *p, i64 *piEof){
   int rc;
   if( p->eFWErr==0 && ALWAYS(p->aBuffer) && p->iBufEnd>p->iBufStart ){
-    p->eFWErr = sqlite3OsWrite(p->pFile, 
-        &p->aBuffer[p->iBufStart], p->iBufEnd - p->iBufStart, 
+    p->eFWErr = sqlite3OsWrite(p->pFile,
+        &p->aBuffer[p->iBufStart], p->iBufEnd - p->iBufStart,
         p->iWriteOff + p->iBufStart
     );
   }
   *piEof = (p->iWriteOff + p->iBufEnd);
-  sqlite3DbFree(db, p->aBuffer);
+  sqlite3_free(p->aBuffer);
   rc = p->eFWErr;
   memset(p, 0, sizeof(FileWriter));
   return rc;
 }
 
 /*
-** Write value iVal encoded as a varint to the file-write object. Return 
+** Write value iVal encoded as a varint to the file-write object. Return
 ** SQLITE_OK if successful, or an SQLite error code if an error occurs.
 	下面这个函数把形参iVal（编码成一个可变长整数变量）的值传到一个file-write实例中
 	成功返回SQLITE_OK，失败则返回错误码
 */
 //函数定义17：
 static void fileWriterWriteVarint(FileWriter *p, u64 iVal){
-  int nByte; 
+  int nByte;
   u8 aByte[10];
   nByte = sqlite3PutVarint(aByte, iVal);
   fileWriterWrite(p, aByte, nByte);//调用了函数15
 }
 
 /*
-** Write the current contents of the in-memory linked-list to a PMA. Return
-** SQLITE_OK if successful, or an SQLite error code otherwise.
+** Sort the in-memory list belonging to slot pThread and append it to the
+** slot's temporary file as a new PMA. Return SQLITE_OK if successful, or
+** an SQLite error code otherwise.
 **　下面函数的功能是把内存中的链表的当前内容写到一个PMA中。
     成功就返回SQLITE_OK，否则就返回一个错误码
 ** The format of a PMA is:
@@ -791,55 +1029,381 @@ static void fileWriterWriteVarint(FileWriter *p, u64 iVal){
 **     * A varint. This varint contains the total number of bytes of content
 **       in the PMA (not including the varint itself).
 **　　　一个可变长的整数变量，这个变量中存储有PMA中所有内容的字节大小（不包含改变量自己）
-**     * One or more records packed end-to-end in order of ascending keys. 
-**       Each record consists of a varint followed by a blob of data (the 
+**     * One or more records packed end-to-end in order of ascending keys.
+**       Each record consists of a varint followed by a blob of data (the
 **       key). The varint is the number of bytes in the blob of data.
 		　一个或多个记录以尾对尾的方式、按照key的递增顺序排序。每条记录都由一个可变长整数和其后的一系列数据组成。
 		　可变长变量的值等于其后一系列的数据占用的字节的数目
+**
+** This function may be called by a worker thread. The temporary file must
+** already have been opened by the VDBE thread.
 */
 //函数定义18：
-static int vdbeSorterListToPMA(sqlite3 *db, const VdbeCursor *pCsr){
+static int vdbeSorterListToPMA(SorterThread *pThread){
   int rc = SQLITE_OK;             /* Return code 返回代码*/
-  VdbeSorter *pSorter = pCsr->pSorter;
   FileWriter writer;
+#ifdef SQLITE_DEBUG
+  i64 nExpect = pThread->iTemp1Off
+              + sqlite3VarintLen(pThread->nInMemory)
+              + pThread->nInMemory;
+#endif
 
   memset(&writer, 0, sizeof(FileWriter));
 
-  if( pSorter->nInMemory==0 ){
-    assert( pSorter->pRecord==0 );
+  if( pThread->nInMemory==0 ){
+    assert( pThread->pList==0 );
     return rc;
   }
+  assert( pThread->pTemp1 );
 
-  rc = vdbeSorterSort(pCsr);
-
-  /* If the first temporary PMA file has not been opened, open it now. 如果第一个临时ＰＭＡ文件没有打开，现在就打开*/
-  if( rc==SQLITE_OK && pSorter->pTemp1==0 ){
-    rc = vdbeSorterOpenTempFile(db, &pSorter->pTemp1);
-    assert( rc!=SQLITE_OK || pSorter->pTemp1 );
-    assert( pSorter->iWriteOff==0 );
-    assert( pSorter->nPMA==0 );
-  }
+  rc = vdbeSorterSort(pThread->pKeyInfo, pThread->pUnpacked, &pThread->pList);
 
   if( rc==SQLITE_OK ){
     SorterRecord *p;
     SorterRecord *pNext = 0;
 
-    fileWriterInit(db, pSorter->pTemp1, &writer, pSorter->iWriteOff);
-    pSorter->nPMA++;
-    fileWriterWriteVarint(&writer, pSorter->nInMemory);
-    for(p=pSorter->pRecord; p; p=pNext){
+    fileWriterInit(pThread->pgsz, pThread->pTemp1, &writer, pThread->iTemp1Off);
+    pThread->nPMA++;
+    fileWriterWriteVarint(&writer, pThread->nInMemory);
+    for(p=pThread->pList; p; p=pNext){
       pNext = p->pNext;
       fileWriterWriteVarint(&writer, p->nVal);
       fileWriterWrite(&writer, p->pVal, p->nVal);
-      sqlite3DbFree(db, p);
+      sqlite3_free(p);
     }
-    pSorter->pRecord = p;
-    rc = fileWriterFinish(db, &writer, &pSorter->iWriteOff);
+    pThread->pList = p;
+    rc = fileWriterFinish(&writer, &pThread->iTemp1Off);
+  }
+  pThread->nInMemory = 0;
+
+  assert( rc!=SQLITE_OK || (nExpect==pThread->iTemp1Off) );
+  return rc;
+}
+
+/*
+** Merge the PMAs in the temporary file of slot pThread, SORTER_MAX_MERGE_COUNT
+** or fewer at a time, until there are no more than pThread->nTarget of them.
+** Each pass writes its output to file pTemp2, which is then swapped with
+** pTemp1.
+**
+** This function may be called by a worker thread. Both temporary files
+** must already have been opened by the VDBE thread.
+*/
+static int vdbeSorterReduce(SorterThread *pThread){
+  int rc = SQLITE_OK;             /* Return code 返回码*/
+
+  assert( pThread->nTarget>0 );
+  while( rc==SQLITE_OK && pThread->nPMA>pThread->nTarget ){
+    i64 iRead = 0;                /* Read offset within pTemp1 */
+    i64 iWrite2 = 0;              /* Write offset for pTemp2 为pTemp2定义偏移量*/
+    int nNew = 0;                 /* Number of PMAs written to pTemp2 */
+    int nGroup;                   /* PMAs merged into each new PMA */
+    int iPMA;                     /* Index of first PMA in current group */
+    sqlite3_file *pTmp;
+
+    /* Choose the group size so that a single pass reaches the target, if
+    ** possible without exceeding SORTER_MAX_MERGE_COUNT. */
+    nGroup = (pThread->nPMA + pThread->nTarget - 1) / pThread->nTarget;
+    if( nGroup>SORTER_MAX_MERGE_COUNT ) nGroup = SORTER_MAX_MERGE_COUNT;
+    if( nGroup<2 ) nGroup = 2;
+
+    for(iPMA=0; rc==SQLITE_OK && iPMA<pThread->nPMA; iPMA+=nGroup){
+      int nIter = pThread->nPMA - iPMA;
+      int i;
+      i64 nWrite = 0;             /* Number of bytes in new PMA 新PMA中的字节数目*/
+      SorterMerger *pMerger;
+
+      if( nIter>nGroup ) nIter = nGroup;
+      pMerger = vdbeSorterMergerNew(
+          nIter, pThread->pKeyInfo, pThread->pUnpacked
+      );
+      if( pMerger==0 ){
+        rc = SQLITE_NOMEM;
+        break;
+      }
+      for(i=0; rc==SQLITE_OK && i<nIter; i++){
+        VdbeSorterIter *pIter = &pMerger->aIter[i];
+        rc = vdbeSorterIterInit(pThread->pTemp1, pThread->iTemp1Off,
+            pThread->pgsz, iRead, pIter, &nWrite
+        );
+        iRead = pIter->iEof;
+      }
+      if( rc==SQLITE_OK ) rc = vdbeSorterMergerInit(pMerger);
+
+      if( rc==SQLITE_OK ){
+        int rc2;                  /* Return code from fileWriterFinish() */
+        int bEof = 0;
+        FileWriter writer;        /* Object used to write to disk 用来往磁盘里写数据的实例*/
+        fileWriterInit(pThread->pgsz, pThread->pTemp2, &writer, iWrite2);
+        fileWriterWriteVarint(&writer, nWrite);
+        while( rc==SQLITE_OK && bEof==0 ){
+          VdbeSorterIter *pIter = &pMerger->aIter[ pMerger->aTree[1] ];
+          assert( pIter->pFile );
+
+          fileWriterWriteVarint(&writer, pIter->nKey);
+          fileWriterWrite(&writer, pIter->aKey, pIter->nKey);
+          rc = vdbeSorterMergerNext(pMerger, &bEof);
+        }
+        rc2 = fileWriterFinish(&writer, &iWrite2);
+        if( rc==SQLITE_OK ) rc = rc2;
+        nNew++;
+      }
+      vdbeSorterMergerFree(pMerger);
+    }
+
+    pTmp = pThread->pTemp1;
+    pThread->pTemp1 = pThread->pTemp2;
+    pThread->pTemp2 = pTmp;
+    pThread->iTemp1Off = iWrite2;
+    pThread->nPMA = nNew;
+  }
+
+  return rc;
+}
+
+/*
+** The main routine for sorter worker threads. It is also invoked directly
+** by the VDBE thread if no worker threads are in use.
+*/
+static void *vdbeSorterThreadMain(void *pCtx){
+  SorterThread *pThread = (SorterThread *)pCtx;
+  if( pThread->eWork==SORTER_THREAD_SORT ){
+    pThread->rc = vdbeSorterListToPMA(pThread);
+  }else{
+    assert( pThread->eWork==SORTER_THREAD_REDUCE );
+    pThread->rc = vdbeSorterReduce(pThread);
+  }
+  return 0;
+}
+
+/*
+** Run the job configured in slot pThread. If worker threads are enabled
+** the job is launched in a new thread and this function returns without
+** waiting for it. Otherwise it runs to completion before returning.
+*/
+static int vdbeSorterRunThread(VdbeSorter *pSorter, SorterThread *pThread){
+  assert( pThread->pThread==0 );
+  if( pSorter->nWorker>0 ){
+    pThread->rc = SQLITE_OK;
+    return sqlite3ThreadCreate(&pThread->pThread, vdbeSorterThreadMain, pThread);
+  }
+  vdbeSorterThreadMain((void *)pThread);
+  return pThread->rc;
+}
+
+/*
+** Hand the current in-memory list to the next slot, which sorts it and
+** writes it out as a PMA. If the slot is still busy with the previous
+** list it was given, wait for it first.
+*/
+static int vdbeSorterFlush(sqlite3 *db, VdbeSorter *pSorter){
+  SorterThread *pThread;
+  int rc;
+
+  pSorter->iPrev = (pSorter->iPrev + 1) % pSorter->nThread;
+  pThread = &pSorter->aThread[pSorter->iPrev];
+  rc = vdbeSorterJoinThread(pThread);
+
+  /* If the slot's temporary PMA file has not been opened, open it now. 如果临时ＰＭＡ文件没有打开，现在就打开*/
+  if( rc==SQLITE_OK && pThread->pTemp1==0 ){
+    rc = vdbeSorterOpenTempFile(db, &pThread->pTemp1);
+    assert( rc!=SQLITE_OK || pThread->pTemp1 );
+    assert( pThread->iTemp1Off==0 );
+    assert( pThread->nPMA==0 );
+  }
+
+  if( rc==SQLITE_OK ){
+    assert( pThread->pList==0 );
+    pThread->pList = pSorter->pRecord;
+    pThread->nInMemory = pSorter->nInMemory;
+    pThread->eWork = SORTER_THREAD_SORT;
+    pSorter->pRecord = 0;
+    pSorter->nInMemory = 0;
+    pSorter->bUsePMA = 1;
+    rc = vdbeSorterRunThread(pSorter, pThread);
   }
 
   return rc;
 }
 
+/*
+** TOP-N MODE:
+**
+** If the sorter is only required to return its N smallest records (for
+** "ORDER BY ... LIMIT N"), sqlite3VdbeSorterLimit() is called before each
+** record is added. In this case the sorter keeps at most N records in
+** aHeap[], a binary max-heap. Once the heap is full, each new record is
+** compared with the largest record retained so far (aHeap[0]) and either
+** discarded immediately, without being copied, or used to replace it.
+**
+** If the records retained still do not fit within the PMA size limit,
+** top-N mode is abandoned, the heap contents are moved to the pRecord
+** list and the sorter continues as a regular external merge sort. This is
+** safe because the records already discarded can not be among the first
+** N. The caller must still stop reading after N records in this case.
+*/
+
+/*
+** Compare records p1 and p2. Return a negative, zero or positive value
+** if p1 is smaller than, equal to or larger than p2.
+*/
+static int vdbeSorterHeapCompare(
+  const VdbeCursor *pCsr,         /* Sorter cursor */
+  SorterRecord *p1,               /* Left side of comparison */
+  SorterRecord *p2                /* Right side of comparison */
+){
+  int res;
+  vdbeSorterCompare(pCsr->pKeyInfo, pCsr->pSorter->pUnpacked, 0,
+      p1->pVal, p1->nVal, p2->pVal, p2->nVal, &res
+  );
+  return res;
+}
+
+/*
+** Restore the heap property of aHeap[] after the record at index i has
+** been replaced by a smaller one.
+*/
+static void vdbeSorterHeapSiftDown(const VdbeCursor *pCsr, int i){
+  VdbeSorter *pSorter = pCsr->pSorter;
+  SorterRecord **aHeap = pSorter->aHeap;
+  for(;;){
+    int iChild = i*2+1;
+    SorterRecord *pTmp;
+    if( iChild>=pSorter->nHeap ) break;
+    if( iChild+1<pSorter->nHeap
+     && vdbeSorterHeapCompare(pCsr, aHeap[iChild+1], aHeap[iChild])>0
+    ){
+      iChild++;
+    }
+    if( vdbeSorterHeapCompare(pCsr, aHeap[iChild], aHeap[i])<=0 ) break;
+    pTmp = aHeap[i];
+    aHeap[i] = aHeap[iChild];
+    aHeap[iChild] = pTmp;
+    i = iChild;
+  }
+}
+
+/*
+** Restore the heap property of aHeap[] after a record has been added at
+** index i.
+*/
+static void vdbeSorterHeapSiftUp(const VdbeCursor *pCsr, int i){
+  SorterRecord **aHeap = pCsr->pSorter->aHeap;
+  while( i>0 ){
+    int iParent = (i-1)/2;
+    SorterRecord *pTmp;
+    if( vdbeSorterHeapCompare(pCsr, aHeap[i], aHeap[iParent])<=0 ) break;
+    pTmp = aHeap[i];
+    aHeap[i] = aHeap[iParent];
+    aHeap[iParent] = pTmp;
+    i = iParent;
+  }
+}
+
+/*
+** Move any records in aHeap[] to the pRecord list, free the heap array
+** and leave top-N mode.
+*/
+static void vdbeSorterHeapToList(VdbeSorter *pSorter){
+  int i;
+  for(i=0; i<pSorter->nHeap; i++){
+    SorterRecord *p = pSorter->aHeap[i];
+    p->pNext = pSorter->pRecord;
+    pSorter->pRecord = p;
+  }
+  sqlite3_free(pSorter->aHeap);
+  pSorter->aHeap = 0;
+  pSorter->nHeap = 0;
+  pSorter->nHeapAlloc = 0;
+  pSorter->eHeap = SORTER_HEAP_OFF;
+}
+
+/*
+** Tell the sorter that only the nLimit smallest records will be read
+** back. This only has an effect if it is called before the first record
+** is added.
+*/
+void sqlite3VdbeSorterLimit(const VdbeCursor *pCsr, i64 nLimit){
+  VdbeSorter *pSorter = pCsr->pSorter;
+  if( pSorter->eHeap==SORTER_HEAP_UNKNOWN ){
+    assert( pSorter->pRecord==0 && pSorter->bUsePMA==0 );
+    if( nLimit>0 ){
+      pSorter->eHeap = SORTER_HEAP_ON;
+      pSorter->nLimit = nLimit;
+    }else{
+      pSorter->eHeap = SORTER_HEAP_OFF;
+    }
+  }
+}
+
+/*
+** Add a record to a sorter in top-N mode.
+*/
+static int vdbeSorterHeapWrite(const VdbeCursor *pCsr, Mem *pVal){
+  VdbeSorter *pSorter = pCsr->pSorter;
+  SorterRecord *pNew;             /* New heap element */
+  int bFull = (pSorter->nHeap>=pSorter->nLimit);
+
+  /* If the heap is full and the new record is not smaller than the
+  ** largest one retained, it can not be one of the first nLimit. */
+  if( bFull ){
+    int res;
+    SorterRecord *pMax = pSorter->aHeap[0];
+    vdbeSorterCompare(pCsr->pKeyInfo, pSorter->pUnpacked, 0,
+        pVal->z, pVal->n, pMax->pVal, pMax->nVal, &res
+    );
+    if( res>=0 ) return SQLITE_OK;
+  }else if( pSorter->nHeap>=pSorter->nHeapAlloc ){
+    SorterRecord **aNew;
+    i64 nNew = pSorter->nHeapAlloc ? pSorter->nHeapAlloc*2 : 64;
+    if( nNew>pSorter->nLimit ) nNew = pSorter->nLimit;
+    if( nNew*sizeof(SorterRecord*)>0x7fffffff ){
+      nNew = 0x7fffffff / sizeof(SorterRecord*);
+    }
+    if( nNew<=pSorter->nHeap ){
+      /* The heap can not grow any further. Sort normally instead. */
+      vdbeSorterHeapToList(pSorter);
+    }else{
+      aNew = (SorterRecord **)sqlite3_realloc(
+          pSorter->aHeap, (int)(nNew*sizeof(SorterRecord*))
+      );
+      if( aNew==0 ) return SQLITE_NOMEM;
+      pSorter->aHeap = aNew;
+      pSorter->nHeapAlloc = (int)nNew;
+    }
+  }
+
+  pNew = (SorterRecord *)sqlite3Malloc(pVal->n + sizeof(SorterRecord));
+  if( pNew==0 ) return SQLITE_NOMEM;
+  pNew->pVal = (void *)&pNew[1];
+  memcpy(pNew->pVal, pVal->z, pVal->n);
+  pNew->nVal = pVal->n;
+  pNew->pNext = 0;
+  pSorter->nInMemory += sqlite3VarintLen(pVal->n) + pVal->n;
+
+  if( pSorter->eHeap!=SORTER_HEAP_ON ){
+    pNew->pNext = pSorter->pRecord;
+    pSorter->pRecord = pNew;
+  }else if( bFull ){
+    SorterRecord *pOld = pSorter->aHeap[0];
+    pSorter->nInMemory -= sqlite3VarintLen(pOld->nVal) + pOld->nVal;
+    sqlite3_free(pOld);
+    pSorter->aHeap[0] = pNew;
+    vdbeSorterHeapSiftDown(pCsr, 0);
+  }else{
+    pSorter->aHeap[pSorter->nHeap] = pNew;
+    vdbeSorterHeapSiftUp(pCsr, pSorter->nHeap);
+    pSorter->nHeap++;
+  }
+
+  /* Fall back to a regular sort if the retained records are too large
+  ** to keep in memory.  */
+  if( pSorter->mxPmaSize>0 && pSorter->nInMemory>pSorter->mxPmaSize ){
+    vdbeSorterHeapToList(pSorter);
+  }
+  return SQLITE_OK;
+}
+
 /*
 ** Add a record to the sorter.把一个记录添加到sorter
 */
@@ -854,78 +1418,44 @@ int sqlite3VdbeSorterWrite(
   SorterRecord *pNew;             /* New list element 新列表元素*/
 
   assert( pSorter );
-  pSorter->nInMemory += sqlite3VarintLen(pVal->n) + pVal->n;
-
-  pNew = (SorterRecord *)sqlite3DbMallocRaw(db, pVal->n + sizeof(SorterRecord));
-  if( pNew==0 ){
-    rc = SQLITE_NOMEM;
+  if( pSorter->eHeap==SORTER_HEAP_ON ){
+    rc = vdbeSorterHeapWrite(pCsr, pVal);
+    if( pSorter->eHeap==SORTER_HEAP_ON ) return rc;
   }else{
-    pNew->pVal = (void *)&pNew[1];
-    memcpy(pNew->pVal, pVal->z, pVal->n);
-    pNew->nVal = pVal->n;
-    pNew->pNext = pSorter->pRecord;
-    pSorter->pRecord = pNew;
+    pSorter->eHeap = SORTER_HEAP_OFF;
+    pSorter->nInMemory += sqlite3VarintLen(pVal->n) + pVal->n;
+
+    pNew = (SorterRecord *)sqlite3Malloc(pVal->n + sizeof(SorterRecord));
+    if( pNew==0 ){
+      rc = SQLITE_NOMEM;
+    }else{
+      pNew->pVal = (void *)&pNew[1];
+      memcpy(pNew->pVal, pVal->z, pVal->n);
+      pNew->nVal = pVal->n;
+      pNew->pNext = pSorter->pRecord;
+      pSorter->pRecord = pNew;
+    }
   }
 
   /* See if the contents of the sorter should now be written out. They
   ** are written out when either of the following are true:
   ** 判断sorter的内容是不是现在就写出去，只要满足下面的条件之一就可写出
-  **   * The total memory allocated for the in-memory list is greater 
+  **   * The total memory allocated for the in-memory list is greater
   **     than (page-size * cache-size), or
   **		已经为内存中的列表分配的内存大于page-size * cache-size时
-  **   * The total memory allocated for the in-memory list is greater 
+  **   * The total memory allocated for the in-memory list is greater
   **     than (page-size * 10) and sqlite3HeapNearlyFull() returns true.
   */			//已经为内存中的列表分配的内存大于page-size * 10并且函数sqlite3HeapNearlyFull()返回真时
   if( rc==SQLITE_OK && pSorter->mxPmaSize>0 && (
         (pSorter->nInMemory>pSorter->mxPmaSize)
      || (pSorter->nInMemory>pSorter->mnPmaSize && sqlite3HeapNearlyFull())
   )){
-#ifdef SQLITE_DEBUG
-    i64 nExpect = pSorter->iWriteOff
-                + sqlite3VarintLen(pSorter->nInMemory)
-                + pSorter->nInMemory;
-#endif
-    rc = vdbeSorterListToPMA(db, pCsr);
-    pSorter->nInMemory = 0;
-    assert( rc!=SQLITE_OK || (nExpect==pSorter->iWriteOff) );
+    rc = vdbeSorterFlush(db, pSorter);
   }
 
   return rc;
 }
 
-/*
-** Helper function for sqlite3VdbeSorterRewind().
-   下面的函数是函数sqlite3VdbeSorterRewind()的辅助函数
-*/
-//函数定义20：
-static int vdbeSorterInitMerge(
-  sqlite3 *db,                    /* Database handle 数据库句柄*/
-  const VdbeCursor *pCsr,         /* Cursor handle for this sorter 此sorter的游标句柄*/
-  i64 *pnByte                     /* Sum of bytes in all opened PMAs 所有PMA中的字节总和*/
-){
-  VdbeSorter *pSorter = pCsr->pSorter;
-  int rc = SQLITE_OK;             /* Return code 返回码*/
-  int i;                          /* Used to iterator through aIter[] 循环变量*/
-  i64 nByte = 0;                  /* Total bytes in all opened PMAs 所有PMA中的字节总和*/
-
-  /* Initialize the iterators. 初始化iterators*/
-  for(i=0; i<SORTER_MAX_MERGE_COUNT; i++){
-    VdbeSorterIter *pIter = &pSorter->aIter[i];
-    rc = vdbeSorterIterInit(db, pSorter, pSorter->iReadOff, pIter, &nByte);
-    pSorter->iReadOff = pIter->iEof;
-    assert( rc!=SQLITE_OK || pSorter->iReadOff<=pSorter->iWriteOff );
-    if( rc!=SQLITE_OK || pSorter->iReadOff>=pSorter->iWriteOff ) break;
-  }
-
-  /* Initialize the aTree[] array. 初始化aTree[]数组*/
-  for(i=pSorter->nTree-1; rc==SQLITE_OK && i>0; i--){
-    rc = vdbeSorterDoCompare(pCsr, i);
-  }
-
-  *pnByte = nByte;
-  return rc;
-}
-
 /*
 ** Once the sorter has been populated, this function is called to prepare
 ** for iterating through its contents in sorted order.
@@ -934,112 +1464,89 @@ static int vdbeSorterInitMerge(
 //函数定义21：
 int sqlite3VdbeSorterRewind(sqlite3 *db, const VdbeCursor *pCsr, int *pbEof){
   VdbeSorter *pSorter = pCsr->pSorter;
-  int rc;                         /* Return code 返回码*/
-  sqlite3_file *pTemp2 = 0;       /* Second temp file to use 要使用的第二个临时文件*/
-  i64 iWrite2 = 0;                /* Write offset for pTemp2 为pTemp2定义偏移量*/
-  int nIter;                      /* Number of iterators used 被使用的迭代器的个数*/
-  int nByte;                      /* Bytes of space required for aIter/aTree ——aIter/aTree需要的空间的字节数*/
-  int N = 2;                      /* Power of 2 >= nIter ；2的幂>= nIter*/
+  int rc = SQLITE_OK;             /* Return code 返回码*/
+  int rc2;
+  int nActive = 0;                /* Number of slots containing PMAs */
+  int nIter = 0;                  /* Number of iterators used 被使用的迭代器的个数*/
+  int i;
 
   assert( pSorter );
+  if( pSorter->eHeap==SORTER_HEAP_ON ){
+    vdbeSorterHeapToList(pSorter);
+  }
 
   /* If no data has been written to disk, then do not do so now. Instead,
   ** sort the VdbeSorter.pRecord list. The vdbe layer will read data directly
-  ** from the in-memory list.  
+  ** from the in-memory list.
      如果还没有数据被写到磁盘，现在就先暂时不做。而是对VdbeSorter.pRecord list进行排序，vdbe层将直接从内存列表里读数据
   */
-  if( pSorter->nPMA==0 ){
+  if( pSorter->bUsePMA==0 ){
     *pbEof = !pSorter->pRecord;
-    assert( pSorter->aTree==0 );
-    return vdbeSorterSort(pCsr);
+    assert( pSorter->pMerger==0 );
+    return vdbeSorterSort(pCsr->pKeyInfo, pSorter->pUnpacked, &pSorter->pRecord);
   }
 
-  /* Write the current in-memory list to a PMA. 把当前内存中的列表写到PMA中去*/
-  rc = vdbeSorterListToPMA(db, pCsr);
+  /* Write the current in-memory list to a PMA, then wait for all slots to
+  ** finish writing. 把当前内存中的列表写到PMA中去*/
+  if( pSorter->pRecord ){
+    rc = vdbeSorterFlush(db, pSorter);
+  }
+  for(i=0; i<pSorter->nThread; i++){
+    rc2 = vdbeSorterJoinThread(&pSorter->aThread[i]);
+    if( rc==SQLITE_OK ) rc = rc2;
+    if( pSorter->aThread[i].nPMA>0 ) nActive++;
+  }
   if( rc!=SQLITE_OK ) return rc;
-
-  /* Allocate space for aIter[] and aTree[]. 为aIter[] 和 aTree[]分配空间*/
-  nIter = pSorter->nPMA;
-  if( nIter>SORTER_MAX_MERGE_COUNT ) nIter = SORTER_MAX_MERGE_COUNT;
-  assert( nIter>0 );
-  while( N<nIter ) N += N;
-  nByte = N * (sizeof(int) + sizeof(VdbeSorterIter));
-  pSorter->aIter = (VdbeSorterIter *)sqlite3DbMallocZero(db, nByte);
-  if( !pSorter->aIter ) return SQLITE_NOMEM;
-  pSorter->aTree = (int *)&pSorter->aIter[N];
-  pSorter->nTree = N;
-
-  do {
-    int iNew;                     /* Index of new, merged, PMA 新合并进来的PMA的下标*/
-
-    for(iNew=0; 
-        rc==SQLITE_OK && iNew*SORTER_MAX_MERGE_COUNT<pSorter->nPMA; 
-        iNew++
-    ){
-      int rc2;                    /* Return code from fileWriterFinish() ；从函数fileWriterFinish()返回的返回码*/
-      FileWriter writer;          /* Object used to write to disk 用来往磁盘里写数据的实例*/
-      i64 nWrite;                 /* Number of bytes in new PMA 新PMA中的字节数目*/
-
-      memset(&writer, 0, sizeof(FileWriter));
-
-      /* If there are SORTER_MAX_MERGE_COUNT or less PMAs in file pTemp1,
-      ** initialize an iterator for each of them and break out of the loop.
-      ** These iterators will be incrementally merged as the VDBE layer calls
-      ** sqlite3VdbeSorterNext().
-      ** 如果文件pTemp1中有SORTER_MAX_MERGE_COUNT个或者更少的PMA，就为他们各初始化一个迭代器，
-		 然后跳出循环。
-      ** Otherwise, if pTemp1 contains more than SORTER_MAX_MERGE_COUNT PMAs,
-      ** initialize interators for SORTER_MAX_MERGE_COUNT of them. These PMAs
-      ** are merged into a single PMA that is written to file pTemp2.
-		 否则，如果文件pTemp1中有多于SORTER_MAX_MERGE_COUNT个的PMA，就为其中的SORTER_MAX_MERGE_COUNT个PMA各初始化一个迭代器，
-		 把这些PMA合并成一个PMA，并把它写入文件pTemp2中
-      */
-      rc = vdbeSorterInitMerge(db, pCsr, &nWrite);
-      assert( rc!=SQLITE_OK || pSorter->aIter[ pSorter->aTree[1] ].pFile );
-      if( rc!=SQLITE_OK || pSorter->nPMA<=SORTER_MAX_MERGE_COUNT ){
-        break;
+  assert( nActive>0 && nActive<=SORTER_MAX_MERGE_COUNT );
+
+  /* The final merge can read at most SORTER_MAX_MERGE_COUNT PMAs. Share
+  ** these between the slots and have each slot that holds more than its
+  ** share reduce them, in parallel if worker threads are in use. */
+  for(i=0; rc==SQLITE_OK && i<pSorter->nThread; i++){
+    SorterThread *pThread = &pSorter->aThread[i];
+    pThread->nTarget = SORTER_MAX_MERGE_COUNT / nActive;
+    if( pThread->nTarget<1 ) pThread->nTarget = 1;
+    if( pThread->nPMA>pThread->nTarget ){
+      if( pThread->pTemp2==0 ){
+        rc = vdbeSorterOpenTempFile(db, &pThread->pTemp2);
       }
-
-      /* Open the second temp file, if it is not already open. 如果第二个临时文件还没打开的话，则现在就打开*/
-      if( pTemp2==0 ){
-        assert( iWrite2==0 );
-        rc = vdbeSorterOpenTempFile(db, &pTemp2);
-      }
-
       if( rc==SQLITE_OK ){
-        int bEof = 0;
-        fileWriterInit(db, pTemp2, &writer, iWrite2);
-        fileWriterWriteVarint(&writer, nWrite);
-        while( rc==SQLITE_OK && bEof==0 ){
-          VdbeSorterIter *pIter = &pSorter->aIter[ pSorter->aTree[1] ];
-          assert( pIter->pFile );
-
-          fileWriterWriteVarint(&writer, pIter->nKey);
-          fileWriterWrite(&writer, pIter->aKey, pIter->nKey);
-          rc = sqlite3VdbeSorterNext(db, pCsr, &bEof);
-        }
-        rc2 = fileWriterFinish(db, &writer, &iWrite2);
-        if( rc==SQLITE_OK ) rc = rc2;
+        pThread->eWork = SORTER_THREAD_REDUCE;
+        rc = vdbeSorterRunThread(pSorter, pThread);
       }
     }
+  }
+  for(i=0; i<pSorter->nThread; i++){
+    rc2 = vdbeSorterJoinThread(&pSorter->aThread[i]);
+    if( rc==SQLITE_OK ) rc = rc2;
+    nIter += pSorter->aThread[i].nPMA;
+  }
+  if( rc!=SQLITE_OK ) return rc;
 
-    if( pSorter->nPMA<=SORTER_MAX_MERGE_COUNT ){
-      break;
-    }else{
-      sqlite3_file *pTmp = pSorter->pTemp1;
-      pSorter->nPMA = iNew;
-      pSorter->pTemp1 = pTemp2;
-      pTemp2 = pTmp;
-      pSorter->iWriteOff = iWrite2;
-      pSorter->iReadOff = 0;
-      iWrite2 = 0;
+  /* Open an iterator on each remaining PMA. These iterators will be
+  ** incrementally merged as the VDBE layer calls sqlite3VdbeSorterNext(). */
+  assert( nIter>0 && nIter<=SORTER_MAX_MERGE_COUNT );
+  pSorter->pMerger = vdbeSorterMergerNew(
+      nIter, pCsr->pKeyInfo, pSorter->pUnpacked
+  );
+  if( pSorter->pMerger==0 ) return SQLITE_NOMEM;
+  nIter = 0;
+  for(i=0; rc==SQLITE_OK && i<pSorter->nThread; i++){
+    SorterThread *pThread = &pSorter->aThread[i];
+    i64 iRead = 0;
+    int j;
+    for(j=0; rc==SQLITE_OK && j<pThread->nPMA; j++){
+      i64 nDummy = 0;
+      VdbeSorterIter *pIter = &pSorter->pMerger->aIter[nIter++];
+      rc = vdbeSorterIterInit(pThread->pTemp1, pThread->iTemp1Off,
+          pThread->pgsz, iRead, pIter, &nDummy
+      );
+      iRead = pIter->iEof;
     }
-  }while( rc==SQLITE_OK );
-
-  if( pTemp2 ){
-    sqlite3OsCloseFree(pTemp2);
   }
-  *pbEof = (pSorter->aIter[pSorter->aTree[1]].pFile==0);
+  if( rc==SQLITE_OK ) rc = vdbeSorterMergerInit(pSorter->pMerger);
+
+  *pbEof = (pSorter->pMerger->aIter[pSorter->pMerger->aTree[1]].pFile==0);
   return rc;
 }
 
@@ -1051,21 +1558,14 @@ int sqlite3VdbeSorterNext(sqlite3 *db, const VdbeCursor *pCsr, int *pbEof){
   VdbeSorter *pSorter = pCsr->pSorter;
   int rc;                         /* 返回码 Return code */
 
-  if( pSorter->aTree ){
-    int iPrev = pSorter->aTree[1];/* Index of iterator to advance 要前进的迭代器的下标*/
-    int i;                        /* Index of aTree[] to recalculate 要重算的数组aTree[]中元素的下标*/
-
-    rc = vdbeSorterIterNext(db, &pSorter->aIter[iPrev]);
-    for(i=(pSorter->nTree+iPrev)/2; rc==SQLITE_OK && i>0; i=i/2){
-      rc = vdbeSorterDoCompare(pCsr, i);
-    }
-
-    *pbEof = (pSorter->aIter[pSorter->aTree[1]].pFile==0);
+  UNUSED_PARAMETER(db);
+  if( pSorter->pMerger ){
+    rc = vdbeSorterMergerNext(pSorter->pMerger, pbEof);
   }else{
     SorterRecord *pFree = pSorter->pRecord;
     pSorter->pRecord = pFree->pNext;
     pFree->pNext = 0;
-    vdbeSorterRecordFree(db, pFree);
+    vdbeSorterRecordFree(pFree);
     *pbEof = !pSorter->pRecord;
     rc = SQLITE_OK;
   }
@@ -1075,7 +1575,7 @@ int sqlite3VdbeSorterNext(sqlite3 *db, const VdbeCursor *pCsr, int *pbEof){
 /*
 ** Return a pointer to a buffer owned by the sorter that contains the current key.
    返回一个指针给buffer，这个buffer是包含当前key的sorter的
-** 
+**
 */
 //函数定义23：
 static void *vdbeSorterRowkey(
@@ -1083,9 +1583,9 @@ static void *vdbeSorterRowkey(
   int *pnKey                      /* OUT: Size of current key in bytes 输出：当前值得字节数大小*/
 ){
   void *pKey;
-  if( pSorter->aTree ){
+  if( pSorter->pMerger ){
     VdbeSorterIter *pIter;
-    pIter = &pSorter->aIter[ pSorter->aTree[1] ];
+    pIter = &pSorter->pMerger->aIter[ pSorter->pMerger->aTree[1] ];
     *pnKey = pIter->nKey;
     pKey = pIter->aKey;
   }else{
@@ -1123,7 +1623,7 @@ int sqlite3VdbeSorterRowkey(const VdbeCursor *pCsr, Mem *pOut){
 ** Otherwise, set *pRes to a negative, zero or positive value if the
 ** key in pVal is smaller than, equal to or larger than the current sorter
 ** key.
-	如有错误发生，就返回一个SQLite错误码；否则把*pRes设置成一个负数，0，或正数，分别对应pVal中的key比当前sorter key小、相等或大。	
+	如有错误发生，就返回一个SQLite错误码；否则把*pRes设置成一个负数，0，或正数，分别对应pVal中的key比当前sorter key小、相等或大。
 */
 //函数定义25：
 int sqlite3VdbeSorterCompare(
@@ -1135,7 +1635,9 @@ int sqlite3VdbeSorterCompare(
   void *pKey; int nKey;           /* Sorter key to compare pVal with 要和pVal相比较的sorter key*/
 
   pKey = vdbeSorterRowkey(pSorter, &nKey);
-  vdbeSorterCompare(pCsr, 1, pVal->z, pVal->n, pKey, nKey, pRes);
+  vdbeSorterCompare(pCsr->pKeyInfo, pSorter->pUnpacked, 1,
+      pVal->z, pVal->n, pKey, nKey, pRes
+  );
   return SQLITE_OK;
 }
 
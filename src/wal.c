@@ -271,6 +271,14 @@ int sqlite3WalTrace = 0;
 #define WAL_MAX_VERSION      3007000
 #define WALINDEX_MAX_VERSION 3007000
 
+/*
+** The versions of the wal and wal-index formats used by databases in
+** wal2 mode (see "WAL2 MODE" below). A connection only accepts the pair
+** of versions that matches the mode it opened the WAL in.
+*/
+#define WAL2_MAX_VERSION      3007015
+#define WALINDEX2_MAX_VERSION 3007015
+
 /*
 ** Indices of various locking bytes.   WAL_NREADER is the number
 ** of available reader locks and should be at least 3.定义各种锁的字节
@@ -282,11 +290,67 @@ int sqlite3WalTrace = 0;
 #define WAL_READ_LOCK(I)       (3+(I))
 #define WAL_NREADER            (SQLITE_SHM_NLOCK-3)
 
+/*
+** WAL2 MODE
+**
+** In wal2 mode a database uses two write-ahead log files, "<db>-wal" and
+** "<db>-wal2", instead of one.  Writers append to the "current" file
+** only.  Checkpointers only ever copy frames from the other file.  Once
+** the other file has been completely checkpointed and the current file
+** holds at least SQLITE_WAL2_LIMIT frames, the next writer switches the
+** roles of the two files and starts overwriting the one that was just
+** checkpointed.  Because a checkpoint never touches the file that
+** readers are adding to, it can always finish and the WAL stops growing
+** even if there is never a moment without readers.
+**
+** The wal-index header field mxFrame2 holds the number of valid frames
+** in the non-current file in its low 31 bits, and the index (0 or 1) of
+** the current file in bit 31.  WalIndexHdr.mxFrame, aFrameCksum[] and
+** aSalt[] always describe the current file, and WalCkptInfo.nBackfill
+** always refers to the non-current file.  The salt-1 value of each file
+** is one greater than that of the file before it, which is how recovery
+** works out which file is current.
+**
+** Hash tables for the two files are interleaved in the wal-index: file 0
+** uses the first table and every second table after it, file 1 uses the
+** others.  wal2IndexFrame() and wal2FileFrame() convert between frame
+** numbers within a file and frame numbers in the wal-index.
+**
+** The aReadMark[] array is not used.  Instead, the read lock that a
+** reader holds describes its snapshot:
+**
+**   WAL_READ_LOCK(0)                 - the database file only,
+**   WAL_READ_LOCK(WAL2_LOCK_PART(i)) - part (or all) of file i only,
+**   WAL_READ_LOCK(WAL2_LOCK_PARTFULL(i)) - part (or all) of file i plus
+**                                      all frames of the other file.
+**
+** A checkpointer must hold an exclusive lock on slot 0 and on both slots
+** that refer to the file it checkpoints.  A writer switching to file i
+** must hold exclusive locks on both slots that refer to file i and on
+** the slot that refers to the other file in full.
+*/
+#define WAL2_LOCK_PART(i)      (1+2*(i))
+#define WAL2_LOCK_PARTFULL(i)  (2+2*(i))
+#define wal2Current(pHdr)      ((int)((pHdr)->mxFrame2>>31))
+#define wal2OtherFrames(pHdr)  ((pHdr)->mxFrame2 & 0x7fffffff)
+
+/*
+** In wal2 mode, the first writer after the current WAL file has grown to
+** this many frames switches to the other file, provided the other file
+** has been checkpointed.
+*/
+#ifndef SQLITE_WAL2_LIMIT
+# define SQLITE_WAL2_LIMIT SQLITE_DEFAULT_WAL_AUTOCHECKPOINT
+#endif
+
 
 /* Object declarations  结构的声明*/
 typedef struct WalIndexHdr WalIndexHdr;
 typedef struct WalIterator WalIterator;
 typedef struct WalCkptInfo WalCkptInfo;
+typedef struct WalGroup WalGroup;
+typedef struct WalFilter WalFilter;
+typedef struct WalReaders WalReaders;
 
 
 /*
@@ -301,7 +365,7 @@ typedef struct WalCkptInfo WalCkptInfo;
 */
 struct WalIndexHdr {
   u32 iVersion;                   /* Wal-index version */          //Wal-index版本信息                               //wal版本
-  u32 unused;                     /* Unused (padding) field */    // 没有过的地方                                    //未使用区域
+  u32 mxFrame2;                   /* wal2: other file frames, current<<31 */
   u32 iChange;                    /* Counter incremented each transaction *///记录每个事务的增长                     // 每次事务的计数器
   u8 isInit;                      /* 1 when initialized */// 当初始化时是  1        
   u8 bigEndCksum;                 /* True if checksums in WAL are big-endian *///如果在WAl的总和检查是二进制则为true  //判断wal中的checksum的类型是否为big-endian 
@@ -429,8 +493,26 @@ struct Wal {
   u8 syncHeader;             /* Fsync the WAL header if true */                                //如果以Fsync为首的WAL为true
   u8 padToSectorBoundary;    /* Pad transactions out to the next sector */                      //与下一个区进行通信
   WalIndexHdr hdr;           /* Wal-index header for current transaction *///当前事务 Wal-index header//为当前事务wal索引头
+  sqlite3_file *pWalFd2;     /* File handle for the second wal2 file */
+  const char *zWalName2;     /* Name of the second wal2 file */
+  u8 bWal2;                  /* True if this is a wal2 mode WAL */
   const char *zWalName;      /* Name of WAL file */                                            //WAL文件的文件名
   u32 nCkpt;                 /* Checkpoint sequence counter in the wal-header *///wal-header检查点序列计数器 //wal检查点序列计数器
+  u32 nCkptStep;             /* Max frames per PASSIVE checkpoint, or 0 */
+  WalGroup *pGroup;          /* Group commit state, or NULL if disabled */
+  int nGroupWindow;          /* Microseconds a group commit leader waits */
+  int groupSyncFlags;        /* Flags for the deferred commit sync */
+  u8 bGroupIntent;           /* True if a write should follow the next read */
+  u8 bGroupRead;             /* True if reading a pending group commit */
+  u8 bGroupWriter;           /* True if writing under the group owner's lock */
+  u8 eGroupCommit;           /* WAL_GROUP_PENDING or WAL_GROUP_DONE, or 0 */
+  int rcGroup;               /* Result of the group sync once DONE */
+  Wal *pGroupNext;           /* Next in WalGroup.pPending list */
+  WalFilter **apFilter;      /* Page filters for full hash tables */
+  int nFilter;               /* Size of array apFilter[] */
+  u32 aFilterSalt[2];        /* hdr.aSalt[] the filters were built for */
+  WalReaders *pReaders;      /* Shared readers state, or NULL if disabled */
+  u8 bPinRead;               /* True if readLock is the WalReaders pin */
 #ifdef SQLITE_DEBUG
   u8 lockError;              /* True if a locking error has occurred */                         //发生锁定错误时
 #endif
@@ -504,6 +586,40 @@ struct WalIterator {
 */
 #define HASHTABLE_NPAGE_ONE  (HASHTABLE_NPAGE - (WALINDEX_HDR_SIZE/sizeof(u32)))
 
+/*
+** Each connection keeps a private summary of every wal-index hash table
+** that is completely filled by frames of its snapshot. Such a table can
+** not change until the WAL is restarted, which also changes the salt
+** values in the wal-index header. The summary is a bloom filter with two
+** bits set for each page number in the table, together with the largest
+** page number in the table, so that sqlite3WalFindFrame() can usually
+** skip a table without probing its hash slots.
+**
+** A filter is built the first time its hash table is searched, and all
+** filters are discarded when the salt values change. A rollback that
+** moves mxFrame back also discards the filters of the tables that will
+** be refilled (see walFilterTruncate()).
+*/
+#define WALFILTER_NBIT   (HASHTABLE_NPAGE*8)      /* Must be 2^WALFILTER_SHIFT */
+#define WALFILTER_SHIFT  15
+struct WalFilter {
+  u32 mxPgno;                     /* Largest page number in the table */
+  u32 aBit[WALFILTER_NBIT/32];    /* Bloom filter bits */
+};
+#define walFilterHash1(P) (((u32)(P)*0x9E3779B1)>>(32-WALFILTER_SHIFT))
+#define walFilterHash2(P) (((u32)(P)*0x85EBCA6B)>>(32-WALFILTER_SHIFT))
+
+/*
+** Discard all page filters built by this connection.
+*/
+static void walFilterReset(Wal *pWal){
+  int i;
+  for(i=0; i<pWal->nFilter; i++){
+    sqlite3_free(pWal->apFilter[i]);
+    pWal->apFilter[i] = 0;
+  }
+}
+
 /* The wal-index is divided into pages of WALINDEX_PGSZ bytes each. */
 #define WALINDEX_PGSZ   (                                         \
     sizeof(ht_slot)*HASHTABLE_NSLOT + HASHTABLE_NPAGE*sizeof(u32) \
@@ -595,6 +711,277 @@ static volatile WalIndexHdr *walIndexHdr(Wal *pWal){
   + (((x)&0x00FF0000)>>8)  + (((x)&0xFF000000)>>24) \
 )
 
+/*
+** The checksum is a linear function of its inputs (modulo 2^32). One
+** step maps the state (s1,s2) and the input words (x0,x1) to
+**
+**     s1' = s1 + s2 + x0
+**     s2' = s1 + 2*s2 + x0 + x1
+**
+** so 8 steps are the same as multiplying (s1,s2) by a constant 2x2 matrix
+** and adding a weighted sum of the 16 input words. The matrix entries and
+** the weights are all Fibonacci numbers. Because every operation is a
+** 32-bit add or multiply, this gives exactly the same result as the
+** step-by-step loop. The weighted sums have no serial dependency, so the
+** code below computes them with SIMD instructions 64 bytes at a time.
+** Each vector lane keeps its own partial (s1,s2). The lanes are added
+** together at the end.
+**
+** On x86 the SSE2 code is always available and the AVX2 code is used if
+** the CPU supports it. On ARM, NEON is used if the compiler targets it.
+** Define SQLITE_DISABLE_WAL_SIMD to use the portable C code only.
+*/
+#if !defined(SQLITE_DISABLE_WAL_SIMD) && defined(__GNUC__) \
+ && (defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__)))
+# include <emmintrin.h>
+# define WAL_CKSUM_SSE2 1
+# if defined(__clang__) || __GNUC__>4 || (__GNUC__==4 && __GNUC_MINOR__>=9)
+#  include <immintrin.h>
+#  define WAL_CKSUM_AVX2 1
+# endif
+#elif !defined(SQLITE_DISABLE_WAL_SIMD) && defined(__GNUC__) \
+ && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+# include <arm_neon.h>
+# define WAL_CKSUM_NEON 1
+#endif
+#if defined(WAL_CKSUM_SSE2) || defined(WAL_CKSUM_NEON)
+# define WAL_CKSUM_SIMD 1
+#endif
+
+#ifdef WAL_CKSUM_SIMD
+/*
+** The weights applied to each of the 16 words of a 64-byte block. Word
+** 2k is multiplied by aCksumW1[2k] to compute its contribution to s1 and
+** by aCksumW2[2k] to compute its contribution to s2.
+*/
+static const u32 aCksumW1[16] = {
+  610, 377, 233, 144, 89, 55, 34, 21, 13, 8, 5, 3, 2, 1, 1, 0
+};
+static const u32 aCksumW2[16] = {
+  987, 610, 377, 233, 144, 89, 55, 34, 21, 13, 8, 5, 3, 2, 1, 1
+};
+
+/*
+** The matrix that 8 checksum steps apply to (s1,s2).
+*/
+#define WAL_CKSUM_M11  610
+#define WAL_CKSUM_M12  987
+#define WAL_CKSUM_M22 1597
+#endif /* WAL_CKSUM_SIMD */
+
+#ifdef WAL_CKSUM_SSE2
+/*
+** Multiply the 32-bit lanes of a and b and keep the low 32 bits of each
+** product. SSE2 has no instruction for this.
+*/
+static __m128i walMullo32(__m128i a, __m128i b){
+  __m128i e = _mm_mul_epu32(a, b);
+  __m128i o = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+  return _mm_unpacklo_epi32(
+      _mm_shuffle_epi32(e, _MM_SHUFFLE(0,0,2,0)),
+      _mm_shuffle_epi32(o, _MM_SHUFFLE(0,0,2,0))
+  );
+}
+
+/*
+** Reverse the byte order of each 32-bit lane of x.
+*/
+static __m128i walBswap32x4(__m128i x){
+  x = _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8));
+  return _mm_shufflehi_epi16(_mm_shufflelo_epi16(x, 0xB1), 0xB1);
+}
+
+/*
+** Return the sum of the four 32-bit lanes of x.
+*/
+static u32 walHsum32x4(__m128i x){
+  x = _mm_add_epi32(x, _mm_shuffle_epi32(x, _MM_SHUFFLE(1,0,3,2)));
+  x = _mm_add_epi32(x, _mm_shuffle_epi32(x, _MM_SHUFFLE(2,3,0,1)));
+  return (u32)_mm_cvtsi128_si32(x);
+}
+
+/*
+** Add nBlock 64-byte blocks starting at a[] to the checksum (*pS1,*pS2)
+** using SSE2.
+*/
+static void walChecksumSse2(
+  int nativeCksum, const u8 *a, int nBlock, u32 *pS1, u32 *pS2
+){
+  const __m128i m11 = _mm_set1_epi32(WAL_CKSUM_M11);
+  const __m128i m12 = _mm_set1_epi32(WAL_CKSUM_M12);
+  const __m128i m22 = _mm_set1_epi32(WAL_CKSUM_M22);
+  __m128i aW1[4], aW2[4];
+  __m128i v1 = _mm_cvtsi32_si128((int)*pS1);
+  __m128i v2 = _mm_cvtsi32_si128((int)*pS2);
+  int i, j;
+
+  for(j=0; j<4; j++){
+    aW1[j] = _mm_loadu_si128((const __m128i*)&aCksumW1[j*4]);
+    aW2[j] = _mm_loadu_si128((const __m128i*)&aCksumW2[j*4]);
+  }
+  for(i=0; i<nBlock; i++, a+=64){
+    __m128i n1 = _mm_add_epi32(walMullo32(v1, m11), walMullo32(v2, m12));
+    __m128i n2 = _mm_add_epi32(walMullo32(v1, m12), walMullo32(v2, m22));
+    for(j=0; j<4; j++){
+      __m128i x = _mm_loadu_si128((const __m128i*)&a[j*16]);
+      if( !nativeCksum ) x = walBswap32x4(x);
+      n1 = _mm_add_epi32(n1, walMullo32(x, aW1[j]));
+      n2 = _mm_add_epi32(n2, walMullo32(x, aW2[j]));
+    }
+    v1 = n1;
+    v2 = n2;
+  }
+  *pS1 = walHsum32x4(v1);
+  *pS2 = walHsum32x4(v2);
+}
+#endif /* WAL_CKSUM_SSE2 */
+
+#ifdef WAL_CKSUM_AVX2
+/*
+** Add nBlock 64-byte blocks starting at a[] to the checksum (*pS1,*pS2)
+** using AVX2. The caller must check that the CPU supports AVX2.
+*/
+__attribute__((target("avx2")))
+static void walChecksumAvx2(
+  int nativeCksum, const u8 *a, int nBlock, u32 *pS1, u32 *pS2
+){
+  const __m256i m11 = _mm256_set1_epi32(WAL_CKSUM_M11);
+  const __m256i m12 = _mm256_set1_epi32(WAL_CKSUM_M12);
+  const __m256i m22 = _mm256_set1_epi32(WAL_CKSUM_M22);
+  const __m256i bswap = _mm256_setr_epi8(
+      3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+      3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12
+  );
+  const __m256i w1a = _mm256_loadu_si256((const __m256i*)&aCksumW1[0]);
+  const __m256i w1b = _mm256_loadu_si256((const __m256i*)&aCksumW1[8]);
+  const __m256i w2a = _mm256_loadu_si256((const __m256i*)&aCksumW2[0]);
+  const __m256i w2b = _mm256_loadu_si256((const __m256i*)&aCksumW2[8]);
+  __m256i v1 = _mm256_setr_epi32((int)*pS1, 0, 0, 0, 0, 0, 0, 0);
+  __m256i v2 = _mm256_setr_epi32((int)*pS2, 0, 0, 0, 0, 0, 0, 0);
+  __m128i h1, h2;
+  int i;
+
+  for(i=0; i<nBlock; i++, a+=64){
+    __m256i xa = _mm256_loadu_si256((const __m256i*)&a[0]);
+    __m256i xb = _mm256_loadu_si256((const __m256i*)&a[32]);
+    __m256i n1, n2;
+    if( !nativeCksum ){
+      xa = _mm256_shuffle_epi8(xa, bswap);
+      xb = _mm256_shuffle_epi8(xb, bswap);
+    }
+    n1 = _mm256_add_epi32(
+        _mm256_mullo_epi32(v1, m11), _mm256_mullo_epi32(v2, m12));
+    n2 = _mm256_add_epi32(
+        _mm256_mullo_epi32(v1, m12), _mm256_mullo_epi32(v2, m22));
+    n1 = _mm256_add_epi32(n1, _mm256_add_epi32(
+        _mm256_mullo_epi32(xa, w1a), _mm256_mullo_epi32(xb, w1b)));
+    n2 = _mm256_add_epi32(n2, _mm256_add_epi32(
+        _mm256_mullo_epi32(xa, w2a), _mm256_mullo_epi32(xb, w2b)));
+    v1 = n1;
+    v2 = n2;
+  }
+  h1 = _mm_add_epi32(_mm256_castsi256_si128(v1), _mm256_extracti128_si256(v1,1));
+  h2 = _mm_add_epi32(_mm256_castsi256_si128(v2), _mm256_extracti128_si256(v2,1));
+  *pS1 = walHsum32x4(h1);
+  *pS2 = walHsum32x4(h2);
+}
+#endif /* WAL_CKSUM_AVX2 */
+
+#ifdef WAL_CKSUM_NEON
+/*
+** Add nBlock 64-byte blocks starting at a[] to the checksum (*pS1,*pS2)
+** using NEON.
+*/
+static void walChecksumNeon(
+  int nativeCksum, const u8 *a, int nBlock, u32 *pS1, u32 *pS2
+){
+  uint32x4_t aW1[4], aW2[4];
+  uint32x4_t v1 = vsetq_lane_u32(*pS1, vdupq_n_u32(0), 0);
+  uint32x4_t v2 = vsetq_lane_u32(*pS2, vdupq_n_u32(0), 0);
+  uint32x2_t h;
+  int i, j;
+
+  for(j=0; j<4; j++){
+    aW1[j] = vld1q_u32(&aCksumW1[j*4]);
+    aW2[j] = vld1q_u32(&aCksumW2[j*4]);
+  }
+  for(i=0; i<nBlock; i++, a+=64){
+    uint32x4_t n1 = vmulq_n_u32(v1, WAL_CKSUM_M11);
+    uint32x4_t n2 = vmulq_n_u32(v1, WAL_CKSUM_M12);
+    n1 = vmlaq_n_u32(n1, v2, WAL_CKSUM_M12);
+    n2 = vmlaq_n_u32(n2, v2, WAL_CKSUM_M22);
+    for(j=0; j<4; j++){
+      uint8x16_t b = vld1q_u8(&a[j*16]);
+      uint32x4_t x;
+      if( !nativeCksum ) b = vrev32q_u8(b);
+      x = vreinterpretq_u32_u8(b);
+      n1 = vmlaq_u32(n1, x, aW1[j]);
+      n2 = vmlaq_u32(n2, x, aW2[j]);
+    }
+    v1 = n1;
+    v2 = n2;
+  }
+  h = vadd_u32(vget_low_u32(v1), vget_high_u32(v1));
+  *pS1 = vget_lane_u32(h, 0) + vget_lane_u32(h, 1);
+  h = vadd_u32(vget_low_u32(v2), vget_high_u32(v2));
+  *pS2 = vget_lane_u32(h, 0) + vget_lane_u32(h, 1);
+}
+#endif /* WAL_CKSUM_NEON */
+
+#ifdef WAL_CKSUM_SIMD
+/*
+** Add as many whole 64-byte blocks of a[] as possible to the checksum
+** (*pS1,*pS2), using the best implementation this CPU supports. Return
+** the number of bytes consumed.
+*/
+static int walChecksumVector(
+  int nativeCksum, const u8 *a, int nByte, u32 *pS1, u32 *pS2
+){
+  int nBlock = nByte/64;
+#if defined(WAL_CKSUM_AVX2)
+  /* This is a benign race. Every thread that tests the CPU gets the
+  ** same answer. */
+  static int hasAvx2 = -1;
+  if( hasAvx2<0 ) hasAvx2 = __builtin_cpu_supports("avx2")!=0;
+  if( hasAvx2 ){
+    walChecksumAvx2(nativeCksum, a, nBlock, pS1, pS2);
+  }else{
+    walChecksumSse2(nativeCksum, a, nBlock, pS1, pS2);
+  }
+#elif defined(WAL_CKSUM_SSE2)
+  walChecksumSse2(nativeCksum, a, nBlock, pS1, pS2);
+#else
+  walChecksumNeon(nativeCksum, a, nBlock, pS1, pS2);
+#endif
+  return nBlock*64;
+}
+#endif /* WAL_CKSUM_SIMD */
+
+/*
+** Add the 8-byte words from aData[] up to (but not including) aEnd[] to 
+** the checksum (*pS1,*pS2), one step at a time.
+*/
+static void walChecksumScalar(
+  int nativeCksum, u32 *aData, u32 *aEnd, u32 *pS1, u32 *pS2
+){
+  u32 s1 = *pS1;
+  u32 s2 = *pS2;
+  if( nativeCksum ){
+    while( aData<aEnd ){
+      s1 += *aData++ + s2;
+      s2 += *aData++ + s1;
+    }
+  }else{
+    while( aData<aEnd ){
+      s1 += BYTESWAP32(aData[0]) + s2;
+      s2 += BYTESWAP32(aData[1]) + s1;
+      aData += 2;
+    }
+  }
+  *pS1 = s1;
+  *pS2 = s2;
+}
+
 /*
 ** Generate or extend an 8 byte checksum based on the data in 
 ** array aByte[] and the initial values of aIn[0] and aIn[1] (or
@@ -628,8 +1015,7 @@ static void walChecksumBytes(
   u32 *aOut        /* OUT: Final checksum value output */                         //最后校验值的输出
 ){
   u32 s1, s2;                                                                    //定义u32类型的变量s1、s2
-  u32 *aData = (u32 *)a;                                                        //定义u32类型指针aData，并且指向a
-  u32 *aEnd = (u32 *)&a[nByte];             
+  int iOff = 0;
 
   if( aIn ){                                                                    //如果aIn不为空
     s1 = aIn[0];                                                                //把aIn[0]的值赋给s1
@@ -641,44 +1027,85 @@ static void walChecksumBytes(
   assert( nByte>=8 );                                                        //如果nByteb不大于8为假，则终止程序 
   assert( (nByte&0x00000007)==0 );                                         // 如果 nByte 不是8的倍数 ，则程序终止
 
-  if( nativeCksum ){                                                   //如果nativeCksum 为真，则
-    do {
-      s1 += *aData++ + s2;
-      s2 += *aData++ + s1;
-    }while( aData<aEnd );
-  }else{                                                              //否则
-    do {
-      s1 += BYTESWAP32(aData[0]) + s2;
-      s2 += BYTESWAP32(aData[1]) + s1;
-      aData += 2;
-    }while( aData<aEnd );
+#ifdef WAL_CKSUM_SIMD
+  if( nByte>=64 ){
+    iOff = walChecksumVector(nativeCksum, a, nByte, &s1, &s2);
   }
+#endif
+  walChecksumScalar(nativeCksum, (u32*)&a[iOff], (u32*)&a[nByte], &s1, &s2);
 
   aOut[0] = s1;                                                      //将s1赋值给aOut[0] 
   aOut[1] = s2;                                                    // 将s2赋值给aout[1] 
 }
 
+#ifdef SQLITE_TEST
+/*
+** Compute the checksum of the nByte bytes at a[] into aOut[]. Use the
+** portable C code if bScalar is true, or the same code as the rest of
+** this module otherwise. Return the name of the implementation used.
+** This is used by the checksum benchmark in test2.c.
+*/
+const char *sqlite3WalChecksumTest(
+  int bScalar, int nativeCksum, u8 *a, int nByte, u32 *aOut
+){
+  const char *zImpl = "c";
+  if( bScalar ){
+    u32 s1 = 0, s2 = 0;
+    walChecksumScalar(nativeCksum, (u32*)a, (u32*)&a[nByte], &s1, &s2);
+    aOut[0] = s1;
+    aOut[1] = s2;
+  }else{
+    walChecksumBytes(nativeCksum, a, nByte, 0, aOut);
+#if defined(WAL_CKSUM_AVX2)
+    zImpl = __builtin_cpu_supports("avx2") ? "avx2" : "sse2";
+#elif defined(WAL_CKSUM_SSE2)
+    zImpl = "sse2";
+#elif defined(WAL_CKSUM_NEON)
+    zImpl = "neon";
+#endif
+  }
+  return zImpl;
+}
+#endif /* SQLITE_TEST */
+
 static void walShmBarrier(Wal *pWal){ 
   if( pWal->exclusiveMode!=WAL_HEAPMEMORY_MODE ){                  // 如果pWal->exclusiveMode 不等于2
     sqlite3OsShmBarrier(pWal->pDbFd);
   }
 }
 /*
-** Write the header information in pWal->hdr into the wal-index.将 标题信息写入pWal->hdr
-**
-** The checksum on pWal->hdr is updated before it is written. pWal ->hdr 的校验和更新是在它被写之前
+** Set the version and update the checksum of pWal->hdr, so that it is
+** ready to be written into the wal-index.
 */
-static void walIndexWriteHdr(Wal *pWal){
-  volatile WalIndexHdr *aHdr = walIndexHdr(pWal);                //返回一个WalIndexHdr 结构指针 
+static void walIndexHdrSeal(Wal *pWal){
   const int nCksum = offsetof(WalIndexHdr, aCksum);              
 
-  assert( pWal->writeLock );                                     //如果不为真 则程序终止                          
   pWal->hdr.isInit = 1;                                        //初始值为1
-  pWal->hdr.iVersion = WALINDEX_MAX_VERSION;                   // 设置版本号 为WALINDEX_MAX_VERSION
+  pWal->hdr.iVersion = pWal->bWal2 ? WALINDEX2_MAX_VERSION : WALINDEX_MAX_VERSION;
   walChecksumBytes(1, (u8*)&pWal->hdr, nCksum, 0, pWal->hdr.aCksum); // 进行校验
-  memcpy((void *)&aHdr[1], (void *)&pWal->hdr, sizeof(WalIndexHdr));         //memcpy函数的功能是从源src所指的内存地址的起始位置开始拷贝n个字节到目标dest所指的内存地址的起始位置中。
+}
+
+/*
+** Write the sealed header *pHdr into the wal-index, making the commit it
+** describes visible to readers.
+*/
+static void walIndexPublishHdr(Wal *pWal, WalIndexHdr *pHdr){
+  volatile WalIndexHdr *aHdr = walIndexHdr(pWal);                //返回一个WalIndexHdr 结构指针 
+
+  assert( pWal->writeLock );                                     //如果不为真 则程序终止                          
+  memcpy((void *)&aHdr[1], (void *)pHdr, sizeof(WalIndexHdr));         //memcpy函数的功能是从源src所指的内存地址的起始位置开始拷贝n个字节到目标dest所指的内存地址的起始位置中。
   walShmBarrier(pWal);                                              //调用  walShmBarrier（）
-  memcpy((void *)&aHdr[0], (void *)&pWal->hdr, sizeof(WalIndexHdr));
+  memcpy((void *)&aHdr[0], (void *)pHdr, sizeof(WalIndexHdr));
+}
+
+/*
+** Write the header information in pWal->hdr into the wal-index.将 标题信息写入pWal->hdr
+**
+** The checksum on pWal->hdr is updated before it is written. pWal ->hdr 的校验和更新是在它被写之前
+*/
+static void walIndexWriteHdr(Wal *pWal){
+  walIndexHdrSeal(pWal);
+  walIndexPublishHdr(pWal, &pWal->hdr);
 }
 
 /*
@@ -716,62 +1143,6 @@ static void walEncodeFrame(
   sqlite3Put4byte(&aFrame[20], aCksum[1]);
 }
 
-/*
-** Check to see if the frame with header in aFrame[] and content检查aFrame【】和adata[] 是否正确，如果正确，填写*piPage  pnTruncate指针return true
-** in aData[] is valid.  If it is a valid frame, fill *piPage and
-** *pnTruncate and return true.  Return if the frame is not valid.
-*/
-//WAL删除节点框架
-static int walDecodeFrame(
-  Wal *pWal,                      /* The write-ahead log */   
-  u32 *piPage,                    /* OUT: Database page number for frame */  //数据库页码
-  u32 *pnTruncate,                /* OUT: New db size (or 0 if not commit) *///新db大小
-  u8 *aData,                      /* Pointer to page data (for checksum) */ //指向页数据的指针
-  u8 *aFrame                      /* Frame data */ //框架数据
-){
-  int nativeCksum;                /* True for native byte-order checksums */   //检查值
-  u32 *aCksum = pWal->hdr.aFrameCksum;
-  u32 pgno;                       /* Page number of the frame */// 定义数据库的页码
-  assert( WAL_FRAME_HDRSIZE==24 );    // 如果为假，则终止程序
-
-  /* A frame is only valid if the salt values in the frame-header
-  ** match the salt values in the wal-header. 
-  */
-  if( memcmp(&pWal->hdr.aSalt, &aFrame[8], 8)!=0 ){  //如果不匹配则 
-    return 0;
-  }
-
-  /* A frame is only valid if the page number is creater than zero.
-  */
-  pgno = sqlite3Get4byte(&aFrame[0]); // 为pgno赋值
-  if( pgno==0 ){  //为真，则
-    return 0;
-  }
-
-  /* A frame is only valid if a checksum of the WAL header,
-  ** all prior frams, the first 16 bytes of this frame-header,  好像是前16和后8个字节代表的信息
-  ** and the frame-data matches the checksum in the last 8 
-  ** bytes of this frame-header.
-  */
-  nativeCksum = (pWal->hdr.bigEndCksum==SQLITE_BIGENDIAN);    //？？？ 
-  walChecksumBytes(nativeCksum, aFrame, 8, aCksum, aCksum);
-  walChecksumBytes(nativeCksum, aData, pWal->szPage, aCksum, aCksum);
-  if( aCksum[0]!=sqlite3Get4byte(&aFrame[16]) 
-   || aCksum[1]!=sqlite3Get4byte(&aFrame[20]) 
-  ){
-    /* Checksum failed. */
-    return 0;
-  }
-
-  /* If we reach this point, the frame is valid.  Return the page number
-  ** and the new database size.如果 帧是有效的，返回页数和新的数据库大小
-  */
-  *piPage = pgno;
-  *pnTruncate = sqlite3Get4byte(&aFrame[4]);
-  return 1;
-}
-      
-
 #if defined(SQLITE_TEST) && defined(SQLITE_DEBUG)
 /*
 ** Names of locks.  This routine is used to provide debugging output and is not
@@ -928,6 +1299,65 @@ static u32 walFramePgno(Wal *pWal, u32 iFrame){
   return pWal->apWiData[iHash][(iFrame-1-HASHTABLE_NPAGE_ONE)%HASHTABLE_NPAGE];//返回 与iFrame对在Wal中的页
 }
 
+/*
+** Return the wal-index frame number used for frame iFrame (which must
+** be greater than zero) of wal2 file iWal.
+*/
+static u32 wal2IndexFrame(int iWal, u32 iFrame){
+  u32 iHash;                      /* Hash table that indexes the frame */
+  u32 iOff;                       /* Offset of the frame within that table */
+  assert( iFrame>0 && (iWal==0 || iWal==1) );
+  if( iWal==0 ){
+    if( iFrame<=HASHTABLE_NPAGE_ONE ) return iFrame;
+    iHash = 2 + 2*((iFrame-HASHTABLE_NPAGE_ONE-1)/HASHTABLE_NPAGE);
+    iOff = (iFrame-HASHTABLE_NPAGE_ONE-1)%HASHTABLE_NPAGE;
+  }else{
+    iHash = 1 + 2*((iFrame-1)/HASHTABLE_NPAGE);
+    iOff = (iFrame-1)%HASHTABLE_NPAGE;
+  }
+  return HASHTABLE_NPAGE_ONE + (iHash-1)*HASHTABLE_NPAGE + iOff + 1;
+}
+
+/*
+** This is the inverse of wal2IndexFrame(). Set *piWal to the wal2 file
+** that wal-index frame iIdx belongs to and return the frame number
+** within that file.
+*/
+static u32 wal2FileFrame(u32 iIdx, int *piWal){
+  int iHash = walFramePage(iIdx);
+  u32 iOff;
+  if( iHash==0 ){
+    *piWal = 0;
+    return iIdx;
+  }
+  iOff = (iIdx-HASHTABLE_NPAGE_ONE-1)%HASHTABLE_NPAGE;
+  *piWal = (iHash & 1);
+  if( iHash & 1 ){
+    return (iHash/2)*HASHTABLE_NPAGE + iOff + 1;
+  }
+  return HASHTABLE_NPAGE_ONE + (iHash/2-1)*HASHTABLE_NPAGE + iOff + 1;
+}
+
+/*
+** Return the wal-index frame number used for frame iFrame of the WAL file
+** that is currently being written. Outside of wal2 mode, this is always
+** iFrame itself.
+*/
+static u32 walIndexFrame(Wal *pWal, u32 iFrame){
+  if( pWal->bWal2 && iFrame ){
+    return wal2IndexFrame(wal2Current(&pWal->hdr), iFrame);
+  }
+  return iFrame;
+}
+
+/*
+** Return the file handle for WAL file iWal (always 0 outside of wal2
+** mode).
+*/
+static sqlite3_file *walFd(Wal *pWal, int iWal){
+  return iWal ? pWal->pWalFd2 : pWal->pWalFd;
+}
+
 /*
 ** Remove entries from the hash table that point to WAL slots greater 从哈希表中删除条目指向WAL　　比pWal - > hdr.mxFrame更大 
 ** than pWal->hdr.mxFrame.
@@ -947,6 +1377,7 @@ static void walCleanupHash(Wal *pWal){
   int iLimit = 0;                 /* Zero values greater than this */ //大于这个值
   int nByte;                      /* Number of bytes to zero in aPgno[] */
   int i;                          /* Used to iterate through aHash[] */ 变量用于循环
+  u32 iLast = walIndexFrame(pWal, pWal->hdr.mxFrame);  /* Last valid entry */
 
   assert( pWal->writeLock ); //看Wal在写事务中，在的话 终止程序
   testcase( pWal->hdr.mxFrame==HASHTABLE_NPAGE_ONE-1 );//调用testcase（）函数 测试评估
@@ -959,14 +1390,14 @@ static void walCleanupHash(Wal *pWal){
   ** the entry that corresponds to frame pWal->hdr.mxFrame. It is guaranteed
   ** that the page said hash-table and array reside on is already mapped.获取包含哈希表和页码的指针数组的条目对应帧pWal - > hdr.mxFrame。这是保证页面说哈希表和数组驻留在已经映射。
   */
-  assert( pWal->nWiData>walFramePage(pWal->hdr.mxFrame) ); //判断是否终止程序
-  assert( pWal->apWiData[walFramePage(pWal->hdr.mxFrame)] );//判断是否终止程序
-  walHashGet(pWal, walFramePage(pWal->hdr.mxFrame), &aHash, &aPgno, &iZero);
+  assert( pWal->nWiData>walFramePage(iLast) ); //判断是否终止程序
+  assert( pWal->apWiData[walFramePage(iLast)] );//判断是否终止程序
+  walHashGet(pWal, walFramePage(iLast), &aHash, &aPgno, &iZero);
 
   /* Zero all hash-table entries that correspond to frame numbers greater
   ** than pWal->hdr.mxFrame.
   */
-  iLimit = pWal->hdr.mxFrame - iZero; //获取ilimit值
+  iLimit = iLast - iZero; //获取ilimit值
   assert( iLimit>0 );            //如果 ilimit 小于0 则程序终止
   for(i=0; i<HASHTABLE_NSLOT; i++){ //对aHash进行遍历，
     if( aHash[i]>iLimit ){            //如果hash值超过限制 ，
@@ -1084,55 +1515,181 @@ static int walIndexAppend(Wal *pWal, u32 iFrame, u32 iPage){
 }
 
 /*
-** Recover the wal-index by reading the write-ahead log file. 
+** PARALLEL RECOVERY
 **
-** This routine first tries to establish an exclusive lock on the
-** wal-index to prevent other threads/processes from doing anything
-** with the WAL or wal-index while recovery is running.  The
-** WAL_RECOVER_LOCK is also held so that other threads will know
-** that this thread is running recovery.  If unable to establish
-** the necessary locks, this routine returns SQLITE_BUSY.*//*通过阅读write-ahead日志文件恢复wal-index. 首先在wal-index上加一个排它锁，当进行恢复WAL_RECOVER_LOCK时其他进程或线程就不能进行,该锁若没有成功建立，程序将返回SQLITE_BUSY。*/
+** Most of the work of recovery is checksumming the frames of the WAL.
+** The checksum of each frame depends on the checksum of the frame
+** before it, so this looks like a serial job. But the checksum is linear
+** (see walChecksumBytes()). Extending checksum (s1,s2) over a frame of
+** szPage+8 bytes gives
+**
+**     A*(s1,s2) + C
+**
+** where A is a 2x2 matrix that depends only on the page size and C is the
+** checksum of the frame with an initial value of (0,0). So the C value of
+** each frame can be computed on its own, by any thread. The chain of
+** checksums is then rebuilt cheaply, in order, as each frame's result is
+** checked against its header.
+**
+** walIndexRecover() reads the WAL in batches of up to about
+** WAL_RECOVER_BATCH bytes, or smaller ones if memory is short. Each batch
+** is split into ranges of frames, and up to SQLITE_WAL_RECOVERY_THREADS
+** threads compute the C values. The calling thread then checks the salts
+** and checksums of the batch in order. It also finds the commit boundaries
+** and adds each valid frame to the wal-index. Set
+** SQLITE_WAL_RECOVERY_THREADS to 0 to do all of this in the calling thread.
+*/
+#ifndef SQLITE_WAL_RECOVERY_THREADS
+# define SQLITE_WAL_RECOVERY_THREADS 4
+#endif
+#define WAL_RECOVER_BATCH  (8*1024*1024)
 
-static int walIndexRecover(Wal *pWal){  /*返回是否加锁进行恢复，不成功返回SQLITE_BUSY*/
-  int rc;                         /* Return Code*//*返回值 */  
-  i64 nSize;                      /* Size of log file*//* 日志文件的大小 */ 
-  u32 aFrameCksum[2] = {0, 0};           /*定义 aFrameCksum 数组*/
-  int iLock;                      /* Lock offset to lock for checkpoint *//* 定义检查点锁*/  
-  int nLock;                      /* Number of locks to hold *//* 所持锁的数 */ 
+/*
+** The number of recovery threads actually used. Test builds let the test
+** harness lower it, so that recovery with and without threads can be
+** compared.
+*/
+#ifdef SQLITE_TEST
+int sqlite3_wal_recovery_threads = SQLITE_WAL_RECOVERY_THREADS;
+#else
+# define sqlite3_wal_recovery_threads SQLITE_WAL_RECOVERY_THREADS
+#endif
 
-  /* Obtain an exclusive lock on all byte in the locking range not already
-  ** locked by the caller. The caller is guaranteed to have locked the
-  ** WAL_WRITE_LOCK byte, and may have also locked the WAL_CKPT_LOCK byte.
-  ** If successful, the same bytes that are locked here are unlocked before
-  ** this function returns.*//*从所有字节中获取一个没有被调用者锁定的排它锁。调用者确保已经锁定WAL_WRITE_LOCK，或许也锁定了WAL_CKPT_LOCK。如果成功，在这个功能返回前锁定的相同字节会被解锁。*/
-  
-  assert( pWal->ckptLock==1 || pWal->ckptLock==0 );/* 如果 pWal->ckptLock==1或pWal->ckptLock==0 ，则终止程序*/
-  assert( WAL_ALL_BUT_WRITE==WAL_WRITE_LOCK+1 );  /*如果WAL_ALL_BUT_WRITE==WAL_WRITE_LOCK+1，则终止程序*/
-  assert( WAL_CKPT_LOCK==WAL_ALL_BUT_WRITE );  /*如果WAL_CKPT_LOCK==WAL_ALL_BUT_WRITE，则终止程序*/
-  assert( pWal->writeLock ); /*如果Wal在写事务下，则终止程序  如果 pWal->writeLock，则终止程序*/
-  iLock = WAL_ALL_BUT_WRITE + pWal->ckptLock; /*wal_all_but_write 为1*/
-  
-  nLock = SQLITE_SHM_NLOCK - iLock;
-  
-  rc = walLockExclusive(pWal, iLock, nLock); /*是否获取排它锁*/
-  
-  if( rc ){  /*如果获取成功*/
-    return rc;/* 返回 rc*/
+/*
+** One of these is used for each range of frames checksummed during
+** recovery.
+*/
+typedef struct WalRecoverTask WalRecoverTask;
+struct WalRecoverTask {
+  int nativeCksum;                /* True for native byte-order checksums */
+  int szPage;                     /* Database page size */
+  int nFrame;                     /* Number of frames in aFrame[] */
+  u8 *aFrame;                     /* First frame of the range */
+  u32 *aCksum;                    /* OUT: Two checksum words per frame */
+};
+
+/*
+** Compute the checksum of each frame in a range, starting from (0,0).
+** This may run in a worker thread.
+*/
+static void *walRecoverTask(void *pCtx){
+  WalRecoverTask *p = (WalRecoverTask*)pCtx;
+  int szFrame = p->szPage + WAL_FRAME_HDRSIZE;
+  int i;
+  for(i=0; i<p->nFrame; i++){
+    u8 *aFrame = &p->aFrame[i*szFrame];
+    u32 *aCksum = &p->aCksum[i*2];
+    walChecksumBytes(p->nativeCksum, aFrame, 8, 0, aCksum);
+    walChecksumBytes(p->nativeCksum, &aFrame[WAL_FRAME_HDRSIZE], p->szPage,
+                     aCksum, aCksum);
   }
-  WALTRACE(("WAL%p: recovery begin...\n", pWal));  /*wal的路径为：WAL%p: recovery begin...\n*/
+  return 0;
+}
 
-  memset(&pWal->hdr, 0, sizeof(WalIndexHdr));  /*为pWal->hdr分配空间并初始化为0*/
+/*
+** Set aMat[] to the matrix that extending a checksum over nByte bytes
+** applies to the initial checksum value. The matrix is stored in row
+** order. nByte must be a multiple of 8.
+*/
+static void walCksumMatrix(int nByte, u32 *aMat){
+  u32 aPow[4] = { 1, 1, 1, 2 };   /* The matrix for a single 8-byte step */
+  u32 aTmp[4];
+  int n = nByte/8;
+  aMat[0] = aMat[3] = 1;
+  aMat[1] = aMat[2] = 0;
+  while( n ){
+    if( n & 1 ){
+      aTmp[0] = aMat[0]*aPow[0] + aMat[1]*aPow[2];
+      aTmp[1] = aMat[0]*aPow[1] + aMat[1]*aPow[3];
+      aTmp[2] = aMat[2]*aPow[0] + aMat[3]*aPow[2];
+      aTmp[3] = aMat[2]*aPow[1] + aMat[3]*aPow[3];
+      memcpy(aMat, aTmp, sizeof(aTmp));
+    }
+    aTmp[0] = aPow[0]*aPow[0] + aPow[1]*aPow[2];
+    aTmp[1] = aPow[0]*aPow[1] + aPow[1]*aPow[3];
+    aTmp[2] = aPow[2]*aPow[0] + aPow[3]*aPow[2];
+    aTmp[3] = aPow[2]*aPow[1] + aPow[3]*aPow[3];
+    memcpy(aPow, aTmp, sizeof(aTmp));
+    n = n>>1;
+  }
+}
+
+/*
+** Compute the checksums of the nFrame frames in aBuf[], using worker
+** threads if it is worthwhile. Write two checksum words per frame to
+** aCksum[].
+*/
+static void walRecoverChecksums(
+  Wal *pWal,                      /* The WAL being recovered */
+  u8 *aBuf,                       /* Frames read from the WAL file */
+  int nFrame,                     /* Number of frames in aBuf[] */
+  u32 *aCksum                     /* OUT: Checksum of each frame */
+){
+  WalRecoverTask aTask[SQLITE_WAL_RECOVERY_THREADS+1];
+  SQLiteThread *apThread[SQLITE_WAL_RECOVERY_THREADS+1];
+  int szFrame = pWal->szPage + WAL_FRAME_HDRSIZE;
+  int nTask = sqlite3_wal_recovery_threads;
+  int iFrame = 0;
+  int i;
+
+  /* Do not start a thread for fewer than 64 frames */
+  if( nTask>SQLITE_WAL_RECOVERY_THREADS ) nTask = SQLITE_WAL_RECOVERY_THREADS;
+  if( nTask>nFrame/64 ) nTask = nFrame/64;
+  if( nTask<1 ) nTask = 1;
+  for(i=0; i<nTask; i++){
+    WalRecoverTask *p = &aTask[i];
+    p->nativeCksum = (pWal->hdr.bigEndCksum==SQLITE_BIGENDIAN);
+    p->szPage = pWal->szPage;
+    p->nFrame = (nFrame-iFrame) / (nTask-i);
+    p->aFrame = &aBuf[(i64)iFrame*szFrame];
+    p->aCksum = &aCksum[iFrame*2];
+    iFrame += p->nFrame;
+    apThread[i] = 0;
+  }
+  assert( iFrame==nFrame );
+
+  /* The calling thread handles the last range itself. If a thread cannot
+  ** be created, its range is also handled here. */
+  for(i=0; i<nTask-1; i++){
+    if( sqlite3ThreadCreate(&apThread[i], walRecoverTask, &aTask[i]) ){
+      walRecoverTask(&aTask[i]);
+    }
+  }
+  walRecoverTask(&aTask[nTask-1]);
+  for(i=0; i<nTask-1; i++){
+    void *pOut;
+    if( apThread[i] ) sqlite3ThreadJoin(apThread[i], &pOut);
+  }
+}
+
+/*
+** Read WAL file iWal (always 0 outside of wal2 mode) and add each valid
+** frame it contains to the wal-index. This is a helper for
+** walIndexRecover().
+**
+** Before this is called, pWal->hdr must be zeroed. On return, its mxFrame,
+** nPage, szPage, aSalt[] and bigEndCksum fields describe the file, and
+** aFrameCksum[] is set to the checksum of its last commit frame. A file
+** that is missing or does not begin with a valid WAL header is treated
+** as empty. SQLITE_OK is returned unless an error occurs.
+*/
+static int walIndexRecoverFile(Wal *pWal, int iWal, u32 *aFrameCksum){
+  sqlite3_file *pWalFd = walFd(pWal, iWal);
+  int rc;                         /* Return Code */
+  i64 nSize;                      /* Size of log file */
 
-  rc = sqlite3OsFileSize(pWal->pWalFd, &nSize);  /* 获取Wal文件信息*/
+  rc = sqlite3OsFileSize(pWalFd, &nSize);  /* 获取Wal文件信息*/
   if( rc!=SQLITE_OK ){   /*如果获取不成功*/
-    goto recovery_error; /*跳转到recovery_error*/
+    return rc;
   }
 
   if( nSize>WAL_HDRSIZE ){           /* nSize 为32*/
     u8 aBuf[WAL_HDRSIZE];         /* Buffer to load WAL header into*//* 加载Wal头数据的缓存区 */  
-    u8 *aFrame = 0;               /* Malloc'd buffer to load entire frame*//* 分配整个帧的缓存*/  
-    int szFrame;                  /* Number of bytes in buffer aFrame[]*//* 定义aFrame[]的字节数 */  
-    u8 *aData;                    /* Pointer to data part of aFrame buffer *//*定义帧数据指针 */  
+    u8 *aFrame = 0;               /* Malloc'd buffer to load a batch of frames */
+    u32 *aCksum = 0;              /* Checksum of each frame in aFrame[] */
+    u32 aMat[4];                  /* Checksum matrix for one frame */
+    int szFrame;                  /* Size of each frame in aFrame[] */
+    int nBatch;                   /* Number of frames aFrame[] can hold */
     int iFrame;                   /* Index of last frame read *//* 读取上一帧的指标 */  
     i64 iOffset;                  /* Next offset to read from log file *//*从日志文件中读取下一个偏移量 */   
     int szPage;                   /* Page size according to the log*//* 定义日志页面大小*/  
@@ -1141,9 +1698,9 @@ static int walIndexRecover(Wal *pWal){  /*返回是否加锁进行恢复，不
     int isValid;                  /* True if this frame is valid *//* 定义帧是可见的*/  
 
     /* Read in the WAL header.*//*读取WAL的头数据 */  
-    rc = sqlite3OsRead(pWal->pWalFd, aBuf, WAL_HDRSIZE, 0); /*获取Wal头数据*/
+    rc = sqlite3OsRead(pWalFd, aBuf, WAL_HDRSIZE, 0); /*获取Wal头数据*/
     if( rc!=SQLITE_OK ){ /*如果不成功 */
-      goto recovery_error;/* 跳转recovery_error*/
+      return rc;
     }
 
     /* If the database page size is not a power of two, or is greater than
@@ -1158,7 +1715,7 @@ static int walIndexRecover(Wal *pWal){  /*返回是否加锁进行恢复，不
      || szPage>SQLITE_MAX_PAGE_SIZE     
      || szPage<512                         
     ){
-      goto finished; /*跳转到finished*/
+      return SQLITE_OK;
     }
     pWal->hdr.bigEndCksum = (u8)(magic&0x00000001); /*获取校验值*/
     pWal->szPage = szPage;  /* 将pWal->szpage赋值 */
@@ -1172,57 +1729,211 @@ static int walIndexRecover(Wal *pWal){  /*返回是否加锁进行恢复，不
     if( pWal->hdr.aFrameCksum[0]!=sqlite3Get4byte(&aBuf[24])             /*如果检验结果与ABuf[]不相同*/
      || pWal->hdr.aFrameCksum[1]!=sqlite3Get4byte(&aBuf[28])
     ){
-      goto finished;                     /*跳转到finished*/
+      return SQLITE_OK;
     }
 
     /* Verify that the version number on the WAL format is one that
     ** are able to understand *//* 验证WAL格式是一个版本号能够理解  验证WAL格式的版本号是易理解的*/                
     version = sqlite3Get4byte(&aBuf[4]); /*获取Wal头数据中version数据*/
-    if( version!=WAL_MAX_VERSION ){       /*如果获取到的version数据不等于WAL_MAX_VERSION*/
-      rc = SQLITE_CANTOPEN_BKPT;               /* rc获取值*/
-      goto finished;                   /*跳转到finished*/
+    if( version!=(pWal->bWal2 ? WAL2_MAX_VERSION : WAL_MAX_VERSION) ){
+      return SQLITE_CANTOPEN_BKPT;
     }
 
-    /* Malloc a buffer to read frames into.*//*分配一个缓冲区读取帧 */  
-    szFrame = szPage + WAL_FRAME_HDRSIZE;       /*WAL_FRAME_HDRSIZE 24和一页的大小*/
-    aFrame = (u8 *)sqlite3_malloc(szFrame);    /*为aFrame分配内存*/ 
-    if( !aFrame ){             /*如果分配不成功*/
-      rc = SQLITE_NOMEM;       /*为rc赋值*/
-      goto recovery_error;    /*跳转到recovery_error*/
+    /* Malloc a buffer to read a batch of frames into, and space for the
+    ** checksum of each frame in the batch. If that much memory is not
+    ** available, halve the batch until it is. A batch of a single frame
+    ** needs no more memory than recovery without threads, so only a
+    ** failure to allocate that is an error. */
+    szFrame = szPage + WAL_FRAME_HDRSIZE;
+    nBatch = WAL_RECOVER_BATCH/szFrame;
+    if( (nSize-WAL_HDRSIZE)/szFrame < nBatch ){
+      nBatch = (int)((nSize-WAL_HDRSIZE)/szFrame);
+      if( nBatch<1 ) nBatch = 1;
     }
-    aData = &aFrame[WAL_FRAME_HDRSIZE]; /*将aFrame的地址赋给aData*/
-
-    /* Read all frames from the log file.*//* 从日志文件中读取所有的帧 */  
+    while( 1 ){
+      if( nBatch>1 ) sqlite3BeginBenignMalloc();
+      aFrame = (u8 *)sqlite3_malloc(nBatch*szFrame);
+      aCksum = (u32 *)sqlite3_malloc(nBatch*2*sizeof(u32));
+      if( nBatch>1 ) sqlite3EndBenignMalloc();
+      if( aFrame && aCksum ) break;
+      sqlite3_free(aFrame);
+      sqlite3_free(aCksum);
+      if( nBatch==1 ) return SQLITE_NOMEM;
+      nBatch /= 2;
+    }
+    walCksumMatrix(szPage+8, aMat);
+
+    /* Read all frames from the log file, one batch at a time. See 
+    ** PARALLEL RECOVERY above. A frame is only valid if its page number
+    ** is not zero, the salt values in its header match the salt values
+    ** in the wal-header, and the checksum of the WAL header, all prior
+    ** frames, the first 8 bytes of this frame-header and the frame-data
+    ** matches the checksum in the last 8 bytes of the frame-header. */
     iFrame = 0;
-    for(iOffset=WAL_HDRSIZE; (iOffset+szFrame)<=nSize; iOffset+=szFrame){         /* WAL_HDRSIZE 32如果iOffset+szFrame小于日志文件大小*/  
-      u32 pgno;                   /* Database page number for frame 帧的数据页码*/         
-      u32 nTruncate;              /* dbsize field from frame header 帧头中数据库大小*/       
-
-      /* Read and decode the next log frame. *//*读取和解码下一个日志帧 */  
-      iFrame++;                                  /* iFrame自加*/
-      rc = sqlite3OsRead(pWal->pWalFd, aFrame, szFrame, iOffset); /*调用SQLite3Osread函数*/ 
-      if( rc!=SQLITE_OK ) break;   /*如果rc不等于SQLITE_OK,则跳出循环*/
-      isValid = walDecodeFrame(pWal, &pgno, &nTruncate, aData, aFrame);  /*获取解码 ，返回一值看是否成功*/
-      if( !isValid ) break;          /*如果无效，则跳出循环*/
-      rc = walIndexAppend(pWal, iFrame, pgno);   /*调用walIndexAppend()函数*/
-      if( rc!=SQLITE_OK ) break;  /* 如果调用不成功，则跳出循环*/
-
-      /* If nTruncate is non-zero, this is a commit record. *//* 如果nTruncate是非空的，则这是一个提交记录*/
-      if( nTruncate ){                  /*  判断是否为空*/
-        pWal->hdr.mxFrame = iFrame;   /*为最新的有效的索引赋值*/
-        pWal->hdr.nPage = nTruncate; /*  Wal文件页数*/
-        pWal->hdr.szPage = (u16)((szPage&0xff00) | (szPage>>16)); /* 一页的数*/
-        testcase( szPage<=32768 );  /* 调用测试函数*/
-        testcase( szPage>=65536 );  /*  调用测试函数*/
-        aFrameCksum[0] = pWal->hdr.aFrameCksum[0];/*将hdr的检验和的值赋给aFrameCksum[0]*/
-        aFrameCksum[1] = pWal->hdr.aFrameCksum[1];/*将hdr的检验和的值赋给aFrameCksum[0]*/
+    isValid = 1;
+    iOffset = WAL_HDRSIZE;
+    while( isValid && (iOffset+szFrame)<=nSize ){
+      int nRead;                  /* Number of frames in this batch */
+      int i;
+
+      nRead = nBatch;
+      if( (nSize-iOffset)/szFrame < nRead ){
+        nRead = (int)((nSize-iOffset)/szFrame);
       }
-    }
+      rc = sqlite3OsRead(pWalFd, aFrame, nRead*szFrame, iOffset);
+      if( rc!=SQLITE_OK ) break;
+      walRecoverChecksums(pWal, aFrame, nRead, aCksum);
+
+      for(i=0; i<nRead; i++){
+        u8 *aHdr = &aFrame[i*szFrame];
+        u32 *aPrev = pWal->hdr.aFrameCksum;
+        u32 pgno;                 /* Database page number for frame */
+        u32 nTruncate;            /* dbsize field from frame header */
+        u32 s1, s2;               /* Checksum up to the end of this frame */
+
+        pgno = sqlite3Get4byte(&aHdr[0]);
+        if( pgno==0 || memcmp(&pWal->hdr.aSalt, &aHdr[8], 8)!=0 ){
+          isValid = 0;
+          break;
+        }
+        s1 = aMat[0]*aPrev[0] + aMat[1]*aPrev[1] + aCksum[i*2];
+        s2 = aMat[2]*aPrev[0] + aMat[3]*aPrev[1] + aCksum[i*2+1];
+        if( s1!=sqlite3Get4byte(&aHdr[16]) || s2!=sqlite3Get4byte(&aHdr[20]) ){
+          isValid = 0;
+          break;
+        }
+        aPrev[0] = s1;
+        aPrev[1] = s2;
 
-    sqlite3_free(aFrame);/* 释放指针*/
+        iFrame++;
+        rc = walIndexAppend(pWal,
+            pWal->bWal2 ? wal2IndexFrame(iWal, iFrame) : (u32)iFrame, pgno
+        );
+        if( rc!=SQLITE_OK ) break;
+
+        /* If nTruncate is non-zero, this is a commit record. */
+        nTruncate = sqlite3Get4byte(&aHdr[4]);
+        if( nTruncate ){
+          pWal->hdr.mxFrame = iFrame;
+          pWal->hdr.nPage = nTruncate;
+          pWal->hdr.szPage = (u16)((szPage&0xff00) | (szPage>>16));
+          testcase( szPage<=32768 );
+          testcase( szPage>=65536 );
+          aFrameCksum[0] = pWal->hdr.aFrameCksum[0];
+          aFrameCksum[1] = pWal->hdr.aFrameCksum[1];
+        }
+      }
+      if( rc!=SQLITE_OK ) break;
+      iOffset += (i64)nRead*szFrame;
+    }
+
+    sqlite3_free(aFrame);
+    sqlite3_free(aCksum);
+  }
+  return rc;
+}
+
+/*
+** Recover the wal-index of a wal2 mode database from both of its WAL
+** files. This is a helper for walIndexRecover(). On success, pWal->hdr
+** describes the current file and aFrameCksum[] is set to the checksum of
+** its last commit frame.
+**
+** If only one of the files contains valid frames, it becomes the current
+** file. If both do, the current file is the one whose salt-1 value is
+** one greater than that of the other. If neither file's salt follows the
+** other's, the files cannot have been written by this code; file 0 is
+** taken to be the current file in that case.
+*/
+static int wal2IndexRecover(Wal *pWal, u32 *aFrameCksum){
+  WalIndexHdr aHdr[2];            /* Header for each file after recovery */
+  u32 aCksum[2][2];               /* Checksum of last commit in each file */
+  u32 aCkpt[2];                   /* Checkpoint sequence number of each file */
+  u32 szPage = 0;                 /* Page size from either file */
+  int iCur;                       /* Index of the current file */
+  int i;
+  int rc = SQLITE_OK;
+
+  for(i=0; i<2; i++){
+    memset(&pWal->hdr, 0, sizeof(WalIndexHdr));
+    pWal->nCkpt = 0;
+    aCksum[i][0] = aCksum[i][1] = 0;
+    rc = walIndexRecoverFile(pWal, i, aCksum[i]);
+    if( rc!=SQLITE_OK ) return rc;
+    memcpy(&aHdr[i], &pWal->hdr, sizeof(WalIndexHdr));
+    aCkpt[i] = pWal->nCkpt;
+    if( aHdr[i].mxFrame ) szPage = pWal->szPage;
+  }
+
+  if( aHdr[0].mxFrame && aHdr[1].mxFrame ){
+    u32 iSalt0 = sqlite3Get4byte((u8*)&aHdr[0].aSalt[0]);
+    u32 iSalt1 = sqlite3Get4byte((u8*)&aHdr[1].aSalt[0]);
+    iCur = (iSalt1==iSalt0+1);
+  }else{
+    iCur = (aHdr[1].mxFrame!=0);
   }
 
-finished:                      /*goto 的标记*/
+  memcpy(&pWal->hdr, &aHdr[iCur], sizeof(WalIndexHdr));
+  pWal->hdr.mxFrame2 = aHdr[!iCur].mxFrame | ((u32)iCur<<31);
+  if( pWal->hdr.mxFrame==0 ){
+    pWal->hdr.nPage = aHdr[!iCur].nPage;
+    pWal->hdr.szPage = aHdr[!iCur].szPage;
+  }
+  if( szPage ) pWal->szPage = szPage;
+  pWal->nCkpt = aCkpt[iCur];
+  aFrameCksum[0] = aCksum[iCur][0];
+  aFrameCksum[1] = aCksum[iCur][1];
+  return SQLITE_OK;
+}
+
+/*
+** Recover the wal-index by reading the write-ahead log file. 
+**
+** This routine first tries to establish an exclusive lock on the
+** wal-index to prevent other threads/processes from doing anything
+** with the WAL or wal-index while recovery is running.  The
+** WAL_RECOVER_LOCK is also held so that other threads will know
+** that this thread is running recovery.  If unable to establish
+** the necessary locks, this routine returns SQLITE_BUSY.*//*通过阅读write-ahead日志文件恢复wal-index. 首先在wal-index上加一个排它锁，当进行恢复WAL_RECOVER_LOCK时其他进程或线程就不能进行,该锁若没有成功建立，程序将返回SQLITE_BUSY。*/
+
+static int walIndexRecover(Wal *pWal){  /*返回是否加锁进行恢复，不成功返回SQLITE_BUSY*/
+  int rc;                         /* Return Code*//*返回值 */  
+  u32 aFrameCksum[2] = {0, 0};           /*定义 aFrameCksum 数组*/
+  int iLock;                      /* Lock offset to lock for checkpoint *//* 定义检查点锁*/  
+  int nLock;                      /* Number of locks to hold *//* 所持锁的数 */ 
+  i64 iStart = 0;                 /* Time recovery started, in ms */
+
+  /* Obtain an exclusive lock on all byte in the locking range not already
+  ** locked by the caller. The caller is guaranteed to have locked the
+  ** WAL_WRITE_LOCK byte, and may have also locked the WAL_CKPT_LOCK byte.
+  ** If successful, the same bytes that are locked here are unlocked before
+  ** this function returns.*//*从所有字节中获取一个没有被调用者锁定的排它锁。调用者确保已经锁定WAL_WRITE_LOCK，或许也锁定了WAL_CKPT_LOCK。如果成功，在这个功能返回前锁定的相同字节会被解锁。*/
+  
+  assert( pWal->ckptLock==1 || pWal->ckptLock==0 );/* 如果 pWal->ckptLock==1或pWal->ckptLock==0 ，则终止程序*/
+  assert( WAL_ALL_BUT_WRITE==WAL_WRITE_LOCK+1 );  /*如果WAL_ALL_BUT_WRITE==WAL_WRITE_LOCK+1，则终止程序*/
+  assert( WAL_CKPT_LOCK==WAL_ALL_BUT_WRITE );  /*如果WAL_CKPT_LOCK==WAL_ALL_BUT_WRITE，则终止程序*/
+  assert( pWal->writeLock ); /*如果Wal在写事务下，则终止程序  如果 pWal->writeLock，则终止程序*/
+  iLock = WAL_ALL_BUT_WRITE + pWal->ckptLock; /*wal_all_but_write 为1*/
+  
+  nLock = SQLITE_SHM_NLOCK - iLock;
+  
+  rc = walLockExclusive(pWal, iLock, nLock); /*是否获取排它锁*/
+  
+  if( rc ){  /*如果获取成功*/
+    return rc;/* 返回 rc*/
+  }
+  WALTRACE(("WAL%p: recovery begin...\n", pWal));  /*wal的路径为：WAL%p: recovery begin...\n*/
+  sqlite3OsCurrentTimeInt64(pWal->pVfs, &iStart);
+
+  memset(&pWal->hdr, 0, sizeof(WalIndexHdr));  /*为pWal->hdr分配空间并初始化为0*/
+
+  if( pWal->bWal2 ){
+    rc = wal2IndexRecover(pWal, aFrameCksum);
+  }else{
+    rc = walIndexRecoverFile(pWal, 0, aFrameCksum);
+  }
+  if( rc!=SQLITE_OK ) goto recovery_error;
+
   if( rc==SQLITE_OK ){                  /*r如果rc为SQLITE_OK*/
     volatile WalCkptInfo *pInfo;           /* 定义校验信息指针变量pInfo*/
     int i;                                 /* 变量i*/
@@ -1246,8 +1957,12 @@ finished:                      /*goto 的标记*/
     ** checkpointing the log file. *//*如果不止一个帧从日志文件中恢复过来,则通过sqlite3_log()上报该事件。这有利于核查由于没有检查点日志的应用程序经常关闭而造成的性能问题。*/
     
 	if( pWal->hdr.nPage ){            
-      sqlite3_log(SQLITE_OK, "Recovered %d frames from WAL file %s",
-          pWal->hdr.nPage, pWal->zWalName
+      i64 iEnd = 0;
+      sqlite3OsCurrentTimeInt64(pWal->pVfs, &iEnd);
+      sqlite3_log(SQLITE_NOTICE_RECOVER_WAL,
+          "recovered %d frames from WAL file %s in %lld ms",
+          pWal->hdr.mxFrame + wal2OtherFrames(&pWal->hdr), pWal->zWalName,
+          iEnd-iStart
       );
     }
   }
@@ -1293,12 +2008,15 @@ int sqlite3WalOpen(    /*打开一个预写日志的连接*/
   sqlite3_file *pDbFd,            /* The open database file */ /* 打开数据库文件*/
   const char *zWalName,           /* Name of the WAL file */  /* Wal文件的名*/
   int bNoShm,                     /* True to run in heap-memory mode */ /* 在堆内存模式中运行*/
+  int bWal2,                      /* True to open a wal2 mode WAL */
   i64 mxWalSize,                  /* Truncate WAL to this size on reset */ /* 重设使Wal文件变小*/
   Wal **ppWal                     /* OUT: Allocated Wal handle *//*  分配Wal运用*/
 ){
   int rc;                         /* Return Code */ /*返回码*/
   Wal *pRet;                      /* Object to allocate and return *//*分配和返回对象*/
   int flags;                      /* Flags passed to OsOpen() */ /*进入osOpen的标志*/
+  int nByte;                      /* Bytes to allocate for pRet */
+  int nName = sqlite3Strlen30(zWalName);  /* Length of zWalName */
 
   assert( zWalName && zWalName[0] ); /*  若zWalName && zWalName[0]，则终止程序*/
   assert( pDbFd );/*终止程序*/
@@ -1317,7 +2035,9 @@ int sqlite3WalOpen(    /*打开一个预写日志的连接*/
 
   /* Allocate an instance of struct Wal to return. */ /*分配一个Wal实例作为返回*/
   *ppWal = 0;             /* 设置值为0*/
-  pRet = (Wal*)sqlite3MallocZero(sizeof(Wal) + pVfs->szOsFile); /*重设Wal文件*/
+  nByte = sizeof(Wal) + pVfs->szOsFile;
+  if( bWal2 ) nByte += ROUND8(pVfs->szOsFile) + nName + 3;
+  pRet = (Wal*)sqlite3MallocZero(nByte); /*重设Wal文件*/
   if( !pRet ){             /* 如果设置不成功*/
     return SQLITE_NOMEM;    /* 返回SqLite_NOMEM*/
   }
@@ -1331,6 +2051,15 @@ int sqlite3WalOpen(    /*打开一个预写日志的连接*/
   pRet->syncHeader = 1;/*为pRet->syncHeader赋值*/
   pRet->padToSectorBoundary = 1;/*为pRet->padToSectorBoundary赋值*/
   pRet->exclusiveMode = (bNoShm ? WAL_HEAPMEMORY_MODE: WAL_NORMAL_MODE);/*为pRet->exclusiveMode赋值*/
+  if( bWal2 ){
+    char *zName2;
+    pRet->bWal2 = 1;
+    pRet->pWalFd2 = (sqlite3_file*)&((u8*)&pRet[1])[ROUND8(pVfs->szOsFile)];
+    zName2 = (char*)&((u8*)pRet->pWalFd2)[pVfs->szOsFile];
+    memcpy(zName2, zWalName, nName);
+    zName2[nName] = '2';
+    pRet->zWalName2 = zName2;
+  }
 
   /* Open file handle on the write-ahead log file. */ /* 在write-ahead日志文件上打开文件运行。*/
   flags = (SQLITE_OPEN_READWRITE|SQLITE_OPEN_CREATE|SQLITE_OPEN_WAL); /*falgs标记*/
@@ -1338,10 +2067,18 @@ int sqlite3WalOpen(    /*打开一个预写日志的连接*/
   if( rc==SQLITE_OK && flags&SQLITE_OPEN_READONLY ){    
     pRet->readOnly = WAL_RDONLY;     /* 设置pRet->readonly的值*/
   }
+  if( rc==SQLITE_OK && bWal2 ){
+    flags = (SQLITE_OPEN_READWRITE|SQLITE_OPEN_CREATE|SQLITE_OPEN_WAL);
+    rc = sqlite3OsOpen(pVfs, pRet->zWalName2, pRet->pWalFd2, flags, &flags);
+    if( rc==SQLITE_OK && flags&SQLITE_OPEN_READONLY ){
+      pRet->readOnly = WAL_RDONLY;
+    }
+  }
 
   if( rc!=SQLITE_OK ){ /*如果rc不成功*/
     walIndexClose(pRet, 0); /* 调用walIndexClose函数*/
     sqlite3OsClose(pRet->pWalFd); /* 调用sqlite3OSclose（）函数*/
+    if( bWal2 ) sqlite3OsClose(pRet->pWalFd2);
     sqlite3_free(pRet);/* 释放pRet函数*/
   }else{
     int iDC = sqlite3OsDeviceCharacteristics(pRet->pWalFd); /*调用系统函数*/
@@ -1362,6 +2099,646 @@ void sqlite3WalLimit(Wal *pWal, i64 iLimit){
   if( pWal ) pWal->mxWalSize = iLimit;
 }
 
+/*
+** Limit the number of frames that each subsequent PASSIVE checkpoint
+** run through this connection copies into the database file to nFrame.
+** If nFrame is zero, there is no limit.
+*/
+void sqlite3WalCheckpointStep(Wal *pWal, int nFrame){
+  if( pWal ) pWal->nCkptStep = (u32)nFrame;
+}
+
+/*
+** GROUP COMMIT
+**
+** Normally each transaction committed with synchronous=FULL syncs the
+** WAL file from within sqlite3WalFrames(), while it still holds the WAL
+** write lock, so the commit rate is bounded by the fsync rate.
+**
+** With group commit enabled (PRAGMA wal_group_commit), a commit made
+** through a connection in a commit group, the WalGroup shared by all
+** connections in this process that use the same WAL file, is not synced
+** or published by sqlite3WalFrames(). Instead its wal-index header is
+** saved in WalGroup.hdr and the connection that made it becomes the
+** owner of the group. The owner keeps the WAL write lock until, in
+** sqlite3WalEndWriteTransaction(), it has waited nGroupWindow
+** microseconds for more commits, synced the WAL and, only if the sync
+** succeeded, written the header of the last commit in the group to the
+** wal-index. So no reader can see a commit before it is durable.
+**
+** While the group is open, other connections in the group may add their
+** commits to it by writing under the owner's lock. A connection whose
+** next read transaction is opened by a statement that writes in
+** autocommit mode (see sqlite3WalWriteIntent()) reads the header of the
+** last pending commit instead of the published one, if its snapshot is
+** the one the group was opened on. Its write transaction then joins the
+** group. Only one connection at a time writes under the owner's lock,
+** and joined transactions must start from the last pending commit, so
+** the commits in a group are a simple chain. A connection that cannot
+** join gets SQLITE_BUSY, as it would from the write lock.
+**
+** Before syncing, the owner closes the group to new members and waits
+** for the joined writer, and for connections reading pending commits,
+** to finish. WalGroup.syncMutex is held by the owner from the first
+** pending commit until the sync is over, and sqlite3WalCommitSync(),
+** called by the pager after each commit, waits on it and then returns
+** the result of the sync. If the sync failed, none of the commits in the
+** group was published and each of them fails with the sync error.
+*/
+struct WalGroup {
+  char *zWalName;            /* Name of the WAL file */
+  int nRef;                  /* Number of Wal objects using this group */
+  sqlite3_mutex *mutex;      /* Protects the fields below */
+  sqlite3_mutex *syncMutex;  /* Held by the owner while commits are pending */
+  Wal *pOwner;               /* Holder of the WAL write lock, or NULL */
+  Wal *pWriter;              /* Connection writing under pOwner's lock */
+  Wal *pPending;             /* Connections with commits awaiting the sync */
+  int nReader;               /* Connections reading the pending commits */
+  u8 bOpen;                  /* True while other connections may join */
+  WalIndexHdr hdrBase;       /* Published wal-index header at open */
+  WalIndexHdr hdr;           /* Header of the last pending commit */
+  WalGroup *pNext;           /* Next group in walGroupList */
+};
+
+/*
+** Values for Wal.eGroupCommit.
+*/
+#define WAL_GROUP_PENDING 1       /* Commit awaits the group sync */
+#define WAL_GROUP_DONE    2       /* Group synced, Wal.rcGroup is valid */
+
+/*
+** All WalGroup objects in this process. Protected by the static master
+** mutex.
+*/
+static WalGroup *walGroupList = 0;
+
+/*
+** Remove pWal from its commit group, if any. Free the group if no other
+** connection is using it.
+*/
+static void walGroupLeave(Wal *pWal){
+  WalGroup *pGroup = pWal->pGroup;
+  if( pGroup ){
+    sqlite3_mutex *pMaster = sqlite3MutexAlloc(SQLITE_MUTEX_STATIC_MASTER);
+    assert( pWal->eGroupCommit==0 && pWal->bGroupRead==0 );
+    sqlite3_mutex_enter(pMaster);
+    if( --pGroup->nRef==0 ){
+      WalGroup **pp;
+      for(pp=&walGroupList; *pp!=pGroup; pp=&(*pp)->pNext);
+      *pp = pGroup->pNext;
+    }else{
+      pGroup = 0;
+    }
+    sqlite3_mutex_leave(pMaster);
+    if( pGroup ){
+      sqlite3_mutex_free(pGroup->mutex);
+      sqlite3_mutex_free(pGroup->syncMutex);
+      sqlite3_free(pGroup);
+    }
+    pWal->pGroup = 0;
+  }
+}
+
+/*
+** Add pWal to the commit group of its WAL file, creating the group if
+** necessary. Return SQLITE_OK or SQLITE_NOMEM.
+*/
+static int walGroupJoin(Wal *pWal){
+  sqlite3_mutex *pMaster = sqlite3MutexAlloc(SQLITE_MUTEX_STATIC_MASTER);
+  WalGroup *pGroup;
+  int rc = SQLITE_OK;
+
+  assert( pWal->pGroup==0 );
+  sqlite3_mutex_enter(pMaster);
+  for(pGroup=walGroupList; pGroup; pGroup=pGroup->pNext){
+    if( strcmp(pGroup->zWalName, pWal->zWalName)==0 ) break;
+  }
+  if( pGroup==0 ){
+    int nName = sqlite3Strlen30(pWal->zWalName);
+    pGroup = (WalGroup*)sqlite3MallocZero(sizeof(WalGroup) + nName + 1);
+    if( pGroup ){
+      pGroup->zWalName = (char*)&pGroup[1];
+      memcpy(pGroup->zWalName, pWal->zWalName, nName+1);
+      if( sqlite3GlobalConfig.bCoreMutex ){
+        pGroup->mutex = sqlite3MutexAlloc(SQLITE_MUTEX_FAST);
+        pGroup->syncMutex = sqlite3MutexAlloc(SQLITE_MUTEX_FAST);
+        if( pGroup->mutex==0 || pGroup->syncMutex==0 ){
+          sqlite3_mutex_free(pGroup->mutex);
+          sqlite3_mutex_free(pGroup->syncMutex);
+          sqlite3_free(pGroup);
+          pGroup = 0;
+        }
+      }
+    }
+    if( pGroup ){
+      pGroup->pNext = walGroupList;
+      walGroupList = pGroup;
+    }else{
+      rc = SQLITE_NOMEM;
+    }
+  }
+  if( pGroup ){
+    pGroup->nRef++;
+    pWal->pGroup = pGroup;
+  }
+  sqlite3_mutex_leave(pMaster);
+  return rc;
+}
+
+/*
+** Configure group commit for pWal. If nWindow is negative, group commit
+** is disabled. Otherwise it is enabled, and a connection that leads a
+** group sync waits nWindow microseconds before syncing so that more
+** commits may join the group.
+*/
+void sqlite3WalGroupCommit(Wal *pWal, int nWindow){
+  if( pWal ){
+    if( nWindow<0 ){
+      if( pWal->pGroup ){
+        sqlite3WalCommitSync(pWal);
+        walGroupLeave(pWal);
+      }
+    }else if( pWal->pGroup || walGroupJoin(pWal)==SQLITE_OK ){
+      pWal->nGroupWindow = nWindow;
+    }
+  }
+}
+
+/*
+** Set whether or not the next read transaction opened through pWal is
+** opened by a statement that will go on to write in autocommit mode, and
+** so may read and join a pending group commit. See GROUP COMMIT above.
+*/
+void sqlite3WalWriteIntent(Wal *pWal, int bIntent){
+  if( pWal ) pWal->bGroupIntent = (u8)bIntent;
+}
+
+/*
+** pWal has just written the frames of a commit that is not to be
+** published until the group sync. If pWal holds the WAL write lock
+** itself, open a group, owned by pWal. Otherwise pWal is writing under
+** the lock of the group owner. Either way, add the commit to the group.
+*/
+static void walGroupAddCommit(Wal *pWal){
+  WalGroup *pGroup = pWal->pGroup;
+
+  walIndexHdrSeal(pWal);
+  if( pWal->bGroupWriter==0 ){
+    sqlite3_mutex_enter(pGroup->syncMutex);
+    sqlite3_mutex_enter(pGroup->mutex);
+    assert( pGroup->pOwner==0 && pGroup->pPending==0 );
+    pGroup->pOwner = pWal;
+    pGroup->bOpen = 1;
+    memcpy(&pGroup->hdrBase, (void *)walIndexHdr(pWal), sizeof(WalIndexHdr));
+  }else{
+    sqlite3_mutex_enter(pGroup->mutex);
+    assert( pGroup->pWriter==pWal );
+  }
+  memcpy(&pGroup->hdr, &pWal->hdr, sizeof(WalIndexHdr));
+  pWal->pGroupNext = pGroup->pPending;
+  pGroup->pPending = pWal;
+  pWal->eGroupCommit = WAL_GROUP_PENDING;
+  sqlite3_mutex_leave(pGroup->mutex);
+}
+
+/*
+** Called by the owner of a commit group, which still holds the WAL write
+** lock, when its write transaction ends. Wait for more commits to join
+** the group, then close it and sync the WAL. If the sync succeeds,
+** publish the last commit in the group. Record the result for every
+** connection with a commit in the group.
+*/
+static void walGroupSync(Wal *pWal){
+  WalGroup *pGroup = pWal->pGroup;
+  Wal *p;
+  int rc;
+
+  assert( pWal->writeLock && pGroup->pOwner==pWal );
+  if( pWal->nGroupWindow>0 ){
+    sqlite3OsSleep(pWal->pVfs, pWal->nGroupWindow);
+  }
+  sqlite3_mutex_enter(pGroup->mutex);
+  pGroup->bOpen = 0;
+  while( pGroup->pWriter || pGroup->nReader ){
+    sqlite3_mutex_leave(pGroup->mutex);
+    sqlite3OsSleep(pWal->pVfs, 100);
+    sqlite3_mutex_enter(pGroup->mutex);
+  }
+  sqlite3_mutex_leave(pGroup->mutex);
+
+  WALTRACE(("WAL%p: group sync up to frame %d\n", pWal, pGroup->hdr.mxFrame));
+  rc = sqlite3OsSync(pWal->pWalFd, pWal->groupSyncFlags);
+  if( rc==SQLITE_OK && pWal->bWal2 ){
+    /* The commits being synced may be in either wal2 file */
+    rc = sqlite3OsSync(pWal->pWalFd2, pWal->groupSyncFlags);
+  }
+  if( rc==SQLITE_OK ){
+    walIndexPublishHdr(pWal, &pGroup->hdr);
+  }else{
+    sqlite3_log(rc, "group sync of committed transactions failed: %s",
+                pWal->zWalName);
+  }
+
+  sqlite3_mutex_enter(pGroup->mutex);
+  for(p=pGroup->pPending; p; p=p->pGroupNext){
+    p->rcGroup = rc;
+    p->eGroupCommit = WAL_GROUP_DONE;
+  }
+  pGroup->pPending = 0;
+  pGroup->pOwner = 0;
+  sqlite3_mutex_leave(pGroup->mutex);
+  sqlite3_mutex_leave(pGroup->syncMutex);
+}
+
+/*
+** pWal has just opened a read transaction for a statement that will
+** write. If a group commit is open on the snapshot pWal has read, read
+** the last pending commit instead, so that the write may join the group.
+** Set *pChanged if so.
+**
+** Snapshots that do not use the WAL (readLock==0), the shared read lock
+** pin and wal2 mode are not supported.
+*/
+static void walGroupBeginRead(Wal *pWal, int *pChanged){
+  WalGroup *pGroup = pWal->pGroup;
+  if( pWal->readLock>0 && pWal->bPinRead==0 && pWal->bWal2==0 ){
+    sqlite3_mutex_enter(pGroup->mutex);
+    if( pGroup->bOpen
+     && memcmp(&pWal->hdr, &pGroup->hdrBase, sizeof(WalIndexHdr))==0
+    ){
+      memcpy(&pWal->hdr, &pGroup->hdr, sizeof(WalIndexHdr));
+      pWal->bGroupRead = 1;
+      pGroup->nReader++;
+      *pChanged = 1;
+    }
+    sqlite3_mutex_leave(pGroup->mutex);
+  }
+}
+
+/*
+** Called when a read transaction that read a pending group commit ends,
+** or becomes a write transaction that joins the group.
+**
+** The page filters built while reading the pending commits are
+** discarded, as the commits are not yet known to be durable.
+*/
+static void walGroupEndRead(Wal *pWal){
+  WalGroup *pGroup = pWal->pGroup;
+  sqlite3_mutex_enter(pGroup->mutex);
+  pGroup->nReader--;
+  sqlite3_mutex_leave(pGroup->mutex);
+  pWal->bGroupRead = 0;
+  walFilterReset(pWal);
+}
+
+/*
+** pWal, a member of a commit group, is starting a write transaction. If
+** another connection owns an open group, and pWal has read its last
+** pending commit, join the group: write under the owner's lock. Return
+** SQLITE_OK, with pWal->writeLock set, if successful. If there is an
+** owner that pWal cannot join, return SQLITE_BUSY. If there is no owner,
+** return SQLITE_OK with pWal->writeLock clear.
+*/
+static int walGroupBeginWrite(Wal *pWal){
+  WalGroup *pGroup = pWal->pGroup;
+  int rc = SQLITE_OK;
+
+  sqlite3_mutex_enter(pGroup->mutex);
+  if( pGroup->pOwner ){
+    rc = SQLITE_BUSY;
+    if( pWal->bGroupRead && pGroup->bOpen && pGroup->pWriter==0
+     && memcmp(&pWal->hdr, &pGroup->hdr, sizeof(WalIndexHdr))==0
+    ){
+      pGroup->pWriter = pWal;
+      pWal->bGroupWriter = 1;
+      pWal->writeLock = 1;
+      rc = SQLITE_OK;
+    }
+  }
+  sqlite3_mutex_leave(pGroup->mutex);
+  if( pWal->bGroupWriter ) walGroupEndRead(pWal);
+  return rc;
+}
+
+/*
+** SHARED READERS
+**
+** Each read transaction normally takes a shared lock on one of the
+** WAL_READ_LOCK() slots, and often an exclusive lock as well to update
+** the slot's aReadMark[] value. With the unix VFS every one of these is
+** an fcntl() call unless another connection in the same process happens
+** to hold the same lock at the same time.
+**
+** With shared readers enabled (PRAGMA wal_shared_readers), connections
+** in a process that use the same WAL file share a WalReaders object. It
+** owns a separate handle on the database file, through which it "pins"
+** a read lock slot whose aReadMark[] value is equal to the mxFrame of
+** the latest snapshot. A read transaction that sees that same snapshot,
+** with a wal-index header identical to the one saved when the pin was
+** taken, uses the pin: it increments WalReaders.nPinRef instead of taking a
+** lock of its own, and decrements it at the end. As long as the pin is
+** held, aReadMark[] for the slot cannot change, so the snapshot is as
+** safe as it would be with a private lock.
+**
+** The pin is released as soon as the count drops to zero, so that an
+** idle process does not hold a read lock that would prevent others from
+** checkpointing frames beyond it or restarting the WAL. So the file
+** locks are shared by read transactions that overlap in time, which is
+** the common case in a busy process.
+*/
+struct WalReaders {
+  char *zWalName;            /* Name of the WAL file */
+  int nRef;                  /* Number of Wal objects using this object */
+  sqlite3_mutex *mutex;      /* Protects the fields below */
+  sqlite3_file *pFd;         /* Database file handle holding the pin */
+  int iPin;                  /* WAL_READ_LOCK() slot pinned, or 0 */
+  WalIndexHdr hdrPin;        /* Snapshot the pin was taken for */
+  int nPinRef;               /* Read transactions using the pin */
+  WalReaders *pNext;         /* Next object in walReadersList */
+};
+
+/*
+** All WalReaders objects in this process. Protected by the static master
+** mutex.
+*/
+static WalReaders *walReadersList = 0;
+
+/*
+** Release the read lock pinned by p, if any. The caller must hold
+** p->mutex, and the pin must not be in use.
+*/
+static void walPinRelease(WalReaders *p){
+  assert( p->nPinRef==0 );
+  if( p->iPin ){
+    sqlite3OsShmLock(p->pFd, WAL_READ_LOCK(p->iPin), 1,
+                     SQLITE_SHM_UNLOCK | SQLITE_SHM_SHARED);
+    p->iPin = 0;
+  }
+}
+
+/*
+** Release the pin of the WalReaders object used by pWal, if it is held
+** but not in use. This is called before pWal tries to take exclusive
+** locks on the read lock slots.
+*/
+static void walPinDrop(Wal *pWal){
+  WalReaders *p = pWal->pReaders;
+  if( p ){
+    sqlite3_mutex_enter(p->mutex);
+    if( p->nPinRef==0 ) walPinRelease(p);
+    sqlite3_mutex_leave(p->mutex);
+  }
+}
+
+/*
+** Try to pin a read lock slot whose aReadMark[] value is equal to the
+** mxFrame of the snapshot in pWal->hdr. The caller must hold p->mutex.
+** Nothing is pinned if an error occurs or the locks are busy.
+*/
+static void walPinAcquire(Wal *pWal, WalReaders *p){
+  volatile WalCkptInfo *pInfo = walCkptInfo(pWal);
+  u32 mxFrame = pWal->hdr.mxFrame;
+  int iSlot = 0;
+  int i;
+
+  assert( p->iPin==0 && p->nPinRef==0 );
+  if( p->pFd==0 ){
+    int nName = sqlite3Strlen30(p->zWalName) - 4;
+    char *zDb = sqlite3DbStrNDup(0, p->zWalName, nName);
+    void volatile *pMap = 0;
+    int rc;
+    if( zDb==0 ) return;
+    rc = sqlite3OsOpenMalloc(pWal->pVfs, zDb, &p->pFd,
+        SQLITE_OPEN_READONLY | SQLITE_OPEN_MAIN_DB, 0
+    );
+    sqlite3_free(zDb);
+    if( rc==SQLITE_OK ){
+      rc = sqlite3OsShmMap(p->pFd, 0, WALINDEX_PGSZ, 0, &pMap);
+      if( rc!=SQLITE_OK ){
+        sqlite3OsCloseFree(p->pFd);
+      }
+    }
+    if( rc!=SQLITE_OK ){
+      p->pFd = 0;
+      return;
+    }
+  }
+
+  for(i=1; i<WAL_NREADER && iSlot==0; i++){
+    if( pInfo->aReadMark[i]==mxFrame ) iSlot = i;
+  }
+  for(i=1; i<WAL_NREADER && iSlot==0; i++){
+    if( SQLITE_OK==sqlite3OsShmLock(p->pFd, WAL_READ_LOCK(i), 1,
+                                    SQLITE_SHM_LOCK | SQLITE_SHM_EXCLUSIVE) ){
+      pInfo->aReadMark[i] = mxFrame;
+      sqlite3OsShmLock(p->pFd, WAL_READ_LOCK(i), 1,
+                       SQLITE_SHM_UNLOCK | SQLITE_SHM_EXCLUSIVE);
+      iSlot = i;
+    }
+  }
+  if( iSlot==0 ) return;
+
+  /* As in walTryBeginRead(), check that neither the slot's aReadMark[]
+  ** value nor the wal-index header changed before the lock was taken. */
+  if( SQLITE_OK==sqlite3OsShmLock(p->pFd, WAL_READ_LOCK(iSlot), 1,
+                                  SQLITE_SHM_LOCK | SQLITE_SHM_SHARED) ){
+    walShmBarrier(pWal);
+    if( pInfo->aReadMark[iSlot]!=mxFrame
+     || memcmp((void *)walIndexHdr(pWal), &pWal->hdr, sizeof(WalIndexHdr))
+    ){
+      sqlite3OsShmLock(p->pFd, WAL_READ_LOCK(iSlot), 1,
+                       SQLITE_SHM_UNLOCK | SQLITE_SHM_SHARED);
+    }else{
+      p->iPin = iSlot;
+      memcpy(&p->hdrPin, &pWal->hdr, sizeof(WalIndexHdr));
+    }
+  }
+}
+
+/*
+** Try to begin a read transaction on the snapshot in pWal->hdr using
+** the pin of pWal's WalReaders object. Return SQLITE_OK and set
+** pWal->readLock if successful, or SQLITE_BUSY if the caller should
+** take a read lock of its own instead.
+*/
+static int walPinBeginRead(Wal *pWal){
+  WalReaders *p = pWal->pReaders;
+  int rc = SQLITE_BUSY;
+
+  assert( p && pWal->readLock<0 && pWal->bPinRead==0 );
+  if( pWal->hdr.mxFrame==0 ) return SQLITE_BUSY;
+  sqlite3_mutex_enter(p->mutex);
+  if( p->iPin && p->nPinRef==0
+   && memcmp(&p->hdrPin, &pWal->hdr, sizeof(WalIndexHdr))
+  ){
+    walPinRelease(p);
+  }
+  if( p->iPin==0 ){
+    walPinAcquire(pWal, p);
+  }
+  if( p->iPin && memcmp(&p->hdrPin, &pWal->hdr, sizeof(WalIndexHdr))==0 ){
+    /* As in walTryBeginRead(), compare the whole header and not only
+    ** mxFrame, so that the pin is only used for exactly the snapshot it
+    ** was taken for. */
+    p->nPinRef++;
+    pWal->readLock = (i16)p->iPin;
+    pWal->bPinRead = 1;
+    rc = SQLITE_OK;
+  }
+  sqlite3_mutex_leave(p->mutex);
+  return rc;
+}
+
+/*
+** Release the read lock held by pWal. pWal->readLock is not modified.
+** If pWal was the last read transaction using the pin of its WalReaders
+** object, the pin is released as well.
+*/
+static void walReadUnlock(Wal *pWal){
+  if( pWal->bPinRead ){
+    WalReaders *p = pWal->pReaders;
+    sqlite3_mutex_enter(p->mutex);
+    if( --p->nPinRef==0 ) walPinRelease(p);
+    sqlite3_mutex_leave(p->mutex);
+    pWal->bPinRead = 0;
+  }else{
+    walUnlockShared(pWal, WAL_READ_LOCK(pWal->readLock));
+  }
+}
+
+/*
+** Remove pWal from its WalReaders object, if any. Free the object if no
+** other connection is using it.
+*/
+static void walReadersLeave(Wal *pWal){
+  WalReaders *p = pWal->pReaders;
+  if( p ){
+    sqlite3_mutex *pMaster = sqlite3MutexAlloc(SQLITE_MUTEX_STATIC_MASTER);
+    if( pWal->bPinRead ){
+      /* Replace the pin with a lock of pWal's own. This does not require
+      ** a system call, as the pin is held by the same process. */
+      walLockShared(pWal, WAL_READ_LOCK(pWal->readLock));
+      walReadUnlock(pWal);
+    }
+    sqlite3_mutex_enter(pMaster);
+    if( --p->nRef==0 ){
+      WalReaders **pp;
+      for(pp=&walReadersList; *pp!=p; pp=&(*pp)->pNext);
+      *pp = p->pNext;
+    }else{
+      p = 0;
+    }
+    sqlite3_mutex_leave(pMaster);
+    if( p ){
+      if( p->pFd ){
+        walPinRelease(p);
+        sqlite3OsShmUnmap(p->pFd, 0);
+        sqlite3OsCloseFree(p->pFd);
+      }
+      sqlite3_mutex_free(p->mutex);
+      sqlite3_free(p);
+    }
+    pWal->pReaders = 0;
+  }
+}
+
+/*
+** Add pWal to the WalReaders object of its WAL file, creating it if
+** necessary. Return SQLITE_OK, or SQLITE_NOMEM.
+*/
+static int walReadersJoin(Wal *pWal){
+  sqlite3_mutex *pMaster = sqlite3MutexAlloc(SQLITE_MUTEX_STATIC_MASTER);
+  WalReaders *p;
+  int rc = SQLITE_OK;
+
+  assert( pWal->pReaders==0 );
+  sqlite3_mutex_enter(pMaster);
+  for(p=walReadersList; p; p=p->pNext){
+    if( strcmp(p->zWalName, pWal->zWalName)==0 ) break;
+  }
+  if( p==0 ){
+    int nName = sqlite3Strlen30(pWal->zWalName);
+    p = (WalReaders*)sqlite3MallocZero(sizeof(WalReaders) + nName + 1);
+    if( p ){
+      p->zWalName = (char*)&p[1];
+      memcpy(p->zWalName, pWal->zWalName, nName+1);
+      if( sqlite3GlobalConfig.bCoreMutex ){
+        p->mutex = sqlite3MutexAlloc(SQLITE_MUTEX_FAST);
+        if( p->mutex==0 ){
+          sqlite3_free(p);
+          p = 0;
+        }
+      }
+    }
+    if( p ){
+      p->pNext = walReadersList;
+      walReadersList = p;
+    }else{
+      rc = SQLITE_NOMEM;
+    }
+  }
+  if( p ){
+    p->nRef++;
+    pWal->pReaders = p;
+  }
+  sqlite3_mutex_leave(pMaster);
+  return rc;
+}
+
+/*
+** Enable (if onoff is true) or disable shared readers for pWal. Shared
+** readers are not used in wal2 mode, in heap-memory mode, with a
+** read-only wal-index, or if the WAL file name does not end in "-wal".
+*/
+void sqlite3WalSharedReaders(Wal *pWal, int onoff){
+  if( pWal ){
+    int n = sqlite3Strlen30(pWal->zWalName);
+    if( onoff==0 ){
+      walReadersLeave(pWal);
+    }else if( pWal->pReaders==0
+     && pWal->bWal2==0
+     && pWal->exclusiveMode!=WAL_HEAPMEMORY_MODE
+     && (pWal->readOnly & WAL_SHM_RDONLY)==0
+     && n>4 && memcmp(&pWal->zWalName[n-4], "-wal", 4)==0
+    ){
+      walReadersJoin(pWal);
+    }
+  }
+}
+
+/*
+** If the most recent transaction committed through pWal was added to a
+** group commit, wait for the group sync and return its result. This
+** must not be called while pWal holds the WAL write lock.
+**
+** If the sync failed, the commit was never published. pWal's copy of
+** the wal-index header, and the page filters built from it, are
+** discarded so that the next read transaction starts afresh.
+*/
+int sqlite3WalCommitSync(Wal *pWal){
+  int rc = SQLITE_OK;
+  if( pWal->eGroupCommit ){
+    WalGroup *pGroup = pWal->pGroup;
+    assert( pGroup && !pWal->writeLock );
+    while( 1 ){
+      int eGroup;
+      sqlite3_mutex_enter(pGroup->mutex);
+      eGroup = pWal->eGroupCommit;
+      sqlite3_mutex_leave(pGroup->mutex);
+      if( eGroup==WAL_GROUP_DONE ) break;
+      sqlite3_mutex_enter(pGroup->syncMutex);
+      sqlite3_mutex_leave(pGroup->syncMutex);
+    }
+    rc = pWal->rcGroup;
+    pWal->eGroupCommit = 0;
+    if( rc!=SQLITE_OK ){
+      memset(&pWal->hdr, 0, sizeof(WalIndexHdr));
+      walFilterReset(pWal);
+    }
+  }
+  return rc;
+}
+
 /*
 ** Find the smallest page number out of all pages held in the WAL that
 ** has not been returned by any prior invocation of this method on the
@@ -1575,7 +2952,12 @@ static void walIteratorFree(WalIterator *p){
 /* The calling routine should invoke walIteratorFree() to destroy the
 ** WalIterator object when it has finished with it.*//*当完成时调用walIteratorFree()来破坏 WalIterator对象。*/
 
-static int walIteratorInit(Wal *pWal, WalIterator **pp){ 
+static int walIteratorInit(
+  Wal *pWal,                      /* WAL connection */
+  int iWal,                       /* Iterate through this wal2 file */
+  u32 nFrame,                     /* Number of frames in the file */
+  WalIterator **pp                /* OUT: New iterator */
+){
   WalIterator *p;                 /* Return value */ /*  返回值*/
   int nSegment;                   /* Number of segments to merge *//*  将合并的部分数*/
   u32 iLast;                      /* Last frame in log *//*  日志中的最后的帧*/
@@ -1587,11 +2969,17 @@ static int walIteratorInit(Wal *pWal, WalIterator **pp){
   /* This routine only runs while holding the checkpoint lock. And
   ** it only runs if there is actually content in the log (mxFrame>0).*//*此程序仅当持有检查点锁时运行，并且只运行有实际内容的日志(mxFrame > 0)*/
   
-  assert( pWal->ckptLock && pWal->hdr.mxFrame>0 ); /*若果不在枷锁下，终止程序*/
-  iLast = pWal->hdr.mxFrame;     /* 获取Wal的值*/
-
-  /* Allocate space for the WalIterator object. */ /*为WalIterator分配空间*/
-  nSegment = walFramePage(iLast) + 1; /*获取几个段的值*/
+  assert( pWal->ckptLock && nFrame>0 ); /*若果不在枷锁下，终止程序*/
+  assert( iWal==0 || pWal->bWal2 );
+  iLast = pWal->bWal2 ? wal2IndexFrame(iWal, nFrame) : nFrame;
+
+  /* Allocate space for the WalIterator object. In wal2 mode, only every
+  ** second hash table belongs to file iWal. */ /*为WalIterator分配空间*/
+  if( pWal->bWal2 ){
+    nSegment = (walFramePage(iLast) - iWal)/2 + 1;
+  }else{
+    nSegment = walFramePage(iLast) + 1; /*获取几个段的值*/
+  }
   nByte = sizeof(WalIterator)          /*计算要分配多少个字节*/
         + (nSegment-1)*sizeof(struct WalSegment)
         + iLast*sizeof(ht_slot);
@@ -1606,7 +2994,7 @@ static int walIteratorInit(Wal *pWal, WalIterator **pp){
   ** of memory will be freed before this function returns. *//*分配merge-sort程序使用的临时空间。内存的锁将会在程序返回前被释放。*/
  
   aTmp = (ht_slot *)sqlite3ScratchMalloc(         /* 调用函数分配内存*/
-      sizeof(ht_slot) * (iLast>HASHTABLE_NPAGE?HASHTABLE_NPAGE:iLast)
+      sizeof(ht_slot) * (nFrame>HASHTABLE_NPAGE?HASHTABLE_NPAGE:nFrame)
   );
   if( !aTmp ){        /*  如果分配不成功*/
     rc = SQLITE_NOMEM;  /*返回SQLlIte_NOMEM*/
@@ -1617,7 +3005,7 @@ static int walIteratorInit(Wal *pWal, WalIterator **pp){
     u32 iZero;                                 
     volatile u32 *aPgno;
 
-    rc = walHashGet(pWal, i, &aHash, &aPgno, &iZero); /*调用walHashGet（）*/
+    rc = walHashGet(pWal, pWal->bWal2 ? iWal+2*i : i, &aHash, &aPgno, &iZero);
     if( rc==SQLITE_OK ){              /* 如果调用成功*/
       int j;                      /* Counter variable */ /*变量 */
       int nEntry;                 /* Number of entries in this segment *//* 在一段中的项目数*/
@@ -1642,42 +3030,203 @@ static int walIteratorInit(Wal *pWal, WalIterator **pp){
       p->aSegment[i].aPgno = (u32 *)aPgno;
     }
   }
-  sqlite3ScratchFree(aTmp);  /* 释放aTmp指针*/
-
-  if( rc!=SQLITE_OK ){   /* 释放aTmp指针*/
-    walIteratorFree(p);   /*释放p指针*/
+  sqlite3ScratchFree(aTmp);  /* 释放aTmp指针*/
+
+  if( rc!=SQLITE_OK ){   /* 释放aTmp指针*/
+    walIteratorFree(p);   /*释放p指针*/
+  }
+  *pp = p;
+  return rc;
+}
+
+/*
+** Attempt to obtain the exclusive WAL lock defined by parameters lockIdx and
+** n. If the attempt fails and parameter xBusy is not NULL, then it is a
+** busy-handler function. Invoke it and retry the lock until either the
+** lock is successfully obtained or the busy-handler returns 0.*//*试图得到被参数lockldx和n定义的排它锁，若获取失败或xBusy参数不为空，则为busy-handler功能，调用它并且再次尝试这个锁直到获取成功或busy-handler返回值为0。*/
+
+static int walBusyLock(       /* 试图获取Wal的锁根据LockIdex*/   
+  Wal *pWal,                      /* WAL connection */ /*  WAL连接*/
+  int (*xBusy)(void*),            /* Function to call when busy */ /*  当忙时调用的功能*/
+  void *pBusyArg,                 /* Context argument for xBusyHandler */ /*  关于xBusyHandler的文本论证*/
+  int lockIdx,                    /* Offset of first byte to lock */ /* 锁的第一个字节偏移量*/
+  int n                           /* Number of bytes to lock */  /*  锁的字节数*/
+){
+  int rc;         /* 定义返回值*/
+  do {
+    rc = walLockExclusive(pWal, lockIdx, n); /*调用函数进行加锁*/
+  }while( xBusy && rc==SQLITE_BUSY && xBusy(pBusyArg) ); 
+  return rc; /*  返回rc值*/
+}
+
+/*
+** The cache of the wal-index header must be valid to call this function.
+** Return the page-size in bytes used by the database. *//*wal-index的头文件缓存对于调用的功能必须是有效的，在数据库中返回page-size的字节。*/
+static int walPagesize(Wal *pWal){     
+  return (pWal->hdr.szPage&0xfe00) + ((pWal->hdr.szPage&0x0001)<<16); 
+}
+
+/*
+** A checkpoint copies pages to the database file in runs of consecutive
+** page numbers, using a single write of up to SQLITE_WAL_CKPT_BATCH bytes
+** for each run. Frames that are also consecutive in the WAL file are read
+** with a single read. Setting SQLITE_WAL_CKPT_BATCH to 0 makes checkpoints
+** copy one page at a time.
+*/
+#ifndef SQLITE_WAL_CKPT_BATCH
+# define SQLITE_WAL_CKPT_BATCH (256*1024)
+#endif
+
+/*
+** The batch size actually used. Test builds let the test harness change
+** it, so that coalesced and page at a time checkpoints can be compared.
+*/
+#ifdef SQLITE_TEST
+int sqlite3_wal_ckpt_batch = SQLITE_WAL_CKPT_BATCH;
+#else
+# define sqlite3_wal_ckpt_batch SQLITE_WAL_CKPT_BATCH
+#endif
+
+/*
+** State used by walCheckpoint() to coalesce writes to the database file.
+*/
+typedef struct WalCkptRun WalCkptRun;
+struct WalCkptRun {
+  int nMax;                       /* Max pages in a run */
+  int nPage;                      /* Number of pages in the current run */
+  u32 iFirst;                     /* Database page number of aData[0] */
+  u32 *aFrame;                    /* WAL frame holding each page of the run */
+  u8 *aData;                      /* Content of the pages in the run */
+  u8 *aScratch;                   /* Space for nMax frames, or NULL */
+};
+
+/*
+** Read the content of the current run from WAL file pWalFd and write it
+** to the database file with a single write. Then start a new, empty run.
+*/
+static int walCkptFlush(
+  Wal *pWal,
+  sqlite3_file *pWalFd,
+  int szPage,
+  WalCkptRun *p
+){
+  int szFrame = szPage + WAL_FRAME_HDRSIZE;
+  int rc = SQLITE_OK;
+  int i, j, k;
+
+  for(i=0; rc==SQLITE_OK && i<p->nPage; i=j){
+    /* Pages i..j-1 are stored in consecutive frames of the WAL */
+    for(j=i+1; j<p->nPage && p->aFrame[j]==p->aFrame[j-1]+1; j++);
+    if( j-i>1 && p->aScratch ){
+      i64 iOffset = walFrameOffset(p->aFrame[i], szPage);
+      rc = sqlite3OsRead(pWalFd, p->aScratch, (j-i)*szFrame, iOffset);
+      for(k=i; rc==SQLITE_OK && k<j; k++){
+        memcpy(&p->aData[k*szPage],
+               &p->aScratch[(k-i)*szFrame + WAL_FRAME_HDRSIZE], szPage);
+      }
+    }else{
+      for(k=i; rc==SQLITE_OK && k<j; k++){
+        i64 iOffset = walFrameOffset(p->aFrame[k], szPage)+WAL_FRAME_HDRSIZE;
+        /* testcase( IS_BIG_INT(iOffset) ); // requires a 4GiB WAL file */
+        rc = sqlite3OsRead(pWalFd, &p->aData[k*szPage], szPage, iOffset);
+      }
+    }
+  }
+  if( rc==SQLITE_OK && p->nPage>0 ){
+    i64 iOffset = (p->iFirst-1)*(i64)szPage;
+    testcase( IS_BIG_INT(iOffset) );
+    rc = sqlite3OsWrite(pWal->pDbFd, p->aData, p->nPage*szPage, iOffset);
+  }
+  p->nPage = 0;
+  return rc;
+}
+
+/*
+** Copy frames nBackfill+1 through mxSafeFrame of WAL file iWal (always 0
+** outside of wal2 mode) into the database file, skipping any that hold
+** pages beyond mxPage. The WAL file is synced first. pIter must iterate
+** through the frames of file iWal. This is a helper for walCheckpoint()
+** and wal2Checkpoint(); the caller holds whatever locks are required
+** and updates nBackfill afterwards.
+*/
+static int walBackfill(
+  Wal *pWal,                      /* Wal connection */
+  WalIterator *pIter,             /* Iterator over the frames of file iWal */
+  int iWal,                       /* WAL file to copy frames from */
+  u32 nBackfill,                  /* Frames already copied */
+  u32 mxSafeFrame,                /* Last frame that may be copied */
+  u32 mxPage,                     /* Max database page to write */
+  int sync_flags,                 /* Flags for OsSync() (or 0) */
+  u8 *zBuf                        /* Temporary buffer to use */
+){
+  sqlite3_file *pWalFd = walFd(pWal, iWal);
+  int szPage = walPagesize(pWal); /* Database page-size */
+  int rc = SQLITE_OK;             /* Return code */
+  i64 nSize;                      /* Current size of database file */
+  u32 iDbpage = 0;                /* Next database page to write */
+  u32 iFrame = 0;                 /* Wal frame containing data for iDbpage */
+  WalCkptRun run;                 /* Run of pages to write in one go */
+  u32 iOneFrame;                  /* run.aFrame[] if not malloced */
+  u8 *pRunBuf = 0;                /* Malloced buffers used by run */
+
+  /* Sync the WAL to disk *//* 将Wal同步到磁盘上*/
+  if( sync_flags ){  /* 是否同步*/
+    rc = sqlite3OsSync(pWalFd, sync_flags);/* 调用同步函数*/
+  }
+
+  /* If the database file may grow as a result of this checkpoint, hint
+  ** about the eventual size of the db file to the VFS layer.*//*如果数据库文件可能会由于这个检查点改变,表示有关于VFS层的db文件的最终大小。*/
+  
+  if( rc==SQLITE_OK ){  /*如果调用成功*/
+    i64 nReq = ((i64)mxPage * szPage);  /*定义64为的变量*/
+    rc = sqlite3OsFileSize(pWal->pDbFd, &nSize); /*调用系统函数，确定文件大小*/
+    if( rc==SQLITE_OK && nSize<nReq ){     /*如果调用成功且数据文件小于最大的阀值*/
+      sqlite3OsFileControlHint(pWal->pDbFd, SQLITE_FCNTL_SIZE_HINT, &nReq); /* 调用函数*/
+    }
+  }
+
+  /* Allocate the buffers used to coalesce writes. If this fails, copy 
+  ** one page at a time through zBuf instead. */
+  memset(&run, 0, sizeof(run));
+  run.nMax = sqlite3_wal_ckpt_batch/szPage;
+  if( run.nMax>1 ){
+    int szFrame = szPage + WAL_FRAME_HDRSIZE;
+    pRunBuf = (u8*)sqlite3_malloc(run.nMax*(szPage + szFrame + 4));
+  }
+  if( pRunBuf ){
+    run.aData = pRunBuf;
+    run.aScratch = &pRunBuf[run.nMax*szPage];
+    run.aFrame = (u32*)&run.aScratch[run.nMax*(szPage + WAL_FRAME_HDRSIZE)];
+  }else{
+    run.nMax = 1;
+    run.aData = zBuf;
+    run.aFrame = &iOneFrame;
+  }
+
+  /* Iterate through the contents of the WAL, copying data to the db file. *//*将Wal的内容复制到数据文件中*/
+  while( rc==SQLITE_OK && 0==walIteratorNext(pIter, &iDbpage, &iFrame) ){ 
+    assert( walFramePgno(pWal, iFrame)==iDbpage ); /*如果调用函数的返回值不等于IDbpage，则终止程序*/
+    if( pWal->bWal2 ){
+      int iFile;
+      iFrame = wal2FileFrame(iFrame, &iFile);
+      assert( iFile==iWal );
+    }
+    if( iFrame<=nBackfill || iFrame>mxSafeFrame || iDbpage>mxPage ) continue; /*如果不满足程序 ，则跳过此次循环*/
+    if( run.nPage>0
+     && (run.nPage==run.nMax || iDbpage!=run.iFirst+run.nPage)
+    ){
+      rc = walCkptFlush(pWal, pWalFd, szPage, &run);
+    }
+    if( run.nPage==0 ) run.iFirst = iDbpage;
+    run.aFrame[run.nPage++] = iFrame;
+  }
+  if( rc==SQLITE_OK ){
+    rc = walCkptFlush(pWal, pWalFd, szPage, &run);
   }
-  *pp = p;
+  sqlite3_free(pRunBuf);
   return rc;
 }
 
-/*
-** Attempt to obtain the exclusive WAL lock defined by parameters lockIdx and
-** n. If the attempt fails and parameter xBusy is not NULL, then it is a
-** busy-handler function. Invoke it and retry the lock until either the
-** lock is successfully obtained or the busy-handler returns 0.*//*试图得到被参数lockldx和n定义的排它锁，若获取失败或xBusy参数不为空，则为busy-handler功能，调用它并且再次尝试这个锁直到获取成功或busy-handler返回值为0。*/
-
-static int walBusyLock(       /* 试图获取Wal的锁根据LockIdex*/   
-  Wal *pWal,                      /* WAL connection */ /*  WAL连接*/
-  int (*xBusy)(void*),            /* Function to call when busy */ /*  当忙时调用的功能*/
-  void *pBusyArg,                 /* Context argument for xBusyHandler */ /*  关于xBusyHandler的文本论证*/
-  int lockIdx,                    /* Offset of first byte to lock */ /* 锁的第一个字节偏移量*/
-  int n                           /* Number of bytes to lock */  /*  锁的字节数*/
-){
-  int rc;         /* 定义返回值*/
-  do {
-    rc = walLockExclusive(pWal, lockIdx, n); /*调用函数进行加锁*/
-  }while( xBusy && rc==SQLITE_BUSY && xBusy(pBusyArg) ); 
-  return rc; /*  返回rc值*/
-}
-
-/*
-** The cache of the wal-index header must be valid to call this function.
-** Return the page-size in bytes used by the database. *//*wal-index的头文件缓存对于调用的功能必须是有效的，在数据库中返回page-size的字节。*/
-static int walPagesize(Wal *pWal){     
-  return (pWal->hdr.szPage&0xfe00) + ((pWal->hdr.szPage&0x0001)<<16); 
-}
-
 /*
 ** Copy as much content as we can from the WAL back into the database file
 ** in response to an sqlite3_wal_checkpoint() request or the equivalent.*//*我们可以从WAL数据库文件在回应sqlite3_wal_checkpoint()请求或等效时尽可能多的复制内容。*/
@@ -1721,8 +3270,6 @@ static int walCheckpoint(
   int rc;                         /* Return code *//*  返回值*/
   int szPage;                     /* Database page-size *//* 数据库页的大小*/
   WalIterator *pIter = 0;         /* Wal iterator context *//* 定义一个迭代指针*/   
-  u32 iDbpage = 0;                /* Next database page to write */ /*下一个要写的数据库页*/ 
-  u32 iFrame = 0;                 /* Wal frame containing data for iDbpage *//* 包含iDbpage内容的Wal帧*/
   u32 mxSafeFrame;                /* Max frame that can be backfilled */ /*可回填的最大帧*/
   u32 mxPage;                     /* Max database page to write *//*可写的最大数据库页*/
   int i;                          /* Loop counter *//*定义循环变量*/  
@@ -1736,7 +3283,7 @@ static int walCheckpoint(
   if( pInfo->nBackfill>=pWal->hdr.mxFrame ) return SQLITE_OK; /*如果pInfo->nBackfill>=pWal->hdr.mxFrame,则返回SQLITE_OK*/
 
   /* Allocate the iterator *//*   配置迭代*/
-  rc = walIteratorInit(pWal, &pIter); /*进行wal的初始化*/
+  rc = walIteratorInit(pWal, 0, pWal->hdr.mxFrame, &pIter); /*进行wal的初始化*/
   if( rc!=SQLITE_OK ){      /*如果调用不成功*/
     return rc;              /*返回 rc*/
   }
@@ -1752,6 +3299,7 @@ static int walCheckpoint(
   
   mxSafeFrame = pWal->hdr.mxFrame;/* 获取mxSafeFrame的值*/
   mxPage = pWal->hdr.nPage;       /*  获取mxpage值*/
+  walPinDrop(pWal);
   for(i=1; i<WAL_NREADER; i++){     
     u32 y = pInfo->aReadMark[i];/* 定义变量 */
     if( mxSafeFrame>y ){      
@@ -1769,42 +3317,21 @@ static int walCheckpoint(
     }
   }
 
+  /* A PASSIVE checkpoint may be asked to copy only a limited number of
+  ** frames, so that a background checkpointer works in short steps. */
+  if( eMode==SQLITE_CHECKPOINT_PASSIVE && pWal->nCkptStep>0
+   && mxSafeFrame>pInfo->nBackfill+pWal->nCkptStep
+  ){
+    mxSafeFrame = pInfo->nBackfill + pWal->nCkptStep;
+  }
+
   if( pInfo->nBackfill<mxSafeFrame
    && (rc = walBusyLock(pWal, xBusy, pBusyArg, WAL_READ_LOCK(0), 1))==SQLITE_OK     /* 判断语句*/
   ){
-    i64 nSize;                    /* Current size of database file *//* 当前数据库大小*/
     u32 nBackfill = pInfo->nBackfill;       
 
-    /* Sync the WAL to disk *//* 将Wal同步到磁盘上*/
-    if( sync_flags ){  /* 是否同步*/
-      rc = sqlite3OsSync(pWal->pWalFd, sync_flags);/* 调用同步函数*/
-    }
-
-    /* If the database file may grow as a result of this checkpoint, hint
-    ** about the eventual size of the db file to the VFS layer.*//*如果数据库文件可能会由于这个检查点改变,表示有关于VFS层的db文件的最终大小。*/
-    
-	if( rc==SQLITE_OK ){  /*如果调用成功*/
-      i64 nReq = ((i64)mxPage * szPage);  /*定义64为的变量*/
-      rc = sqlite3OsFileSize(pWal->pDbFd, &nSize); /*调用系统函数，确定文件大小*/
-      if( rc==SQLITE_OK && nSize<nReq ){     /*如果调用成功且数据文件小于最大的阀值*/
-        sqlite3OsFileControlHint(pWal->pDbFd, SQLITE_FCNTL_SIZE_HINT, &nReq); /* 调用函数*/
-      }
-    }
-
-    /* Iterate through the contents of the WAL, copying data to the db file. *//*将Wal的内容复制到数据文件中*/
-    while( rc==SQLITE_OK && 0==walIteratorNext(pIter, &iDbpage, &iFrame) ){ 
-      i64 iOffset;        /*定义 64 的变量*/
-      assert( walFramePgno(pWal, iFrame)==iDbpage ); /*如果调用函数的返回值不等于IDbpage，则终止程序*/
-      if( iFrame<=nBackfill || iFrame>mxSafeFrame || iDbpage>mxPage ) continue; /*如果不满足程序 ，则跳过此次循环*/
-      iOffset = walFrameOffset(iFrame, szPage) + WAL_FRAME_HDRSIZE; /*为IoffSET赋值*/
-      /* testcase( IS_BIG_INT(iOffset) );*//*requires a 4GiB WAL file */
-      rc = sqlite3OsRead(pWal->pWalFd, zBuf, szPage, iOffset);  /*调用系统读函数*/
-      if( rc!=SQLITE_OK ) break; /*如果调用不成功 ，终止循环*/
-      iOffset = (iDbpage-1)*(i64)szPage; /*求取值*/
-      testcase( IS_BIG_INT(iOffset) ); /*测试函数*/
-      rc = sqlite3OsWrite(pWal->pDbFd, zBuf, szPage, iOffset);   /*调用写函数*/
-      if( rc!=SQLITE_OK ) break;/*如果调用不成功，则跳出循环*/
-    }
+    rc = walBackfill(pWal, pIter, 0, nBackfill, mxSafeFrame, mxPage,
+                     sync_flags, zBuf);
 
     /* If work was actually accomplished... *//*如果工作完成...*/
     if( rc==SQLITE_OK ){  /*如果rc 等于SQLite_OK*/
@@ -1856,20 +3383,171 @@ static int walCheckpoint(
 }
 
 /*
-** If the WAL file is currently larger than nMax bytes in size, truncate
+** This is the wal2 mode version of walCheckpoint(). Only frames of the
+** non-current WAL file are copied into the database, and only while no
+** reader is using a snapshot that includes part of that file, or none
+** of the WAL at all. Readers of the current file never block it. This is
+** what allows a checkpoint to finish while new readers keep arriving.
+**
+** An SQLITE_CHECKPOINT_RESTART checkpoint is handled in the same way as
+** SQLITE_CHECKPOINT_FULL, as the next writer to switch files will start
+** overwriting the checkpointed file from the beginning anyway.
+*/
+static int wal2Checkpoint(
+  Wal *pWal,                      /* Wal connection */
+  int eMode,                      /* One of PASSIVE, FULL or RESTART */
+  int (*xBusyCall)(void*),        /* Function to call when busy */
+  void *pBusyArg,                 /* Context argument for xBusyHandler */
+  int sync_flags,                 /* Flags for OsSync() (or 0) */
+  u8 *zBuf                        /* Temporary buffer to use */
+){
+  int iCkpt = !wal2Current(&pWal->hdr);      /* File to checkpoint */
+  u32 nFrame = wal2OtherFrames(&pWal->hdr);  /* Frames in file iCkpt */
+  volatile WalCkptInfo *pInfo = walCkptInfo(pWal);
+  int (*xBusy)(void*) = 0;        /* Function to call when waiting for locks */
+  WalIterator *pIter = 0;         /* Wal iterator context */
+  int rc;                         /* Return code */
+
+  if( pInfo->nBackfill>=nFrame ) return SQLITE_OK;
+  if( eMode!=SQLITE_CHECKPOINT_PASSIVE ) xBusy = xBusyCall;
+
+  rc = walBusyLock(pWal, xBusy, pBusyArg, WAL_READ_LOCK(0), 1);
+  if( rc==SQLITE_OK ){
+    rc = walBusyLock(pWal, xBusy, pBusyArg,
+                     WAL_READ_LOCK(WAL2_LOCK_PART(iCkpt)), 2);
+    if( rc==SQLITE_OK ){
+      u32 nBackfill = pInfo->nBackfill;
+      u32 mxSafeFrame = nFrame;
+
+      /* A writer may have switched files since the header was read. If so,
+      ** there is nothing left to do - a switch only takes place once the
+      ** non-current file has been checkpointed. */
+      if( walIndexHdr(pWal)->mxFrame2!=pWal->hdr.mxFrame2 ){
+        rc = SQLITE_BUSY;
+      }
+      if( eMode==SQLITE_CHECKPOINT_PASSIVE && pWal->nCkptStep>0
+       && mxSafeFrame>nBackfill+pWal->nCkptStep
+      ){
+        mxSafeFrame = nBackfill + pWal->nCkptStep;
+      }
+      if( rc==SQLITE_OK ){
+        rc = walIteratorInit(pWal, iCkpt, nFrame, &pIter);
+      }
+      if( rc==SQLITE_OK ){
+        rc = walBackfill(pWal, pIter, iCkpt, nBackfill, mxSafeFrame,
+                         pWal->hdr.nPage, sync_flags, zBuf);
+      }
+
+      /* Once the whole file has been copied, make the database durable, as
+      ** the file will be overwritten after the next switch. The database
+      ** may only be truncated if no snapshot includes current file frames,
+      ** as otherwise a reader may still need pages beyond the end. */
+      if( rc==SQLITE_OK && mxSafeFrame==nFrame ){
+        if( pWal->hdr.mxFrame==0 ){
+          i64 szDb = pWal->hdr.nPage*(i64)walPagesize(pWal);
+          testcase( IS_BIG_INT(szDb) );
+          rc = sqlite3OsTruncate(pWal->pDbFd, szDb);
+        }
+        if( rc==SQLITE_OK && sync_flags ){
+          rc = sqlite3OsSync(pWal->pDbFd, sync_flags);
+        }
+      }
+      if( rc==SQLITE_OK ){
+        pInfo->nBackfill = mxSafeFrame;
+      }
+      walUnlockExclusive(pWal, WAL_READ_LOCK(WAL2_LOCK_PART(iCkpt)), 2);
+    }
+    walUnlockExclusive(pWal, WAL_READ_LOCK(0), 1);
+  }
+
+  if( rc==SQLITE_BUSY ) rc = SQLITE_OK;
+  if( rc==SQLITE_OK && eMode!=SQLITE_CHECKPOINT_PASSIVE
+   && pInfo->nBackfill<nFrame
+  ){
+    rc = SQLITE_BUSY;
+  }
+  walIteratorFree(pIter);
+  return rc;
+}
+
+/* Forward reference */
+static int walIndexReadHdr(Wal *pWal, int *pChanged);
+
+/*
+** This is called by sqlite3WalClose() in wal2 mode, after the ordinary
+** checkpoint has run. The caller holds an EXCLUSIVE lock on the database
+** file, so there are no other connections and the contents of both WAL
+** files may be copied into the database before they are deleted.
+*/
+static int wal2CheckpointAll(
+  Wal *pWal,                      /* Wal connection */
+  int sync_flags,                 /* Flags for OsSync() (or 0) */
+  int nBuf,                       /* Size of zBuf in bytes */
+  u8 *zBuf                        /* Temporary buffer to use */
+){
+  int isChanged = 0;              /* Not used */
+  int rc;                         /* Return code */
+
+  rc = walLockExclusive(pWal, WAL_CKPT_LOCK, 1);
+  if( rc!=SQLITE_OK ) return rc;
+  pWal->ckptLock = 1;
+  rc = walIndexReadHdr(pWal, &isChanged);
+  if( rc==SQLITE_OK && (pWal->hdr.mxFrame>0 || wal2OtherFrames(&pWal->hdr)) ){
+    int iCur = wal2Current(&pWal->hdr);
+    u32 aFirst[2];                /* Frames of each file already copied */
+    u32 aLast[2];                 /* Frames in each file */
+    int i;
+
+    aFirst[!iCur] = walCkptInfo(pWal)->nBackfill;
+    aLast[!iCur] = wal2OtherFrames(&pWal->hdr);
+    aFirst[iCur] = 0;
+    aLast[iCur] = pWal->hdr.mxFrame;
+    if( walPagesize(pWal)!=nBuf ) rc = SQLITE_CORRUPT_BKPT;
+
+    /* Copy the rest of the non-current file, then the current file */
+    for(i=0; rc==SQLITE_OK && i<2; i++){
+      int iWal = i ? iCur : !iCur;
+      WalIterator *pIter = 0;
+      if( aFirst[iWal]>=aLast[iWal] ) continue;
+      rc = walIteratorInit(pWal, iWal, aLast[iWal], &pIter);
+      if( rc==SQLITE_OK ){
+        rc = walBackfill(pWal, pIter, iWal, aFirst[iWal], aLast[iWal],
+                         pWal->hdr.nPage, sync_flags, zBuf);
+      }
+      walIteratorFree(pIter);
+    }
+    if( rc==SQLITE_OK ){
+      i64 szDb = pWal->hdr.nPage*(i64)walPagesize(pWal);
+      rc = sqlite3OsTruncate(pWal->pDbFd, szDb);
+      if( rc==SQLITE_OK && sync_flags ){
+        rc = sqlite3OsSync(pWal->pDbFd, sync_flags);
+      }
+    }
+  }
+  memset(&pWal->hdr, 0, sizeof(WalIndexHdr));
+  walUnlockExclusive(pWal, WAL_CKPT_LOCK, 1);
+  pWal->ckptLock = 0;
+  return rc;
+}
+
+/*
+** If WAL file iWal is currently larger than nMax bytes in size, truncate
 ** it to exactly nMax bytes. If an error occurs while doing so, ignore it. *//*如果Wal文件比 nMax的字节还要大，则缩短它到正确的长度。如果此时有错，则忽略它。*/
 
-static void walLimitSize(Wal *pWal, i64 nMax){
+static void walLimitSize(Wal *pWal, int iWal, i64 nMax){
+  sqlite3_file *pWalFd = walFd(pWal, iWal);
   i64 sz;     /*定义64为的变量*/ 
   int rx; 
   sqlite3BeginBenignMalloc();/*调用函数*/
-  rx = sqlite3OsFileSize(pWal->pWalFd, &sz); /*调用系统函数得到Wal的大小*/
+  rx = sqlite3OsFileSize(pWalFd, &sz); /*调用系统函数得到Wal的大小*/
   if( rx==SQLITE_OK && (sz > nMax ) ){    /*如果调用函数成功，如果文件大小超过范围*/
-    rx = sqlite3OsTruncate(pWal->pWalFd, nMax);/* 调用函数，将文件大小缩短*/
+    rx = sqlite3OsTruncate(pWalFd, nMax);/* 调用函数，将文件大小缩短*/
   }
   sqlite3EndBenignMalloc(); /*结束内存管理*/
   if( rx ){       /*如果rx为真*/   
-    sqlite3_log(rx, "cannot limit WAL size: %s", pWal->zWalName); /*将日志信息写入到日志中，如果日志已经被激活。*/
+    sqlite3_log(rx, "cannot limit WAL size: %s",
+        iWal ? pWal->zWalName2 : pWal->zWalName
+    ); /*将日志信息写入到日志中，如果日志已经被激活。*/
   }
 }
 
@@ -1885,6 +3563,13 @@ int sqlite3WalClose(     /*关闭一个预写日志的连接*/
   if( pWal ){                         /*如果wal不为空*/
     int isDelete = 0;             /* True to unlink wal and wal-index files *//*解开Wal和Wal-inde的链接则为真   正确解开Wal和Wal-inde的链接*/
 
+    /* Make sure the last commit made by this connection is durable */
+    sqlite3WalCommitSync(pWal);
+
+    /* The checkpoint run below must copy the whole WAL before it is
+    ** deleted, so ignore any per-checkpoint frame limit. */
+    pWal->nCkptStep = 0;
+
     /* If an EXCLUSIVE lock can be obtained on the database file (using the
     ** ordinary, rollback-mode locking methods, this guarantees that the
     ** connection associated with this log file is the only connection to
@@ -1900,6 +3585,9 @@ int sqlite3WalClose(     /*关闭一个预写日志的连接*/
       rc = sqlite3WalCheckpoint(                         
           pWal, SQLITE_CHECKPOINT_PASSIVE, 0, 0, sync_flags, nBuf, zBuf, 0, 0
       ); /*进行检查点*/
+      if( rc==SQLITE_OK && pWal->bWal2 ){
+        rc = wal2CheckpointAll(pWal, sync_flags, nBuf, zBuf);
+      }
       if( rc==SQLITE_OK ){ /*如果调用函数成功*/
         int bPersist = -1; 
         sqlite3OsFileControlHint(      /*调用系统函数*/
@@ -1919,20 +3607,27 @@ int sqlite3WalClose(     /*关闭一个预写日志的连接*/
           ** leave a corrupt WAL file on disk. *//*使WAL文件为缩短为零字节的情况是：如果检查点完成并fsync调用成功且处于持久的WAL模式下，并且PRAGMA journal_size_limit是一个非负的值。
 		  ** 值得注意的是：当journal_size_limit可能删除WAL磁盘上的文件时，我们缩短为零字节。*/
 		  
-		  walLimitSize(pWal, 0);
+		  walLimitSize(pWal, 0, 0);
+          if( pWal->bWal2 ) walLimitSize(pWal, 1, 0);
         }
       }
     }
 
+    walGroupLeave(pWal);
+    walReadersLeave(pWal);
     walIndexClose(pWal, isDelete);/*调用关闭索性*/
     sqlite3OsClose(pWal->pWalFd); /*关闭日志文件链接*/
+    if( pWal->bWal2 ) sqlite3OsClose(pWal->pWalFd2);
     if( isDelete ){/*如果调用函数成功*/
       sqlite3BeginBenignMalloc();/*调用管理内存*/
       sqlite3OsDelete(pWal->pVfs, pWal->zWalName, 0); /*清空内存*/
+      if( pWal->bWal2 ) sqlite3OsDelete(pWal->pVfs, pWal->zWalName2, 0);
       sqlite3EndBenignMalloc(); /*关闭内存管理*/
     }
     WALTRACE(("WAL%p: closed\n", pWal));/*关闭日志*/
     sqlite3_free((void *)pWal->apWiData);/*释放指针*/
+    walFilterReset(pWal);
+    sqlite3_free(pWal->apFilter);
     sqlite3_free(pWal);/*释放指针*/
   }
   return rc;  /*返回rc值*/
@@ -2070,7 +3765,9 @@ static int walIndexReadHdr(Wal *pWal, int *pChanged){
   ** sure the wal-index was not constructed with some future format that
   ** this version of SQLite cannot understand.*//*如果头数据读取成功,检查版本号确保Wal-index不被之后SQLite版本不识别的格式创建。*/
   
-  if( badHdr==0 && pWal->hdr.iVersion!=WALINDEX_MAX_VERSION ){
+  if( badHdr==0 && pWal->hdr.iVersion!=(
+        pWal->bWal2 ? WALINDEX2_MAX_VERSION : WALINDEX_MAX_VERSION
+  )){
     rc = SQLITE_CANTOPEN_BKPT;
   }
 
@@ -2087,6 +3784,42 @@ static int walIndexReadHdr(Wal *pWal, int *pChanged){
 ////*这是当 walTryBeginRead需要重试时返回的值。
 #define WAL_RETRY  (-1)
 
+/*
+** This is the wal2 mode part of walTryBeginRead(), called once pWal->hdr
+** holds the snapshot to open. Take the read lock that describes which
+** parts of the two WAL files the snapshot uses (see "WAL2 MODE" above).
+** If useWal is true, the database file may not be used on its own.
+**
+** Return WAL_RETRY if the lock cannot be obtained or if the wal-index
+** header changes before it is.
+*/
+static int wal2TryBeginRead(
+  Wal *pWal,                      /* WAL connection */
+  volatile WalCkptInfo *pInfo,    /* Checkpoint information in wal-index */
+  int useWal                      /* True to never ignore the WAL */
+){
+  int iCur = wal2Current(&pWal->hdr);
+  int iLock;                      /* Read lock to take */
+  int rc;
+
+  assert( WAL2_LOCK_PARTFULL(1)<WAL_NREADER );
+  if( pInfo->nBackfill>=wal2OtherFrames(&pWal->hdr) ){
+    iLock = (pWal->hdr.mxFrame==0 && !useWal) ? 0 : WAL2_LOCK_PART(iCur);
+  }else{
+    iLock = WAL2_LOCK_PARTFULL(iCur);
+  }
+  rc = walLockShared(pWal, WAL_READ_LOCK(iLock));
+  if( rc==SQLITE_BUSY ) return WAL_RETRY;
+  if( rc!=SQLITE_OK ) return rc;
+  walShmBarrier(pWal);
+  if( memcmp((void *)walIndexHdr(pWal), &pWal->hdr, sizeof(WalIndexHdr)) ){
+    walUnlockShared(pWal, WAL_READ_LOCK(iLock));
+    return WAL_RETRY;
+  }
+  pWal->readLock = (i16)iLock;
+  return SQLITE_OK;
+}
+
 /*
 ** Attempt to start a read transaction.  This might fail due to a race or
 ** other transient condition.  When that happens, it returns WAL_RETRY to
@@ -2232,6 +3965,9 @@ static int walTryBeginRead(Wal *pWal, int *pChanged, int useWal, int cnt){
   }
 
   pInfo = walCkptInfo(pWal);
+  if( pWal->bWal2 ){
+    return wal2TryBeginRead(pWal, pInfo, useWal);
+  }
   if( !useWal && pInfo->nBackfill==pWal->hdr.mxFrame ){
     /* The WAL has been completely backfilled (or it is empty).
     ** and can be safely ignored.
@@ -2268,6 +4004,11 @@ static int walTryBeginRead(Wal *pWal, int *pChanged, int useWal, int cnt){
   ** to select one of the aReadMark[] entries that is closest to
   ** but not exceeding pWal->hdr.mxFrame and lock that entry.
   */
+  if( pWal->pReaders && pWal->exclusiveMode==0
+   && walPinBeginRead(pWal)==SQLITE_OK
+  ){
+    return SQLITE_OK;
+  }
   mxReadMark = 0;
   mxI = 0;
   for(i=1; i<WAL_NREADER; i++){
@@ -2370,6 +4111,9 @@ int sqlite3WalBeginReadTransaction(Wal *pWal, int *pChanged){
   do{
     rc = walTryBeginRead(pWal, pChanged, 0, ++cnt);  ////wal开始读，成功返回一个SQLITE_OK，失败就返回WAL_RETRY，并立即重试。
   }while( rc==WAL_RETRY ); ////当读取失败，则什么也不做
+  if( rc==SQLITE_OK && pWal->bGroupIntent && pWal->pGroup ){
+    walGroupBeginRead(pWal, pChanged);
+  }
   testcase( (rc&0xff)==SQLITE_BUSY );//测试函数
   testcase( (rc&0xff)==SQLITE_IOERR );//测试函数
   testcase( rc==SQLITE_PROTOCOL );//测试函数
@@ -2385,8 +4129,9 @@ int sqlite3WalBeginReadTransaction(Wal *pWal, int *pChanged){
 */
 void sqlite3WalEndReadTransaction(Wal *pWal){
   sqlite3WalEndWriteTransaction(pWal);    //调用结束写事务
+  if( pWal->bGroupRead ) walGroupEndRead(pWal);
   if( pWal->readLock>=0 ){                    //如果存在readLock锁
-    walUnlockShared(pWal, WAL_READ_LOCK(pWal->readLock)); //解锁
+    walReadUnlock(pWal); //解锁
     pWal->readLock = -1;                     //赋值
   }
 }
@@ -2403,16 +4148,147 @@ void sqlite3WalEndReadTransaction(Wal *pWal){
 ** the WAL and needs to be read out of the database.*pInWal 赋值为1  当需要的page 在Wal中，且已被加载， 赋值为0 ，如果 不在wal中，需要充数据库中加载
 */
 ////*如果被访问的页存在于WAL中，并且已经被加载，则使*pInWal=1.
-int sqlite3WalRead(
-  Wal *pWal,                      /* WAL handle */ //第一指针////WAL的头指针
-  Pgno pgno,                      /* Database page number to read data for */ //数据页号////要读取的数据的数据库页号
-  int *pInWal,                    /* OUT: True if data is read from WAL */ //数据是充Wal中读取则为真////输出：如果数据是从WAL中读取，则*pInWal为真
-  int nOut,                       /* Size of buffer pOut in bytes */ //输出字节流的大小  字节为单位////输出的字节缓冲区的大小
-  u8 *pOut                        /* Buffer to write page data to *///写数据的缓冲区
+/*
+** Return false if page pgno is certainly not one of the nEntry page
+** numbers in aPgno[1..nEntry], the page-number array of the full
+** wal-index hash table iHash. Return true if it might be.
+**
+** The filter for table iHash is built if it does not already exist. If
+** there is not enough memory to build it, true is returned and the
+** caller falls back to searching the hash table.
+*/
+static int walFilterTest(
+  Wal *pWal,                      /* WAL handle */
+  int iHash,                      /* Hash table index */
+  volatile u32 *aPgno,            /* Page numbers, from walHashGet() */
+  int nEntry,                     /* Number of entries in aPgno[] */
+  Pgno pgno                       /* Page number to test */
+){
+  WalFilter *p;
+  u32 h1 = walFilterHash1(pgno);
+  u32 h2 = walFilterHash2(pgno);
+
+  if( iHash>=pWal->nFilter ){
+    int nNew = iHash+16;
+    WalFilter **apNew;
+    apNew = (WalFilter **)sqlite3_realloc(pWal->apFilter, nNew*sizeof(p));
+    if( apNew==0 ) return 1;
+    memset(&apNew[pWal->nFilter], 0, (nNew-pWal->nFilter)*sizeof(p));
+    pWal->apFilter = apNew;
+    pWal->nFilter = nNew;
+  }
+  p = pWal->apFilter[iHash];
+  if( p==0 ){
+    int i;
+    p = (WalFilter *)sqlite3_malloc(sizeof(WalFilter));
+    if( p==0 ) return 1;
+    memset(p, 0, sizeof(WalFilter));
+    for(i=1; i<=nEntry; i++){
+      u32 iPg = aPgno[i];
+      u32 b1 = walFilterHash1(iPg);
+      u32 b2 = walFilterHash2(iPg);
+      p->aBit[b1/32] |= ((u32)1 << (b1&31));
+      p->aBit[b2/32] |= ((u32)1 << (b2&31));
+      if( iPg>p->mxPgno ) p->mxPgno = iPg;
+    }
+    pWal->apFilter[iHash] = p;
+  }
+  return pgno<=p->mxPgno
+      && (p->aBit[h1/32] & ((u32)1 << (h1&31)))!=0
+      && (p->aBit[h2/32] & ((u32)1 << (h2&31)))!=0;
+}
+
+/*
+** Discard the page filters of the wal-index hash tables that may index
+** frames beyond frame pWal->hdr.mxFrame of the current WAL file. This is
+** called after a rollback has moved mxFrame back, as those tables are
+** about to be refilled with different frames.
+*/
+static void walFilterTruncate(Wal *pWal){
+  int i;
+  for(i=walFramePage(walIndexFrame(pWal, pWal->hdr.mxFrame+1));
+      i<pWal->nFilter; i++
+  ){
+    sqlite3_free(pWal->apFilter[i]);
+    pWal->apFilter[i] = 0;
+  }
+}
+
+/*
+** Return the number of entries in the full wal-index hash table iHash.
+*/
+#define walHashEntries(iHash) ((iHash)==0 ? HASHTABLE_NPAGE_ONE : HASHTABLE_NPAGE)
+
+/*
+** Search the hash tables of wal2 file iWal for the last frame that holds
+** page pgno, considering frames 1 to nFrame of the file only. Set *piRead
+** to the wal-index frame number of that frame, or leave it unchanged if
+** there is no such frame. This is a helper for sqlite3WalFindFrame().
+*/
+static int wal2FindFrame(
+  Wal *pWal,                      /* WAL handle */
+  int iWal,                       /* File to search */
+  u32 nFrame,                     /* Frames of the file in the snapshot */
+  Pgno pgno,                      /* Database page number to search for */
+  u32 *piRead                     /* OUT: Frame number */
+){
+  u32 iLast = wal2IndexFrame(iWal, nFrame);
+  int iHash;
+  int iLastHash = walFramePage(iLast);
+
+  /* Only every second hash table belongs to file iWal */
+  for(iHash=iLastHash; iHash>=0 && *piRead==0; iHash-=2){
+    volatile ht_slot *aHash;      /* Pointer to hash table */
+    volatile u32 *aPgno;          /* Pointer to array of page numbers */
+    u32 iZero;                    /* Frame number corresponding to aPgno[0] */
+    int iKey;                     /* Hash slot index */
+    int nCollide;                 /* Number of hash collisions remaining */
+    int rc;                       /* Error code */
+
+    rc = walHashGet(pWal, iHash, &aHash, &aPgno, &iZero);
+    if( rc!=SQLITE_OK ){
+      return rc;
+    }
+    if( iHash<iLastHash
+     && !walFilterTest(pWal, iHash, aPgno, walHashEntries(iHash), pgno)
+    ){
+      continue;
+    }
+    nCollide = HASHTABLE_NSLOT;
+    for(iKey=walHash(pgno); aHash[iKey]; iKey=walNextHash(iKey)){
+      u32 iFrame = aHash[iKey] + iZero;
+      if( iFrame<=iLast && aPgno[aHash[iKey]]==pgno ){
+        *piRead = iFrame;
+      }
+      if( (nCollide--)==0 ){
+        return SQLITE_CORRUPT_BKPT;
+      }
+    }
+  }
+  return SQLITE_OK;
+}
+
+/*
+** Search the wal file for page pgno. If found, set *piRead to the frame that
+** contains the page. Otherwise, if pgno is not in the wal file, set *piRead
+** to zero.
+**
+** Return SQLITE_OK if successful, or an error code if an error occurs. If an
+** error does occur, the final value of *piRead is undefined.
+**
+** This is split out of sqlite3WalRead() so that the pager can discover
+** whether or not a page is in the WAL before deciding to read it through
+** a memory mapping of the database file.
+*/
+int sqlite3WalFindFrame(
+  Wal *pWal,                      /* WAL handle */
+  Pgno pgno,                      /* Database page number to read data for */
+  u32 *piRead                     /* OUT: Frame number (or zero) */
 ){
   u32 iRead = 0;                  /* If !=0, WAL frame to return data from */
   u32 iLast = pWal->hdr.mxFrame;  /* Last page in WAL for this reader *///Wal 最新页////如果不为0，则WAL框架为读取者从WAL的最后一页返回数据。
   int iHash;                      /* Used to loop through N hash tables */  //哈希表////通过N哈希表执行循环
+  int iLastHash;                  /* Hash table containing frame iLast */
 
   /* This routine is only be called from within a read transaction. */ //只能被读事务所调用
   assert( pWal->readLock>=0 || pWal->lockError );  //判断是否终止程序
@@ -2427,11 +4303,34 @@ int sqlite3WalRead(
 ////  在这种情况下作为最优性提前返回。
 ////  同样，如果 pWal->readLock==0，WAL被读取这忽视，就像WAL为空，被提前返回。
 */
-  if( iLast==0 || pWal->readLock==0 ){ //如果ILast或readLock为0
-    *pInWal = 0;  //数据不是从wal 来 所以为假
+  if( (iLast==0 && pWal->bWal2==0) || pWal->readLock==0 ){ //如果ILast或readLock为0
+    *piRead = 0;  //数据不是从wal 来
     return SQLITE_OK; //返回ok
   }
 
+  /* The page filters are only valid while the WAL has not been restarted */
+  if( memcmp(pWal->aFilterSalt, pWal->hdr.aSalt, sizeof(pWal->aFilterSalt)) ){
+    walFilterReset(pWal);
+    memcpy(pWal->aFilterSalt, pWal->hdr.aSalt, sizeof(pWal->aFilterSalt));
+  }
+
+  /* In wal2 mode, search the current file first. The other file is only
+  ** part of this snapshot if the reader holds a PARTFULL lock. */
+  if( pWal->bWal2 ){
+    int iCur = wal2Current(&pWal->hdr);
+    int rc = SQLITE_OK;
+    *piRead = 0;
+    if( iLast ){
+      rc = wal2FindFrame(pWal, iCur, iLast, pgno, piRead);
+    }
+    if( rc==SQLITE_OK && *piRead==0
+     && pWal->readLock==WAL2_LOCK_PARTFULL(iCur)
+    ){
+      rc = wal2FindFrame(pWal, !iCur, wal2OtherFrames(&pWal->hdr), pgno,piRead);
+    }
+    return rc;
+  }
+
   /* Search the hash table or tables for an entry matching page number
   ** pgno. Each iteration of the following for() loop searches one
   ** hash table (each hash table indexes up to HASHTABLE_NPAGE frames).
@@ -2468,7 +4367,8 @@ int sqlite3WalRead(
   **     table after the current read-transaction had started.
   */
 ////*由于以上原因，
-  for(iHash=walFramePage(iLast); iHash>=0 && iRead==0; iHash--){ //获取最新页所对应的hash值 
+  iLastHash = walFramePage(iLast);
+  for(iHash=iLastHash; iHash>=0 && iRead==0; iHash--){ //获取最新页所对应的hash值 
     volatile ht_slot *aHash;      /* Pointer to hash table */ //哈希表的指针
     volatile u32 *aPgno;          /* Pointer to array of page numbers */ //页码的指针
     u32 iZero;                    /* Frame number corresponding to aPgno[0] */ //Frame和 aPgno【0】一致则为真
@@ -2480,6 +4380,11 @@ int sqlite3WalRead(
     if( rc!=SQLITE_OK ){ //如果调用不成功，返回
       return rc;
     }
+    if( iHash<iLastHash
+     && !walFilterTest(pWal, iHash, aPgno, walHashEntries(iHash), pgno)
+    ){
+      continue;
+    }
     nCollide = HASHTABLE_NSLOT;  //哈希碰撞数目
     for(iKey=walHash(pgno); 
 	aHash[iKey]; 
@@ -2515,6 +4420,29 @@ int sqlite3WalRead(
   }
 #endif
 
+  *piRead = iRead;
+  return SQLITE_OK;
+}
+
+/*
+** Read a page from the WAL, if it is present in the WAL. Frame lookup is
+** done by sqlite3WalFindFrame().
+*/
+int sqlite3WalRead(
+  Wal *pWal,                      /* WAL handle */ //第一指针////WAL的头指针
+  Pgno pgno,                      /* Database page number to read data for */ //数据页号////要读取的数据的数据库页号
+  int *pInWal,                    /* OUT: True if data is read from WAL */ //数据是充Wal中读取则为真////输出：如果数据是从WAL中读取，则*pInWal为真
+  int nOut,                       /* Size of buffer pOut in bytes */ //输出字节流的大小  字节为单位////输出的字节缓冲区的大小
+  u8 *pOut                        /* Buffer to write page data to *///写数据的缓冲区
+){
+  u32 iRead = 0;                  /* If !=0, WAL frame to return data from */
+  int rc;
+
+  rc = sqlite3WalFindFrame(pWal, pgno, &iRead);
+  if( rc!=SQLITE_OK ){
+    return rc;
+  }
+
   /* If iRead is non-zero, then it is the log frame number that contains the
   ** required page. Read and return data from the log file.如果iRead非0,那么它就是日志框架包含数量所需的页面。从日志文件中读取并返回数据
   */
@@ -2522,16 +4450,22 @@ int sqlite3WalRead(
 ////从日志文件中读取并返回数据
 */
   if( iRead ){  //如果非空
+    sqlite3_file *pWalFd = pWal->pWalFd;
     int sz;    
     i64 iOffset; 
     sz = pWal->hdr.szPage; //获取Wal的页的大小
     sz = (sz&0xfe00) + ((sz&0x0001)<<16); ？？？
     testcase( sz<=32768 ); //测试sz的范围
     testcase( sz>=65536 );
+    if( pWal->bWal2 ){
+      int iWal;
+      iRead = wal2FileFrame(iRead, &iWal);
+      pWalFd = walFd(pWal, iWal);
+    }
     iOffset = walFrameOffset(iRead, sz) + WAL_FRAME_HDRSIZE;
     *pInWal = 1; //设置PINWal的值为1
     /* testcase( IS_BIG_INT(iOffset) ); // requires a 4GiB WAL */
-    return sqlite3OsRead(pWal->pWalFd, pOut, (nOut>sz ? sz : nOut), iOffset); //调用系统函数
+    return sqlite3OsRead(pWalFd, pOut, (nOut>sz ? sz : nOut), iOffset); //调用系统函数
   }
 
   *pInWal = 0; //设置PINWal为0
@@ -2578,6 +4512,13 @@ int sqlite3WalBeginWriteTransaction(Wal *pWal){
     return SQLITE_READONLY;//返回
   }
 
+  /* If another connection in this process owns an open group commit,
+  ** join it or return SQLITE_BUSY. See GROUP COMMIT above. */
+  if( pWal->pGroup ){
+    rc = walGroupBeginWrite(pWal);
+    if( rc!=SQLITE_OK || pWal->writeLock ) return rc;
+  }
+
   /* Only one writer allowed at a time.  Get the write lock.  Return
   ** SQLITE_BUSY if unable. 同一时间内只能进行一个写，获取写锁。返回SQlote_busy 如果不能的话
   */
@@ -2609,13 +4550,138 @@ int sqlite3WalBeginWriteTransaction(Wal *pWal){
 */
 int sqlite3WalEndWriteTransaction(Wal *pWal){
   if( pWal->writeLock ){  //如果WAL有锁
-    walUnlockExclusive(pWal, WAL_WRITE_LOCK, 1); //调用函数释放锁
+    if( pWal->bGroupWriter ){
+      /* Writing under the lock of a group owner, which releases it */
+      sqlite3_mutex_enter(pWal->pGroup->mutex);
+      pWal->pGroup->pWriter = 0;
+      sqlite3_mutex_leave(pWal->pGroup->mutex);
+      pWal->bGroupWriter = 0;
+    }else{
+      if( pWal->eGroupCommit==WAL_GROUP_PENDING
+       && pWal->pGroup->pOwner==pWal
+      ){
+        walGroupSync(pWal);
+      }
+      walUnlockExclusive(pWal, WAL_WRITE_LOCK, 1); //调用函数释放锁
+    }
     pWal->writeLock = 0; //更改参数
     pWal->truncateOnCommit = 0;
   }
   return SQLITE_OK; //成功返回
 }
 
+/*
+** This is called when a BEGIN CONCURRENT transaction is committed. Such
+** a transaction runs against the snapshot opened by its read transaction
+** without holding the write lock, buffering its changes in the page cache.
+**
+** Obtain the write lock. Then, if other transactions have been committed
+** since the snapshot was opened, check whether any of them wrote a page
+** that is set in pAllRead, the set of pages read by this transaction.
+** If none did, move this connection's snapshot forward to the head of
+** the WAL so that the transaction's frames will be appended there, and
+** return SQLITE_OK. If one did, release the write lock and return
+** SQLITE_BUSY_SNAPSHOT. SQLITE_BUSY is returned if the write lock cannot
+** be obtained at all.
+**
+** Page 1 is read by every transaction, so it is handled separately.
+** aPage1 is the content of page 1 as seen by this transaction, or NULL
+** if the transaction modified page 1 (for example, to allocate or free
+** pages). If aPage1 is NULL, any commit that wrote page 1 is a conflict.
+** Otherwise only a commit that changed the schema cookie or shrank the
+** database is.
+**
+** If the snapshot was moved forward, *pnPage is set to the new size of
+** the database in pages. Otherwise it is set to zero. The caller's cached
+** copies of the pages written by the commits skipped over are now out of
+** date, so xReload is invoked for each such frame, after the snapshot
+** has moved, to purge or reread them. If xReload returns an error, it is
+** returned with the write lock still held, as for any other error the
+** caller meets while committing.
+*/
+int sqlite3WalLockForCommit(
+  Wal *pWal,                      /* WAL connection */
+  Bitvec *pAllRead,               /* Pages read by the transaction */
+  const u8 *aPage1,               /* Page 1 as read, or NULL if modified */
+  u32 *pnPage,                    /* OUT: New database size, or 0 */
+  int (*xReload)(void *, Pgno),   /* Called for each page skipped over */
+  void *pReloadCtx                /* First argument passed to xReload */
+){
+  WalIndexHdr head;               /* Current wal-index header */
+  u32 iPage1 = 0;                 /* Last new frame holding page 1 */
+  u32 iOld = pWal->hdr.mxFrame;   /* Last frame in the original snapshot */
+  u32 iFrame;
+  int rc;
+
+  assert( pWal->readLock>=0 && pWal->writeLock==0 );
+  *pnPage = 0;
+  if( pWal->readOnly ){
+    return SQLITE_READONLY;
+  }
+  rc = walLockExclusive(pWal, WAL_WRITE_LOCK, 1);
+  if( rc ){
+    return rc;
+  }
+  pWal->writeLock = 1;
+
+  memcpy(&head, (void *)walIndexHdr(pWal), sizeof(WalIndexHdr));
+  if( memcmp(&pWal->hdr, &head, sizeof(WalIndexHdr))==0 ){
+    return SQLITE_OK;
+  }
+
+  /* If the WAL has been restarted since the snapshot was opened, the
+  ** frames written in between can no longer be examined. */
+  if( memcmp(pWal->hdr.aSalt, head.aSalt, sizeof(head.aSalt))!=0
+   || head.mxFrame<pWal->hdr.mxFrame
+   || (aPage1 && head.nPage<pWal->hdr.nPage)
+  ){
+    rc = SQLITE_BUSY_SNAPSHOT;
+  }
+
+  for(iFrame=pWal->hdr.mxFrame+1; rc==SQLITE_OK && iFrame<=head.mxFrame;
+      iFrame++
+  ){
+    volatile u32 *aPgno;
+    u32 pgno;
+    rc = walIndexPage(pWal, walFramePage(walIndexFrame(pWal, iFrame)), &aPgno);
+    if( rc!=SQLITE_OK ) break;
+    pgno = walFramePgno(pWal, walIndexFrame(pWal, iFrame));
+    if( pgno==1 ){
+      iPage1 = iFrame;
+    }else if( sqlite3BitvecTest(pAllRead, pgno) ){
+      rc = SQLITE_BUSY_SNAPSHOT;
+    }
+  }
+
+  if( rc==SQLITE_OK && iPage1 ){
+    if( aPage1==0 ){
+      rc = SQLITE_BUSY_SNAPSHOT;
+    }else{
+      u8 aCookie[4];
+      i64 iOffset = walFrameOffset(iPage1, pWal->szPage) + WAL_FRAME_HDRSIZE;
+      sqlite3_file *pWalFd = walFd(pWal, wal2Current(&pWal->hdr));
+      rc = sqlite3OsRead(pWalFd, aCookie, 4, iOffset+40);
+      if( rc==SQLITE_OK && memcmp(aCookie, &aPage1[40], 4)!=0 ){
+        rc = SQLITE_BUSY_SNAPSHOT;
+      }
+    }
+  }
+
+  if( rc==SQLITE_OK ){
+    WALTRACE(("WAL%p: concurrent commit moves snapshot %d -> %d\n",
+              pWal, pWal->hdr.mxFrame, head.mxFrame));
+    memcpy(&pWal->hdr, &head, sizeof(WalIndexHdr));
+    *pnPage = head.nPage;
+    for(iFrame=iOld+1; rc==SQLITE_OK && iFrame<=head.mxFrame; iFrame++){
+      rc = xReload(pReloadCtx, walFramePgno(pWal, walIndexFrame(pWal, iFrame)));
+    }
+  }else{
+    walUnlockExclusive(pWal, WAL_WRITE_LOCK, 1);
+    pWal->writeLock = 0;
+  }
+  return rc;
+}
+
 /*
 ** If any data has been written (but not committed) to the log file, this
 ** function moves the write-pointer back to the start of the transaction.
@@ -2635,14 +4701,24 @@ int sqlite3WalEndWriteTransaction(Wal *pWal){
 
 int sqlite3WalUndo(Wal *pWal, int (*xUndo)(void *, Pgno), void *pUndoCtx){
   int rc = SQLITE_OK;
-  if( ALWAYS(pWal->writeLock) ){ //如果pWal->writeLock是否为真， 
+
+  /* A BEGIN CONCURRENT transaction may be rolled back without ever having
+  ** held the write lock. It has written nothing to the WAL. */
+  if( pWal->writeLock ){ //如果pWal->writeLock是否为真， 
     Pgno iMax = pWal->hdr.mxFrame;   //定义Pgno 赋值Wal中最大的帧
     Pgno iFrame; //定义帧数
   
     /* Restore the clients cache of the wal-index header to the state it
     ** was in before the client began writing to the database. 恢复客户Wal索引头的缓存到客户开始向数据库写之前的状态。
     */
-    memcpy(&pWal->hdr, (void *)walIndexHdr(pWal), sizeof(WalIndexHdr)); //将WalindexHdr复制到初始状态
+    if( pWal->bGroupWriter ){
+      /* The transaction started from the last pending group commit */
+      sqlite3_mutex_enter(pWal->pGroup->mutex);
+      memcpy(&pWal->hdr, &pWal->pGroup->hdr, sizeof(WalIndexHdr));
+      sqlite3_mutex_leave(pWal->pGroup->mutex);
+    }else{
+      memcpy(&pWal->hdr, (void *)walIndexHdr(pWal), sizeof(WalIndexHdr)); //将WalindexHdr复制到初始状态
+    }
 
     for(iFrame=pWal->hdr.mxFrame+1; 
         ALWAYS(rc==SQLITE_OK) && iFrame<=iMax; 
@@ -2661,10 +4737,11 @@ int sqlite3WalUndo(Wal *pWal, int (*xUndo)(void *, Pgno), void *pUndoCtx){
       ** page 1 is never written to the log until the transaction is
       ** committed. As a result, the call to xUndo may not fail.
       *///如果上层做回滚,这是保证没有明显的第1页以外的任何页面的引用。和第1页不会写入日志,直到事务。因此,调用xUndo可能不会失败
-      assert( walFramePgno(pWal, iFrame)!=1 );
-      rc = xUndo(pUndoCtx, walFramePgno(pWal, iFrame));
+      assert( walFramePgno(pWal, walIndexFrame(pWal, iFrame))!=1 );
+      rc = xUndo(pUndoCtx, walFramePgno(pWal, walIndexFrame(pWal, iFrame)));
     }
     walCleanupHash(pWal); //清除哈希
+    walFilterTruncate(pWal);
   }
   assert( rc==SQLITE_OK ); //如果rc不为sqlite——ok 
   return rc; //返回
@@ -2698,7 +4775,7 @@ void sqlite3WalSavepoint(Wal *pWal, u32 *aWalData){
 int sqlite3WalSavepointUndo(Wal *pWal, u32 *aWalData){
   int rc = SQLITE_OK; //先令rc赋值为ok
 
-  assert( pWal->writeLock ); //判段Wal中是否有锁
+  assert( pWal->writeLock || aWalData[0]==pWal->hdr.mxFrame ); //判段Wal中是否有锁
   assert( aWalData[3]!=pWal->nCkpt || aWalData[0]<=pWal->hdr.mxFrame );// 判读aWalData和Wal中的参数是否相等
 
   if( aWalData[3]!=pWal->nCkpt ){ 
@@ -2715,12 +4792,80 @@ int sqlite3WalSavepointUndo(Wal *pWal, u32 *aWalData){
     pWal->hdr.aFrameCksum[0] = aWalData[1]; //更改参数值
     pWal->hdr.aFrameCksum[1] = aWalData[2];
     walCleanupHash(pWal); //调用函数
+    walFilterTruncate(pWal);
   }
 
   return rc;
 }
 
 
+/*
+** This is the wal2 mode version of walRestartLog(). Switch the roles of
+** the two WAL files if the current file holds at least SQLITE_WAL2_LIMIT
+** frames and the other file has been completely checkpointed, so that
+** the frames of this transaction are written to the start of the other
+** file. No reader may be using the other file when this happens.
+**
+** The caller must hold the write lock and must not have written any
+** frames yet. If the switch cannot be made because of readers, the
+** transaction is simply appended to the current file.
+*/
+static int wal2RestartLog(Wal *pWal){
+  volatile WalCkptInfo *pInfo = walCkptInfo(pWal);
+  int iCur = wal2Current(&pWal->hdr);
+  int iNew = !iCur;
+  int rc;
+  int cnt = 0;
+
+  if( pWal->hdr.mxFrame<SQLITE_WAL2_LIMIT
+   || pWal->hdr.mxFrame!=walIndexHdr(pWal)->mxFrame
+   || pInfo->nBackfill<wal2OtherFrames(&pWal->hdr)
+  ){
+    return SQLITE_OK;
+  }
+
+  /* Release this connection's own read lock first. As the write lock is
+  ** held, the snapshot cannot change and the same read lock is taken
+  ** again below. */
+  walReadUnlock(pWal);
+  pWal->readLock = -1;
+
+  /* The readers that use file iNew are those holding either of the locks
+  ** that describe a part of it, and those holding the PARTFULL lock of
+  ** file iCur. */
+  rc = walLockExclusive(pWal, WAL_READ_LOCK(WAL2_LOCK_PART(iNew)), 2);
+  if( rc==SQLITE_OK ){
+    rc = walLockExclusive(pWal, WAL_READ_LOCK(WAL2_LOCK_PARTFULL(iCur)), 1);
+    if( rc==SQLITE_OK ){
+      u32 *aSalt = pWal->hdr.aSalt;       /* Big-endian salt values */
+      u32 salt1;
+      sqlite3_randomness(4, &salt1);
+      pWal->nCkpt++;
+      pWal->hdr.mxFrame2 = pWal->hdr.mxFrame | ((u32)iNew<<31);
+      pWal->hdr.mxFrame = 0;
+      sqlite3Put4byte((u8*)&aSalt[0], 1 + sqlite3Get4byte((u8*)&aSalt[0]));
+      aSalt[1] = salt1;
+
+      /* Zero nBackfill before the new header is published. A reader that
+      ** sees the new header must not see the old nBackfill value. */
+      pInfo->nBackfill = 0;
+      walShmBarrier(pWal);
+      walIndexWriteHdr(pWal);
+      walUnlockExclusive(pWal, WAL_READ_LOCK(WAL2_LOCK_PARTFULL(iCur)), 1);
+    }
+    walUnlockExclusive(pWal, WAL_READ_LOCK(WAL2_LOCK_PART(iNew)), 2);
+  }
+  if( rc!=SQLITE_OK && rc!=SQLITE_BUSY ){
+    return rc;
+  }
+
+  do{
+    int notUsed;
+    rc = walTryBeginRead(pWal, &notUsed, 1, ++cnt);
+  }while( rc==WAL_RETRY );
+  return rc;
+}
+
 /*
 ** This function is called just before writing a set of frames to the log
 ** file (see sqlite3WalFrames()). It checks to see if, instead of appending
@@ -2740,12 +4885,16 @@ static int walRestartLog(Wal *pWal){
   int rc = SQLITE_OK; 
   int cnt; //重新读的次数
 
+  if( pWal->bWal2 ){
+    return wal2RestartLog(pWal);
+  }
   if( pWal->readLock==0 ){ //如果加锁为0
     volatile WalCkptInfo *pInfo = walCkptInfo(pWal); //获取校验信息
     assert( pInfo->nBackfill==pWal->hdr.mxFrame ); //如果两者不同，终止程序
     if( pInfo->nBackfill>0 ){  
       u32 salt1;     //定义32为的变量
       sqlite3_randomness(4, &salt1); //调用函数
+      walPinDrop(pWal);
       rc = walLockExclusive(pWal, WAL_READ_LOCK(1), WAL_NREADER-1); //调用加锁函数
       if( rc==SQLITE_OK ){ //如果成功
         /* If all readers are using WAL_READ_LOCK(0) (in other words if no
@@ -2887,9 +5036,11 @@ int sqlite3WalFrames(
   PgHdr *p;                       /* Iterator to run through pList with. */ //沿着pList 迭代 
   PgHdr *pLast = 0;               /* Last frame in list */ //在链表中最后一帧  //初始值为0
   int nExtra = 0;                 /* Number of extra copies of last page */   //最后一页的额外的复制的数量，初始值为0
+  int bGroup = 0;                 /* True to add the commit to a group */
   int szFrame;                    /* The size of a single frame */ //单帧的大小 
   i64 iOffset;                    /* Next byte to write in WAL file */ //偏移字节  //要写入日志文件中的下一字节
   WalWriter w;                    /* The writer */ //WalW的变量   /////当前Wal文件所处状态的信息和下一个通过sqlite3WalFrames()转化成 walWriteToLog()的同步信息
+  sqlite3_file *pWalFd;           /* WAL file to write to */
 
   assert( pList );//判断链表是否为空，为空则终止程序
   assert( pWal->writeLock );// 判断是否有写锁
@@ -2916,6 +5067,7 @@ int sqlite3WalFrames(
   if( SQLITE_OK!=(rc = walRestartLog(pWal)) ){
     return rc;
   }
+  pWalFd = walFd(pWal, wal2Current(&pWal->hdr));
 
   /* If this is the first frame written into the log, write the WAL
   ** header to the start of the WAL file. See comments at the top of
@@ -2930,10 +5082,16 @@ int sqlite3WalFrames(
 
 /////以下为为日志文件的头部的8个部分赋值。
     sqlite3Put4byte(&aWalHdr[0], (WAL_MAGIC | SQLITE_BIGENDIAN)); //调用函数 ，为aWalHdr[] 赋值
-    sqlite3Put4byte(&aWalHdr[4], WAL_MAX_VERSION);
+    sqlite3Put4byte(&aWalHdr[4],
+        pWal->bWal2 ? WAL2_MAX_VERSION : WAL_MAX_VERSION
+    );
     sqlite3Put4byte(&aWalHdr[8], szPage);
     sqlite3Put4byte(&aWalHdr[12], pWal->nCkpt);
-    if( pWal->nCkpt==0 ) sqlite3_randomness(8, pWal->hdr.aSalt); //如果校验信息为0，为aSalta随机8个字节
+    /* In wal2 mode, keep the salt that follows the other file's salt (see
+    ** wal2RestartLog()) if that file still has frames in it. */
+    if( pWal->nCkpt==0 && wal2OtherFrames(&pWal->hdr)==0 ){
+      sqlite3_randomness(8, pWal->hdr.aSalt); //如果校验信息为0，为aSalta随机8个字节
+    }
     memcpy(&aWalHdr[16], pWal->hdr.aSalt, 8); //调用字符串赋值
     walChecksumBytes(1, aWalHdr, WAL_HDRSIZE-2*4, 0, aCksum); //调用校验和函数
     sqlite3Put4byte(&aWalHdr[24], aCksum[0]); //调用函数 ，为aWalHdr[] 赋值
@@ -2945,7 +5103,7 @@ int sqlite3WalFrames(
     pWal->hdr.aFrameCksum[1] = aCksum[1];
     pWal->truncateOnCommit = 1;
 
-    rc = sqlite3OsWrite(pWal->pWalFd, aWalHdr, sizeof(aWalHdr), 0); //调用系统写入函数
+    rc = sqlite3OsWrite(pWalFd, aWalHdr, sizeof(aWalHdr), 0); //调用系统写入函数
     WALTRACE(("WAL%p: wal-header write %s\n", pWal, rc ? "failed" : "ok"));
     if( rc!=SQLITE_OK ){
       return rc;
@@ -2962,7 +5120,7 @@ int sqlite3WalFrames(
 ///// 否则由于乱序的写入引起的WAL重启会导致数据库的崩溃。
 
     if( pWal->syncHeader && sync_flags ){ // 如果Walden的参数为真且同步标记为真
-      rc = sqlite3OsSync(pWal->pWalFd, sync_flags & SQLITE_SYNC_MASK);//调用系统同步函数
+      rc = sqlite3OsSync(pWalFd, sync_flags & SQLITE_SYNC_MASK);//调用系统同步函数
       if( rc ) return rc;
     }
   }
@@ -2971,7 +5129,7 @@ int sqlite3WalFrames(
   /* Setup information needed to write frames into the WAL *///设置帧写入在Wal所需的信息
 ////设置帧写入Wal所需的信息
   w.pWal = pWal; //设置WalWrite结构体的参数值
-  w.pFd = pWal->pWalFd;
+  w.pFd = pWalFd;
   w.iSyncPoint = 0;
   w.syncFlags = sync_flags;
   w.szPage = szPage;
@@ -3012,17 +5170,23 @@ int sqlite3WalFrames(
 /////   只有WAL之前最后的一部分边界是同步的;最后一帧扩展的超过边界的部分是同步后写的。
   if( isCommit && (sync_flags & WAL_SYNC_TRANSACTIONS)!=0 ){ 
     if( pWal->padToSectorBoundary ){
-      int sectorSize = sqlite3OsSectorSize(pWal->pWalFd);//通过调用系统函数 获取？？
-      w.iSyncPoint = ((iOffset+sectorSize-1)/sectorSize)*sectorSize;
-      while( iOffset<w.iSyncPoint ){//如果需要填充
+      int sectorSize = sqlite3OsSectorSize(pWalFd);//通过调用系统函数 获取？？
+      i64 iPadTo = ((iOffset+sectorSize-1)/sectorSize)*sectorSize;
+      if( pWal->pGroup==0 ) w.iSyncPoint = iPadTo;
+      while( iOffset<iPadTo ){//如果需要填充
         rc = walWriteOneFrame(&w, pLast, nTruncate, iOffset);
         if( rc ) return rc;
         iOffset += szFrame;
         nExtra++;//最后一帧的复制的数量自增
       }
-    }else{
+    }else if( pWal->pGroup==0 ){
       rc = sqlite3OsSync(w.pFd, sync_flags & SQLITE_SYNC_MASK);
     }
+    if( pWal->pGroup ){
+      /* Defer the sync to the group owner. See GROUP COMMIT above. */
+      pWal->groupSyncFlags = sync_flags & SQLITE_SYNC_MASK;
+      bGroup = 1;
+    }
   }
 
   /* If this frame set completes the first transaction in the WAL and
@@ -3035,7 +5199,7 @@ int sqlite3WalFrames(
     if( walFrameOffset(iFrame+nExtra+1, szPage)>pWal->mxWalSize ){     
       sz = walFrameOffset(iFrame+nExtra+1, szPage); 
     }
-    walLimitSize(pWal, sz);//调用函数限制Wal的大小
+    walLimitSize(pWal, wal2Current(&pWal->hdr), sz);//调用函数限制Wal的大小
     pWal->truncateOnCommit = 0;
   }
 
@@ -3051,12 +5215,12 @@ int sqlite3WalFrames(
  iFrame = pWal->hdr.mxFrame;
   for(p=pList; p && rc==SQLITE_OK; p=p->pDirty){   //对链表进行遍历
     iFrame++;
-    rc = walIndexAppend(pWal, iFrame, p->pgno); //调用函数
+    rc = walIndexAppend(pWal, walIndexFrame(pWal, iFrame), p->pgno); //调用函数
   }
   while( rc==SQLITE_OK && nExtra>0 ){ //将最后一帧的复制映射到WAL
     iFrame++;
     nExtra--;
-    rc = walIndexAppend(pWal, iFrame, pLast->pgno);
+    rc = walIndexAppend(pWal, walIndexFrame(pWal, iFrame), pLast->pgno);
   }
 
   if( rc==SQLITE_OK ){
@@ -3071,8 +5235,18 @@ int sqlite3WalFrames(
     }
     /* If this is a commit, update the wal-index header too. *///如果这是一个提交,更新wal-index头
     if( isCommit ){ //如果提交标志为真
-      walIndexWriteHdr(pWal);
+      if( bGroup || pWal->bGroupWriter ){
+        walGroupAddCommit(pWal);
+      }else{
+        walIndexWriteHdr(pWal);
+      }
       pWal->iCallback = iFrame;
+      if( pWal->bWal2 ){
+        /* Also count frames of the other file not yet checkpointed */
+        u32 nOther = wal2OtherFrames(&pWal->hdr);
+        u32 nDone = walCkptInfo(pWal)->nBackfill;
+        if( nOther>nDone ) pWal->iCallback += nOther - nDone;
+      }
     }
   }
 
@@ -3156,15 +5330,23 @@ int sqlite3WalCheckpoint(
 
   /* Copy data from the log to the database file. */ //将日志文件中的数据拷贝到 数据文件中 。
   if( rc==SQLITE_OK ){
-    if( pWal->hdr.mxFrame && walPagesize(pWal)!=nBuf ){  //如果信息不匹配
+    if( (pWal->hdr.mxFrame || wal2OtherFrames(&pWal->hdr))
+     && walPagesize(pWal)!=nBuf
+    ){  //如果信息不匹配
       rc = SQLITE_CORRUPT_BKPT;// 返回
+    }else if( pWal->bWal2 ){
+      rc = wal2Checkpoint(pWal, eMode2, xBusy, pBusyArg, sync_flags, zBuf);
     }else{
       rc = walCheckpoint(pWal, eMode2, xBusy, pBusyArg, sync_flags, zBuf);// 调用检查点函数
     }
 
-    /* If no error occurred, set the output variables. */ //如果没有error 发生，设置输出变量
+    /* If no error occurred, set the output variables. In wal2 mode, the
+    ** frame count includes both files but only frames of the non-current
+    ** file are ever reported as backfilled. */ //如果没有error 发生，设置输出变量
     if( rc==SQLITE_OK || rc==SQLITE_BUSY ){ 
-      if( pnLog ) *pnLog = (int)pWal->hdr.mxFrame; //获取Frame的个数
+      if( pnLog ){
+        *pnLog = (int)(pWal->hdr.mxFrame + wal2OtherFrames(&pWal->hdr)); //获取Frame的个数
+      }
       if( pnCkpt ) *pnCkpt = (int)(walCkptInfo(pWal)->nBackfill); //回填Frame个数
     }
   }
@@ -3279,7 +5461,7 @@ int sqlite3WalExclusiveMode(Wal *pWal, int op){
   }else if( op>0 ){
     assert( pWal->exclusiveMode==0 );
     assert( pWal->readLock>=0 );
-    walUnlockShared(pWal, WAL_READ_LOCK(pWal->readLock));
+    walReadUnlock(pWal);
     pWal->exclusiveMode = 1;
     rc = 1;
   }else{
@@ -28,13 +28,20 @@
 #ifdef SQLITE_OMIT_WAL
 # define sqlite3WalOpen(x,y,z)                   0
 # define sqlite3WalLimit(x,y)
+# define sqlite3WalCheckpointStep(y,z)
+# define sqlite3WalGroupCommit(y,z)
+# define sqlite3WalSharedReaders(y,z)
+# define sqlite3WalCommitSync(z)                 0
+# define sqlite3WalWriteIntent(y,z)
 # define sqlite3WalClose(w,x,y,z)                0
 # define sqlite3WalBeginReadTransaction(y,z)     0
 # define sqlite3WalEndReadTransaction(z)
 # define sqlite3WalRead(v,w,x,y,z)               0
+# define sqlite3WalFindFrame(x,y,z)              0
 # define sqlite3WalDbsize(y)                     0
 # define sqlite3WalBeginWriteTransaction(y)      0
 # define sqlite3WalEndWriteTransaction(x)        0
+# define sqlite3WalLockForCommit(w,x,y,z,u,v)    0
 # define sqlite3WalUndo(x,y,z)                   0
 # define sqlite3WalSavepoint(y,z)
 # define sqlite3WalSavepointUndo(y,z)            0
@@ -54,12 +61,23 @@
 typedef struct Wal Wal;
 
 /* Open and close a connection to a write-ahead log. */
-int sqlite3WalOpen(sqlite3_vfs*, sqlite3_file*, const char *, int, i64, Wal**);
+int sqlite3WalOpen(sqlite3_vfs*, sqlite3_file*, const char *, int, int, i64, Wal**);
 int sqlite3WalClose(Wal *pWal, int sync_flags, int, u8 *);
 
 /* Set the limiting size of a WAL file. */
 void sqlite3WalLimit(Wal*, i64);
 
+/* Limit the number of frames copied by each PASSIVE checkpoint. */
+void sqlite3WalCheckpointStep(Wal*, int);
+
+/* Enable or disable group commit, and make a deferred commit durable. */
+void sqlite3WalGroupCommit(Wal*, int);
+int sqlite3WalCommitSync(Wal*);
+void sqlite3WalWriteIntent(Wal*, int);
+
+/* Enable or disable shared read locks for connections in this process. */
+void sqlite3WalSharedReaders(Wal*, int);
+
 /* Used by readers to open (lock) and close (unlock) a snapshot.  A 
 ** snapshot is like a read-transaction.  It is the state of the database
 ** at an instant in time.  sqlite3WalOpenSnapshot gets a read lock and
@@ -73,6 +91,10 @@ void sqlite3WalEndReadTransaction(Wal *pWal);
 /* Read a page from the write-ahead log, if it is present. */
 int sqlite3WalRead(Wal *pWal, Pgno pgno, int *pInWal, int nOut, u8 *pOut);
 
+/* Return the WAL frame that holds page pgno, or zero if it is not in the
+** WAL. */
+int sqlite3WalFindFrame(Wal *pWal, Pgno pgno, u32 *piRead);
+
 /* If the WAL is not empty, return the size of the database. */
 Pgno sqlite3WalDbsize(Wal *pWal);
 
@@ -80,6 +102,11 @@ Pgno sqlite3WalDbsize(Wal *pWal);
 int sqlite3WalBeginWriteTransaction(Wal *pWal);
 int sqlite3WalEndWriteTransaction(Wal *pWal);
 
+/* Obtain the WRITER lock to commit a BEGIN CONCURRENT transaction. */
+int sqlite3WalLockForCommit(Wal *pWal, Bitvec *pAllRead, const u8 *aPage1,
+                            u32 *pnPage, int (*xReload)(void *, Pgno),
+                            void *pReloadCtx);
+
 /* Undo any frames written (but not committed) to the log */
 int sqlite3WalUndo(Wal *pWal, int (*xUndo)(void *, Pgno), void *pUndoCtx);
 
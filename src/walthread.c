@@ -0,0 +1,360 @@
+/*
+** 2012 November 12
+**
+** The author disclaims copyright to this source code.  In place of
+** a legal notice, here is a blessing:
+**
+**    May you do good and not evil.
+**    May you find forgiveness for yourself and forgive others.
+**    May you share freely, never taking more than you give.
+**
+*************************************************************************
+**
+** This file implements background checkpointing of WAL databases.
+**
+** Normally, the sqlite3_wal_hook() callback installed by
+** sqlite3_wal_autocheckpoint() runs a checkpoint on whichever connection
+** happens to commit the transaction that pushes the WAL past the
+** configured size. That commit then takes as long as the checkpoint.
+**
+** "PRAGMA [database.]checkpoint_thread = N" attaches a WalCheckpointer
+** object to the named database of the connection. From then on the
+** auto-checkpoint callback only wakes the checkpointer, which copies the
+** WAL into the database from a separate thread through a private
+** connection of its own. It runs PASSIVE checkpoints a limited number of
+** frames at a time, repeating them for as long as they make progress,
+** and escalates to a RESTART checkpoint once the WAL holds N or more
+** frames. Setting N to zero removes the checkpointer again.
+**
+** If the private connection cannot be opened or used (for example
+** because the database uses locking_mode=EXCLUSIVE), or if no thread can
+** be started, checkpoints are run inline as before.
+**
+** Progress is reported through sqlite3_db_status() as
+** SQLITE_DBSTATUS_CHECKPOINT_DONE and SQLITE_DBSTATUS_CHECKPOINT_LAG.
+*/
+#include "sqliteInt.h"
+
+#ifndef SQLITE_OMIT_WAL
+
+/*
+** The maximum number of frames copied into the database file by each
+** PASSIVE checkpoint run by a background checkpointer.
+*/
+#ifndef SQLITE_DEFAULT_CKPT_STEP
+# define SQLITE_DEFAULT_CKPT_STEP 100
+#endif
+
+/*
+** A background checkpointer for a single database. The list of all
+** checkpointers belonging to a connection is at sqlite3.pCkpt.
+**
+** The pThread and pNext fields, and the dbCkpt connection while no task
+** is running, are only accessed by the thread that holds the owning
+** connection's mutex. All other fields are shared with the checkpoint
+** task and protected by the mutex member.
+*/
+struct WalCheckpointer {
+  char *zDb;                 /* Schema name ("main", or attached name) */
+  sqlite3 *dbCkpt;           /* Private connection used to checkpoint */
+  SQLiteThread *pThread;     /* Most recently started task, or NULL */
+  WalCheckpointer *pNext;    /* Next checkpointer of the same connection */
+  sqlite3_mutex *mutex;      /* Mutex protecting the fields below */
+  int rc;                    /* Sticky error code from the task */
+  int nRestart;              /* Run RESTART checkpoints at this WAL size */
+  u8 bRunning;               /* True while a task is running */
+  u8 bPending;               /* More frames committed while running */
+  u8 bShutdown;              /* Set to ask a running task to stop */
+  int nLog;                  /* Frames in the WAL when last observed */
+  int nBackfill;             /* Frames checkpointed when last observed */
+  int nDone;                 /* Total frames copied by this checkpointer */
+  int nLag;                  /* Frames in the WAL not yet checkpointed */
+  int mxLag;                 /* High-water mark of nLag */
+};
+
+/*
+** Run a single checkpoint on the private connection of p. Return an
+** SQLite error code, with *pnLog and *pnCkpt set as for
+** sqlite3_wal_checkpoint_v2().
+*/
+static int walCheckpointerStep(
+  WalCheckpointer *p,        /* Background checkpointer */
+  int eMode,                 /* SQLITE_CHECKPOINT_PASSIVE or RESTART */
+  int *pnLog,                /* OUT: Size of WAL in frames */
+  int *pnCkpt                /* OUT: Frames checkpointed */
+){
+  sqlite3 *db = p->dbCkpt;
+  int rc;
+
+  /* Reading the database makes sure that the pager of the private
+  ** connection has opened the WAL file, if there is one. Otherwise the
+  ** checkpoint below would be a no-op. */
+  rc = sqlite3_exec(db, "PRAGMA schema_version", 0, 0, 0);
+  if( rc==SQLITE_OK ){
+    sqlite3_mutex_enter(db->mutex);
+    sqlite3PagerCheckpointStep(sqlite3BtreePager(db->aDb[0].pBt),
+        eMode==SQLITE_CHECKPOINT_PASSIVE ? SQLITE_DEFAULT_CKPT_STEP : 0
+    );
+    sqlite3_mutex_leave(db->mutex);
+    rc = sqlite3_wal_checkpoint_v2(db, "main", eMode, pnLog, pnCkpt);
+  }
+  return rc;
+}
+
+/*
+** The main routine of a checkpoint task. Run checkpoints on the database
+** until either the WAL has been completely checkpointed, no further
+** progress can be made, or the owner asks the task to stop.
+*/
+static void *walCheckpointerMain(void *pCtx){
+  WalCheckpointer *p = (WalCheckpointer*)pCtx;
+  int nPrev = -1;                 /* nCkpt returned by previous step */
+  int rc = SQLITE_OK;
+
+  while( 1 ){
+    int eMode = SQLITE_CHECKPOINT_PASSIVE;
+    int nLog = -1;
+    int nCkpt = -1;
+    int bMore;
+
+    sqlite3_mutex_enter(p->mutex);
+    if( p->bShutdown ){
+      p->bRunning = 0;
+      sqlite3_mutex_leave(p->mutex);
+      break;
+    }
+    p->bPending = 0;
+    if( p->nLog>=p->nRestart ) eMode = SQLITE_CHECKPOINT_RESTART;
+    sqlite3_mutex_leave(p->mutex);
+
+    rc = walCheckpointerStep(p, eMode, &nLog, &nCkpt);
+    if( rc==SQLITE_BUSY || rc==SQLITE_LOCKED ) rc = SQLITE_OK;
+
+    sqlite3_mutex_enter(p->mutex);
+    bMore = p->bPending;
+    if( rc!=SQLITE_OK ){
+      p->rc = rc;
+      bMore = 0;
+    }else if( nLog>=0 && nCkpt>=0 ){
+      /* A checkpoint counter smaller than the last one observed means
+      ** that the WAL has been restarted in between. */
+      p->nDone += nCkpt - (nCkpt>=p->nBackfill ? p->nBackfill : 0);
+      p->nBackfill = nCkpt;
+      p->nLog = nLog;
+      p->nLag = nLog - nCkpt;
+      if( p->nLag>p->mxLag ) p->mxLag = p->nLag;
+      if( nCkpt<nLog && nCkpt>nPrev ) bMore = 1;
+    }
+    if( !bMore ) p->bRunning = 0;
+    sqlite3_mutex_leave(p->mutex);
+    if( !bMore ) break;
+    nPrev = nCkpt;
+  }
+  return SQLITE_INT_TO_PTR(rc);
+}
+
+/*
+** Stop the checkpoint task of p, if any, and free p.
+*/
+static void walCheckpointerFree(WalCheckpointer *p){
+  SQLiteThread *pThread;
+  void *pOut;
+
+  sqlite3_mutex_enter(p->mutex);
+  p->bShutdown = 1;
+  pThread = p->pThread;
+  p->pThread = 0;
+  sqlite3_mutex_leave(p->mutex);
+  if( pThread ) sqlite3ThreadJoin(pThread, &pOut);
+  sqlite3_close(p->dbCkpt);
+  sqlite3_mutex_free(p->mutex);
+  sqlite3_free(p);
+}
+
+/*
+** Find the checkpointer attached to database zDb of connection db.
+** Return a pointer to the list entry that points to it, or to the
+** terminating NULL if there is no such checkpointer.
+*/
+static WalCheckpointer **walCheckpointerFind(sqlite3 *db, const char *zDb){
+  WalCheckpointer **pp;
+  for(pp=&db->pCkpt; *pp; pp=&(*pp)->pNext){
+    if( sqlite3StrICmp((*pp)->zDb, zDb)==0 ) break;
+  }
+  return pp;
+}
+
+/*
+** Implementation of "PRAGMA checkpoint_thread" for database iDb.
+**
+** If nRestart is greater than zero, attach a background checkpointer to
+** the database (if there is not one already) and configure it to run
+** RESTART checkpoints once the WAL grows to nRestart frames. If nRestart
+** is zero, remove any background checkpointer from the database. If it
+** is negative, change nothing.
+**
+** Return the RESTART threshold of the database's checkpointer after the
+** change, or zero if it has none.
+*/
+int sqlite3WalCheckpointerConfig(sqlite3 *db, int iDb, int nRestart){
+  Db *pDb = &db->aDb[iDb];
+  WalCheckpointer **pp;
+  WalCheckpointer *p;
+  const char *zFile;
+  int nDb;
+  int rc;
+
+  assert( sqlite3_mutex_held(db->mutex) );
+  pp = walCheckpointerFind(db, pDb->zName);
+  p = *pp;
+  if( nRestart<0 ){
+    return p ? p->nRestart : 0;
+  }
+  if( nRestart==0 ){
+    if( p ){
+      *pp = p->pNext;
+      walCheckpointerFree(p);
+    }
+    return 0;
+  }
+  if( p ){
+    sqlite3_mutex_enter(p->mutex);
+    p->nRestart = nRestart;
+    sqlite3_mutex_leave(p->mutex);
+    return nRestart;
+  }
+
+  /* Temporary and in-memory databases cannot be opened by a second
+  ** connection, and have no WAL anyway. */
+  zFile = pDb->pBt ? sqlite3BtreeGetFilename(pDb->pBt) : 0;
+  if( zFile==0 || zFile[0]==0 ) return 0;
+
+  nDb = sqlite3Strlen30(pDb->zName);
+  p = (WalCheckpointer*)sqlite3MallocZero(sizeof(WalCheckpointer) + nDb + 1);
+  if( p==0 ){
+    db->mallocFailed = 1;
+    return 0;
+  }
+  p->zDb = (char*)&p[1];
+  memcpy(p->zDb, pDb->zName, nDb+1);
+  p->nRestart = nRestart;
+  if( sqlite3GlobalConfig.bCoreMutex ){
+    p->mutex = sqlite3MutexAlloc(SQLITE_MUTEX_FAST);
+    if( p->mutex==0 ){
+      sqlite3_free(p);
+      db->mallocFailed = 1;
+      return 0;
+    }
+  }
+  rc = sqlite3_open_v2(zFile, &p->dbCkpt,
+      SQLITE_OPEN_READWRITE|SQLITE_OPEN_PRIVATECACHE, db->pVfs->zName
+  );
+  if( rc!=SQLITE_OK ){
+    walCheckpointerFree(p);
+    return 0;
+  }
+  p->pNext = db->pCkpt;
+  db->pCkpt = p;
+  return nRestart;
+}
+
+/*
+** This is called by the auto-checkpoint callback when the WAL of
+** database zDb has grown to nFrame frames. If the database has a
+** background checkpointer, wake it up and return true. Otherwise, or
+** if the checkpointer is unable to run, return false. The caller should
+** then run the checkpoint itself.
+*/
+int sqlite3WalCheckpointerWake(sqlite3 *db, const char *zDb, int nFrame){
+  WalCheckpointer *p;
+  SQLiteThread *pOld;
+  void *pOut;
+
+  assert( sqlite3_mutex_held(db->mutex) );
+  p = *walCheckpointerFind(db, zDb);
+  if( p==0 ) return 0;
+
+  sqlite3_mutex_enter(p->mutex);
+  if( p->rc!=SQLITE_OK ){
+    sqlite3_mutex_leave(p->mutex);
+    return 0;
+  }
+  p->nLog = nFrame;
+  if( p->bRunning ){
+    p->bPending = 1;
+    sqlite3_mutex_leave(p->mutex);
+    return 1;
+  }
+  p->bRunning = 1;
+  pOld = p->pThread;
+  p->pThread = 0;
+  sqlite3_mutex_leave(p->mutex);
+
+  /* The previous task has already cleared bRunning, so joining it does
+  ** not block for any significant time. If no thread can be started,
+  ** sqlite3ThreadCreate() runs the task to completion before returning. */
+  if( pOld ) sqlite3ThreadJoin(pOld, &pOut);
+  if( sqlite3ThreadCreate(&p->pThread, walCheckpointerMain, p)!=SQLITE_OK ){
+    sqlite3_mutex_enter(p->mutex);
+    p->bRunning = 0;
+    sqlite3_mutex_leave(p->mutex);
+    return 0;
+  }
+  return 1;
+}
+
+/*
+** Remove the background checkpointer from database iDb of connection
+** db, if it has one. This is called when the database is detached.
+*/
+void sqlite3WalCheckpointerClose(sqlite3 *db, int iDb){
+  sqlite3WalCheckpointerConfig(db, iDb, 0);
+}
+
+/*
+** Remove all background checkpointers from connection db. This is called
+** when the connection is closed.
+*/
+void sqlite3WalCheckpointerCloseAll(sqlite3 *db){
+  while( db->pCkpt ){
+    WalCheckpointer *p = db->pCkpt;
+    db->pCkpt = p->pNext;
+    walCheckpointerFree(p);
+  }
+}
+
+/*
+** Implementation of the SQLITE_DBSTATUS_CHECKPOINT_DONE and
+** SQLITE_DBSTATUS_CHECKPOINT_LAG verbs of sqlite3_db_status(). The
+** values are summed over all background checkpointers of connection db.
+*/
+void sqlite3WalCheckpointerStatus(
+  sqlite3 *db,               /* Database connection */
+  int op,                    /* SQLITE_DBSTATUS_CHECKPOINT_* verb */
+  int *pCurrent,             /* OUT: Current value */
+  int *pHighwater,           /* OUT: High-water mark */
+  int resetFlag              /* True to reset the value or high-water mark */
+){
+  WalCheckpointer *p;
+  int nCur = 0;
+  int nHigh = 0;
+
+  assert( sqlite3_mutex_held(db->mutex) );
+  for(p=db->pCkpt; p; p=p->pNext){
+    sqlite3_mutex_enter(p->mutex);
+    if( op==SQLITE_DBSTATUS_CHECKPOINT_DONE ){
+      nCur += p->nDone;
+      if( resetFlag ) p->nDone = 0;
+    }else{
+      assert( op==SQLITE_DBSTATUS_CHECKPOINT_LAG );
+      nCur += p->nLag;
+      nHigh += p->mxLag;
+      if( resetFlag ) p->mxLag = p->nLag;
+    }
+    sqlite3_mutex_leave(p->mutex);
+  }
+  *pCurrent = nCur;
+  *pHighwater = nHigh;
+}
+
+#endif /* SQLITE_OMIT_WAL */
@@ -542,6 +542,7 @@ struct WhereCost {
 #define WHERE_MULTI_OR     0x10000000  /* OR using multiple indices  OR使用多重索引 */
 #define WHERE_TEMP_INDEX   0x20000000  /* Uses an ephemeral index  使用临时索引 */
 #define WHERE_DISTINCT     0x40000000  /* Correct order for DISTINCT  DISTINCT的正确顺序 */
+#define WHERE_HASH_JOIN    0x80000000  /* WHERE_TEMP_INDEX is a hash table */
 
 /*
 ** 扫描:
@@ -3057,6 +3058,42 @@ struct SrcList_item *pSrc,     /* Table we are trying to access *//* 尝试登
 }
 #endif
 
+#if !defined(SQLITE_OMIT_AUTOMATIC_INDEX) && !defined(SQLITE_OMIT_HASH_JOIN)
+#ifdef SQLITE_TEST
+/*
+** If this variable is set, automatic indexes are never implemented as
+** hash joins.  Test builds only.
+*/
+int sqlite3_where_nohash = 0;
+#else
+# define sqlite3_where_nohash 0
+#endif
+
+/*
+** Return true if every WHERE clause term that would drive an automatic
+** index on pSrc compares its operands using the BINARY collating sequence.
+** Only such terms may be implemented by a hash join, as the hash of a
+** key is computed from the bytes of its text and blob values.
+*/
+static int hashJoinTermsOk(
+  Parse *pParse,              /* The parsing context */
+  WhereClause *pWC,           /* The WHERE clause */
+  struct SrcList_item *pSrc,  /* The FROM clause term to search */
+  Bitmask notReady            /* Mask of cursors that are not available */
+){
+  WhereTerm *pTerm;
+  WhereTerm *pWCEnd = &pWC->a[pWC->nTerm];
+  for(pTerm=pWC->a; pTerm<pWCEnd; pTerm++){
+    if( termCanDriveIndex(pTerm, pSrc, notReady) ){
+      Expr *pX = pTerm->pExpr;
+      CollSeq *pColl = sqlite3BinaryCompareCollSeq(pParse, pX->pLeft, pX->pRight);
+      if( pColl && sqlite3StrICmp(pColl->zName, "BINARY") ) return 0;
+    }
+  }
+  return 1;
+}
+#endif
+
 #ifndef SQLITE_OMIT_AUTOMATIC_INDEX
 /*
 ** If the query plan for pSrc specified in pCost is a full table scan
@@ -3204,6 +3241,27 @@ struct SrcList_item *pSrc,  /* The FROM clause term to search *//* 用于搜索
       pCost->plan.nRow = logN + 1;
       pCost->plan.wsFlags = WHERE_TEMP_INDEX;
       pCost->used = pTerm->prereqRight;
+#ifndef SQLITE_OMIT_HASH_JOIN
+      /* If the transient index is only ever probed using equality
+      ** constraints that compare using the BINARY collating sequence and
+      ** the table is expected to fit within the memory budget, build a
+      ** hash table instead. Building it costs one pass over the table
+      ** and each probe is constant time. Should the estimate be wrong,
+      ** the hash table is moved to a B-tree index at run-time. */
+      if( !sqlite3_where_nohash
+       && nTableRow<=(double)sqlite3VdbeHashJoinBudget(pParse->db, pTable->nCol)
+       && hashJoinTermsOk(pParse, pWC, pSrc, notReady)
+      ){
+        double costHash = 2*(nTableRow/pParse->nQueryLoop + 1);
+        if( costHash<costTempIdx ){
+          WHERETRACE(("hash join reduces cost from %.1f to %.1f\n",
+                        costTempIdx, costHash));
+          pCost->rCost = costHash;
+          pCost->plan.nRow = 1;
+          pCost->plan.wsFlags = WHERE_TEMP_INDEX|WHERE_HASH_JOIN;
+        }
+      }
+#endif
       break;
     }
   }
@@ -3247,6 +3305,7 @@ struct SrcList_item *pSrc,  /* The FROM clause term to get the next index *//* 
 	KeyInfo *pKeyinfo;          /* Key information for the index */   /* 索引中的关键信息*/
 	int addrTop;                /* Top of the index fill loop *//* 索引填充循环的顶部*/
 	int regRecord;              /* Register holding an index record *//* 注册保留一个索引记录*/
+	int regBase;                /* First register of the index key */
 	int n;                      /* Column counter *//* 列数计数器*/
 	int i;                      /* Loop counter *//* 循环计数器*/
 	int mxBitCol;               /* Maximum column in pSrc->colUsed *//* pSrc-》colUsed的最大列数*/
@@ -3280,6 +3339,7 @@ struct SrcList_item *pSrc,  /* The FROM clause term to get the next index *//* 
   KeyInfo *pKeyinfo;          /* Key information for the index 索引的关键信息 */   
   int addrTop;                /* Top of the index fill loop 填充循环的索引顶部 */
   int regRecord;              /* Register holding an index record 记录保存一个索引记录 */
+  int regBase;                /* First register of the index key */
   int n;                      /* Column counter 列计数器 */
   int i;                      /* Loop counter 循环计数器 */
   int mxBitCol;               /* Maximum column in pSrc->colUsed 在pSrc->colUsed中的最大的列 */
@@ -3429,6 +3489,12 @@ struct SrcList_item *pSrc,  /* The FROM clause term to get the next index *//* 
 >>>>>>> 91288352e83e9763d493ed84aec377d15ced3949
   pKeyinfo = sqlite3IndexKeyinfo(pParse, pIdx);
   assert( pLevel->iIdxCur>=0 );
+#ifndef SQLITE_OMIT_HASH_JOIN
+  if( pLevel->plan.wsFlags & WHERE_HASH_JOIN ){
+    sqlite3VdbeAddOp4(v, OP_HashJoinOpen, pLevel->iIdxCur, nColumn+1,
+                      pLevel->plan.nEq, (char*)pKeyinfo, P4_KEYINFO_HANDOFF);
+  }else
+#endif
   sqlite3VdbeAddOp4(v, OP_OpenAutoindex, pLevel->iIdxCur, nColumn+1, 0,
                     (char*)pKeyinfo, P4_KEYINFO_HANDOFF);
   VdbeComment((v, "for %s", pTable->zName));
@@ -3444,9 +3510,16 @@ struct SrcList_item *pSrc,  /* The FROM clause term to get the next index *//* 
 >>>>>>> 91288352e83e9763d493ed84aec377d15ced3949
   addrTop = sqlite3VdbeAddOp1(v, OP_Rewind, pLevel->iTabCur);
   regRecord = sqlite3GetTempReg(pParse);
-  sqlite3GenerateIndexKey(pParse, pIdx, pLevel->iTabCur, regRecord, 1);
-  sqlite3VdbeAddOp2(v, OP_IdxInsert, pLevel->iIdxCur, regRecord);
-  sqlite3VdbeChangeP5(v, OPFLAG_USESEEKRESULT);
+  regBase = sqlite3GenerateIndexKey(pParse, pIdx, pLevel->iTabCur, regRecord, 1);
+#ifndef SQLITE_OMIT_HASH_JOIN
+  if( pLevel->plan.wsFlags & WHERE_HASH_JOIN ){
+    sqlite3VdbeAddOp3(v, OP_HashJoinInsert, pLevel->iIdxCur, regRecord, regBase);
+  }else
+#endif
+  {
+    sqlite3VdbeAddOp2(v, OP_IdxInsert, pLevel->iIdxCur, regRecord);
+    sqlite3VdbeChangeP5(v, OPFLAG_USESEEKRESULT);
+  }
   sqlite3VdbeAddOp2(v, OP_Next, pLevel->iTabCur, addrTop+1);
   sqlite3VdbeChangeP5(v, SQLITE_STMTSTATUS_AUTOINDEX);
   sqlite3VdbeJumpHere(v, addrTop);
@@ -6415,7 +6488,8 @@ static char *explainIndexRange(sqlite3 *db, WhereLevel *pLevel, Table *pTab){
 ** This function is a no-op unless currently processing an EXPLAIN QUERY PLAN
 ** command. If the query being compiled is an EXPLAIN QUERY PLAN, a single
 ** record is added to the output to describe the table scan strategy in 
-** pLevel.
+** pLevel. The address of the OP_Explain opcode is returned, or zero if
+** no opcode was added.
 <<<<<<< HEAD
 这个函数是无操作,除非目前处理解释查询计划命令。
 如果查询编译是一个解释查询计划,
@@ -6426,7 +6500,7 @@ static char *explainIndexRange(sqlite3 *db, WhereLevel *pLevel, Table *pTab){
 如果查询编译是一个解释查询计划
 输出是会添加一个记录来扫描在pLevel中德表扫描策略
 */
-static void explainOneScan(
+static int explainOneScan(
   Parse *pParse,                  /* 解析上下文*/
   SrcList *pTabList,              /* 这个循环是表的列循环*/
   WhereLevel *pLevel,             /* 扫描并写OP_Explain操作码*/
@@ -6439,7 +6513,7 @@ static void explainOneScan(
 ** 这个函数是一个空操作，除非当前执行一个EXPLAIN QUERY PLAN命令。
 ** 如果开始编译的查询是一个EXPLAIN QUERY PLAN，输出是会添加一个记录来描述在pLevel中的表扫描策略。
 */
-static void explainOneScan(
+static int explainOneScan(
   Parse *pParse,                  /* Parse context 分析上下文 */
   SrcList *pTabList,              /* Table list this loop refers to 这个循环引用的表列表 */
   WhereLevel *pLevel,             /* Scan to write OP_Explain opcode for 扫描写入的OP_Explain操作码 */
@@ -6448,7 +6522,8 @@ static void explainOneScan(
   u16 wctrlFlags                  /* Flags passed to sqlite3WhereBegin() 传给sqlite3WhereBegin()的标志 */
 >>>>>>> 91288352e83e9763d493ed84aec377d15ced3949
 ){
-  if( pParse->explain==2 ){
+  int addrExplain = 0;            /* Address of the OP_Explain opcode */
+  if( pParse->explain>=2 ){
     u32 flags = pLevel->plan.wsFlags;
     struct SrcList_item *pItem = &pTabList->a[pLevel->iFrom];
 <<<<<<< HEAD
@@ -6467,7 +6542,7 @@ static void explainOneScan(
     int isSearch;                 /* True for a SEARCH. False for SCAN. 是一个查找则为TRUE，扫描则为FALSE */
 >>>>>>> 91288352e83e9763d493ed84aec377d15ced3949
 
-    if( (flags&WHERE_MULTI_OR) || (wctrlFlags&WHERE_ONETABLE_ONLY) ) return;
+    if( (flags&WHERE_MULTI_OR) || (wctrlFlags&WHERE_ONETABLE_ONLY) ) return 0;
 
     isSearch = (pLevel->plan.nEq>0)
              || (flags&(WHERE_BTM_LIMIT|WHERE_TOP_LIMIT))!=0
@@ -6483,6 +6558,13 @@ static void explainOneScan(
     if( pItem->zAlias ){
       zMsg = sqlite3MAppendf(db, zMsg, "%s AS %s", zMsg, pItem->zAlias);
     }
+#ifndef SQLITE_OMIT_HASH_JOIN
+    if( flags & WHERE_HASH_JOIN ){
+      char *zWhere = explainIndexRange(db, pLevel, pItem->pTab);
+      zMsg = sqlite3MAppendf(db, zMsg, "%s USING HASH JOIN%s", zMsg, zWhere);
+      sqlite3DbFree(db, zWhere);
+    }else
+#endif
     if( (flags & WHERE_INDEXED)!=0 ){
       char *zWhere = explainIndexRange(db, pLevel, pItem->pTab);
       zMsg = sqlite3MAppendf(db, zMsg, "%s USING %s%sINDEX%s%s%s", zMsg, 
@@ -6520,11 +6602,13 @@ static void explainOneScan(
       nRow = (sqlite3_int64)pLevel->plan.nRow;
     }
     zMsg = sqlite3MAppendf(db, zMsg, "%s (~%lld rows)", zMsg, nRow);
-    sqlite3VdbeAddOp4(v, OP_Explain, iId, iLevel, iFrom, zMsg, P4_DYNAMIC);
+    addrExplain = sqlite3VdbeAddOp4(v, OP_Explain, iId, iLevel, iFrom,
+                                    zMsg, P4_DYNAMIC);
   }
+  return addrExplain;
 }
 #else
-# define explainOneScan(u,v,w,x,y,z)
+# define explainOneScan(u,v,w,x,y,z) 0
 #endif /* SQLITE_OMIT_EXPLAIN */
 
 
@@ -6819,6 +6903,35 @@ static Bitmask codeOneLoopStart(
       sqlite3VdbeAddOp3(v, testOp, memEndValue, addrBrk, iRowidReg);
       sqlite3VdbeChangeP5(v, SQLITE_AFF_NUMERIC | SQLITE_JUMPIFNULL);
     }
+#ifndef SQLITE_OMIT_HASH_JOIN
+  }else if( pLevel->plan.wsFlags & WHERE_HASH_JOIN ){
+    /* Case 2b: Probe a hash table built by constructAutomaticIndex().
+    **
+    **         The equality constraints are evaluated into registers and
+    **         used to seek the hash join cursor. Each matching entry is
+    **         then visited in turn by OP_HashJoinNext.
+    */
+    int iIdxCur = pLevel->iIdxCur;
+    int nEq = pLevel->plan.nEq;
+    int regBase;
+    char *zAff;
+
+    regBase = codeAllEqualityTerms(pParse, pLevel, pWC, notReady, 0, &zAff);
+    codeApplyAffinity(pParse, regBase, nEq, zAff);
+    sqlite3DbFree(pParse->db, zAff);
+    sqlite3VdbeAddOp4Int(v, OP_HashJoinSeek, iIdxCur, pLevel->addrNxt,
+                         regBase, nEq);
+    if( !omitTable ){
+      iRowidReg = iReleaseReg = sqlite3GetTempReg(pParse);
+      sqlite3VdbeAddOp3(v, OP_Column, iIdxCur, pLevel->plan.u.pIdx->nColumn,
+                        iRowidReg);
+      sqlite3ExprCacheStore(pParse, iCur, -1, iRowidReg);
+      sqlite3VdbeAddOp2(v, OP_Seek, iCur, iRowidReg);  /* Deferred seek */
+    }
+    pLevel->op = OP_HashJoinNext;
+    pLevel->p1 = iIdxCur;
+    pLevel->p2 = sqlite3VdbeCurrentAddr(v);
+#endif
   }else if( pLevel->plan.wsFlags & (WHERE_COLUMN_RANGE|WHERE_COLUMN_EQ) ){
     /* Case 3: A scan using an index.
     **
@@ -7582,6 +7695,7 @@ static Bitmask codeOneLoopStart(
     pLevel->p5 = SQLITE_STMTSTATUS_FULLSCAN_STEP;
   }
   notReady &= ~getMask(pWC->pMaskSet, iCur);
+  pLevel->addrVisit = sqlite3VdbeCurrentAddr(v);
 
   /* Insert code to test every subexpression that can be completely
   ** computed using the current set of tables.
@@ -8650,9 +8764,19 @@ WhereInfo *sqlite3WhereBegin(
   notReady = ~(Bitmask)0;
   for(i=0; i<nTabList; i++){
     pLevel = &pWInfo->a[i];
-    explainOneScan(pParse, pTabList, pLevel, i, pLevel->iFrom, wctrlFlags);
+    pLevel->addrExplain = explainOneScan(
+        pParse, pTabList, pLevel, i, pLevel->iFrom, wctrlFlags
+    );
     notReady = codeOneLoopStart(pWInfo, i, wctrlFlags, notReady);
     pWInfo->iContinue = pLevel->addrCont;
+    if( pLevel->addrExplain && pParse->explain==3 ){
+      /* For EXPLAIN ANALYZE, mark the point reached by each row that passes
+      ** the WHERE terms coded for this loop. */
+      int addrOutput = sqlite3VdbeAddOp0(v, OP_Noop);
+      sqlite3VdbeScanStat(v, pLevel->addrExplain, pLevel->addrVisit,
+          addrOutput, pTabList->a[pLevel->iFrom].iCursor, pLevel->iIdxCur
+      );
+    }
   }
 
 #ifdef SQLITE_TEST  /* For testing and debugging use only 只用于测试和调试 */
@@ -8802,6 +8926,9 @@ void sqlite3WhereEnd(WhereInfo *pWInfo){
       }
       sqlite3VdbeJumpHere(v, addr);
     }
+    if( pLevel->addrExplain && pParse->explain==3 ){
+      sqlite3VdbeScanStatEnd(v, pLevel->addrExplain);
+    }
   }
 
   /* The "break" point is here, just past the end of the outer loop.
@@ -8897,6 +9024,14 @@ void sqlite3WhereEnd(WhereInfo *pWInfo){
                || j<pIdx->nColumn );
         }else if( pOp->opcode==OP_Rowid ){
           pOp->p1 = pLevel->iIdxCur;
+#ifndef SQLITE_OMIT_HASH_JOIN
+          if( pLevel->plan.wsFlags & WHERE_HASH_JOIN ){
+            /* The rowid is the last field of each hash join record */
+            pOp->opcode = OP_Column;
+            pOp->p3 = pOp->p2;
+            pOp->p2 = pIdx->nColumn;
+          }else
+#endif
           pOp->opcode = OP_IdxRowid;
         }
       }